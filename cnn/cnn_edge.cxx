@@ -823,6 +823,20 @@ bool CNN_Edge::is_reachable() const {
     return !disabled && forward_visited && reverse_visited;
 }
 
+/**
+ * Whether this edge's convolution can be computed together with other's (see CNN_Genome's
+ * edge groups): both are reachable convolutions out of the same node with the same filter sizes,
+ * filter directions and output sizes, into different nodes.
+ */
+bool CNN_Edge::shares_convolution(const CNN_Edge* other) const {
+    return type == CONVOLUTIONAL && other->type == CONVOLUTIONAL && is_reachable() && other->is_reachable()
+           && input_node == other->input_node && output_node != other->output_node && filter_x == other->filter_x
+           && filter_y == other->filter_y && reverse_filter_x == other->reverse_filter_x
+           && reverse_filter_y == other->reverse_filter_y && batch_size == other->batch_size
+           && output_node->get_size_x() == other->output_node->get_size_x()
+           && output_node->get_size_y() == other->output_node->get_size_y();
+}
+
 bool CNN_Edge::is_forward_visited() const {
     return forward_visited;
 }
@@ -1145,6 +1159,78 @@ void CNN_Edge::propagate_forward(
     );
 }
 
+/**
+ * Propagates a group of edges which share their convolution forward with one call to the
+ * convolution kernels, which read the input node's values once for all of them. The group's
+ * time is split evenly between the edges.
+ */
+void CNN_Edge::propagate_forward(
+    const vector<CNN_Edge*>& edges, bool training, bool accumulate_test_statistics, float epsilon, float alpha,
+    bool perform_dropout, float hidden_dropout_probability, minstd_rand0& generator
+) {
+    if (edges.size() == 1) {
+        edges[0]->propagate_forward(
+            training, accumulate_test_statistics, epsilon, alpha, perform_dropout, hidden_dropout_probability,
+            generator
+        );
+        return;
+    }
+
+    using namespace std::chrono;
+    high_resolution_clock::time_point propagate_forward_start_time = high_resolution_clock::now();
+
+    CNN_Edge* first = edges[0];
+
+    vector<float*> weights;
+    vector<float*> outputs;
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        weights.push_back(edges[i]->weights);
+        outputs.push_back(edges[i]->output_node->get_values_in());
+    }
+
+    prop_forward_filters(
+        first->reverse_filter_y, first->reverse_filter_x, first->input_node->get_values_out(), edges.size(),
+        &weights[0], &outputs[0], first->batch_size, first->input_node->get_size_y(), first->input_node->get_size_x(),
+        first->filter_y, first->filter_x, first->output_node->get_size_y(), first->output_node->get_size_x()
+    );
+
+    high_resolution_clock::time_point propagate_forward_end_time = high_resolution_clock::now();
+    duration<float, std::milli> time_span = propagate_forward_end_time - propagate_forward_start_time;
+
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        edges[i]->propagate_forward_time += time_span.count() / (1000.0 * edges.size());
+
+        edges[i]->output_node->input_fired(
+            training, accumulate_test_statistics, epsilon, alpha, perform_dropout, hidden_dropout_probability, generator
+        );
+    }
+}
+
+void CNN_Edge::propagate_forward(
+    const vector<CNN_Edge*>& edges, const float* input, float* const* outputs, int32_t extra_y, int32_t extra_x
+) {
+    CNN_Edge* first = edges[0];
+
+    if (first->type != CONVOLUTIONAL || first->reverse_filter_y || first->reverse_filter_x) {
+        cerr << "ERROR: only convolutional edges with forward filters can be propagated over a larger input, edge "
+             << first->innovation_number << " has type: " << first->type
+             << ", reverse_filter_y: " << first->reverse_filter_y << ", reverse_filter_x: " << first->reverse_filter_x
+             << endl;
+        exit(1);
+    }
+
+    vector<float*> weights;
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        weights.push_back(edges[i]->weights);
+    }
+
+    prop_forward_filters(
+        false, false, input, edges.size(), &weights[0], outputs, 1, first->input_node->get_size_y() + extra_y,
+        first->input_node->get_size_x() + extra_x, first->filter_y, first->filter_x,
+        first->output_node->get_size_y() + extra_y, first->output_node->get_size_x() + extra_x
+    );
+}
+
 void CNN_Edge::update_weights(float mu, float learning_rate, float weight_decay) {
     if (!is_reachable()) {
         return;
@@ -1341,6 +1427,54 @@ void CNN_Edge::propagate_backward(bool training, float mu, float learning_rate,
     input_node->output_fired(training, mu, learning_rate, epsilon);
 }
 
+/**
+ * Propagates a group of edges which share their convolution backward with one call to the
+ * convolution kernels, which sum the errors of all the edges into each of the input node's
+ * errors at once.
+ */
+void CNN_Edge::propagate_backward(
+    const vector<CNN_Edge*>& edges, bool training, float mu, float learning_rate, float epsilon
+) {
+    if (edges.size() == 1) {
+        edges[0]->propagate_backward(training, mu, learning_rate, epsilon);
+        return;
+    }
+
+    using namespace std::chrono;
+    high_resolution_clock::time_point propagate_backward_start_time = high_resolution_clock::now();
+
+    CNN_Edge* first = edges[0];
+
+    vector<float*> output_errors;
+    vector<float*> weight_updates;
+    vector<float*> weights;
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        for (int32_t current = 0; current < edges[i]->filter_size; current++) {
+            edges[i]->weight_updates[current] = 0;
+        }
+
+        output_errors.push_back(edges[i]->output_node->get_errors_in());
+        weight_updates.push_back(edges[i]->weight_updates);
+        weights.push_back(edges[i]->weights);
+    }
+
+    prop_backward_filters(
+        first->reverse_filter_y, first->reverse_filter_x, edges.size(), &output_errors[0],
+        first->input_node->get_values_out(), first->input_node->get_errors_out(), &weight_updates[0], &weights[0],
+        first->batch_size, first->input_node->get_size_y(), first->input_node->get_size_x(), first->filter_y,
+        first->filter_x, first->output_node->get_size_y(), first->output_node->get_size_x()
+    );
+
+    high_resolution_clock::time_point propagate_backward_end_time = high_resolution_clock::now();
+    duration<float, std::milli> time_span = propagate_backward_end_time - propagate_backward_start_time;
+
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        edges[i]->propagate_backward_time += time_span.count() / (1000.0 * edges.size());
+
+        edges[i]->input_node->output_fired(training, mu, learning_rate, epsilon);
+    }
+}
+
 bool CNN_Edge::has_nan() const {
     // cout << "checking to see if edge " << innovation_number << " has nan or inf, filter_size: " << filter_size <<
     // endl;
@@ -1641,6 +1775,95 @@ istream& operator>>(istream& is, CNN_Edge* edge) {
     return is;
 }
 
+void CNN_Edge::write_binary(ostream& outfile) const {
+    outfile.write((char*) &edge_id, sizeof(int32_t));
+    outfile.write((char*) &exact_id, sizeof(int32_t));
+    outfile.write((char*) &genome_id, sizeof(int32_t));
+    outfile.write((char*) &type, sizeof(int32_t));
+    outfile.write((char*) &innovation_number, sizeof(int32_t));
+    outfile.write((char*) &input_node_innovation_number, sizeof(int32_t));
+    outfile.write((char*) &output_node_innovation_number, sizeof(int32_t));
+    outfile.write((char*) &filter_x, sizeof(int32_t));
+    outfile.write((char*) &filter_y, sizeof(int32_t));
+    outfile.write((char*) &fixed, sizeof(bool));
+    outfile.write((char*) &reverse_filter_x, sizeof(bool));
+    outfile.write((char*) &reverse_filter_y, sizeof(bool));
+    outfile.write((char*) &disabled, sizeof(bool));
+    outfile.write((char*) &forward_visited, sizeof(bool));
+    outfile.write((char*) &reverse_visited, sizeof(bool));
+    outfile.write((char*) &needs_initialization, sizeof(bool));
+    outfile.write((char*) &batch_size, sizeof(int32_t));
+
+    outfile.write((char*) &scale, sizeof(float));
+    outfile.write((char*) &best_scale, sizeof(float));
+    outfile.write((char*) &previous_velocity_scale, sizeof(float));
+    outfile.write((char*) &best_velocity_scale, sizeof(float));
+
+    int32_t pool_size = y_pools.size();
+    outfile.write((char*) &pool_size, sizeof(int32_t));
+    outfile.write((char*) y_pools.data(), sizeof(int32_t) * pool_size);
+
+    pool_size = x_pools.size();
+    outfile.write((char*) &pool_size, sizeof(int32_t));
+    outfile.write((char*) x_pools.data(), sizeof(int32_t) * pool_size);
+
+    write_binary_floats(outfile, weights, filter_size);
+    write_binary_floats(outfile, best_weights, filter_size);
+    write_binary_floats(outfile, previous_velocity, filter_size);
+    write_binary_floats(outfile, best_velocity, filter_size);
+}
+
+void CNN_Edge::read_binary(istream& infile) {
+    infile.read((char*) &edge_id, sizeof(int32_t));
+    infile.read((char*) &exact_id, sizeof(int32_t));
+    infile.read((char*) &genome_id, sizeof(int32_t));
+    infile.read((char*) &type, sizeof(int32_t));
+    infile.read((char*) &innovation_number, sizeof(int32_t));
+    infile.read((char*) &input_node_innovation_number, sizeof(int32_t));
+    infile.read((char*) &output_node_innovation_number, sizeof(int32_t));
+    infile.read((char*) &filter_x, sizeof(int32_t));
+    infile.read((char*) &filter_y, sizeof(int32_t));
+    infile.read((char*) &fixed, sizeof(bool));
+    infile.read((char*) &reverse_filter_x, sizeof(bool));
+    infile.read((char*) &reverse_filter_y, sizeof(bool));
+    infile.read((char*) &disabled, sizeof(bool));
+    infile.read((char*) &forward_visited, sizeof(bool));
+    infile.read((char*) &reverse_visited, sizeof(bool));
+    infile.read((char*) &needs_initialization, sizeof(bool));
+    infile.read((char*) &batch_size, sizeof(int32_t));
+
+    filter_size = filter_y * filter_x;
+
+    weights = new float[filter_size]();
+    weight_updates = new float[filter_size]();
+    best_weights = new float[filter_size]();
+
+    previous_velocity = new float[filter_size]();
+    best_velocity = new float[filter_size]();
+
+    infile.read((char*) &scale, sizeof(float));
+    infile.read((char*) &best_scale, sizeof(float));
+    infile.read((char*) &previous_velocity_scale, sizeof(float));
+    infile.read((char*) &best_velocity_scale, sizeof(float));
+
+    int32_t pool_size;
+    infile.read((char*) &pool_size, sizeof(int32_t));
+    y_pools.resize(pool_size);
+    infile.read((char*) y_pools.data(), sizeof(int32_t) * pool_size);
+
+    infile.read((char*) &pool_size, sizeof(int32_t));
+    x_pools.resize(pool_size);
+    infile.read((char*) x_pools.data(), sizeof(int32_t) * pool_size);
+
+    update_offset(y_pools, y_pool_offset);
+    update_offset(x_pools, x_pool_offset);
+
+    read_binary_floats(infile, weights, filter_size);
+    read_binary_floats(infile, best_weights, filter_size);
+    read_binary_floats(infile, previous_velocity, filter_size);
+    read_binary_floats(infile, best_velocity, filter_size);
+}
+
 bool CNN_Edge::is_identical(const CNN_Edge* other, bool testing_checkpoint) {
     if (are_different("edge_id", edge_id, other->edge_id)) {
         return false;
@@ -180,6 +180,27 @@ class CNN_Edge {
     );
 
     void propagate_backward(bool training, float mu, float learning_rate, float epsilon);
+
+    bool shares_convolution(const CNN_Edge* other) const;
+
+    static void propagate_forward(
+        const vector<CNN_Edge*>& edges, bool training, bool accumulate_test_statistics, float epsilon, float alpha,
+        bool perform_dropout, float hidden_dropout_probability, minstd_rand0& generator
+    );
+
+    static void propagate_backward(
+        const vector<CNN_Edge*>& edges, bool training, float mu, float learning_rate, float epsilon
+    );
+
+    /**
+     * Propagates a group of convolutional edges (see shares_convolution) forward over an input
+     * larger than their input node, into outputs larger than their output nodes by the same
+     * extra_y and extra_x, for fully convolutional inference. The outputs are added to.
+     */
+    static void propagate_forward(
+        const vector<CNN_Edge*>& edges, const float* input, float* const* outputs, int32_t extra_y, int32_t extra_x
+    );
+
     void update_weights(float mu, float learning_rate, float weight_decay);
 
     void print_statistics();
@@ -188,6 +209,14 @@ class CNN_Edge {
 
     friend ostream& operator<<(ostream& os, const CNN_Edge* flight);
     friend istream& operator>>(istream& is, CNN_Edge* flight);
+
+    /**
+     * The same fields as operator<< and operator>>, for binary checkpoints (see
+     * CNN_Genome::write_binary), with the weights, best weights and velocities as aligned raw
+     * arrays (see write_binary_floats).
+     */
+    void write_binary(ostream& outfile) const;
+    void read_binary(istream& infile);
 };
 
 int random_edge_type(float random_value);
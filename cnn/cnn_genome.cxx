@@ -1,4 +1,5 @@
 #include <algorithm>
+using std::copy;
 using std::sort;
 using std::upper_bound;
 
@@ -45,6 +46,9 @@ using std::ostringstream;
 using std::string;
 using std::to_string;
 
+#include <utility>
+using std::move;
+
 #include <vector>
 using std::vector;
 
@@ -55,6 +59,7 @@ using std::vector;
 #include "cnn_edge.hxx"
 #include "cnn_genome.hxx"
 #include "cnn_node.hxx"
+#include "common/arguments.hxx"
 #include "common/exp.hxx"
 #include "common/files.hxx"
 #include "common/random.hxx"
@@ -93,6 +98,17 @@ CNN_Genome::CNN_Genome(string filename, bool is_checkpoint) {
     genome_id = -1;
     started_from_checkpoint = is_checkpoint;
 
+    // binary checkpoints start with CHECKPOINT_MAGIC, anything else is a text genome
+    ifstream binary_infile(filename, ios::in | ios::binary);
+    char magic[8];
+    binary_infile.read(magic, 8);
+    if (binary_infile.gcount() == 8 && string(magic, 8).compare(CHECKPOINT_MAGIC) == 0) {
+        binary_infile.seekg(0);
+        read_binary(binary_infile);
+        return;
+    }
+    binary_infile.close();
+
     string file_contents;
 
     // cout << "getting file as string: '" << filename << "'" << endl;
@@ -201,6 +217,7 @@ void parse_array(vector<T>& output, istringstream& iss) {
 #ifdef _MYSQL_
 CNN_Genome::CNN_Genome(int _genome_id) {
     progress_function = NULL;
+    quantized = NULL;
     version_str = EXACT_VERSION_STR;
 
     ostringstream query;
@@ -504,6 +521,7 @@ CNN_Genome::CNN_Genome(
     number_test_images = _number_test_images;
 
     progress_function = NULL;
+    quantized = NULL;
 
     velocity_reset = _velocity_reset;
 
@@ -606,6 +624,8 @@ CNN_Genome::~CNN_Genome() {
         softmax_nodes.pop_back();
     }
     softmax_nodes.clear();
+
+    delete quantized;
 }
 
 bool CNN_Genome::equals(CNN_Genome* other) const {
@@ -1282,6 +1302,7 @@ bool CNN_Genome::visit_nodes() {
             edges[i]->get_output_node()->add_input();
         }
     }
+    group_edges();
 
     /*
     for (uint32_t i = 0; i < nodes.size(); i++) {
@@ -1301,9 +1322,60 @@ bool CNN_Genome::visit_nodes() {
     return true;
 }
 
-void CNN_Genome::evaluate_images(
-    const ImagesInterface& images, const vector<int>& batch, vector<vector<float> >& predictions, int offset
-) {
+/**
+ * Groups the (sorted) edges which share a convolution (see CNN_Edge::shares_convolution), so
+ * they are propagated with one call to the convolution kernels. This is redone whenever the edges
+ * are sorted or visited, as their order or reachability may change. Each group is placed at its
+ * first edge, which keeps the forward (and reversed, backward) order valid: all the edges into a
+ * node come before the first edge out of it.
+ */
+void CNN_Genome::group_edges() {
+    edge_groups.clear();
+
+    // the groups of edges out of each node
+    map<int, vector<int32_t> > node_groups;
+
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        if (!edges[i]->is_reachable()) {
+            continue;
+        }
+
+        vector<int32_t>& groups = node_groups[edges[i]->get_input_node()->get_innovation_number()];
+
+        int32_t group = -1;
+        for (uint32_t j = 0; j < groups.size() && group < 0; j++) {
+            bool shares = true;
+            for (uint32_t k = 0; k < edge_groups[groups[j]].size() && shares; k++) {
+                shares = edges[i]->shares_convolution(edge_groups[groups[j]][k]);
+            }
+            if (shares) {
+                group = groups[j];
+            }
+        }
+
+        if (group >= 0) {
+            edge_groups[group].push_back(edges[i]);
+        } else {
+            groups.push_back(edge_groups.size());
+            edge_groups.push_back(vector<CNN_Edge*>(1, edges[i]));
+        }
+    }
+}
+
+const float* CNN_Genome::fetch_batch(const ImagesInterface& images, const vector<int>& batch) {
+    batch_values.resize(
+        batch.size() * images.get_image_channels() * images.get_image_height() * images.get_image_width()
+    );
+    images.get_batch(batch, batch_values.data());
+    return batch_values.data();
+}
+
+void CNN_Genome::evaluate_images(const ImagesInterface& images, const vector<int>& batch, float* predictions) {
+    if (quantized != NULL) {
+        quantized->evaluate_images(images, batch, fetch_batch(images, batch), predictions);
+        return;
+    }
+
     bool training = false;
     bool accumulate_test_statistics = false;
 
@@ -1311,15 +1383,18 @@ void CNN_Genome::evaluate_images(
         nodes[i]->reset();
     }
 
+    const float* batch_values = fetch_batch(images, batch);
     for (uint32_t channel = 0; channel < input_nodes.size(); channel++) {
         input_nodes[channel]->set_values(
-            images, batch, channel, training, accumulate_test_statistics, input_dropout_probability, generator
+            images, batch, batch_values, channel, training, accumulate_test_statistics, input_dropout_probability,
+            generator
         );
     }
 
-    for (uint32_t i = 0; i < edges.size(); i++) {
-        edges[i]->propagate_forward(
-            training, accumulate_test_statistics, epsilon, alpha, training, hidden_dropout_probability, generator
+    for (uint32_t i = 0; i < edge_groups.size(); i++) {
+        CNN_Edge::propagate_forward(
+            edge_groups[i], training, accumulate_test_statistics, epsilon, alpha, training, hidden_dropout_probability,
+            generator
         );
     }
 
@@ -1419,11 +1494,24 @@ void CNN_Genome::evaluate_images(
                 max_value = value;
             }
 
-            predictions[batch[batch_number] - offset][i] = value;
+            predictions[(batch_number * softmax_nodes.size()) + i] = value;
         }
     }
 }
 
+void CNN_Genome::evaluate_images(
+    const ImagesInterface& images, const vector<int>& batch, vector<vector<float> >& predictions, int offset
+) {
+    int32_t number_softmax_nodes = softmax_nodes.size();
+    batch_predictions.resize(batch.size() * number_softmax_nodes);
+    evaluate_images(images, batch, batch_predictions.data());
+
+    for (int32_t batch_number = 0; batch_number < (int32_t) batch.size(); batch_number++) {
+        const float* prediction = &batch_predictions[batch_number * number_softmax_nodes];
+        copy(prediction, prediction + number_softmax_nodes, predictions[batch[batch_number] - offset].begin());
+    }
+}
+
 void calculate_softmax(
     const vector<float>& values_in, vector<float>& values_out, vector<float>& gradient, int expected_class,
     int& predicted_class, float& entropy
@@ -1503,6 +1591,39 @@ void calculate_softmax(
     */
 }
 
+/**
+ * The total error and number of correct predictions of the predictions of evaluate, calculated
+ * the same as evaluate_images does.
+ */
+static void score_predictions(
+    const ImagesInterface& images, const vector<vector<float> >& predictions, float& total_error,
+    int& correct_predictions
+) {
+    total_error = 0.0;
+    correct_predictions = 0;
+
+    for (int32_t i = 0; i < images.get_number_images(); i++) {
+        int expected_class = images.get_classification(i);
+
+        int predicted_class = 0;
+        for (int32_t j = 1; j < (int32_t) predictions[i].size(); j++) {
+            if (predictions[i][j] > predictions[i][predicted_class]) {
+                predicted_class = j;
+            }
+        }
+
+        float error = predictions[i][expected_class];
+        if (error == 0) {
+            error = 1.0 / EXACT_MAX_FLOAT;
+        }
+        total_error -= log(error);
+
+        if (predicted_class == expected_class) {
+            correct_predictions++;
+        }
+    }
+}
+
 void CNN_Genome::check_gradients(const ImagesInterface& images) {
     vector<int> batch;
     for (uint32_t i = 0; i < batch_size; i++) {
@@ -1630,6 +1751,16 @@ void CNN_Genome::check_gradients(const ImagesInterface& images) {
 void CNN_Genome::evaluate_images(
     const ImagesInterface& images, const vector<int>& batch, bool training, float& total_error,
     int& correct_predictions, bool accumulate_test_statistics
+) {
+    evaluate_images(
+        images, batch, fetch_batch(images, batch), training, total_error, correct_predictions,
+        accumulate_test_statistics
+    );
+}
+
+void CNN_Genome::evaluate_images(
+    const ImagesInterface& images, const vector<int>& batch, const float* batch_values, bool training,
+    float& total_error, int& correct_predictions, bool accumulate_test_statistics
 ) {
     for (uint32_t i = 0; i < nodes.size(); i++) {
         nodes[i]->reset();
@@ -1637,13 +1768,15 @@ void CNN_Genome::evaluate_images(
 
     for (uint32_t channel = 0; channel < input_nodes.size(); channel++) {
         input_nodes[channel]->set_values(
-            images, batch, channel, training, accumulate_test_statistics, input_dropout_probability, generator
+            images, batch, batch_values, channel, training, accumulate_test_statistics, input_dropout_probability,
+            generator
         );
     }
 
-    for (uint32_t i = 0; i < edges.size(); i++) {
-        edges[i]->propagate_forward(
-            training, accumulate_test_statistics, epsilon, alpha, training, hidden_dropout_probability, generator
+    for (uint32_t i = 0; i < edge_groups.size(); i++) {
+        CNN_Edge::propagate_forward(
+            edge_groups[i], training, accumulate_test_statistics, epsilon, alpha, training, hidden_dropout_probability,
+            generator
         );
     }
 
@@ -1715,8 +1848,8 @@ void CNN_Genome::evaluate_images(
     }
 
     if (training) {
-        for (int32_t i = edges.size() - 1; i >= 0; i--) {
-            edges[i]->propagate_backward(training, mu, learning_rate, epsilon);
+        for (int32_t i = edge_groups.size() - 1; i >= 0; i--) {
+            CNN_Edge::propagate_backward(edge_groups[i], training, mu, learning_rate, epsilon);
         }
 
         for (int32_t i = 0; i < edges.size(); i++) {
@@ -1854,9 +1987,316 @@ void CNN_Genome::print_progress(
         << weight_decay << endl;
 }
 
-void CNN_Genome::evaluate_large_images(const LargeImages& images, string output_directory) {
-    int current_subimage = 0;
+void CNN_Genome::quantize(const ImagesInterface& calibration_images) {
+    delete quantized;
+    quantized = NULL;
+
+    // the nodes and edges which are evaluated, in the order they are propagated
+    vector<CNN_Node*> evaluated_nodes;
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i]->is_reachable() || nodes[i]->is_input()) {
+            evaluated_nodes.push_back(nodes[i]);
+        }
+    }
+
+    vector<CNN_Edge*> evaluated_edges;
+    for (uint32_t i = 0; i < edge_groups.size(); i++) {
+        for (uint32_t j = 0; j < edge_groups[i].size(); j++) {
+            if (edge_groups[i][j]->is_reachable()) {
+                evaluated_edges.push_back(edge_groups[i][j]);
+            }
+        }
+    }
+
+    // the largest activation of each node over the calibration images, which are evaluated
+    // unquantized
+    int number_images = calibration_images.get_number_images();
+    vector<float> max_activations(evaluated_nodes.size(), 0.0);
+    vector<vector<float> > predictions(number_images, vector<float>(softmax_nodes.size(), 0.0));
+
+    for (int32_t j = 0; j < number_images; j += batch_size) {
+        vector<int> batch;
+        for (int32_t k = 0; k < batch_size && (j + k) < number_images; k++) {
+            batch.push_back(j + k);
+        }
+
+        evaluate_images(calibration_images, batch, predictions, 0);
+
+        for (uint32_t i = 0; i < evaluated_nodes.size(); i++) {
+            CNN_Node* node = evaluated_nodes[i];
+            if (node->is_softmax()) {
+                continue;
+            }
+
+            // the activations of hidden nodes are their values in after the relu and dropout
+            const float* activations = node->is_input() ? node->get_values_out() : node->get_values_in();
+            int32_t size = batch.size() * node->get_size_y() * node->get_size_x();
+
+            for (int32_t current = 0; current < size; current++) {
+                if (fabs(activations[current]) > max_activations[i]) {
+                    max_activations[i] = fabs(activations[current]);
+                }
+            }
+        }
+    }
+
+    float error;
+    int correct_predictions;
+    score_predictions(calibration_images, predictions, error, correct_predictions);
+
+    quantized = new QuantizedCNN(
+        evaluated_nodes, evaluated_edges, input_nodes, softmax_nodes, max_activations, epsilon,
+        input_dropout_probability, hidden_dropout_probability
+    );
+
+    float quantized_error;
+    int quantized_correct_predictions;
+    evaluate(calibration_images, predictions);
+    score_predictions(calibration_images, predictions, quantized_error, quantized_correct_predictions);
+
+    float rate = 100.0 * (float) correct_predictions / (float) number_images;
+    float quantized_rate = 100.0 * (float) quantized_correct_predictions / (float) number_images;
+
+    cout << "quantized genome " << generation_id << " on " << number_images << " calibration images, predictions: "
+         << correct_predictions << " -> " << quantized_correct_predictions << " (" << fixed << setprecision(2) << rate
+         << "% -> " << quantized_rate << "%, delta: " << (quantized_rate - rate) << "%), error: " << setprecision(5)
+         << error << " -> " << quantized_error << " (delta: " << (quantized_error - error) << ")" << endl;
+}
+
+bool CNN_Genome::quantize_from_arguments(const vector<string>& arguments, const ImagesInterface& predicted_images) {
+    if (!argument_exists(arguments, "--quantize")) {
+        return false;
+    }
+
+    string calibration_data;
+    get_argument(arguments, "--calibration_data", true, calibration_data);
+
+    Images calibration_images(
+        calibration_data, padding, predicted_images.get_average(), predicted_images.get_std_dev()
+    );
+    quantize(calibration_images);
+    return true;
+}
+
+bool CNN_Genome::is_quantized() const {
+    return quantized != NULL;
+}
+
+/**
+ * Genomes whose reachable edges are all convolutions with forward filters (no pooling or
+ * reversed filters, which are not translation equivariant) compute the same prediction for a
+ * subimage as their convolutions over the whole large image do at its position, as long as the
+ * subimages are not padded.
+ */
+bool CNN_Genome::is_fully_convolutional(const MultiImagesInterface& images) const {
+    if (images.get_padding() != 0) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        if (edges[i]->is_reachable()
+            && (edges[i]->get_type() != CONVOLUTIONAL || edges[i]->is_reverse_filter_y()
+                || edges[i]->is_reverse_filter_x())) {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
+        if (softmax_nodes[i]->get_size_y() != 1 || softmax_nodes[i]->get_size_x() != 1) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Calculates the predictions of every subimage of a large image at once, by running the
+ * convolutions over the whole large image instead of each subimage, so the values of pixels
+ * shared by neighboring subimages are only calculated once. The nodes' feature maps are as large
+ * as their nodes plus the number of subimages along each dimension; the large image is split
+ * into tiles of subimages so these fit in FULLY_CONVOLUTIONAL_TILE_VALUES.
+ */
+void CNN_Genome::evaluate_large_image_fully_convolutional(
+    const MultiImagesInterface& images, int image_number, float* predictions
+) {
+    int matrix_height = images.get_large_image_height(image_number) - images.get_image_height() + 1;
+    int matrix_width = images.get_large_image_width(image_number) - images.get_image_width() + 1;
+
+    // the largest square tile whose feature maps (values in and out of every node) fit
+    int32_t tile_size = matrix_height > matrix_width ? matrix_height : matrix_width;
+    while (tile_size > 1) {
+        int64_t tile_values = 0;
+        for (uint32_t i = 0; i < nodes.size(); i++) {
+            if (!nodes[i]->is_reachable() && !nodes[i]->is_input()) {
+                continue;
+            }
+            tile_values += 2 * (int64_t) (nodes[i]->get_size_y() + tile_size - 1)
+                           * (int64_t) (nodes[i]->get_size_x() + tile_size - 1);
+        }
+
+        if (tile_values <= FULLY_CONVOLUTIONAL_TILE_VALUES) {
+            break;
+        }
+        tile_size /= 2;
+    }
+
+    map<int, int32_t> node_positions;
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        node_positions[nodes[i]->get_innovation_number()] = i;
+    }
+
+    vector<vector<float> > values_in(nodes.size());
+    vector<vector<float> > values_out(nodes.size());
+    vector<bool> activated(nodes.size());
+
+    for (int32_t tile_y = 0; tile_y < matrix_height; tile_y += tile_size) {
+        for (int32_t tile_x = 0; tile_x < matrix_width; tile_x += tile_size) {
+            // the number of subimages in this tile, the feature maps are this much (less one)
+            // larger than their nodes
+            int32_t extra_y = (tile_y + tile_size > matrix_height ? matrix_height - tile_y : tile_size) - 1;
+            int32_t extra_x = (tile_x + tile_size > matrix_width ? matrix_width - tile_x : tile_size) - 1;
+
+            if (quantized != NULL) {
+                quantized->evaluate_tile(
+                    images, image_number, tile_y, tile_x, extra_y, extra_x, matrix_width, predictions
+                );
+                continue;
+            }
+
+            for (uint32_t i = 0; i < nodes.size(); i++) {
+                if (nodes[i]->is_reachable() || nodes[i]->is_input()) {
+                    int32_t size = (nodes[i]->get_size_y() + extra_y) * (nodes[i]->get_size_x() + extra_x);
+                    values_in[i].assign(size, 0.0);
+                    values_out[i].resize(size);
+                }
+                activated[i] = false;
+            }
+
+            for (uint32_t channel = 0; channel < input_nodes.size(); channel++) {
+                int32_t position = node_positions[input_nodes[channel]->get_innovation_number()];
+                int32_t size_y = input_nodes[channel]->get_size_y() + extra_y;
+                int32_t size_x = input_nodes[channel]->get_size_x() + extra_x;
+
+                float avg = images.get_channel_avg(channel);
+                float std_dev = images.get_channel_std_dev(channel);
+                float dropout_scale = input_dropout_probability > 0 ? 1.0 - input_dropout_probability : 1.0;
+
+                int current = 0;
+                for (int32_t y = 0; y < size_y; y++) {
+                    for (int32_t x = 0; x < size_x; x++) {
+                        float pixel = images.get_raw_pixel(image_number, channel, tile_y + y, tile_x + x);
+                        values_out[position][current] = ((pixel / 255.0) - avg) / std_dev;
+                        values_out[position][current] *= dropout_scale;
+                        current++;
+                    }
+                }
+                activated[position] = true;
+            }
+
+            for (uint32_t i = 0; i < edge_groups.size(); i++) {
+                int32_t input = node_positions[edge_groups[i][0]->get_input_node()->get_innovation_number()];
+
+                // all the edges into a node come before the edges out of it
+                if (!activated[input]) {
+                    nodes[input]->activate_and_normalize(
+                        &values_in[input][0], &values_out[input][0], values_in[input].size(), epsilon,
+                        hidden_dropout_probability
+                    );
+                    activated[input] = true;
+                }
+
+                vector<float*> outputs;
+                for (uint32_t j = 0; j < edge_groups[i].size(); j++) {
+                    outputs.push_back(
+                        &values_in[node_positions[edge_groups[i][j]->get_output_node()->get_innovation_number()]][0]
+                    );
+                }
+
+                CNN_Edge::propagate_forward(edge_groups[i], &values_out[input][0], &outputs[0], extra_y, extra_x);
+            }
+
+            // the softmax nodes' values at each position are the predictions of the subimage there
+            int32_t tile_width = extra_x + 1;
+            for (int32_t y = 0; y <= extra_y; y++) {
+                for (int32_t x = 0; x <= extra_x; x++) {
+                    int32_t current = (y * tile_width) + x;
+                    int32_t subimage = ((tile_y + y) * matrix_width) + tile_x + x;
+                    float* prediction = predictions + (subimage * softmax_nodes.size());
+
+                    float softmax_max = -numeric_limits<float>::max();
+                    for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
+                        int32_t position = node_positions[softmax_nodes[i]->get_innovation_number()];
+                        if (values_in[position][current] > softmax_max) {
+                            softmax_max = values_in[position][current];
+                        }
+                    }
+
+                    float softmax_sum = 0.0;
+                    for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
+                        int32_t position = node_positions[softmax_nodes[i]->get_innovation_number()];
+                        prediction[i] = exact_exp(values_in[position][current] - softmax_max);
+                        softmax_sum += prediction[i];
+                    }
+
+                    for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
+                        prediction[i] /= softmax_sum;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * The predictions of every subimage of a large image, fully convolutionally if the genome and
+ * images allow it, otherwise a batch of subimages at a time.
+ */
+void CNN_Genome::evaluate_large_image(
+    const MultiImagesInterface& images, int image_number, vector<float>& predictions
+) {
+    int number_subimages = images.get_number_subimages(image_number);
+    int32_t number_softmax_nodes = softmax_nodes.size();
+    predictions.resize((size_t) number_subimages * number_softmax_nodes);
+
+    if (is_fully_convolutional(images)) {
+        evaluate_large_image_fully_convolutional(images, image_number, predictions.data());
+        return;
+    }
 
+    int initial_offset = 0;
+    for (int32_t i = 0; i < image_number; i++) {
+        initial_offset += images.get_number_subimages(i);
+    }
+
+    for (int32_t j = 0; j < number_subimages; j += batch_size) {
+        if (j % 10000 == 0) {
+            cout << "subimage: " << j << "/" << number_subimages << endl;
+        }
+
+        vector<int> batch;
+        for (int32_t k = 0; k < batch_size && (j + k) < number_subimages; k++) {
+            batch.push_back(initial_offset + j + k);
+        }
+
+        evaluate_images(images, batch, &predictions[(size_t) j * number_softmax_nodes]);
+    }
+}
+
+void CNN_Genome::evaluate_large_image(
+    const MultiImagesInterface& images, int image_number, vector<vector<float> >& predictions
+) {
+    vector<float> large_image_predictions;
+    evaluate_large_image(images, image_number, large_image_predictions);
+
+    int32_t number_softmax_nodes = softmax_nodes.size();
+    for (int32_t i = 0; i < images.get_number_subimages(image_number); i++) {
+        const float* prediction = &large_image_predictions[(size_t) i * number_softmax_nodes];
+        copy(prediction, prediction + number_softmax_nodes, predictions[i].begin());
+    }
+}
+
+void CNN_Genome::evaluate_large_images(const LargeImages& images, string output_directory) {
     vector<vector<int> > bins(images.get_number_classes(), vector<int>(10, 0));
 
     // cout << "number classes: " << images.get_number_classes() << endl;
@@ -1870,22 +2310,7 @@ void CNN_Genome::evaluate_large_images(const LargeImages& images, string output_
         vector<vector<float> > predictions(number_subimages, vector<float>(images.get_number_classes(), 0.0));
         // cout << "created vector!" << endl;
 
-        for (uint32_t j = 0; j < number_subimages; j += batch_size) {
-            // cout << "image " << image_number << ", number subimages: " << number_subimages << ", batch is: ";
-            vector<int> batch;
-            for (uint32_t k = 0; k < batch_size && (j + k) < number_subimages; k++) {
-                batch.push_back(current_subimage + j + k);
-                // cout << " " << current_subimage + j + k;
-            }
-            // cout << endl;
-
-            // cout << "evaluating images for batch starting at " << j << " with batch size " << batch_size << endl;
-            // float batch_total_error = 0.0;
-            // int batch_correct_predictions = 0;
-            evaluate_images(images, batch, predictions, current_subimage);
-            // cout << "evaluated images!" << endl;
-        }
-        current_subimage += number_subimages;
+        evaluate_large_image(images, image_number, predictions);
 
         // cout << "checking predictions!" << endl;
         int classification = images.get_image_classification(image_number);
@@ -1945,24 +2370,7 @@ void CNN_Genome::get_prediction_matrix(
     cout << "created predictions vector for image: " << image_number << ", number subimages: " << number_subimages
          << ", number_classes: " << number_classes << endl;
 
-    int initial_offset = 0;
-    for (uint32_t i = 0; i < image_number; i++) {
-        initial_offset += images.get_number_subimages(i);
-    }
-    int current_subimage = initial_offset;
-
-    for (uint32_t j = 0; j < number_subimages; j += batch_size) {
-        if (j % 10000 == 0) {
-            cout << "subimage: " << j << "/" << number_subimages << endl;
-        }
-
-        vector<int> batch;
-        for (uint32_t k = 0; k < batch_size && (j + k) < number_subimages; k++) {
-            batch.push_back(current_subimage + j + k);
-        }
-
-        evaluate_images(images, batch, predictions, initial_offset);
-    }
+    evaluate_large_image(images, image_number, predictions);
 
     // now create the prediction matrix to put these predictions into
     int matrix_height =
@@ -2098,16 +2506,26 @@ void CNN_Genome::evaluate(
         edges[i]->reset_times();
     }
 
+    vector<vector<int> > batches;
     for (uint32_t j = 0; j < order.size(); j += batch_size) {
         vector<int> batch;
         for (uint32_t k = 0; k < batch_size && (j + k) < order.size(); k++) {
             batch.push_back(order[j + k]);
         }
+        batches.push_back(batch);
+    }
+
+    // the next batch is fetched in the background while the current one is evaluated
+    BatchPrefetcher prefetcher(images, batches);
+
+    for (uint32_t j = 0; j < batches.size(); j++) {
+        const vector<int>& batch = batches[j];
 
         float batch_total_error = 0.0;
         int batch_correct_predictions = 0;
         evaluate_images(
-            images, batch, training, batch_total_error, batch_correct_predictions, accumulate_test_statistics
+            images, batch, prefetcher.get_next_batch(), training, batch_total_error, batch_correct_predictions,
+            accumulate_test_statistics
         );
 
         /*
@@ -2181,6 +2599,15 @@ void CNN_Genome::evaluate(
 void CNN_Genome::evaluate(
     string progress_name, const ImagesInterface& images, float& total_error, int& correct_predictions
 ) {
+    if (quantized != NULL) {
+        vector<vector<float> > predictions;
+        evaluate(images, predictions);
+        score_predictions(images, predictions, total_error, correct_predictions);
+
+        print_progress(cerr, progress_name, total_error, correct_predictions, images.get_number_images());
+        return;
+    }
+
     backprop_order.clear();
     for (int32_t i = 0; i < images.get_number_images(); i++) {
         backprop_order.push_back(i);
@@ -2258,6 +2685,7 @@ void CNN_Genome::stochastic_backpropagation(
 
     // sort edges by depth of input node
     sort(edges.begin(), edges.end(), sort_CNN_Edges_by_depth());
+    group_edges();
 
     vector<long> validation_order;
     for (uint32_t i = 0; i < number_validation_images; i++) {
@@ -2327,7 +2755,7 @@ void CNN_Genome::stochastic_backpropagation(
         epoch++;
 
         if (checkpoint_filename.compare("") != 0) {
-            write_to_file(checkpoint_filename);
+            write_to_binary_file(checkpoint_filename);
         }
 
         if (progress_function != NULL) {
@@ -2500,6 +2928,7 @@ void CNN_Genome::write(ostream& outfile) {
 
 void CNN_Genome::read(istream& infile) {
     progress_function = NULL;
+    quantized = NULL;
 
     bool verbose = true;
 
@@ -2836,6 +3265,330 @@ void CNN_Genome::write_to_file(string filename) {
     outfile.close();
 }
 
+static void write_binary_string(ostream& out, string s) {
+    int32_t n = (int32_t) s.size();
+    out.write((char*) &n, sizeof(int32_t));
+    out.write(s.data(), n);
+}
+
+static void read_binary_string(istream& in, string& s) {
+    int32_t n;
+    in.read((char*) &n, sizeof(int32_t));
+    s.resize(n);
+    in.read(&s[0], n);
+}
+
+// the 64 bit FNV-1a hash of the payload of a binary checkpoint
+static uint64_t checkpoint_checksum(const string& payload) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint64_t i = 0; i < payload.size(); i++) {
+        hash ^= (uint8_t) payload[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void CNN_Genome::write_binary(ostream& outfile) {
+    ostringstream payload_oss(ios::out | ios::binary);
+
+    write_binary_string(payload_oss, EXACT_VERSION_STR);
+    payload_oss.write((char*) &exact_id, sizeof(int32_t));
+    payload_oss.write((char*) &genome_id, sizeof(int32_t));
+
+    payload_oss.write((char*) &initial_mu, sizeof(float));
+    payload_oss.write((char*) &mu, sizeof(float));
+    payload_oss.write((char*) &mu_delta, sizeof(float));
+
+    payload_oss.write((char*) &initial_learning_rate, sizeof(float));
+    payload_oss.write((char*) &learning_rate, sizeof(float));
+    payload_oss.write((char*) &learning_rate_delta, sizeof(float));
+
+    payload_oss.write((char*) &initial_weight_decay, sizeof(float));
+    payload_oss.write((char*) &weight_decay, sizeof(float));
+    payload_oss.write((char*) &weight_decay_delta, sizeof(float));
+
+    payload_oss.write((char*) &batch_size, sizeof(int32_t));
+
+    payload_oss.write((char*) &epsilon, sizeof(float));
+    payload_oss.write((char*) &alpha, sizeof(float));
+
+    payload_oss.write((char*) &input_dropout_probability, sizeof(float));
+    payload_oss.write((char*) &hidden_dropout_probability, sizeof(float));
+
+    payload_oss.write((char*) &velocity_reset, sizeof(int32_t));
+
+    payload_oss.write((char*) &epoch, sizeof(int32_t));
+    payload_oss.write((char*) &max_epochs, sizeof(int32_t));
+    payload_oss.write((char*) &reset_weights, sizeof(bool));
+
+    payload_oss.write((char*) &padding, sizeof(int32_t));
+
+    payload_oss.write((char*) &best_epoch, sizeof(int32_t));
+    payload_oss.write((char*) &number_validation_images, sizeof(int32_t));
+    payload_oss.write((char*) &best_validation_predictions, sizeof(int32_t));
+    payload_oss.write((char*) &best_validation_error, sizeof(float));
+
+    payload_oss.write((char*) &number_training_images, sizeof(int32_t));
+    payload_oss.write((char*) &training_predictions, sizeof(int32_t));
+    payload_oss.write((char*) &training_error, sizeof(float));
+
+    payload_oss.write((char*) &number_test_images, sizeof(int32_t));
+    payload_oss.write((char*) &test_predictions, sizeof(int32_t));
+    payload_oss.write((char*) &test_error, sizeof(float));
+
+    payload_oss.write((char*) &generation_id, sizeof(int32_t));
+
+    ostringstream normal_distribution_oss;
+    normal_distribution_oss << normal_distribution;
+    write_binary_string(payload_oss, normal_distribution_oss.str());
+
+    ostringstream generator_oss;
+    generator_oss << generator;
+    write_binary_string(payload_oss, generator_oss.str());
+
+    ostringstream generated_by_map_oss;
+    write_map(generated_by_map_oss, generated_by_map);
+    write_binary_string(payload_oss, generated_by_map_oss.str());
+
+    int32_t number_nodes = nodes.size();
+    payload_oss.write((char*) &number_nodes, sizeof(int32_t));
+    for (int32_t i = 0; i < number_nodes; i++) {
+        nodes[i]->write_binary(payload_oss);
+    }
+
+    int32_t number_edges = edges.size();
+    payload_oss.write((char*) &number_edges, sizeof(int32_t));
+    for (int32_t i = 0; i < number_edges; i++) {
+        edges[i]->write_binary(payload_oss);
+    }
+
+    int32_t number_input_nodes = input_nodes.size();
+    payload_oss.write((char*) &number_input_nodes, sizeof(int32_t));
+    for (int32_t i = 0; i < number_input_nodes; i++) {
+        int32_t innovation_number = input_nodes[i]->get_innovation_number();
+        payload_oss.write((char*) &innovation_number, sizeof(int32_t));
+    }
+
+    int32_t number_softmax_nodes = softmax_nodes.size();
+    payload_oss.write((char*) &number_softmax_nodes, sizeof(int32_t));
+    for (int32_t i = 0; i < number_softmax_nodes; i++) {
+        int32_t innovation_number = softmax_nodes[i]->get_innovation_number();
+        payload_oss.write((char*) &innovation_number, sizeof(int32_t));
+    }
+
+    vector<int64_t> order(backprop_order.begin(), backprop_order.end());
+    int32_t order_size = order.size();
+    payload_oss.write((char*) &order_size, sizeof(int32_t));
+    payload_oss.write((char*) order.data(), sizeof(int64_t) * order_size);
+
+    string payload = move(payload_oss).str();
+
+    uint32_t version = CHECKPOINT_VERSION;
+    uint32_t alignment = CHECKPOINT_ALIGNMENT;
+    uint64_t payload_size = payload.size();
+    uint64_t checksum = checkpoint_checksum(payload);
+
+    outfile.write(CHECKPOINT_MAGIC, 8);
+    outfile.write((char*) &version, sizeof(uint32_t));
+    outfile.write((char*) &alignment, sizeof(uint32_t));
+    outfile.write((char*) &payload_size, sizeof(uint64_t));
+    outfile.write((char*) &checksum, sizeof(uint64_t));
+    outfile.write(payload.data(), payload_size);
+}
+
+void CNN_Genome::write_to_binary_file(string filename) {
+    ofstream outfile(filename, ios::out | ios::binary);
+    write_binary(outfile);
+    outfile.close();
+}
+
+void CNN_Genome::read_binary(istream& infile) {
+    progress_function = NULL;
+    quantized = NULL;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t alignment;
+    uint64_t payload_size;
+    uint64_t checksum;
+
+    infile.read(magic, 8);
+    infile.read((char*) &version, sizeof(uint32_t));
+    infile.read((char*) &alignment, sizeof(uint32_t));
+    infile.read((char*) &payload_size, sizeof(uint64_t));
+    infile.read((char*) &checksum, sizeof(uint64_t));
+
+    if (!infile.good() || string(magic, 8).compare(CHECKPOINT_MAGIC) != 0) {
+        cerr << "ERROR: invalid binary checkpoint, it did not start with a '" << CHECKPOINT_MAGIC << "' header" << endl;
+        exit(1);
+    }
+
+    if (version != CHECKPOINT_VERSION || alignment != CHECKPOINT_ALIGNMENT) {
+        cerr << "ERROR: binary checkpoint has format version " << version << " and alignment " << alignment
+             << " but expected format version " << CHECKPOINT_VERSION << " and alignment " << CHECKPOINT_ALIGNMENT
+             << endl;
+        exit(1);
+    }
+
+    string payload(payload_size, '\0');
+    infile.read(&payload[0], payload_size);
+
+    if ((uint64_t) infile.gcount() != payload_size) {
+        cerr << "ERROR: binary checkpoint was truncated, read " << infile.gcount() << " of " << payload_size
+             << " bytes" << endl;
+        exit(1);
+    }
+
+    if (checkpoint_checksum(payload) != checksum) {
+        cerr << "ERROR: binary checkpoint checksum did not match, the checkpoint is corrupt" << endl;
+        exit(1);
+    }
+
+    istringstream payload_iss(move(payload), ios::in | ios::binary);
+
+    read_binary_string(payload_iss, version_str);
+
+    cerr << "read binary CNN_Genome checkpoint with version string: '" << version_str << "'" << endl;
+
+    if (version_str.compare(EXACT_VERSION_STR) != 0) {
+        cerr << "breaking because version_str '" << version_str << "' did not match EXACT_VERSION_STR '"
+             << EXACT_VERSION_STR << "': " << version_str.compare(EXACT_VERSION_STR) << endl;
+        return;
+    }
+
+    payload_iss.read((char*) &exact_id, sizeof(int32_t));
+    payload_iss.read((char*) &genome_id, sizeof(int32_t));
+
+    payload_iss.read((char*) &initial_mu, sizeof(float));
+    payload_iss.read((char*) &mu, sizeof(float));
+    payload_iss.read((char*) &mu_delta, sizeof(float));
+
+    payload_iss.read((char*) &initial_learning_rate, sizeof(float));
+    payload_iss.read((char*) &learning_rate, sizeof(float));
+    payload_iss.read((char*) &learning_rate_delta, sizeof(float));
+
+    payload_iss.read((char*) &initial_weight_decay, sizeof(float));
+    payload_iss.read((char*) &weight_decay, sizeof(float));
+    payload_iss.read((char*) &weight_decay_delta, sizeof(float));
+
+    payload_iss.read((char*) &batch_size, sizeof(int32_t));
+
+    payload_iss.read((char*) &epsilon, sizeof(float));
+    payload_iss.read((char*) &alpha, sizeof(float));
+
+    payload_iss.read((char*) &input_dropout_probability, sizeof(float));
+    payload_iss.read((char*) &hidden_dropout_probability, sizeof(float));
+
+    payload_iss.read((char*) &velocity_reset, sizeof(int32_t));
+
+    payload_iss.read((char*) &epoch, sizeof(int32_t));
+    payload_iss.read((char*) &max_epochs, sizeof(int32_t));
+    payload_iss.read((char*) &reset_weights, sizeof(bool));
+
+    payload_iss.read((char*) &padding, sizeof(int32_t));
+
+    payload_iss.read((char*) &best_epoch, sizeof(int32_t));
+    payload_iss.read((char*) &number_validation_images, sizeof(int32_t));
+    payload_iss.read((char*) &best_validation_predictions, sizeof(int32_t));
+    payload_iss.read((char*) &best_validation_error, sizeof(float));
+
+    payload_iss.read((char*) &number_training_images, sizeof(int32_t));
+    payload_iss.read((char*) &training_predictions, sizeof(int32_t));
+    payload_iss.read((char*) &training_error, sizeof(float));
+
+    payload_iss.read((char*) &number_test_images, sizeof(int32_t));
+    payload_iss.read((char*) &test_predictions, sizeof(int32_t));
+    payload_iss.read((char*) &test_error, sizeof(float));
+
+    payload_iss.read((char*) &generation_id, sizeof(int32_t));
+
+    string normal_distribution_str;
+    read_binary_string(payload_iss, normal_distribution_str);
+    istringstream normal_distribution_iss(normal_distribution_str);
+    normal_distribution_iss >> normal_distribution;
+
+    string generator_str;
+    read_binary_string(payload_iss, generator_str);
+    istringstream generator_iss(generator_str);
+    generator_iss >> generator;
+
+    string generated_by_map_str;
+    read_binary_string(payload_iss, generated_by_map_str);
+    istringstream generated_by_map_iss(generated_by_map_str);
+    generated_by_map.clear();
+    read_map(generated_by_map_iss, generated_by_map);
+
+    nodes.clear();
+    int32_t number_nodes;
+    payload_iss.read((char*) &number_nodes, sizeof(int32_t));
+    for (int32_t i = 0; i < number_nodes; i++) {
+        CNN_Node* node = new CNN_Node();
+        node->read_binary(payload_iss);
+        nodes.push_back(node);
+    }
+
+    edges.clear();
+    int32_t number_edges;
+    payload_iss.read((char*) &number_edges, sizeof(int32_t));
+    for (int32_t i = 0; i < number_edges; i++) {
+        CNN_Edge* edge = new CNN_Edge();
+        edge->read_binary(payload_iss);
+
+        if (!edge->set_nodes(nodes)) {
+            cerr << "ERROR: filter size didn't match when reading genome from binary checkpoint!" << endl;
+            cerr << "This should never happen!" << endl;
+            exit(1);
+        }
+
+        edges.push_back(edge);
+    }
+
+    input_nodes.clear();
+    int32_t number_input_nodes;
+    payload_iss.read((char*) &number_input_nodes, sizeof(int32_t));
+    for (int32_t i = 0; i < number_input_nodes; i++) {
+        int32_t innovation_number;
+        payload_iss.read((char*) &innovation_number, sizeof(int32_t));
+
+        for (uint32_t j = 0; j < nodes.size(); j++) {
+            if (nodes[j]->get_innovation_number() == innovation_number) {
+                input_nodes.push_back(nodes[j]);
+                break;
+            }
+        }
+    }
+
+    softmax_nodes.clear();
+    int32_t number_softmax_nodes;
+    payload_iss.read((char*) &number_softmax_nodes, sizeof(int32_t));
+    for (int32_t i = 0; i < number_softmax_nodes; i++) {
+        int32_t innovation_number;
+        payload_iss.read((char*) &innovation_number, sizeof(int32_t));
+
+        for (uint32_t j = 0; j < nodes.size(); j++) {
+            if (nodes[j]->get_innovation_number() == innovation_number) {
+                softmax_nodes.push_back(nodes[j]);
+                break;
+            }
+        }
+    }
+
+    int32_t order_size;
+    payload_iss.read((char*) &order_size, sizeof(int32_t));
+    vector<int64_t> order(order_size);
+    payload_iss.read((char*) order.data(), sizeof(int64_t) * order_size);
+    backprop_order.assign(order.begin(), order.end());
+
+    if (!payload_iss.good()) {
+        cerr << "ERROR: binary checkpoint payload ended before all of the genome was read" << endl;
+        exit(1);
+    }
+
+    cerr << "read " << number_nodes << " nodes and " << number_edges << " edges from binary checkpoint" << endl;
+
+    visit_nodes();
+}
+
 void CNN_Genome::print_graphviz(ostream& out) const {
     out << "digraph CNN {" << endl;
 
@@ -13,8 +13,10 @@ using std::vector;
 #include "cnn_edge.hxx"
 #include "cnn_node.hxx"
 #include "common/random.hxx"
+#include "image_tools/batch_prefetcher.hxx"
 #include "image_tools/image_set.hxx"
 #include "image_tools/large_image_set.hxx"
+#include "quantized_cnn.hxx"
 
 #define SANITY_CHECK_BEFORE_INSERT    0
 #define SANITY_CHECK_AFTER_GENERATION 1
@@ -22,6 +24,16 @@ using std::vector;
 // mysql can't handl the max float value for some reason
 #define EXACT_MAX_FLOAT 10000000
 
+// the number of values in the feature maps of a tile in fully convolutional inference (1MB, so
+// they stay in cache)
+#define FULLY_CONVOLUTIONAL_TILE_VALUES 262144
+
+// binary checkpoints start with a header of the magic, the format version, the payload's size and
+// its checksum (see CNN_Genome::write_binary)
+#define CHECKPOINT_MAGIC       "EXACTCNN"
+#define CHECKPOINT_VERSION     1
+#define CHECKPOINT_HEADER_SIZE 32
+
 class CNN_Genome {
    private:
     string version_str;
@@ -30,6 +42,8 @@ class CNN_Genome {
 
     vector<CNN_Node*> nodes;
     vector<CNN_Edge*> edges;
+    // the edges in propagation order, with the edges which share a convolution together
+    vector<vector<CNN_Edge*> > edge_groups;
 
     vector<CNN_Node*> input_nodes;
     vector<CNN_Node*> softmax_nodes;
@@ -80,6 +94,12 @@ class CNN_Genome {
     bool started_from_checkpoint;
     vector<long> backprop_order;
 
+    // the values of batches which are not prefetched, from ImagesInterface::get_batch
+    vector<float> batch_values;
+
+    // the predictions of a batch, one softmax value per node for each image in the batch
+    vector<float> batch_predictions;
+
     int generation_id;
     string name;
     string checkpoint_filename;
@@ -89,6 +109,9 @@ class CNN_Genome {
 
     int (*progress_function)(float);
 
+    // the int8 version of the genome used for inference once it has been quantized, otherwise NULL
+    QuantizedCNN* quantized;
+
    public:
     /**
      *  Initialize a genome from a file
@@ -161,6 +184,7 @@ class CNN_Genome {
 
     bool sanity_check(int type);
     bool visit_nodes();
+    void group_edges();
 
     void get_node_copies(vector<CNN_Node*>& node_copies) const;
     void get_edge_copies(vector<CNN_Edge*>& edge_copies) const;
@@ -210,13 +234,20 @@ class CNN_Genome {
 
     void resize_edges_around_node(int node_position);
 
+    void evaluate_images(const ImagesInterface& images, const vector<int>& batch, float* predictions);
     void evaluate_images(
         const ImagesInterface& images, const vector<int>& batch, vector<vector<float> >& predictions, int offset
     );
+    const float* fetch_batch(const ImagesInterface& images, const vector<int>& batch);
+
     void evaluate_images(
         const ImagesInterface& images, const vector<int>& batch, bool training, float& total_error,
         int& correct_predictions, bool accumulate_test_statistics
     );
+    void evaluate_images(
+        const ImagesInterface& images, const vector<int>& batch, const float* batch_values, bool training,
+        float& total_error, int& correct_predictions, bool accumulate_test_statistics
+    );
 
     void set_to_best();
     void save_to_best();
@@ -226,6 +257,38 @@ class CNN_Genome {
 
     void check_gradients(const ImagesInterface& images);
 
+    /**
+     * Quantizes the genome's current weights to int8 for inference (see QuantizedCNN), with the
+     * steps of the nodes' activations calibrated on the images, which should be the validation
+     * images. The predictions of evaluate, evaluate_large_image and the prediction matrices are
+     * then made by the quantized genome, and its error and accuracy on the images are printed
+     * along with how much they changed from the unquantized genome's.
+     */
+    void quantize(const ImagesInterface& calibration_images);
+
+    /**
+     * Quantizes the genome if --quantize was given, calibrating it on the --calibration_data
+     * images normalized with the channel averages and standard deviations of the images it will
+     * predict, so the calibrated steps fit the activations of those predictions. Returns true if
+     * the genome was quantized.
+     */
+    bool quantize_from_arguments(const vector<string>& arguments, const ImagesInterface& predicted_images);
+    bool is_quantized() const;
+
+    bool is_fully_convolutional(const MultiImagesInterface& images) const;
+    void evaluate_large_image_fully_convolutional(
+        const MultiImagesInterface& images, int image_number, float* predictions
+    );
+
+    /**
+     * The predictions of every subimage of a large image, one after another in a single buffer
+     * with a value for each softmax node, so predicting a large image doesn't allocate a vector
+     * for each subimage.
+     */
+    void evaluate_large_image(const MultiImagesInterface& images, int image_number, vector<float>& predictions);
+    void evaluate_large_image(
+        const MultiImagesInterface& images, int image_number, vector<vector<float> >& predictions
+    );
     void evaluate_large_images(const LargeImages& images, string output_directory);
 
     void evaluate(const ImagesInterface& images, vector<vector<float> >& predictions);
@@ -251,6 +314,18 @@ class CNN_Genome {
 
     void read(istream& infile);
 
+    /**
+     * A versioned binary format for checkpoints, which are much faster to write and read than the
+     * hexfloats of write and read. The header (CHECKPOINT_HEADER_SIZE bytes) is followed by the
+     * same fields as write, with the nodes' and edges' float arrays written raw and aligned to
+     * CHECKPOINT_ALIGNMENT bytes, and the payload's FNV-1a checksum is checked when it is read. The
+     * file constructor reads either format, so text genomes are still readable.
+     */
+    void write_binary(ostream& outfile);
+    void write_to_binary_file(string filename);
+
+    void read_binary(istream& infile);
+
     void print_graphviz(ostream& out) const;
 
     void set_generated_by(string type);
@@ -81,6 +81,21 @@ void write_hexfloat(ostream& outfile, float value) {
 #endif
 }
 
+void write_binary_floats(ostream& outfile, const float* values, int32_t count) {
+    const char padding[CHECKPOINT_ALIGNMENT] = {0};
+    int64_t position = outfile.tellp();
+    outfile.write(padding, (CHECKPOINT_ALIGNMENT - (position % CHECKPOINT_ALIGNMENT)) % CHECKPOINT_ALIGNMENT);
+
+    outfile.write((char*) values, sizeof(float) * count);
+}
+
+void read_binary_floats(istream& infile, float* values, int32_t count) {
+    int64_t position = infile.tellg();
+    infile.seekg((CHECKPOINT_ALIGNMENT - (position % CHECKPOINT_ALIGNMENT)) % CHECKPOINT_ALIGNMENT, ios::cur);
+
+    infile.read((char*) values, sizeof(float) * count);
+}
+
 CNN_Node::CNN_Node() {
     node_id = -1;
     exact_id = -1;
@@ -806,35 +821,104 @@ void CNN_Node::print_batch_statistics() {
          << ", running_variance: " << running_variance << ", gamma: " << gamma << ", beta: " << beta << endl;
 }
 
-void CNN_Node::batch_normalize(bool training, bool accumulating_test_statistics, float epsilon, float alpha) {
-    // normalize the batch
+/**
+ * Fills mask with 0 (dropped) or 1 (kept) for each of its values, dropping them with
+ * dropout_probability. The random numbers are drawn in bulk, four 16 bit samples from each
+ * draw of a xorshift64* generator, instead of a (slower) minstd_rand0 draw and a division for
+ * each value. The xorshift generator is seeded from the genome's generator, so the masks are
+ * still reproducible from the genome's seed.
+ */
+static void fill_dropout_mask(float* mask, int32_t size, float dropout_probability, minstd_rand0& generator) {
+    uint64_t state = ((((uint64_t) generator()) << 32) ^ generator()) | 1;
+    uint32_t threshold = dropout_probability * 65536.0;
+
+    for (int32_t current = 0; current < size; current += 4) {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        uint64_t samples = state * 2685821657736338717ULL;
+
+        for (int32_t i = 0; i < 4 && current + i < size; i++) {
+            mask[current + i] = ((samples >> (16 * i)) & 0xffff) < threshold ? 0.0 : 1.0;
+        }
+    }
+}
+
+/**
+ * The (leaky, capped) relu of a value and its gradient, written as selects so the loops
+ * using them can be vectorized.
+ */
+static inline float relu(float value) {
+    return value <= RELU_MIN ? value * (float) RELU_MIN_LEAK : (value > RELU_MAX ? (float) RELU_MAX : value);
+}
+
+static inline float relu_gradient(float value) {
+    return value <= RELU_MIN ? (float) RELU_MIN_LEAK : (value > RELU_MAX ? (float) RELU_MAX_LEAK : 1.0f);
+}
+
+void CNN_Node::activate_and_normalize(
+    bool training, bool accumulating_test_statistics, float epsilon, float alpha, bool perform_dropout,
+    float dropout_probability, minstd_rand0& generator
+) {
+    // the dropout mask is drawn into the relu gradients, which are then multiplied by it; without
+    // a mask the values are scaled by the probability of keeping them instead
+    bool masked = dropout_probability > 0 && perform_dropout && !accumulating_test_statistics;
+    float dropout_scale = dropout_probability > 0 && !masked ? 1.0 - dropout_probability : 1.0;
+    if (masked) {
+        fill_dropout_mask(relu_gradients, total_size, dropout_probability, generator);
+    }
+
+    // local copies of the arrays, so the compiler knows the stores to them do not change them
+    float* values_in = this->values_in;
+    float* values_out = this->values_out;
+    float* relu_gradients = this->relu_gradients;
+
     if (training || accumulating_test_statistics) {
-        batch_mean = 0.0;
+        // first pass: the activation and dropout, and the sums for the batch mean and variance,
+        // which are kept in independent lanes (in double precision, as the variance is
+        // calculated from the sum of squares) so they can be vectorized
+        const int32_t lanes = 8;
+        double sums[lanes];
+        double squares[lanes];
+        for (int32_t lane = 0; lane < lanes; lane++) {
+            sums[lane] = 0.0;
+            squares[lane] = 0.0;
+        }
 
-        // cout << "pre-batch normalization on node: " << innovation_number << endl;
+        for (int32_t start = 0; start < total_size; start += lanes) {
+            int32_t count = total_size - start < lanes ? total_size - start : lanes;
 
-        for (int32_t current = 0; current < total_size; current++) {
-            batch_mean += values_in[current];
+            for (int32_t lane = 0; lane < count; lane++) {
+                int32_t current = start + lane;
+                float value = values_in[current];
+                float mask = relu_gradients[current];
+
+                values_in[current] = relu(value) * (masked ? mask : dropout_scale);
+                relu_gradients[current] = relu_gradient(value) * (masked ? mask : 1.0f);
+
+                sums[lane] += values_in[current];
+                squares[lane] += (double) values_in[current] * values_in[current];
+            }
         }
-        batch_mean /= (uint64_t) batch_size * (uint64_t) size_y * (uint64_t) size_x;
 
-        batch_variance = 0.0;
-        float diff;
-        for (int32_t current = 0; current < total_size; current++) {
-            diff = values_in[current] - batch_mean;
-            batch_variance += diff * diff;
+        double sum = 0.0;
+        double sum_squares = 0.0;
+        for (int32_t lane = 0; lane < lanes; lane++) {
+            sum += sums[lane];
+            sum_squares += squares[lane];
         }
-        batch_variance /= (uint64_t) batch_size * (uint64_t) size_y * (uint64_t) size_x;
+
+        double m = (uint64_t) batch_size * (uint64_t) size_y * (uint64_t) size_x;
+        batch_mean = sum / m;
+        batch_variance = fmax(0.0, (sum_squares / m) - ((sum / m) * (sum / m)));
 
         batch_std_dev = exact_sqrt(batch_variance + epsilon);
 
         inverse_variance = 1.0 / batch_std_dev;
 
-        // cout << endl;
-        // cout << "post-batch normalization on node: " << innovation_number << endl;
-        float temp;
+        // second pass: the normalization
         for (int32_t current = 0; current < total_size; current++) {
-            temp = (values_in[current] - batch_mean) * inverse_variance;
+            float temp = (values_in[current] - batch_mean) * inverse_variance;
             values_in[current] = temp;  // values in becomes x_hat
             values_out[current] = (gamma * temp) + beta;
         }
@@ -857,7 +941,9 @@ void CNN_Node::batch_normalize(bool training, bool accumulating_test_statistics,
                 cout << endl;
             }
 
-            throw runtime_error("batch_normalize resulted in NAN or INF when calculating batch_mean or batch_variance");
+            throw runtime_error(
+                "activate_and_normalize resulted in NAN or INF when calculating batch_mean or batch_variance"
+            );
         }
 #endif
 
@@ -866,85 +952,76 @@ void CNN_Node::batch_normalize(bool training, bool accumulating_test_statistics,
         if (accumulating_test_statistics) {
             running_mean += batch_mean;
             running_variance += batch_variance;
-            // running_mean = (batch_mean * alpha) + ((1.0 - alpha) * running_mean);
-            // running_variance = (batch_variance * alpha) + ((1.0 - alpha) * running_variance);
-
-            // cout << "node " << innovation_number << " accumulating test statistics, batch_mean: " << batch_mean << ",
-            // batch_variance: " << batch_variance << endl;
         } else {
             running_mean = (batch_mean * alpha) + ((1.0 - alpha) * running_mean);
             running_variance = (batch_variance * alpha) + ((1.0 - alpha) * running_variance);
         }
 
-        // cout << "\tnode " << innovation_number << ", batch_mean: " << batch_mean << ", batch_variance: " <<
-        // batch_variance << ", batch_std_dev: " << batch_std_dev << ", running_mean: " << running_mean << ",
-        // running_variance: " << running_variance << endl;
-
     } else {  // testing
         float term1 = gamma / exact_sqrt(running_variance + epsilon);
         float term2 = beta - ((gamma * running_mean) / exact_sqrt(running_variance + epsilon));
 
+        // a single pass, as the normalization uses the running mean and variance
         for (int32_t current = 0; current < total_size; current++) {
+            float value = values_in[current];
+            float mask = relu_gradients[current];
+
+            values_in[current] = relu(value) * (masked ? mask : dropout_scale);
+            relu_gradients[current] = relu_gradient(value) * (masked ? mask : 1.0f);
             values_out[current] = (term1 * values_in[current]) + term2;
+        }
 
 #ifdef NAN_CHECKS
+        for (int32_t current = 0; current < total_size; current++) {
             if (std::isnan(values_out[current]) || std::isinf(values_out[current])) {
-                cerr << "ERROR! NAN or INF batch_mean or batch_variance on node " << innovation_number << "!" << endl;
+                cerr << "ERROR! NAN or INF values_out on node " << innovation_number << "!" << endl;
                 cerr << "values_out[" << current << "]: " << values_out[current] << ", values_in[" << current
                      << "]: " << values_in[current] << endl;
                 cerr << "gamma: " << gamma << ", beta: " << beta << endl;
                 cerr << "term1: " << term1 << ", term2: " << term2 << endl;
 
-                int current = 0;
-                for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
-                    for (int32_t y = 0; y < size_y; y++) {
-                        for (int32_t x = 0; x < size_x; x++) {
-                            cout << setw(10) << std::fixed << values_in[current];
-                            current++;
-                        }
-                        cout << endl;
-                    }
-                    cout << endl;
-                }
-
-                throw runtime_error("batch_normalize resulted in NAN or INF when calculating values_out");
+                throw runtime_error("activate_and_normalize resulted in NAN or INF when calculating values_out");
             }
-#endif
         }
+#endif
     }
 }
 
-void CNN_Node::apply_relu(float* values, float* gradients) {
-    for (int32_t current = 0; current < total_size; current++) {
-        // cout << "values_out for node " << innovation_number << " now " << values_out[batch_number][y][x] << " after
-        // adding bias: " << bias[batch_number][y][x] << endl;
-
-        // apply activation function
-        if (values[current] <= RELU_MIN) {
-            values[current] = values[current] * RELU_MIN_LEAK;
-            gradients[current] = RELU_MIN_LEAK;
-        } else if (values[current] > RELU_MAX) {
-            values[current] = RELU_MAX;
-            gradients[current] = RELU_MAX_LEAK;
-        } else {
-            gradients[current] = 1.0;
-        }
+void CNN_Node::activate_and_normalize(
+    float* values_in, float* values_out, int32_t size, float epsilon, float dropout_probability
+) const {
+    float dropout_scale = dropout_probability > 0 ? 1.0 - dropout_probability : 1.0;
+
+    float term1 = gamma / exact_sqrt(running_variance + epsilon);
+    float term2 = beta - ((gamma * running_mean) / exact_sqrt(running_variance + epsilon));
+
+    for (int32_t current = 0; current < size; current++) {
+        values_in[current] = relu(values_in[current]) * dropout_scale;
+        values_out[current] = (term1 * values_in[current]) + term2;
     }
 }
 
+void CNN_Node::activate(float* values, int32_t size, float dropout_probability) const {
+    float dropout_scale = dropout_probability > 0 ? 1.0 - dropout_probability : 1.0;
+
+    for (int32_t current = 0; current < size; current++) {
+        values[current] = relu(values[current]) * dropout_scale;
+    }
+}
+
+void CNN_Node::get_normalization(float epsilon, float& scale, float& shift) const {
+    scale = gamma / exact_sqrt(running_variance + epsilon);
+    shift = beta - ((gamma * running_mean) / exact_sqrt(running_variance + epsilon));
+}
+
 void CNN_Node::apply_dropout(
     float* values, float* gradients, bool perform_dropout, bool accumulate_test_statistics, float dropout_probability,
     minstd_rand0& generator
 ) {
     if (perform_dropout && !accumulate_test_statistics) {
+        fill_dropout_mask(gradients, total_size, dropout_probability, generator);
         for (int32_t current = 0; current < total_size; current++) {
-            // cout << "values for node " << innovation_number << " now " << values[batch_number][y][x] << " after
-            // adding bias: " << bias[batch_number][y][x] << endl;
-
-            if (random_0_1(generator) < dropout_probability) {
-                values[current] = 0.0;
-                gradients[current] = 0.0;
-            }
+            values[current] *= gradients[current];
         }
 
     } else {
@@ -955,50 +1032,65 @@ void CNN_Node::apply_dropout(
     }
 }
 
-void CNN_Node::backpropagate_relu(float* errors, float* gradients) {
-    for (int32_t current = 0; current < total_size; current++) {
-        errors[current] *= gradients[current];
+void CNN_Node::backpropagate_normalization_and_activation(
+    bool training, float mu, float learning_rate, float epsilon
+) {
+    // backprop  batch normalization here, the first pass sums the terms of the gradients in
+    // independent lanes so it can be vectorized
+    const float* errors_out = this->errors_out;
+    const float* values_in = this->values_in;
+    const float* relu_gradients = this->relu_gradients;
+    float* errors_in = this->errors_in;
+
+    const int32_t lanes = 8;
+    float delta_betas[lanes];
+    float delta_gammas[lanes];
+    float derr_dvariances[lanes];
+    float derr_dmean_term1s[lanes];
+    float derr_dmean_term2s[lanes];
+    for (int32_t lane = 0; lane < lanes; lane++) {
+        delta_betas[lane] = 0.0;
+        delta_gammas[lane] = 0.0;
+        derr_dvariances[lane] = 0.0;
+        derr_dmean_term1s[lane] = 0.0;
+        derr_dmean_term2s[lane] = 0.0;
     }
-}
-
-void CNN_Node::backpropagate_batch_normalization(bool training, float mu, float learning_rate, float epsilon) {
-    // backprop  batch normalization here
-    float delta_beta = 0.0;
-    float delta_gamma = 0.0;
-
-    float value_in;
-    float value_hat;
-    // float value_out;
-    float delta_out;
-    // float delta_values_hat;
-    // float delta_values_hat_sum = 0.0;
-    // float delta_values_hat_x_values_sum = 0.0;
 
-    float derr_dvariance = 0.0;
-    float derr_dmean = 0.0;
+    for (int32_t start = 0; start < total_size; start += lanes) {
+        int32_t count = total_size - start < lanes ? total_size - start : lanes;
 
-    float derr_dmean_term1 = 0.0;
-    float derr_dmean_term2 = 0.0;
-
-    float m = (uint64_t) batch_size * (uint64_t) size_y * (uint64_t) size_x;
-    float diff;
+        for (int32_t lane = 0; lane < count; lane++) {
+            float delta_out = errors_out[start + lane];
+            float value_hat = values_in[start + lane];
 
-    for (int32_t current = 0; current < total_size; current++) {
-        delta_out = errors_out[current];
-        value_hat = values_in[current];
+            float value_in = (value_hat + batch_mean) * batch_std_dev;
+            float diff = value_in - batch_mean;
 
-        value_in = (value_hat + batch_mean) * batch_std_dev;
-        diff = value_in - batch_mean;
+            delta_betas[lane] += delta_out;
+            delta_gammas[lane] += value_hat * delta_out;
 
-        delta_beta += delta_out;
-        delta_gamma += value_hat * delta_out;
+            derr_dvariances[lane] += diff * delta_out * gamma;
 
-        derr_dvariance += diff * delta_out * gamma;
+            derr_dmean_term1s[lane] += delta_out * gamma;
+            derr_dmean_term2s[lane] += diff;
+        }
+    }
 
-        derr_dmean_term1 += delta_out * gamma;
-        derr_dmean_term2 += diff;
+    float delta_beta = 0.0;
+    float delta_gamma = 0.0;
+    float derr_dvariance = 0.0;
+    float derr_dmean_term1 = 0.0;
+    float derr_dmean_term2 = 0.0;
+    for (int32_t lane = 0; lane < lanes; lane++) {
+        delta_beta += delta_betas[lane];
+        delta_gamma += delta_gammas[lane];
+        derr_dvariance += derr_dvariances[lane];
+        derr_dmean_term1 += derr_dmean_term1s[lane];
+        derr_dmean_term2 += derr_dmean_term2s[lane];
     }
 
+    float m = (uint64_t) batch_size * (uint64_t) size_y * (uint64_t) size_x;
+
     float inv_m = 1.0 / m;
     float inv_m_x_2 = 2.0 * inv_m;
 
@@ -1009,20 +1101,27 @@ void CNN_Node::backpropagate_batch_normalization(bool training, float mu, float
 
     derr_dmean_term1 *= -inverse_variance;
     derr_dmean_term2 *= -inv_m_x_2 * derr_dvariance;
-    derr_dmean = derr_dmean_term1 + derr_dmean_term2;
+    float derr_dmean = derr_dmean_term1 + derr_dmean_term2;
+
+    float mean = batch_mean;
+    float std_dev = batch_std_dev;
+    float inverse_std_dev = inverse_variance;
 
+    // the second pass calculates the errors and backpropagates them through the relu (and the
+    // dropout, whose mask is in the relu gradients)
     for (int32_t current = 0; current < total_size; current++) {
-        delta_out = errors_out[current] * relu_gradients[current];
-        value_hat = values_in[current];
-        value_in = (value_hat + batch_mean) * batch_std_dev;
+        float delta_out = errors_out[current] * relu_gradients[current];
+        float value_in = (values_in[current] + mean) * std_dev;
 
-        errors_in[current] = (delta_out * inverse_variance) + (derr_dvariance * inv_m_x_2 * (value_in - batch_mean))
-                             + (derr_dmean * inv_m);
+        float error = (delta_out * inverse_std_dev) + (derr_dvariance * inv_m_x_2 * (value_in - mean))
+                      + (derr_dmean * inv_m);
+        errors_in[current] = error * relu_gradients[current];
+    }
 
 #ifdef NAN_CHECKS
+    for (int32_t current = 0; current < total_size; current++) {
         if (std::isnan(errors_in[current]) || std::isinf(errors_in[current])) {
             cerr << "ERROR! errors_in[" << current << "] became: " << errors_in[current] << "!" << endl;
-            cerr << "value_in: " << value_in << endl;
             cerr << "derr_dmean: " << derr_dmean << endl;
             cerr << "inv_m: " << inv_m << endl;
             cerr << "derr_dvariance: " << derr_dvariance << endl;
@@ -1031,18 +1130,12 @@ void CNN_Node::backpropagate_batch_normalization(bool training, float mu, float
             cerr << "batch_mean: " << batch_mean << endl;
             cerr << "batch_size: " << batch_size << endl;
             cerr << "gamma: " << gamma << endl;
-            cerr << "delta_out: " << delta_out << endl;
             cerr << "values_in[" << current << "]: " << values_in[current] << endl;
 
-            for (int32_t current = 0; current < total_size; current++) {
-                cout << "errors_out[" << current << "]: " << errors_out[current] << ", values_in[" << current
-                     << "]: " << values_in[current] << endl;
-            }
-
-            throw runtime_error("backpropagate_batch_normalization resulted in NAN or INF");
+            throw runtime_error("backpropagate_normalization_and_activation resulted in NAN or INF");
         }
-#endif
     }
+#endif
 
     if (training) {
         // backpropagate beta
@@ -1094,8 +1187,8 @@ void CNN_Node::backpropagate_batch_normalization(bool training, float mu, float
 }
 
 void CNN_Node::set_values(
-    const ImagesInterface& images, const vector<int>& batch, int channel, bool perform_dropout,
-    bool accumulate_test_statistics, float input_dropout_probability, minstd_rand0& generator
+    const ImagesInterface& images, const vector<int>& batch, const float* batch_values, int channel,
+    bool perform_dropout, bool accumulate_test_statistics, float input_dropout_probability, minstd_rand0& generator
 ) {
     // images.size() may be less than batch size, in the case when the total number of images is not divisible by the
     // batch_size
@@ -1122,13 +1215,15 @@ void CNN_Node::set_values(
 
     // images.size() may be less than batch size, in the case when the total number of images is not divisible by the
     // batch_size
-    int current = 0;
+    int32_t channel_size = size_y * size_x;
+    int32_t image_size = images.get_image_channels() * channel_size;
+
     for (int32_t batch_number = 0; batch_number < batch.size(); batch_number++) {
-        for (int32_t y = 0; y < size_y; y++) {
-            for (int32_t x = 0; x < size_x; x++) {
-                values_out[current] = images.get_pixel(batch[batch_number], channel, y, x);
-                current++;
-            }
+        const float* channel_values = batch_values + (batch_number * image_size) + (channel * channel_size);
+        float* node_values = values_out + (batch_number * channel_size);
+
+        for (int32_t current = 0; current < channel_size; current++) {
+            node_values[current] = channel_values[current];
         }
     }
 
@@ -1154,16 +1249,10 @@ void CNN_Node::input_fired(
 
     if (inputs_fired == total_inputs) {
         if (type != SOFTMAX_NODE) {
-            apply_relu(values_in, relu_gradients);
-
-            if (hidden_dropout_probability > 0) {
-                apply_dropout(
-                    values_in, relu_gradients, perform_dropout, accumulate_test_statistics, hidden_dropout_probability,
-                    generator
-                );
-            }
-
-            batch_normalize(training, accumulate_test_statistics, epsilon, alpha);
+            activate_and_normalize(
+                training, accumulate_test_statistics, epsilon, alpha, perform_dropout, hidden_dropout_probability,
+                generator
+            );
         }
 
     } else if (inputs_fired > total_inputs) {
@@ -1195,8 +1284,7 @@ void CNN_Node::output_fired(bool training, float mu, float learning_rate, float
 
     if (outputs_fired == total_outputs) {
         if (type != SOFTMAX_NODE && type != INPUT_NODE) {
-            backpropagate_batch_normalization(training, mu, learning_rate, epsilon);
-            backpropagate_relu(errors_in, relu_gradients);
+            backpropagate_normalization_and_activation(training, mu, learning_rate, epsilon);
         }
 
     } else if (outputs_fired > total_outputs) {
@@ -1403,6 +1491,74 @@ std::istream& operator>>(std::istream& is, CNN_Node* node) {
     return is;
 }
 
+void CNN_Node::write_binary(ostream& outfile) const {
+    outfile.write((char*) &node_id, sizeof(int32_t));
+    outfile.write((char*) &exact_id, sizeof(int32_t));
+    outfile.write((char*) &genome_id, sizeof(int32_t));
+    outfile.write((char*) &innovation_number, sizeof(int32_t));
+    outfile.write((char*) &depth, sizeof(float));
+    outfile.write((char*) &batch_size, sizeof(int32_t));
+    outfile.write((char*) &size_x, sizeof(int32_t));
+    outfile.write((char*) &size_y, sizeof(int32_t));
+    outfile.write((char*) &type, sizeof(int32_t));
+    outfile.write((char*) &weight_count, sizeof(int32_t));
+    outfile.write((char*) &needs_initialization, sizeof(bool));
+    outfile.write((char*) &disabled, sizeof(bool));
+
+    float parameters[10] = {
+        gamma, best_gamma, previous_velocity_gamma, beta, best_beta, previous_velocity_beta, running_mean,
+        best_running_mean, running_variance, best_running_variance
+    };
+    write_binary_floats(outfile, parameters, 10);
+}
+
+void CNN_Node::read_binary(istream& infile) {
+    infile.read((char*) &node_id, sizeof(int32_t));
+    infile.read((char*) &exact_id, sizeof(int32_t));
+    infile.read((char*) &genome_id, sizeof(int32_t));
+    infile.read((char*) &innovation_number, sizeof(int32_t));
+    infile.read((char*) &depth, sizeof(float));
+    infile.read((char*) &batch_size, sizeof(int32_t));
+    infile.read((char*) &size_x, sizeof(int32_t));
+    infile.read((char*) &size_y, sizeof(int32_t));
+    infile.read((char*) &type, sizeof(int32_t));
+    infile.read((char*) &weight_count, sizeof(int32_t));
+    infile.read((char*) &needs_initialization, sizeof(bool));
+    infile.read((char*) &disabled, sizeof(bool));
+
+    total_size = batch_size * size_y * size_x;
+
+    float parameters[10];
+    read_binary_floats(infile, parameters, 10);
+    gamma = parameters[0];
+    best_gamma = parameters[1];
+    previous_velocity_gamma = parameters[2];
+    beta = parameters[3];
+    best_beta = parameters[4];
+    previous_velocity_beta = parameters[5];
+    running_mean = parameters[6];
+    best_running_mean = parameters[7];
+    running_variance = parameters[8];
+    best_running_variance = parameters[9];
+
+    total_inputs = 0;
+    inputs_fired = 0;
+
+    total_outputs = 0;
+    outputs_fired = 0;
+
+    forward_visited = false;
+    reverse_visited = false;
+
+    values_in = new float[total_size]();
+    errors_in = new float[total_size]();
+
+    values_out = new float[total_size]();
+    errors_out = new float[total_size]();
+    relu_gradients = new float[total_size]();
+    pool_gradients = new float[total_size]();
+}
+
 bool CNN_Node::is_identical(const CNN_Node* other, bool testing_checkpoint) {
     if (are_different("node_id", node_id, other->node_id)) {
         return false;
@@ -150,9 +150,14 @@ class CNN_Node {
 
     bool has_nan() const;
 
+    /**
+     * Sets the node's values to a channel of the batch's images, from their values as written by
+     * ImagesInterface::get_batch.
+     */
     void set_values(
-        const ImagesInterface& images, const vector<int>& batch, int channel, bool perform_dropout,
-        bool accumulate_test_statistics, float input_dropout_probability, minstd_rand0& generator
+        const ImagesInterface& images, const vector<int>& batch, const float* batch_values, int channel,
+        bool perform_dropout, bool accumulate_test_statistics, float input_dropout_probability,
+        minstd_rand0& generator
     );
 
     float get_value_in(int batch_number, int y, int x);
@@ -211,16 +216,38 @@ class CNN_Node {
 
     void print_batch_statistics();
 
-    void batch_normalize(bool training, bool accumulating_test_statistics, float epsilon, float alpha);
-    void apply_relu(float* values, float* gradients);
+    /**
+     * The relu, dropout and batch normalization of the node's inputs, fused into one pass over
+     * the values for the activation, dropout and batch statistics and one for the normalization
+     * (or a single pass when testing, which normalizes with the running statistics).
+     */
+    void activate_and_normalize(
+        bool training, bool accumulating_test_statistics, float epsilon, float alpha, bool perform_dropout,
+        float dropout_probability, minstd_rand0& generator
+    );
+
+    /**
+     * The same as activate_and_normalize when testing, for values other than the node's (e.g. a
+     * feature map larger than the node in fully convolutional inference).
+     */
+    void activate_and_normalize(
+        float* values_in, float* values_out, int32_t size, float epsilon, float dropout_probability
+    ) const;
+
+    /**
+     * The relu and dropout of activate_and_normalize when testing without the normalization, and
+     * the scale and shift the normalization then applies to the values (values * scale + shift),
+     * for quantized inference, which folds the normalization into the node's outgoing edges.
+     */
+    void activate(float* values, int32_t size, float dropout_probability) const;
+    void get_normalization(float epsilon, float& scale, float& shift) const;
+
     void apply_dropout(
         float* values, float* gradients, bool perform_dropout, bool accumulate_test_statistics,
         float dropout_probability, minstd_rand0& generator
     );
 
-    // void backpropagate_dropout();
-    void backpropagate_relu(float* errors, float* gradients);
-    void backpropagate_batch_normalization(bool training, float mu, float learning_rate, float epsilon);
+    void backpropagate_normalization_and_activation(bool training, float mu, float learning_rate, float epsilon);
 
     void print_statistics();
     void print_statistics(const float* values, const float* errors, const float* gradients);
@@ -229,11 +256,29 @@ class CNN_Node {
 
     friend ostream& operator<<(ostream& os, const CNN_Node* node);
     friend istream& operator>>(istream& is, CNN_Node* node);
+
+    /**
+     * The same fields as operator<< and operator>>, for binary checkpoints (see
+     * CNN_Genome::write_binary).
+     */
+    void write_binary(ostream& outfile) const;
+    void read_binary(istream& infile);
 };
 
 float read_hexfloat(istream& infile);
 void write_hexfloat(ostream& outfile, float value);
 
+// binary checkpoints start their float arrays at multiples of this many bytes from the start of
+// their payload
+#define CHECKPOINT_ALIGNMENT 32
+
+/**
+ * Writes and reads arrays of floats for binary checkpoints, raw, after padding the stream to the
+ * next multiple of CHECKPOINT_ALIGNMENT (the stream's position 0 is the start of the payload).
+ */
+void write_binary_floats(ostream& outfile, const float* values, int32_t count);
+void read_binary_floats(istream& infile, float* values, int32_t count);
+
 struct sort_CNN_Nodes_by_depth {
     bool operator()(const CNN_Node* n1, const CNN_Node* n2) {
         if (n1->get_depth() < n2->get_depth()) {
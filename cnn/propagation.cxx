@@ -1,18 +1,38 @@
+#include <atomic>
+using std::atomic;
+
 #include <cmath>
+#include <condition_variable>
+using std::condition_variable;
+
+#include <functional>
+using std::function;
+
 #include <iostream>
 
 #include "stdint.h"
 using std::cerr;
+using std::cout;
 using std::endl;
 
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+#include <thread>
+using std::thread;
+
 #include <vector>
 using std::vector;
 
 #include "propagation.hxx"
+#include "propagation_kernels.hxx"
 
-void prop_forward(
-    const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+static void prop_forward_scalar(
+    const float* input, const float* weights, float* output, int32_t batch_size, int32_t batch_start, int32_t batch_end,
+    int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y,
+    int32_t output_size_x
 ) {
     int current_weight, current_output, current_input;
 
@@ -25,7 +45,7 @@ void prop_forward(
 #endif
 
     current_output = 0;
-    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+    for (int32_t batch_number = batch_start; batch_number < batch_end; batch_number++) {
         current_weight = 0;
 
         for (int32_t fy = 0; fy < filter_y; fy++) {
@@ -59,9 +79,10 @@ void prop_forward(
     }
 }
 
-void prop_forward_ry(
-    const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+static void prop_forward_ry_scalar(
+    const float* input, const float* weights, float* output, int32_t batch_size, int32_t batch_start, int32_t batch_end,
+    int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y,
+    int32_t output_size_x
 ) {
     int current_weight, current_output, current_input;
 
@@ -69,7 +90,7 @@ void prop_forward_ry(
     int input_image_size = input_size_y * input_size_x;
     // int width_difference = input_size_x - output_size_x;
 
-    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+    for (int32_t batch_number = batch_start; batch_number < batch_end; batch_number++) {
         current_weight = 0;
 
         for (int32_t fy = 0; fy < filter_y; fy++) {
@@ -89,9 +110,10 @@ void prop_forward_ry(
     }
 }
 
-void prop_forward_rx(
-    const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+static void prop_forward_rx_scalar(
+    const float* input, const float* weights, float* output, int32_t batch_size, int32_t batch_start, int32_t batch_end,
+    int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y,
+    int32_t output_size_x
 ) {
     int current_weight, current_output, current_input;
 
@@ -99,7 +121,7 @@ void prop_forward_rx(
     int input_image_size = input_size_y * input_size_x;
     // int width_difference = input_size_x - output_size_x;
 
-    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+    for (int32_t batch_number = batch_start; batch_number < batch_end; batch_number++) {
         current_weight = 0;
 
         for (int32_t fy = 0; fy < filter_y; fy++) {
@@ -120,9 +142,10 @@ void prop_forward_rx(
     }
 }
 
-void prop_forward_ry_rx(
-    const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y,
-    int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+static void prop_forward_ry_rx_scalar(
+    const float* input, const float* weights, float* output, int32_t batch_size, int32_t batch_start, int32_t batch_end,
+    int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y,
+    int32_t output_size_x
 ) {
     int current_weight, current_output, current_input;
 
@@ -130,7 +153,7 @@ void prop_forward_ry_rx(
     int input_image_size = input_size_y * input_size_x;
     // int width_difference = input_size_x - output_size_x;
 
-    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+    for (int32_t batch_number = batch_start; batch_number < batch_end; batch_number++) {
         current_weight = 0;
 
         for (int32_t fy = 0; fy < filter_y; fy++) {
@@ -150,10 +173,10 @@ void prop_forward_ry_rx(
     }
 }
 
-void prop_backward(
+static void prop_backward_scalar(
     float* output_errors, float* input, float* input_errors, float* weight_updates, float* weights, int32_t batch_size,
-    int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y,
-    int32_t output_size_x
+    int32_t batch_start, int32_t batch_end, int32_t input_size_y, int32_t input_size_x, int32_t filter_y,
+    int32_t filter_x, int32_t output_size_y, int32_t output_size_x
 ) {
     int current_weight, current_output, current_input;
 
@@ -163,7 +186,7 @@ void prop_backward(
 
     float weight_update, weight, delta;
 
-    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+    for (int32_t batch_number = batch_start; batch_number < batch_end; batch_number++) {
         current_weight = 0;
 
         for (int32_t fy = 0; fy < filter_y; fy++) {
@@ -191,10 +214,10 @@ void prop_backward(
     }
 }
 
-void prop_backward_ry(
+static void prop_backward_ry_scalar(
     float* output_errors, float* input, float* input_errors, float* weight_updates, float* weights, int32_t batch_size,
-    int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y,
-    int32_t output_size_x
+    int32_t batch_start, int32_t batch_end, int32_t input_size_y, int32_t input_size_x, int32_t filter_y,
+    int32_t filter_x, int32_t output_size_y, int32_t output_size_x
 ) {
     int current_weight, current_output, current_input;
 
@@ -203,7 +226,7 @@ void prop_backward_ry(
 
     float weight_update, weight, delta;
 
-    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+    for (int32_t batch_number = batch_start; batch_number < batch_end; batch_number++) {
         current_weight = 0;
 
         for (int32_t fy = 0; fy < filter_y; fy++) {
@@ -228,10 +251,10 @@ void prop_backward_ry(
     }
 }
 
-void prop_backward_rx(
+static void prop_backward_rx_scalar(
     float* output_errors, float* input, float* input_errors, float* weight_updates, float* weights, int32_t batch_size,
-    int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y,
-    int32_t output_size_x
+    int32_t batch_start, int32_t batch_end, int32_t input_size_y, int32_t input_size_x, int32_t filter_y,
+    int32_t filter_x, int32_t output_size_y, int32_t output_size_x
 ) {
     int current_weight, current_output, current_input;
 
@@ -240,7 +263,7 @@ void prop_backward_rx(
 
     float weight_update, weight, delta;
 
-    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+    for (int32_t batch_number = batch_start; batch_number < batch_end; batch_number++) {
         current_weight = 0;
 
         for (int32_t fy = 0; fy < filter_y; fy++) {
@@ -265,10 +288,10 @@ void prop_backward_rx(
     }
 }
 
-void prop_backward_ry_rx(
+static void prop_backward_ry_rx_scalar(
     float* output_errors, float* input, float* input_errors, float* weight_updates, float* weights, int32_t batch_size,
-    int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y,
-    int32_t output_size_x
+    int32_t batch_start, int32_t batch_end, int32_t input_size_y, int32_t input_size_x, int32_t filter_y,
+    int32_t filter_x, int32_t output_size_y, int32_t output_size_x
 ) {
     int current_weight, current_output, current_input;
 
@@ -277,7 +300,7 @@ void prop_backward_ry_rx(
 
     float weight_update, weight, delta;
 
-    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+    for (int32_t batch_number = batch_start; batch_number < batch_end; batch_number++) {
         current_weight = 0;
 
         for (int32_t fy = 0; fy < filter_y; fy++) {
@@ -302,8 +325,713 @@ void prop_backward_ry_rx(
     }
 }
 
+/********************************************
+ * KERNEL SELECTION
+ ********************************************/
+
+static int32_t best_propagation_kernels() {
+    if (propagation_kernels_supported(AVX512_KERNELS)) {
+        return AVX512_KERNELS;
+    } else if (propagation_kernels_supported(AVX2_KERNELS)) {
+        return AVX2_KERNELS;
+    } else {
+        return SCALAR_KERNELS;
+    }
+}
+
+bool propagation_kernels_supported(int32_t kernels) {
+    if (kernels == SCALAR_KERNELS) {
+        return true;
+    }
+
+#ifdef VECTORIZED_PROPAGATION
+    __builtin_cpu_init();
+    if (kernels == AVX2_KERNELS) {
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    } else if (kernels == AVX512_KERNELS) {
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("fma");
+    }
+#endif
+
+    return false;
+}
+
+static int32_t propagation_kernels = best_propagation_kernels();
+
+void set_propagation_kernels(int32_t kernels) {
+    if (!propagation_kernels_supported(kernels)) {
+        cerr << "ERROR: propagation kernels " << kernels << " are not supported on this processor" << endl;
+        exit(1);
+    }
+    propagation_kernels = kernels;
+}
+
+int32_t get_propagation_kernels() {
+    return propagation_kernels;
+}
+
+static void dispatch_forward(
+    bool reverse_y, bool reverse_x, const float* input, int32_t number_filters, const float* const* weights,
+    float* const* outputs, int32_t batch_size, int32_t batch_start, int32_t batch_end, int32_t input_size_y,
+    int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+#ifdef VECTORIZED_PROPAGATION
+    if (propagation_kernels == AVX512_KERNELS) {
+        prop_forward_avx512(
+            reverse_y, reverse_x, input, number_filters, weights, outputs, batch_size, batch_start, batch_end,
+            input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+        );
+        return;
+    } else if (propagation_kernels == AVX2_KERNELS) {
+        prop_forward_avx2(
+            reverse_y, reverse_x, input, number_filters, weights, outputs, batch_size, batch_start, batch_end,
+            input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+        );
+        return;
+    }
+#endif
+
+    for (int32_t f = 0; f < number_filters; f++) {
+        if (reverse_y && reverse_x) {
+            prop_forward_ry_rx_scalar(
+                input, weights[f], outputs[f], batch_size, batch_start, batch_end, input_size_y, input_size_x, filter_y,
+                filter_x, output_size_y, output_size_x
+            );
+        } else if (reverse_y) {
+            prop_forward_ry_scalar(
+                input, weights[f], outputs[f], batch_size, batch_start, batch_end, input_size_y, input_size_x, filter_y,
+                filter_x, output_size_y, output_size_x
+            );
+        } else if (reverse_x) {
+            prop_forward_rx_scalar(
+                input, weights[f], outputs[f], batch_size, batch_start, batch_end, input_size_y, input_size_x, filter_y,
+                filter_x, output_size_y, output_size_x
+            );
+        } else {
+            prop_forward_scalar(
+                input, weights[f], outputs[f], batch_size, batch_start, batch_end, input_size_y, input_size_x, filter_y,
+                filter_x, output_size_y, output_size_x
+            );
+        }
+    }
+}
+
+static void dispatch_backward(
+    bool reverse_y, bool reverse_x, int32_t number_filters, float* const* output_errors, float* input,
+    float* input_errors, float* const* weight_updates, float* const* weights, int32_t batch_size, int32_t batch_start,
+    int32_t batch_end, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x,
+    int32_t output_size_y, int32_t output_size_x
+) {
+#ifdef VECTORIZED_PROPAGATION
+    if (propagation_kernels == AVX512_KERNELS) {
+        prop_backward_avx512(
+            reverse_y, reverse_x, number_filters, output_errors, input, input_errors, weight_updates, weights,
+            batch_size, batch_start, batch_end, input_size_y, input_size_x, filter_y, filter_x, output_size_y,
+            output_size_x
+        );
+        return;
+    } else if (propagation_kernels == AVX2_KERNELS) {
+        prop_backward_avx2(
+            reverse_y, reverse_x, number_filters, output_errors, input, input_errors, weight_updates, weights,
+            batch_size, batch_start, batch_end, input_size_y, input_size_x, filter_y, filter_x, output_size_y,
+            output_size_x
+        );
+        return;
+    }
+#endif
+
+    for (int32_t f = 0; f < number_filters; f++) {
+        if (reverse_y && reverse_x) {
+            prop_backward_ry_rx_scalar(
+                output_errors[f], input, input_errors, weight_updates[f], weights[f], batch_size, batch_start,
+                batch_end, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+            );
+        } else if (reverse_y) {
+            prop_backward_ry_scalar(
+                output_errors[f], input, input_errors, weight_updates[f], weights[f], batch_size, batch_start,
+                batch_end, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+            );
+        } else if (reverse_x) {
+            prop_backward_rx_scalar(
+                output_errors[f], input, input_errors, weight_updates[f], weights[f], batch_size, batch_start,
+                batch_end, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+            );
+        } else {
+            prop_backward_scalar(
+                output_errors[f], input, input_errors, weight_updates[f], weights[f], batch_size, batch_start,
+                batch_end, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+            );
+        }
+    }
+}
+
+/********************************************
+ * THREADS
+ ********************************************/
+
+/**
+ * The threads the images of a batch are split across, one image per task. The calling thread
+ * runs tasks as well, so there is one fewer worker than threads. Only one convolution uses the
+ * workers at a time; if they are busy (e.g. with another genome's convolution in exact_mt)
+ * run returns false and the convolution is done on the calling thread.
+ */
+class PropagationThreads {
+   private:
+    vector<thread> workers;
+
+    // held by the convolution using the workers (or while they are resized)
+    mutex busy;
+
+    mutex work_mutex;
+    condition_variable work_ready;
+    condition_variable work_done;
+
+    const function<void(int32_t)>* task;
+    int32_t number_tasks;
+    atomic<int32_t> next_task;
+    int32_t running_workers;
+    int64_t generation;
+    bool stopping;
+
+    void run_tasks() {
+        for (int32_t i = next_task++; i < number_tasks; i = next_task++) {
+            (*task)(i);
+        }
+    }
+
+    void work(int64_t seen_generation) {
+        unique_lock<mutex> lock(work_mutex);
+        while (true) {
+            work_ready.wait(lock, [&] { return stopping || generation != seen_generation; });
+            if (stopping) {
+                return;
+            }
+            seen_generation = generation;
+
+            lock.unlock();
+            run_tasks();
+            lock.lock();
+
+            running_workers--;
+            if (running_workers == 0) {
+                work_done.notify_one();
+            }
+        }
+    }
+
+   public:
+    PropagationThreads()
+        : task(NULL), number_tasks(0), next_task(0), running_workers(0), generation(0), stopping(false) {
+    }
+
+    ~PropagationThreads() {
+        resize(1);
+    }
+
+    int32_t size() const {
+        return workers.size() + 1;
+    }
+
+    void resize(int32_t number_threads) {
+        lock_guard<mutex> busy_lock(busy);
+
+        {
+            lock_guard<mutex> lock(work_mutex);
+            stopping = true;
+        }
+        work_ready.notify_all();
+        for (int32_t i = 0; i < (int32_t) workers.size(); i++) {
+            workers[i].join();
+        }
+        workers.clear();
+
+        stopping = false;
+        for (int32_t i = 1; i < number_threads; i++) {
+            workers.push_back(thread(&PropagationThreads::work, this, generation));
+        }
+    }
+
+    bool run(int32_t count, const function<void(int32_t)>& f) {
+        unique_lock<mutex> busy_lock(busy, std::try_to_lock);
+        if (!busy_lock.owns_lock() || workers.size() == 0) {
+            return false;
+        }
+
+        {
+            lock_guard<mutex> lock(work_mutex);
+            task = &f;
+            number_tasks = count;
+            next_task = 0;
+            running_workers = workers.size();
+            generation++;
+        }
+        work_ready.notify_all();
+
+        run_tasks();
+
+        unique_lock<mutex> lock(work_mutex);
+        work_done.wait(lock, [&] { return running_workers == 0; });
+        return true;
+    }
+};
+
+static PropagationThreads propagation_threads;
+
+void set_propagation_threads(int32_t number_threads) {
+    if (number_threads < 1) {
+        cerr << "ERROR: number of propagation threads must be at least 1, was " << number_threads << endl;
+        exit(1);
+    }
+    propagation_threads.resize(number_threads);
+}
+
+int32_t get_propagation_threads() {
+    return propagation_threads.size();
+}
+
+void prop_forward_filters(
+    bool reverse_y, bool reverse_x, const float* input, int32_t number_filters, const float* const* weights,
+    float* const* outputs, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y,
+    int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+    // each image's outputs only depend on its input, so they can be computed on any thread
+    if (batch_size > 1 && propagation_threads.size() > 1) {
+        bool threaded = propagation_threads.run(batch_size, [&](int32_t batch_number) {
+            dispatch_forward(
+                reverse_y, reverse_x, input, number_filters, weights, outputs, batch_size, batch_number,
+                batch_number + 1, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+            );
+        });
+
+        if (threaded) {
+            return;
+        }
+    }
+
+    dispatch_forward(
+        reverse_y, reverse_x, input, number_filters, weights, outputs, batch_size, 0, batch_size, input_size_y,
+        input_size_x, filter_y, filter_x, output_size_y, output_size_x
+    );
+}
+
+void prop_backward_filters(
+    bool reverse_y, bool reverse_x, int32_t number_filters, float* const* output_errors, float* input,
+    float* input_errors, float* const* weight_updates, float* const* weights, int32_t batch_size,
+    int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y,
+    int32_t output_size_x
+) {
+    if (batch_size > 1 && propagation_threads.size() > 1) {
+        // each image's weight updates are kept separately and then added in the order of the
+        // images, the same as the single threaded kernels add them, so the results do not depend
+        // on the number of threads (or which thread computed which image)
+        int32_t filter_size = filter_y * filter_x;
+        vector<float> image_weight_updates(batch_size * number_filters * filter_size, 0.0);
+
+        bool threaded = propagation_threads.run(batch_size, [&](int32_t batch_number) {
+            vector<float*> updates(number_filters);
+            for (int32_t f = 0; f < number_filters; f++) {
+                updates[f] = &image_weight_updates[((batch_number * number_filters) + f) * filter_size];
+            }
+
+            dispatch_backward(
+                reverse_y, reverse_x, number_filters, output_errors, input, input_errors, &updates[0], weights,
+                batch_size, batch_number, batch_number + 1, input_size_y, input_size_x, filter_y, filter_x,
+                output_size_y, output_size_x
+            );
+        });
+
+        if (threaded) {
+            for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+                for (int32_t f = 0; f < number_filters; f++) {
+                    float* updates = &image_weight_updates[((batch_number * number_filters) + f) * filter_size];
+                    for (int32_t i = 0; i < filter_size; i++) {
+                        weight_updates[f][i] += updates[i];
+                    }
+                }
+            }
+            return;
+        }
+    }
+
+    dispatch_backward(
+        reverse_y, reverse_x, number_filters, output_errors, input, input_errors, weight_updates, weights, batch_size,
+        0, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+    );
+}
+
+void prop_forward(
+    const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y,
+    int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+    prop_forward_filters(
+        false, false, input, 1, &weights, &output, batch_size, input_size_y, input_size_x, filter_y, filter_x,
+        output_size_y, output_size_x
+    );
+}
+
+void prop_forward_ry(
+    const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y,
+    int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+    prop_forward_filters(
+        true, false, input, 1, &weights, &output, batch_size, input_size_y, input_size_x, filter_y, filter_x,
+        output_size_y, output_size_x
+    );
+}
+
+void prop_forward_rx(
+    const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y,
+    int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+    prop_forward_filters(
+        false, true, input, 1, &weights, &output, batch_size, input_size_y, input_size_x, filter_y, filter_x,
+        output_size_y, output_size_x
+    );
+}
+
+void prop_forward_ry_rx(
+    const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y,
+    int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+    prop_forward_filters(
+        true, true, input, 1, &weights, &output, batch_size, input_size_y, input_size_x, filter_y, filter_x,
+        output_size_y, output_size_x
+    );
+}
+
+void prop_backward(
+    float* output_errors, float* input, float* input_errors, float* weight_updates, float* weights, int32_t batch_size,
+    int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y,
+    int32_t output_size_x
+) {
+    prop_backward_filters(
+        false, false, 1, &output_errors, input, input_errors, &weight_updates, &weights, batch_size, input_size_y,
+        input_size_x, filter_y, filter_x, output_size_y, output_size_x
+    );
+}
+
+void prop_backward_ry(
+    float* output_errors, float* input, float* input_errors, float* weight_updates, float* weights, int32_t batch_size,
+    int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y,
+    int32_t output_size_x
+) {
+    prop_backward_filters(
+        true, false, 1, &output_errors, input, input_errors, &weight_updates, &weights, batch_size, input_size_y,
+        input_size_x, filter_y, filter_x, output_size_y, output_size_x
+    );
+}
+
+void prop_backward_rx(
+    float* output_errors, float* input, float* input_errors, float* weight_updates, float* weights, int32_t batch_size,
+    int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y,
+    int32_t output_size_x
+) {
+    prop_backward_filters(
+        false, true, 1, &output_errors, input, input_errors, &weight_updates, &weights, batch_size, input_size_y,
+        input_size_x, filter_y, filter_x, output_size_y, output_size_x
+    );
+}
+
+void prop_backward_ry_rx(
+    float* output_errors, float* input, float* input_errors, float* weight_updates, float* weights, int32_t batch_size,
+    int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y,
+    int32_t output_size_x
+) {
+    prop_backward_filters(
+        true, true, 1, &output_errors, input, input_errors, &weight_updates, &weights, batch_size, input_size_y,
+        input_size_x, filter_y, filter_x, output_size_y, output_size_x
+    );
+}
+
 #ifdef PROPAGATE_TEST
+#include <random>
+using std::minstd_rand0;
+using std::uniform_real_distribution;
+
+#include <string>
+using std::string;
+
+void fill_random(vector<float>& values, int32_t size, minstd_rand0& generator) {
+    uniform_real_distribution<float> distribution(-1.0, 1.0);
+    values.resize(size);
+    for (int32_t i = 0; i < size; i++) {
+        values[i] = distribution(generator);
+    }
+}
+
+bool compare(string name, const vector<float>& expected, const vector<float>& actual) {
+    for (int32_t i = 0; i < (int32_t) expected.size(); i++) {
+        float scale = fmax(1.0, fmax(fabs(expected[i]), fabs(actual[i])));
+        if (fabs(expected[i] - actual[i]) > 1e-4 * scale) {
+            cerr << "    " << name << "[" << i << "] was " << actual[i] << ", expected " << expected[i] << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Runs one of the 8 convolve operations with the scalar kernels and the given kernels on the
+ * same random values (accumulating into random outputs and errors, as the edges do) and
+ * checks the results are the same within float tolerance.
+ */
+bool test_convolution(
+    int32_t kernels, bool reverse_y, bool reverse_x, int32_t batch_size, int32_t input_size_y, int32_t input_size_x,
+    int32_t filter_y, int32_t filter_x, minstd_rand0& generator
+) {
+    int32_t output_size_y = reverse_y ? input_size_y + filter_y - 1 : input_size_y - filter_y + 1;
+    int32_t output_size_x = reverse_x ? input_size_x + filter_x - 1 : input_size_x - filter_x + 1;
+
+    vector<float> input, weights, output, output_errors, input_errors, weight_updates;
+    fill_random(input, batch_size * input_size_y * input_size_x, generator);
+    fill_random(weights, filter_y * filter_x, generator);
+    fill_random(output, batch_size * output_size_y * output_size_x, generator);
+    fill_random(output_errors, batch_size * output_size_y * output_size_x, generator);
+    fill_random(input_errors, batch_size * input_size_y * input_size_x, generator);
+    fill_random(weight_updates, filter_y * filter_x, generator);
+
+    vector<vector<float> > outputs(2, output);
+    vector<vector<float> > all_input_errors(2, input_errors);
+    vector<vector<float> > all_weight_updates(2, weight_updates);
+
+    for (int32_t i = 0; i < 2; i++) {
+        set_propagation_kernels(i == 0 ? SCALAR_KERNELS : kernels);
+
+        void (*forward)(
+            const float*, const float*, float*, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t
+        );
+        void (*backward)(
+            float*, float*, float*, float*, float*, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t
+        );
+
+        if (reverse_y && reverse_x) {
+            forward = prop_forward_ry_rx;
+            backward = prop_backward_ry_rx;
+        } else if (reverse_y) {
+            forward = prop_forward_ry;
+            backward = prop_backward_ry;
+        } else if (reverse_x) {
+            forward = prop_forward_rx;
+            backward = prop_backward_rx;
+        } else {
+            forward = prop_forward;
+            backward = prop_backward;
+        }
+
+        forward(
+            &input[0], &weights[0], &outputs[i][0], batch_size, input_size_y, input_size_x, filter_y, filter_x,
+            output_size_y, output_size_x
+        );
+        backward(
+            &output_errors[0], &input[0], &all_input_errors[i][0], &all_weight_updates[i][0], &weights[0], batch_size,
+            input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+        );
+    }
+
+    bool passed = compare("output", outputs[0], outputs[1])
+                  && compare("input_errors", all_input_errors[0], all_input_errors[1])
+                  && compare("weight_updates", all_weight_updates[0], all_weight_updates[1]);
+
+    cout << (passed ? "passed: " : "FAILED: ") << "reverse_y: " << reverse_y << ", reverse_x: " << reverse_x
+         << ", batch_size: " << batch_size << ", input: " << input_size_y << "x" << input_size_x
+         << ", filter: " << filter_y << "x" << filter_x << endl;
+    return passed;
+}
+
+/**
+ * Runs the convolutions of one input with number_filters filters with the scalar kernels (one
+ * filter at a time) and the given kernels on the same random values and checks the results are
+ * the same within float tolerance.
+ */
+bool test_filters(
+    int32_t kernels, bool reverse_y, bool reverse_x, int32_t number_filters, int32_t batch_size, int32_t input_size_y,
+    int32_t input_size_x, int32_t filter_y, int32_t filter_x, minstd_rand0& generator
+) {
+    int32_t output_size_y = reverse_y ? input_size_y + filter_y - 1 : input_size_y - filter_y + 1;
+    int32_t output_size_x = reverse_x ? input_size_x + filter_x - 1 : input_size_x - filter_x + 1;
+    int32_t output_size = batch_size * output_size_y * output_size_x;
+
+    vector<float> input, input_errors;
+    fill_random(input, batch_size * input_size_y * input_size_x, generator);
+    fill_random(input_errors, batch_size * input_size_y * input_size_x, generator);
+
+    vector<vector<float> > weights(number_filters), output_errors(number_filters);
+    vector<vector<vector<float> > > outputs(2, vector<vector<float> >(number_filters));
+    vector<vector<vector<float> > > all_weight_updates(2, vector<vector<float> >(number_filters));
+    for (int32_t f = 0; f < number_filters; f++) {
+        fill_random(weights[f], filter_y * filter_x, generator);
+        fill_random(output_errors[f], output_size, generator);
+        fill_random(outputs[0][f], output_size, generator);
+        fill_random(all_weight_updates[0][f], filter_y * filter_x, generator);
+    }
+    outputs[1] = outputs[0];
+    all_weight_updates[1] = all_weight_updates[0];
+    vector<vector<float> > all_input_errors(2, input_errors);
+
+    for (int32_t i = 0; i < 2; i++) {
+        set_propagation_kernels(i == 0 ? SCALAR_KERNELS : kernels);
+
+        vector<float*> weight_pointers, output_pointers, output_error_pointers, weight_update_pointers;
+        for (int32_t f = 0; f < number_filters; f++) {
+            weight_pointers.push_back(&weights[f][0]);
+            output_pointers.push_back(&outputs[i][f][0]);
+            output_error_pointers.push_back(&output_errors[f][0]);
+            weight_update_pointers.push_back(&all_weight_updates[i][f][0]);
+        }
+
+        prop_forward_filters(
+            reverse_y, reverse_x, &input[0], number_filters, &weight_pointers[0], &output_pointers[0], batch_size,
+            input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+        );
+        prop_backward_filters(
+            reverse_y, reverse_x, number_filters, &output_error_pointers[0], &input[0], &all_input_errors[i][0],
+            &weight_update_pointers[0], &weight_pointers[0], batch_size, input_size_y, input_size_x, filter_y,
+            filter_x, output_size_y, output_size_x
+        );
+    }
+
+    bool passed = compare("input_errors", all_input_errors[0], all_input_errors[1]);
+    for (int32_t f = 0; f < number_filters; f++) {
+        passed = passed && compare("output", outputs[0][f], outputs[1][f])
+                 && compare("weight_updates", all_weight_updates[0][f], all_weight_updates[1][f]);
+    }
+
+    cout << (passed ? "passed: " : "FAILED: ") << number_filters << " filters, reverse_y: " << reverse_y
+         << ", reverse_x: " << reverse_x << ", batch_size: " << batch_size << ", input: " << input_size_y << "x"
+         << input_size_x << ", filter: " << filter_y << "x" << filter_x << endl;
+    return passed;
+}
+
+/**
+ * Runs the convolutions of one input with number_filters filters on 1 and number_threads threads
+ * with the given kernels, and checks the results are exactly the same.
+ */
+bool test_threads(
+    int32_t kernels, int32_t number_threads, bool reverse_y, bool reverse_x, int32_t number_filters,
+    int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x,
+    minstd_rand0& generator
+) {
+    int32_t output_size_y = reverse_y ? input_size_y + filter_y - 1 : input_size_y - filter_y + 1;
+    int32_t output_size_x = reverse_x ? input_size_x + filter_x - 1 : input_size_x - filter_x + 1;
+    int32_t output_size = batch_size * output_size_y * output_size_x;
+
+    vector<float> input, weights, output_errors;
+    fill_random(input, batch_size * input_size_y * input_size_x, generator);
+    fill_random(weights, number_filters * filter_y * filter_x, generator);
+    fill_random(output_errors, number_filters * output_size, generator);
+
+    vector<vector<float> > outputs(2), input_errors(2), weight_updates(2);
+    fill_random(outputs[0], number_filters * output_size, generator);
+    fill_random(input_errors[0], batch_size * input_size_y * input_size_x, generator);
+    fill_random(weight_updates[0], number_filters * filter_y * filter_x, generator);
+    outputs[1] = outputs[0];
+    input_errors[1] = input_errors[0];
+    weight_updates[1] = weight_updates[0];
+
+    set_propagation_kernels(kernels);
+    for (int32_t i = 0; i < 2; i++) {
+        set_propagation_threads(i == 0 ? 1 : number_threads);
+
+        vector<float*> weight_pointers, output_pointers, output_error_pointers, weight_update_pointers;
+        for (int32_t f = 0; f < number_filters; f++) {
+            weight_pointers.push_back(&weights[f * filter_y * filter_x]);
+            output_pointers.push_back(&outputs[i][f * output_size]);
+            output_error_pointers.push_back(&output_errors[f * output_size]);
+            weight_update_pointers.push_back(&weight_updates[i][f * filter_y * filter_x]);
+        }
+
+        prop_forward_filters(
+            reverse_y, reverse_x, &input[0], number_filters, &weight_pointers[0], &output_pointers[0], batch_size,
+            input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+        );
+        prop_backward_filters(
+            reverse_y, reverse_x, number_filters, &output_error_pointers[0], &input[0], &input_errors[i][0],
+            &weight_update_pointers[0], &weight_pointers[0], batch_size, input_size_y, input_size_x, filter_y,
+            filter_x, output_size_y, output_size_x
+        );
+    }
+    set_propagation_threads(1);
+
+    bool passed =
+        outputs[0] == outputs[1] && input_errors[0] == input_errors[1] && weight_updates[0] == weight_updates[1];
+
+    cout << (passed ? "passed: " : "FAILED: ") << number_threads << " threads, kernels " << kernels << ", "
+         << number_filters << " filters, reverse_y: " << reverse_y << ", reverse_x: " << reverse_x
+         << ", batch_size: " << batch_size << ", input: " << input_size_y << "x" << input_size_x
+         << ", filter: " << filter_y << "x" << filter_x << endl;
+    return passed;
+}
+
 int main(int argc, char** argv) {
-    // make tests for the 8 convolve operations
+    minstd_rand0 generator(1337);
+
+    // image and filter sizes covering full vector blocks, single vectors and the scalar remainders
+    vector<vector<int32_t> > sizes = {{1, 1, 1, 1},   {3, 5, 2, 2},   {7, 9, 3, 3},    {16, 16, 5, 5},
+                                      {28, 28, 1, 7}, {32, 33, 7, 1}, {40, 70, 5, 3},  {64, 64, 3, 9},
+                                      {9, 100, 4, 4}, {2, 80, 2, 17}, {130, 20, 11, 6}, {50, 150, 6, 14}};
+
+    bool passed = true;
+    vector<int32_t> all_kernels = {AVX2_KERNELS, AVX512_KERNELS};
+    for (int32_t kernels : all_kernels) {
+        if (!propagation_kernels_supported(kernels)) {
+            cout << "kernels " << kernels << " are not supported on this processor, skipping them" << endl;
+            continue;
+        }
+
+        cout << "testing kernels " << kernels << " against the scalar kernels:" << endl;
+        for (int32_t i = 0; i < (int32_t) sizes.size(); i++) {
+            for (int32_t reverse = 0; reverse < 4; reverse++) {
+                bool reverse_y = reverse & 1;
+                bool reverse_x = reverse & 2;
+
+                // the reversed filters go from the smaller image to the larger one
+                int32_t input_size_y = sizes[i][0];
+                int32_t input_size_x = sizes[i][1];
+                if (!reverse_y) {
+                    input_size_y += sizes[i][2] - 1;
+                }
+                if (!reverse_x) {
+                    input_size_x += sizes[i][3] - 1;
+                }
+
+                passed = test_convolution(
+                             kernels, reverse_y, reverse_x, 1 + (i % 3), input_size_y, input_size_x, sizes[i][2],
+                             sizes[i][3], generator
+                         )
+                         && passed;
+
+                // grouped filters of up to four at a time and the remaining filters
+                passed = test_filters(
+                             kernels, reverse_y, reverse_x, 2 + (i % 6), 1 + (i % 3), input_size_y, input_size_x,
+                             sizes[i][2], sizes[i][3], generator
+                         )
+                         && passed;
+            }
+        }
+    }
+
+    if (!passed) {
+        cerr << "ERROR: the vectorized kernels did not match the scalar kernels" << endl;
+        return 1;
+    }
+
+    cout << "testing multithreaded convolutions against single threaded ones:" << endl;
+    vector<int32_t> threaded_kernels = {SCALAR_KERNELS, AVX2_KERNELS, AVX512_KERNELS};
+    for (int32_t kernels : threaded_kernels) {
+        if (!propagation_kernels_supported(kernels)) {
+            continue;
+        }
+
+        for (int32_t reverse = 0; reverse < 4; reverse++) {
+            passed = test_threads(kernels, 3, reverse & 1, reverse & 2, 5, 7, 20, 24, 5, 5, generator) && passed;
+            passed = test_threads(kernels, 8, reverse & 1, reverse & 2, 1, 25, 9, 40, 3, 7, generator) && passed;
+        }
+    }
+
+    if (!passed) {
+        cerr << "ERROR: the multithreaded convolutions did not match the single threaded ones" << endl;
+        return 1;
+    }
+    return 0;
 }
 #endif
@@ -6,6 +6,45 @@
 #include "stdint.h"
 using std::vector;
 
+#define SCALAR_KERNELS 0
+#define AVX2_KERNELS   1
+#define AVX512_KERNELS 2
+
+/**
+ * The convolutions below use the fastest kernels the processor supports: the AVX-512 or AVX2
+ * kernels (if they were compiled in, see propagation_kernels.hxx) or otherwise the scalar loops.
+ * set_propagation_kernels selects them explicitly, e.g. to compare them.
+ */
+bool propagation_kernels_supported(int32_t kernels);
+void set_propagation_kernels(int32_t kernels);
+int32_t get_propagation_kernels();
+
+/**
+ * The number of threads (including the calling one) the images of a batch are split across in
+ * the convolutions, 1 by default. The results are the same for any number of threads.
+ */
+void set_propagation_threads(int32_t number_threads);
+int32_t get_propagation_threads();
+
+/**
+ * The convolutions of one input with several filters, e.g. all the edges out of a node with the
+ * same filter sizes, reversed filter directions and output sizes. The vectorized kernels compute
+ * them together, so each input image is read once for all the filters, and the backward pass
+ * sums all their input errors into each input error value at once.
+ */
+void prop_forward_filters(
+    bool reverse_y, bool reverse_x, const float* input, int32_t number_filters, const float* const* weights,
+    float* const* outputs, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y,
+    int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+);
+
+void prop_backward_filters(
+    bool reverse_y, bool reverse_x, int32_t number_filters, float* const* output_errors, float* input,
+    float* input_errors, float* const* weight_updates, float* const* weights, int32_t batch_size,
+    int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y,
+    int32_t output_size_x
+);
+
 void prop_forward(
     const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y,
     int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
@@ -0,0 +1,73 @@
+#include <immintrin.h>
+
+#include "propagation_kernels.hxx"
+
+// compiled with -mavx2 -mfma, only called if the processor supports them
+
+struct Avx2Vector {
+    typedef __m256 type;
+    static const int32_t width = 8;
+
+    static inline type zero() {
+        return _mm256_setzero_ps();
+    }
+
+    static inline type set(float value) {
+        return _mm256_set1_ps(value);
+    }
+
+    static inline type load(const float* values) {
+        return _mm256_loadu_ps(values);
+    }
+
+    static inline void store(float* values, type v) {
+        _mm256_storeu_ps(values, v);
+    }
+
+    static inline __m256i mask(int32_t count) {
+        static const int32_t masks[16] = {-1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0};
+        return _mm256_loadu_si256((const __m256i*) (masks + 8 - count));
+    }
+
+    static inline type load_partial(const float* values, int32_t count) {
+        return _mm256_maskload_ps(values, mask(count));
+    }
+
+    static inline void store_partial(float* values, type v, int32_t count) {
+        _mm256_maskstore_ps(values, mask(count), v);
+    }
+
+    static inline type multiply_add(type a, type b, type c) {
+        return _mm256_fmadd_ps(a, b, c);
+    }
+
+    static inline float sum(type v) {
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+        return _mm_cvtss_f32(sum);
+    }
+};
+
+void prop_forward_avx2(
+    bool reverse_y, bool reverse_x, const float* input, int32_t number_filters, const float* const* weights,
+    float* const* outputs, int32_t batch_size, int32_t batch_start, int32_t batch_end, int32_t input_size_y,
+    int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+    forward_kernel<Avx2Vector>(
+        reverse_y, reverse_x, input, number_filters, weights, outputs, batch_size, batch_start, batch_end, input_size_y,
+        input_size_x, filter_y, filter_x, output_size_y, output_size_x
+    );
+}
+
+void prop_backward_avx2(
+    bool reverse_y, bool reverse_x, int32_t number_filters, const float* const* output_errors, const float* input,
+    float* input_errors, float* const* weight_updates, const float* const* weights, int32_t batch_size,
+    int32_t batch_start, int32_t batch_end, int32_t input_size_y, int32_t input_size_x, int32_t filter_y,
+    int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+    backward_kernel<Avx2Vector>(
+        reverse_y, reverse_x, number_filters, output_errors, input, input_errors, weight_updates, weights, batch_size,
+        batch_start, batch_end, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+    );
+}
@@ -0,0 +1,74 @@
+#include <immintrin.h>
+
+#include "propagation_kernels.hxx"
+
+// compiled with -mavx512f -mfma, only called if the processor supports them
+
+struct Avx512Vector {
+    typedef __m512 type;
+    static const int32_t width = 16;
+
+    static inline type zero() {
+        return _mm512_setzero_ps();
+    }
+
+    static inline type set(float value) {
+        return _mm512_set1_ps(value);
+    }
+
+    static inline type load(const float* values) {
+        return _mm512_loadu_ps(values);
+    }
+
+    static inline void store(float* values, type v) {
+        _mm512_storeu_ps(values, v);
+    }
+
+    static inline type load_partial(const float* values, int32_t count) {
+        return _mm512_maskz_loadu_ps((__mmask16) ((1 << count) - 1), values);
+    }
+
+    static inline void store_partial(float* values, type v, int32_t count) {
+        _mm512_mask_storeu_ps(values, (__mmask16) ((1 << count) - 1), v);
+    }
+
+    static inline type multiply_add(type a, type b, type c) {
+        return _mm512_fmadd_ps(a, b, c);
+    }
+
+    static inline float sum(type v) {
+        // only used once per weight, so a store is simpler than the shuffles (whose
+        // intrinsics trip -Wmaybe-uninitialized in some GCC versions)
+        float values[width];
+        _mm512_storeu_ps(values, v);
+
+        float sum = 0.0;
+        for (int32_t i = 0; i < width; i++) {
+            sum += values[i];
+        }
+        return sum;
+    }
+};
+
+void prop_forward_avx512(
+    bool reverse_y, bool reverse_x, const float* input, int32_t number_filters, const float* const* weights,
+    float* const* outputs, int32_t batch_size, int32_t batch_start, int32_t batch_end, int32_t input_size_y,
+    int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+    forward_kernel<Avx512Vector>(
+        reverse_y, reverse_x, input, number_filters, weights, outputs, batch_size, batch_start, batch_end, input_size_y,
+        input_size_x, filter_y, filter_x, output_size_y, output_size_x
+    );
+}
+
+void prop_backward_avx512(
+    bool reverse_y, bool reverse_x, int32_t number_filters, const float* const* output_errors, const float* input,
+    float* input_errors, float* const* weight_updates, const float* const* weights, int32_t batch_size,
+    int32_t batch_start, int32_t batch_end, int32_t input_size_y, int32_t input_size_x, int32_t filter_y,
+    int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+    backward_kernel<Avx512Vector>(
+        reverse_y, reverse_x, number_filters, output_errors, input, input_errors, weight_updates, weights, batch_size,
+        batch_start, batch_end, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+    );
+}
@@ -0,0 +1,572 @@
+#ifndef CNN_PROPAGATION_KERNELS_H
+#define CNN_PROPAGATION_KERNELS_H
+
+#include "stdint.h"
+
+/**
+ * The vectorized convolution kernels used by prop_forward_filters and prop_backward_filters (and
+ * the single filter convolutions) when the processor supports them. They are compiled once per
+ * instruction set (propagation_avx2.cxx and propagation_avx512.cxx), each of which
+ * instantiates the templates below with its own vector type. Everything here is a template
+ * of the vector type, and they do not use the standard library's templates, so no code compiled
+ * for one instruction set is shared with (and possibly linked into) the scalar code.
+ */
+
+void prop_forward_avx2(
+    bool reverse_y, bool reverse_x, const float* input, int32_t number_filters, const float* const* weights,
+    float* const* outputs, int32_t batch_size, int32_t batch_start, int32_t batch_end, int32_t input_size_y,
+    int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+);
+
+void prop_backward_avx2(
+    bool reverse_y, bool reverse_x, int32_t number_filters, const float* const* output_errors, const float* input,
+    float* input_errors, float* const* weight_updates, const float* const* weights, int32_t batch_size,
+    int32_t batch_start, int32_t batch_end, int32_t input_size_y, int32_t input_size_x, int32_t filter_y,
+    int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+);
+
+void prop_forward_avx512(
+    bool reverse_y, bool reverse_x, const float* input, int32_t number_filters, const float* const* weights,
+    float* const* outputs, int32_t batch_size, int32_t batch_start, int32_t batch_end, int32_t input_size_y,
+    int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+);
+
+void prop_backward_avx512(
+    bool reverse_y, bool reverse_x, int32_t number_filters, const float* const* output_errors, const float* input,
+    float* input_errors, float* const* weight_updates, const float* const* weights, int32_t batch_size,
+    int32_t batch_start, int32_t batch_end, int32_t input_size_y, int32_t input_size_x, int32_t filter_y,
+    int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+);
+
+/**
+ * Adds the filter taps of FILTERS filters to VECTORS vectors of consecutive values of each of
+ * their outputs, which are kept in registers while every tap is added to them, so each output
+ * value is read and written once instead of once per tap, and each input vector is loaded once
+ * for all the filters. input points to the input value of the first tap for the first output
+ * value (outputs[f] + x), and the filter rows step through the input by row_step (which is
+ * negative for a reversed filter y) and the filter columns by column_step. If PARTIAL, the last
+ * vector only has last values.
+ */
+template <class V, int32_t VECTORS, int32_t FILTERS, bool PARTIAL>
+inline void scatter_block(
+    float* const* outputs, int32_t x, const float* input, int32_t row_step, int32_t column_step,
+    const float* const* filters, int32_t filter_rows, int32_t filter_x, int32_t last
+) {
+    typename V::type sums[FILTERS][VECTORS];
+    for (int32_t f = 0; f < FILTERS; f++) {
+        for (int32_t v = 0; v < VECTORS; v++) {
+            if (PARTIAL && v == VECTORS - 1) {
+                sums[f][v] = V::load_partial(outputs[f] + x + (v * V::width), last);
+            } else {
+                sums[f][v] = V::load(outputs[f] + x + (v * V::width));
+            }
+        }
+    }
+
+    for (int32_t fy = 0; fy < filter_rows; fy++) {
+        const float* input_row = input + (fy * row_step);
+
+        for (int32_t fx = 0; fx < filter_x; fx++) {
+            const float* current_input = input_row + (fx * column_step);
+
+            typename V::type values[VECTORS];
+            for (int32_t v = 0; v < VECTORS; v++) {
+                if (PARTIAL && v == VECTORS - 1) {
+                    values[v] = V::load_partial(current_input + (v * V::width), last);
+                } else {
+                    values[v] = V::load(current_input + (v * V::width));
+                }
+            }
+
+            for (int32_t f = 0; f < FILTERS; f++) {
+                typename V::type weight = V::set(filters[f][(fy * filter_x) + fx]);
+                for (int32_t v = 0; v < VECTORS; v++) {
+                    sums[f][v] = V::multiply_add(weight, values[v], sums[f][v]);
+                }
+            }
+        }
+    }
+
+    for (int32_t f = 0; f < FILTERS; f++) {
+        for (int32_t v = 0; v < VECTORS; v++) {
+            if (PARTIAL && v == VECTORS - 1) {
+                V::store_partial(outputs[f] + x + (v * V::width), sums[f][v], last);
+            } else {
+                V::store(outputs[f] + x + (v * V::width), sums[f][v]);
+            }
+        }
+    }
+}
+
+/**
+ * The convolutions of one input image with FILTERS filters, computed a row of output values at a
+ * time, in blocks of (up to) eight vectors over all the filters and then one block with the
+ * remaining (partial) vectors. The input row of a reversed filter y is the output row minus the
+ * filter offset instead of plus it, so only the filter rows which are inside the input are used.
+ */
+template <class V, bool reverse_y, int32_t FILTERS>
+void scatter_rows(
+    const float* input_image, int32_t row_size, int32_t column_offset, int32_t column_step,
+    const float* const* weights, float* const* output_images, int32_t input_size_y, int32_t filter_y,
+    int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+    const int32_t vectors = FILTERS <= 2 ? 4 : 2;
+    const int32_t block = vectors * V::width;
+    int32_t row_step = reverse_y ? -row_size : row_size;
+
+    for (int32_t y = 0; y < output_size_y; y++) {
+        int32_t fy_start = 0;
+        int32_t fy_end = filter_y;
+        if (reverse_y) {
+            fy_start = y - input_size_y + 1 > 0 ? y - input_size_y + 1 : 0;
+            fy_end = y + 1 < filter_y ? y + 1 : filter_y;
+        }
+
+        const float* input_row = input_image + ((reverse_y ? y - fy_start : y + fy_start) * row_size) + column_offset;
+        int32_t filter_rows = fy_end - fy_start;
+
+        const float* filters[FILTERS];
+        float* output_rows[FILTERS];
+        for (int32_t f = 0; f < FILTERS; f++) {
+            filters[f] = weights[f] + (fy_start * filter_x);
+            output_rows[f] = output_images[f] + (y * output_size_x);
+        }
+
+        int32_t x = 0;
+        for (; x + block <= output_size_x; x += block) {
+            scatter_block<V, vectors, FILTERS, false>(
+                output_rows, x, input_row + x, row_step, column_step, filters, filter_rows, filter_x, 0
+            );
+        }
+
+        int32_t remaining = output_size_x - x;
+        if (remaining > 0) {
+            int32_t remaining_vectors = (remaining + V::width - 1) / V::width;
+            int32_t last = remaining - ((remaining_vectors - 1) * V::width);
+
+            if (remaining_vectors == 1) {
+                scatter_block<V, 1, FILTERS, true>(
+                    output_rows, x, input_row + x, row_step, column_step, filters, filter_rows, filter_x, last
+                );
+            } else if (remaining_vectors == 2) {
+                scatter_block<V, 2, FILTERS, true>(
+                    output_rows, x, input_row + x, row_step, column_step, filters, filter_rows, filter_x, last
+                );
+            } else if (remaining_vectors == 3) {
+                scatter_block<V, 3, FILTERS, true>(
+                    output_rows, x, input_row + x, row_step, column_step, filters, filter_rows, filter_x, last
+                );
+            } else {
+                scatter_block<V, 4, FILTERS, true>(
+                    output_rows, x, input_row + x, row_step, column_step, filters, filter_rows, filter_x, last
+                );
+            }
+        }
+    }
+}
+
+/**
+ * Copies the images into the thread's padded buffer with filter_x - 1 zeros on each side of
+ * every row, so a reversed filter x has all its taps for every output value. Returns the buffer.
+ */
+template <class V>
+inline float* pad_rows(
+    int32_t number_images, const float* const* images, int32_t image_offset, int32_t size_y, int32_t size_x,
+    int32_t filter_x
+) {
+    // kept for the thread's following convolutions
+    static thread_local float* padded = NULL;
+    static thread_local int32_t padded_size = 0;
+
+    int32_t padding = filter_x - 1;
+    int32_t row_size = size_x + (2 * padding);
+    int32_t image_size = size_y * row_size;
+
+    if (padded_size < number_images * image_size) {
+        delete[] padded;
+        padded_size = number_images * image_size;
+        padded = new float[padded_size];
+    }
+
+    for (int32_t i = 0; i < number_images; i++) {
+        const float* image = images[i] + image_offset;
+        float* padded_image = padded + (i * image_size);
+
+        for (int32_t y = 0; y < size_y; y++) {
+            float* padded_row = padded_image + (y * row_size);
+            for (int32_t x = 0; x < padding; x++) {
+                padded_row[x] = 0.0;
+                padded_row[padding + size_x + x] = 0.0;
+            }
+            for (int32_t x = 0; x < size_x; x++) {
+                padded_row[padding + x] = image[(y * size_x) + x];
+            }
+        }
+    }
+    return padded;
+}
+
+/**
+ * The convolutions of an input with several filters (the edges out of a node with the same filter
+ * and output sizes), done one image at a time for up to four filters at once, so the input image
+ * is (padded and) read once for them instead of once per filter.
+ */
+template <class V, bool reverse_y, bool reverse_x>
+void forward_kernel(
+    const float* input, int32_t number_filters, const float* const* weights, float* const* outputs, int32_t batch_size,
+    int32_t batch_start, int32_t batch_end, int32_t input_size_y, int32_t input_size_x, int32_t filter_y,
+    int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+    int32_t row_size = reverse_x ? input_size_x + (2 * (filter_x - 1)) : input_size_x;
+    // output x plus this is the input x of the first filter column
+    int32_t column_offset = reverse_x ? filter_x - 1 : 0;
+    int32_t column_step = reverse_x ? -1 : 1;
+
+    for (int32_t batch_number = batch_start; batch_number < batch_end; batch_number++) {
+        const float* input_image = input + (batch_number * input_size_y * input_size_x);
+        if (reverse_x) {
+            input_image = pad_rows<V>(
+                1, &input, batch_number * input_size_y * input_size_x, input_size_y, input_size_x, filter_x
+            );
+        }
+
+        for (int32_t f = 0; f < number_filters; f += 4) {
+            float* output_images[4];
+            int32_t filters = number_filters - f < 4 ? number_filters - f : 4;
+            for (int32_t i = 0; i < filters; i++) {
+                output_images[i] = outputs[f + i] + (batch_number * output_size_y * output_size_x);
+            }
+
+            if (filters == 1) {
+                scatter_rows<V, reverse_y, 1>(
+                    input_image, row_size, column_offset, column_step, weights + f, output_images, input_size_y,
+                    filter_y, filter_x, output_size_y, output_size_x
+                );
+            } else if (filters == 2) {
+                scatter_rows<V, reverse_y, 2>(
+                    input_image, row_size, column_offset, column_step, weights + f, output_images, input_size_y,
+                    filter_y, filter_x, output_size_y, output_size_x
+                );
+            } else if (filters == 3) {
+                scatter_rows<V, reverse_y, 3>(
+                    input_image, row_size, column_offset, column_step, weights + f, output_images, input_size_y,
+                    filter_y, filter_x, output_size_y, output_size_x
+                );
+            } else {
+                scatter_rows<V, reverse_y, 4>(
+                    input_image, row_size, column_offset, column_step, weights + f, output_images, input_size_y,
+                    filter_y, filter_x, output_size_y, output_size_x
+                );
+            }
+        }
+    }
+}
+
+/**
+ * Adds the convolutions of several input images (each with its own filter) to VECTORS vectors of
+ * consecutive output values, which are kept in registers for all the images and taps. The
+ * inputs of the first tap for the first output value are images[i] + offset, otherwise this is
+ * the same as scatter_block.
+ */
+template <class V, int32_t VECTORS, bool PARTIAL>
+inline void gather_block(
+    float* output, int32_t number_images, const float* const* images, int32_t offset, int32_t row_step,
+    int32_t column_step, const float* const* filters, int32_t filter_offset, int32_t filter_rows, int32_t filter_x,
+    int32_t last
+) {
+    typename V::type sums[VECTORS];
+    for (int32_t v = 0; v < VECTORS; v++) {
+        if (PARTIAL && v == VECTORS - 1) {
+            sums[v] = V::load_partial(output + (v * V::width), last);
+        } else {
+            sums[v] = V::load(output + (v * V::width));
+        }
+    }
+
+    for (int32_t i = 0; i < number_images; i++) {
+        const float* input = images[i] + offset;
+        const float* filter = filters[i] + filter_offset;
+
+        for (int32_t fy = 0; fy < filter_rows; fy++) {
+            const float* input_row = input + (fy * row_step);
+            const float* filter_row = filter + (fy * filter_x);
+
+            for (int32_t fx = 0; fx < filter_x; fx++) {
+                const float* current_input = input_row + (fx * column_step);
+                typename V::type weight = V::set(filter_row[fx]);
+
+                for (int32_t v = 0; v < VECTORS; v++) {
+                    if (PARTIAL && v == VECTORS - 1) {
+                        sums[v] =
+                            V::multiply_add(weight, V::load_partial(current_input + (v * V::width), last), sums[v]);
+                    } else {
+                        sums[v] = V::multiply_add(weight, V::load(current_input + (v * V::width)), sums[v]);
+                    }
+                }
+            }
+        }
+    }
+
+    for (int32_t v = 0; v < VECTORS; v++) {
+        if (PARTIAL && v == VECTORS - 1) {
+            V::store_partial(output + (v * V::width), sums[v], last);
+        } else {
+            V::store(output + (v * V::width), sums[v]);
+        }
+    }
+}
+
+/**
+ * The sum of the convolutions of several inputs with their own filters into one output (the
+ * input errors of a node from the output errors of its edges), so each output value is read and
+ * written once for all of them instead of once per input.
+ */
+template <class V, bool reverse_y, bool reverse_x>
+void gather_kernel(
+    int32_t number_images, const float* const* inputs, const float* const* weights, float* output, int32_t batch_size,
+    int32_t batch_start, int32_t batch_end, int32_t input_size_y, int32_t input_size_x, int32_t filter_y,
+    int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+    const int32_t block = 4 * V::width;
+
+    int32_t row_size = reverse_x ? input_size_x + (2 * (filter_x - 1)) : input_size_x;
+    int32_t image_size = input_size_y * row_size;
+    int32_t column_offset = reverse_x ? filter_x - 1 : 0;
+    int32_t column_step = reverse_x ? -1 : 1;
+    int32_t row_step = reverse_y ? -row_size : row_size;
+
+    const float** images = new const float*[number_images];
+
+    for (int32_t batch_number = batch_start; batch_number < batch_end; batch_number++) {
+        int32_t input_offset = batch_number * input_size_y * input_size_x;
+        float* output_image = output + (batch_number * output_size_y * output_size_x);
+
+        if (reverse_x) {
+            const float* padded =
+                pad_rows<V>(number_images, inputs, input_offset, input_size_y, input_size_x, filter_x);
+            for (int32_t i = 0; i < number_images; i++) {
+                images[i] = padded + (i * image_size);
+            }
+        } else {
+            for (int32_t i = 0; i < number_images; i++) {
+                images[i] = inputs[i] + input_offset;
+            }
+        }
+
+        for (int32_t y = 0; y < output_size_y; y++) {
+            int32_t fy_start = 0;
+            int32_t fy_end = filter_y;
+            if (reverse_y) {
+                fy_start = y - input_size_y + 1 > 0 ? y - input_size_y + 1 : 0;
+                fy_end = y + 1 < filter_y ? y + 1 : filter_y;
+            }
+
+            float* output_row = output_image + (y * output_size_x);
+            int32_t row_offset = ((reverse_y ? y - fy_start : y + fy_start) * row_size) + column_offset;
+            int32_t filter_offset = fy_start * filter_x;
+            int32_t filter_rows = fy_end - fy_start;
+
+            int32_t x = 0;
+            for (; x + block <= output_size_x; x += block) {
+                gather_block<V, 4, false>(
+                    output_row + x, number_images, images, row_offset + x, row_step, column_step, weights,
+                    filter_offset, filter_rows, filter_x, 0
+                );
+            }
+
+            int32_t remaining = output_size_x - x;
+            if (remaining > 0) {
+                int32_t vectors = (remaining + V::width - 1) / V::width;
+                int32_t last = remaining - ((vectors - 1) * V::width);
+
+                if (vectors == 1) {
+                    gather_block<V, 1, true>(
+                        output_row + x, number_images, images, row_offset + x, row_step, column_step, weights,
+                        filter_offset, filter_rows, filter_x, last
+                    );
+                } else if (vectors == 2) {
+                    gather_block<V, 2, true>(
+                        output_row + x, number_images, images, row_offset + x, row_step, column_step, weights,
+                        filter_offset, filter_rows, filter_x, last
+                    );
+                } else if (vectors == 3) {
+                    gather_block<V, 3, true>(
+                        output_row + x, number_images, images, row_offset + x, row_step, column_step, weights,
+                        filter_offset, filter_rows, filter_x, last
+                    );
+                } else {
+                    gather_block<V, 4, true>(
+                        output_row + x, number_images, images, row_offset + x, row_step, column_step, weights,
+                        filter_offset, filter_rows, filter_x, last
+                    );
+                }
+            }
+        }
+    }
+
+    delete[] images;
+}
+
+/**
+ * Adds the dot products of shared[0 .. length) with shifted[t .. t + length) for the taps
+ * t = 0 .. TAPS - 1 to sums, loading each shared vector once for all the taps. The values past
+ * the last full vector are loaded as a partial vector.
+ */
+template <class V, int32_t TAPS>
+inline void accumulate_taps(const float* shared, const float* shifted, int32_t length, typename V::type* sums) {
+    int32_t x = 0;
+    for (; x + V::width <= length; x += V::width) {
+        typename V::type values = V::load(shared + x);
+        for (int32_t t = 0; t < TAPS; t++) {
+            sums[t] = V::multiply_add(values, V::load(shifted + x + t), sums[t]);
+        }
+    }
+
+    if (x < length) {
+        int32_t last = length - x;
+        typename V::type values = V::load_partial(shared + x, last);
+        for (int32_t t = 0; t < TAPS; t++) {
+            sums[t] = V::multiply_add(values, V::load_partial(shifted + x + t, last), sums[t]);
+        }
+    }
+}
+
+/**
+ * The weight updates of a convolution: each is the dot product of the smaller image (the
+ * output errors, or the input along a reversed filter direction) with the larger one shifted by
+ * the tap's offset. Taps along a filter row are computed four at a time, sharing the loads of
+ * the smaller image.
+ */
+template <class V, bool reverse_y, bool reverse_x>
+void weight_update_kernel(
+    const float* output_errors, const float* input, float* weight_updates, int32_t batch_size, int32_t batch_start,
+    int32_t batch_end, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x,
+    int32_t output_size_y, int32_t output_size_x
+) {
+    const int32_t taps = 4;
+
+    int32_t rows = reverse_y ? input_size_y : output_size_y;
+    int32_t length = reverse_x ? input_size_x : output_size_x;
+
+    for (int32_t batch_number = batch_start; batch_number < batch_end; batch_number++) {
+        const float* input_image = input + (batch_number * input_size_y * input_size_x);
+        const float* errors_image = output_errors + (batch_number * output_size_y * output_size_x);
+
+        for (int32_t fy = 0; fy < filter_y; fy++) {
+            for (int32_t fx = 0; fx < filter_x;) {
+                int32_t group = filter_x - fx >= taps ? taps : 1;
+
+                typename V::type sums[taps];
+                for (int32_t t = 0; t < taps; t++) {
+                    sums[t] = V::zero();
+                }
+
+                for (int32_t y = 0; y < rows; y++) {
+                    const float* input_row = input_image + ((reverse_y ? y : y + fy) * input_size_x);
+                    const float* errors_row = errors_image + ((reverse_y ? y + fy : y) * output_size_x);
+
+                    const float* shared = reverse_x ? input_row : errors_row;
+                    const float* shifted = (reverse_x ? errors_row : input_row) + fx;
+
+                    if (group == taps) {
+                        accumulate_taps<V, taps>(shared, shifted, length, sums);
+                    } else {
+                        accumulate_taps<V, 1>(shared, shifted, length, sums);
+                    }
+                }
+
+                for (int32_t t = 0; t < group; t++) {
+                    weight_updates[(fy * filter_x) + fx + t] += V::sum(sums[t]) / batch_size;
+                }
+                fx += group;
+            }
+        }
+    }
+}
+
+/**
+ * The backward pass of several convolutions of the same input: the weight updates of each
+ * filter, and the input errors, which are the sum of the output errors convolved with the
+ * filters in the opposite directions, so they use the gather kernel with the input and output
+ * swapped and the filter directions reversed.
+ */
+template <class V, bool reverse_y, bool reverse_x>
+void backward_kernel(
+    int32_t number_filters, const float* const* output_errors, const float* input, float* input_errors,
+    float* const* weight_updates, const float* const* weights, int32_t batch_size, int32_t batch_start,
+    int32_t batch_end, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x,
+    int32_t output_size_y, int32_t output_size_x
+) {
+    for (int32_t f = 0; f < number_filters; f++) {
+        weight_update_kernel<V, reverse_y, reverse_x>(
+            output_errors[f], input, weight_updates[f], batch_size, batch_start, batch_end, input_size_y, input_size_x,
+            filter_y, filter_x, output_size_y, output_size_x
+        );
+    }
+
+    gather_kernel<V, !reverse_y, !reverse_x>(
+        number_filters, output_errors, weights, input_errors, batch_size, batch_start, batch_end, output_size_y,
+        output_size_x, filter_y, filter_x, input_size_y, input_size_x
+    );
+}
+
+template <class V>
+void backward_kernel(
+    bool reverse_y, bool reverse_x, int32_t number_filters, const float* const* output_errors, const float* input,
+    float* input_errors, float* const* weight_updates, const float* const* weights, int32_t batch_size,
+    int32_t batch_start, int32_t batch_end, int32_t input_size_y, int32_t input_size_x, int32_t filter_y,
+    int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+    if (reverse_y && reverse_x) {
+        backward_kernel<V, true, true>(
+            number_filters, output_errors, input, input_errors, weight_updates, weights, batch_size, batch_start,
+            batch_end, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+        );
+    } else if (reverse_y) {
+        backward_kernel<V, true, false>(
+            number_filters, output_errors, input, input_errors, weight_updates, weights, batch_size, batch_start,
+            batch_end, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+        );
+    } else if (reverse_x) {
+        backward_kernel<V, false, true>(
+            number_filters, output_errors, input, input_errors, weight_updates, weights, batch_size, batch_start,
+            batch_end, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+        );
+    } else {
+        backward_kernel<V, false, false>(
+            number_filters, output_errors, input, input_errors, weight_updates, weights, batch_size, batch_start,
+            batch_end, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x
+        );
+    }
+}
+
+template <class V>
+void forward_kernel(
+    bool reverse_y, bool reverse_x, const float* input, int32_t number_filters, const float* const* weights,
+    float* const* outputs, int32_t batch_size, int32_t batch_start, int32_t batch_end, int32_t input_size_y,
+    int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+    if (reverse_y && reverse_x) {
+        forward_kernel<V, true, true>(
+            input, number_filters, weights, outputs, batch_size, batch_start, batch_end, input_size_y, input_size_x,
+            filter_y, filter_x, output_size_y, output_size_x
+        );
+    } else if (reverse_y) {
+        forward_kernel<V, true, false>(
+            input, number_filters, weights, outputs, batch_size, batch_start, batch_end, input_size_y, input_size_x,
+            filter_y, filter_x, output_size_y, output_size_x
+        );
+    } else if (reverse_x) {
+        forward_kernel<V, false, true>(
+            input, number_filters, weights, outputs, batch_size, batch_start, batch_end, input_size_y, input_size_x,
+            filter_y, filter_x, output_size_y, output_size_x
+        );
+    } else {
+        forward_kernel<V, false, false>(
+            input, number_filters, weights, outputs, batch_size, batch_start, batch_end, input_size_y, input_size_x,
+            filter_y, filter_x, output_size_y, output_size_x
+        );
+    }
+}
+
+#endif
@@ -0,0 +1,424 @@
+#include <algorithm>
+using std::find;
+
+#include <cmath>
+using std::fabs;
+
+#include <iostream>
+using std::cerr;
+using std::endl;
+
+#include <limits>
+using std::numeric_limits;
+
+#include <random>
+using std::minstd_rand0;
+
+#include <vector>
+using std::vector;
+
+#include "common/exp.hxx"
+#include "pooling.hxx"
+#include "propagation.hxx"
+#include "quantized_cnn.hxx"
+
+static void quantize(const float* values, int8_t* codes, int32_t size, float step) {
+    float inverse_step = 1.0 / step;
+
+    for (int32_t current = 0; current < size; current++) {
+        float code = values[current] * inverse_step;
+        code = code > QUANTIZED_MAX ? QUANTIZED_MAX : (code < -QUANTIZED_MAX ? -QUANTIZED_MAX : code);
+        codes[current] = (int8_t) (code < 0 ? code - 0.5f : code + 0.5f);
+    }
+}
+
+/**
+ * The int8 version of the convolution kernels (prop_forward, prop_forward_ry, prop_forward_rx and
+ * prop_forward_ry_rx) for a single image, accumulated in int32. Forward filters are moved over
+ * the rows and columns of the output, and reversed filters spread each row or column of the
+ * input over the output.
+ */
+static void quantized_convolution(
+    bool reverse_y, bool reverse_x, const int8_t* input, const int8_t* weights, int32_t* output, int32_t input_size_y,
+    int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x
+) {
+    int32_t rows = reverse_y ? input_size_y : output_size_y;
+    int32_t columns = reverse_x ? input_size_x : output_size_x;
+
+    int32_t current_weight = 0;
+    for (int32_t fy = 0; fy < filter_y; fy++) {
+        for (int32_t fx = 0; fx < filter_x; fx++) {
+            int32_t weight = weights[current_weight++];
+            if (weight == 0) {
+                continue;
+            }
+
+            for (int32_t y = 0; y < rows; y++) {
+                const int8_t* input_row = input + ((reverse_y ? y : y + fy) * input_size_x) + (reverse_x ? 0 : fx);
+                int32_t* output_row = output + ((reverse_y ? y + fy : y) * output_size_x) + (reverse_x ? fx : 0);
+
+                for (int32_t x = 0; x < columns; x++) {
+                    output_row[x] += weight * input_row[x];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * The int8 version of max pooling (pool_forward and its reversed versions) for a single image.
+ * Pools along a dimension are of the input when it is pooled down, with one output value for
+ * each, or of the output when it is spread up, with one input value for each. The largest code
+ * of each input pool (or the smallest, as the largest value when the factor is negative) is
+ * multiplied by the factor and added to its output pool.
+ */
+static void quantized_pool(
+    bool reverse_y, bool reverse_x, const int8_t* input, bool minimum, float factor, float* output,
+    int32_t input_size_x, int32_t output_size_x, const vector<int>& y_pools, const vector<int>& y_pool_offsets,
+    const vector<int>& x_pools, const vector<int>& x_pool_offsets
+) {
+    for (int32_t pool_y = 0; pool_y < (int32_t) y_pools.size(); pool_y++) {
+        int32_t in_y = reverse_y ? pool_y : y_pool_offsets[pool_y];
+        int32_t in_rows = reverse_y ? 1 : y_pools[pool_y];
+        int32_t out_y = reverse_y ? y_pool_offsets[pool_y] : pool_y;
+        int32_t out_rows = reverse_y ? y_pools[pool_y] : 1;
+
+        for (int32_t pool_x = 0; pool_x < (int32_t) x_pools.size(); pool_x++) {
+            int32_t in_x = reverse_x ? pool_x : x_pool_offsets[pool_x];
+            int32_t in_columns = reverse_x ? 1 : x_pools[pool_x];
+            int32_t out_x = reverse_x ? x_pool_offsets[pool_x] : pool_x;
+            int32_t out_columns = reverse_x ? x_pools[pool_x] : 1;
+
+            int32_t extreme = input[(in_y * input_size_x) + in_x];
+            for (int32_t y = in_y; y < in_y + in_rows; y++) {
+                for (int32_t x = in_x; x < in_x + in_columns; x++) {
+                    int32_t code = input[(y * input_size_x) + x];
+                    if (minimum ? code < extreme : code > extreme) {
+                        extreme = code;
+                    }
+                }
+            }
+
+            float value = factor * extreme;
+            for (int32_t y = out_y; y < out_y + out_rows; y++) {
+                for (int32_t x = out_x; x < out_x + out_columns; x++) {
+                    output[(y * output_size_x) + x] += value;
+                }
+            }
+        }
+    }
+}
+
+QuantizedCNN::QuantizedCNN(
+    const vector<CNN_Node*>& _nodes, const vector<CNN_Edge*>& _edges, const vector<CNN_Node*>& input_nodes,
+    const vector<CNN_Node*>& softmax_nodes, const vector<float>& max_activations, float epsilon,
+    float _input_dropout_probability, float _hidden_dropout_probability
+) {
+    nodes = _nodes;
+    edges = _edges;
+
+    input_dropout_probability = _input_dropout_probability;
+    hidden_dropout_probability = _hidden_dropout_probability;
+
+    scales.assign(nodes.size(), 1.0);
+    shifts.assign(nodes.size(), 0.0);
+    steps.assign(nodes.size(), 1.0);
+
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        // the input nodes are not normalized, and the softmax nodes' values are not activated
+        if (!nodes[i]->is_input() && !nodes[i]->is_softmax()) {
+            nodes[i]->get_normalization(epsilon, scales[i], shifts[i]);
+        }
+
+        if (max_activations[i] > 0) {
+            steps[i] = max_activations[i] / QUANTIZED_MAX;
+        }
+    }
+
+    vector<CNN_Node*>::const_iterator found;
+    for (uint32_t i = 0; i < input_nodes.size(); i++) {
+        found = find(nodes.begin(), nodes.end(), input_nodes[i]);
+        input_positions.push_back(found - nodes.begin());
+    }
+
+    for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
+        found = find(nodes.begin(), nodes.end(), softmax_nodes[i]);
+        if (found == nodes.end()) {
+            cerr << "ERROR: softmax node " << softmax_nodes[i]->get_innovation_number()
+                 << " is not reachable, the genome can't be quantized" << endl;
+            exit(1);
+        }
+        softmax_positions.push_back(found - nodes.begin());
+    }
+
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        CNN_Edge* edge = edges[i];
+
+        int32_t input = find(nodes.begin(), nodes.end(), edge->get_input_node()) - nodes.begin();
+        int32_t output = find(nodes.begin(), nodes.end(), edge->get_output_node()) - nodes.begin();
+        edge_inputs.push_back(input);
+        edge_outputs.push_back(output);
+
+        weight_codes.push_back(vector<int8_t>());
+        y_pools.push_back(vector<int>());
+        y_pool_offsets.push_back(vector<int>());
+        x_pools.push_back(vector<int>());
+        x_pool_offsets.push_back(vector<int>());
+
+        if (edge->get_type() == CONVOLUTIONAL) {
+            vector<float> weights;
+            float max_weight = 0.0;
+            for (int32_t j = 0; j < edge->get_filter_size(); j++) {
+                weights.push_back(scales[input] * edge->get_weight(j));
+                if (fabs(weights[j]) > max_weight) {
+                    max_weight = fabs(weights[j]);
+                }
+            }
+
+            float weight_step = max_weight > 0 ? max_weight / QUANTIZED_MAX : 1.0;
+            weight_codes[i].resize(weights.size());
+            quantize(&weights[0], &weight_codes[i][0], weights.size(), weight_step);
+
+            factors.push_back(steps[input] * weight_step);
+
+        } else if (edge->get_type() == POOLING) {
+            initialize_pools(y_pools[i], y_pool_offsets[i], nodes[input]->get_size_y(), nodes[output]->get_size_y());
+            initialize_pools(x_pools[i], x_pool_offsets[i], nodes[input]->get_size_x(), nodes[output]->get_size_x());
+
+            factors.push_back(edge->get_scale() * scales[input] * steps[input]);
+
+        } else {
+            cerr << "ERROR: unknown edge type in QuantizedCNN: " << edge->get_type() << endl;
+            exit(1);
+        }
+    }
+
+    values.resize(nodes.size());
+    codes.resize(nodes.size());
+    biases.resize(nodes.size());
+    bias_extra_y = -1;
+    bias_extra_x = -1;
+}
+
+int32_t QuantizedCNN::get_size(int32_t position, int32_t extra_y, int32_t extra_x) const {
+    return (nodes[position]->get_size_y() + extra_y) * (nodes[position]->get_size_x() + extra_x);
+}
+
+/**
+ * The bias of a node is the sum of the shifts of its input nodes through its input edges: each
+ * pooled value is shifted once, and each convolution adds the shift times the sum of the weights
+ * which reach each output value, i.e. the convolution of the weights over an input of ones
+ * (which differs near the edges of reversed filters).
+ */
+void QuantizedCNN::calculate_biases(int32_t extra_y, int32_t extra_x) {
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        biases[i].assign(get_size(i, extra_y, extra_x), 0.0);
+    }
+
+    vector<float> ones;
+    vector<float> convolution;
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        int32_t input = edge_inputs[i];
+        int32_t output = edge_outputs[i];
+        vector<float>& bias = biases[output];
+
+        if (shifts[input] == 0) {
+            continue;
+        }
+
+        if (edges[i]->get_type() == POOLING) {
+            for (uint32_t j = 0; j < bias.size(); j++) {
+                bias[j] += edges[i]->get_scale() * shifts[input];
+            }
+            continue;
+        }
+
+        int32_t input_size_y = nodes[input]->get_size_y() + extra_y;
+        int32_t input_size_x = nodes[input]->get_size_x() + extra_x;
+        int32_t output_size_y = nodes[output]->get_size_y() + extra_y;
+        int32_t output_size_x = nodes[output]->get_size_x() + extra_x;
+        int32_t filter_y = edges[i]->get_filter_y();
+        int32_t filter_x = edges[i]->get_filter_x();
+
+        ones.assign(input_size_y * input_size_x, 1.0);
+        convolution.assign(bias.size(), 0.0);
+
+        // the shift is convolved with the edge's weights without the scale folded in
+        vector<float> filter(edges[i]->get_filter_size());
+        for (uint32_t j = 0; j < filter.size(); j++) {
+            filter[j] = edges[i]->get_weight(j);
+        }
+
+        if (edges[i]->is_reverse_filter_y() && edges[i]->is_reverse_filter_x()) {
+            prop_forward_ry_rx(
+                &ones[0], &filter[0], &convolution[0], 1, input_size_y, input_size_x, filter_y, filter_x,
+                output_size_y, output_size_x
+            );
+        } else if (edges[i]->is_reverse_filter_y()) {
+            prop_forward_ry(
+                &ones[0], &filter[0], &convolution[0], 1, input_size_y, input_size_x, filter_y, filter_x,
+                output_size_y, output_size_x
+            );
+        } else if (edges[i]->is_reverse_filter_x()) {
+            prop_forward_rx(
+                &ones[0], &filter[0], &convolution[0], 1, input_size_y, input_size_x, filter_y, filter_x,
+                output_size_y, output_size_x
+            );
+        } else {
+            prop_forward(
+                &ones[0], &filter[0], &convolution[0], 1, input_size_y, input_size_x, filter_y, filter_x,
+                output_size_y, output_size_x
+            );
+        }
+
+        for (uint32_t j = 0; j < bias.size(); j++) {
+            bias[j] += shifts[input] * convolution[j];
+        }
+    }
+
+    bias_extra_y = extra_y;
+    bias_extra_x = extra_x;
+}
+
+/**
+ * Propagates the values of the input nodes (which have already been set) through the quantized
+ * edges, over feature maps extra_y and extra_x larger than the nodes.
+ */
+void QuantizedCNN::propagate(int32_t extra_y, int32_t extra_x) {
+    if (extra_y != bias_extra_y || extra_x != bias_extra_x) {
+        calculate_biases(extra_y, extra_x);
+    }
+
+    vector<bool> quantized(nodes.size(), false);
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        if (!nodes[i]->is_input()) {
+            values[i] = biases[i];
+        }
+    }
+
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        int32_t input = edge_inputs[i];
+        int32_t output = edge_outputs[i];
+
+        int32_t input_size_y = nodes[input]->get_size_y() + extra_y;
+        int32_t input_size_x = nodes[input]->get_size_x() + extra_x;
+        int32_t output_size_y = nodes[output]->get_size_y() + extra_y;
+        int32_t output_size_x = nodes[output]->get_size_x() + extra_x;
+
+        // all the edges into a node come before the edges out of it
+        if (!quantized[input]) {
+            if (!nodes[input]->is_input()) {
+                nodes[input]->activate(&values[input][0], values[input].size(), hidden_dropout_probability);
+            }
+            codes[input].resize(values[input].size());
+            quantize(&values[input][0], &codes[input][0], values[input].size(), steps[input]);
+            quantized[input] = true;
+        }
+
+        float* output_values = &values[output][0];
+
+        if (edges[i]->get_type() == CONVOLUTIONAL) {
+            accumulator.assign(output_size_y * output_size_x, 0);
+
+            quantized_convolution(
+                edges[i]->is_reverse_filter_y(), edges[i]->is_reverse_filter_x(), &codes[input][0],
+                &weight_codes[i][0], &accumulator[0], input_size_y, input_size_x, edges[i]->get_filter_y(),
+                edges[i]->get_filter_x(), output_size_y, output_size_x
+            );
+
+            float factor = factors[i];
+            for (int32_t j = 0; j < (int32_t) accumulator.size(); j++) {
+                output_values[j] += factor * accumulator[j];
+            }
+
+        } else {
+            quantized_pool(
+                edges[i]->is_reverse_filter_y(), edges[i]->is_reverse_filter_x(), &codes[input][0], factors[i] < 0,
+                factors[i], output_values, input_size_x, output_size_x, y_pools[i], y_pool_offsets[i], x_pools[i],
+                x_pool_offsets[i]
+            );
+        }
+    }
+}
+
+void QuantizedCNN::calculate_softmax(int32_t current, float* prediction) const {
+    float softmax_max = -numeric_limits<float>::max();
+    for (uint32_t i = 0; i < softmax_positions.size(); i++) {
+        if (values[softmax_positions[i]][current] > softmax_max) {
+            softmax_max = values[softmax_positions[i]][current];
+        }
+    }
+
+    float softmax_sum = 0.0;
+    for (uint32_t i = 0; i < softmax_positions.size(); i++) {
+        prediction[i] = exact_exp(values[softmax_positions[i]][current] - softmax_max);
+        softmax_sum += prediction[i];
+    }
+
+    for (uint32_t i = 0; i < softmax_positions.size(); i++) {
+        prediction[i] /= softmax_sum;
+    }
+}
+
+void QuantizedCNN::evaluate_images(
+    const ImagesInterface& images, const vector<int>& batch, const float* batch_values, float* predictions
+) {
+    float dropout_scale = input_dropout_probability > 0 ? 1.0 - input_dropout_probability : 1.0;
+
+    int32_t channel_size = images.get_image_height() * images.get_image_width();
+    int32_t image_size = images.get_image_channels() * channel_size;
+
+    for (int32_t batch_number = 0; batch_number < (int32_t) batch.size(); batch_number++) {
+        for (uint32_t channel = 0; channel < input_positions.size(); channel++) {
+            const float* channel_values = batch_values + (batch_number * image_size) + (channel * channel_size);
+            vector<float>& input_values = values[input_positions[channel]];
+
+            input_values.resize(channel_size);
+            for (int32_t current = 0; current < channel_size; current++) {
+                input_values[current] = channel_values[current] * dropout_scale;
+            }
+        }
+
+        propagate(0, 0);
+        calculate_softmax(0, predictions + (batch_number * softmax_positions.size()));
+    }
+}
+
+void QuantizedCNN::evaluate_tile(
+    const MultiImagesInterface& images, int image_number, int32_t tile_y, int32_t tile_x, int32_t extra_y,
+    int32_t extra_x, int32_t matrix_width, float* predictions
+) {
+    float dropout_scale = input_dropout_probability > 0 ? 1.0 - input_dropout_probability : 1.0;
+
+    for (uint32_t channel = 0; channel < input_positions.size(); channel++) {
+        int32_t position = input_positions[channel];
+        int32_t size_y = nodes[position]->get_size_y() + extra_y;
+        int32_t size_x = nodes[position]->get_size_x() + extra_x;
+
+        float avg = images.get_channel_avg(channel);
+        float std_dev = images.get_channel_std_dev(channel);
+
+        values[position].resize(size_y * size_x);
+
+        int current = 0;
+        for (int32_t y = 0; y < size_y; y++) {
+            for (int32_t x = 0; x < size_x; x++) {
+                float pixel = images.get_raw_pixel(image_number, channel, tile_y + y, tile_x + x);
+                values[position][current] = ((pixel / 255.0) - avg) / std_dev;
+                values[position][current] *= dropout_scale;
+                current++;
+            }
+        }
+    }
+
+    propagate(extra_y, extra_x);
+
+    // the softmax nodes' values at each position are the predictions of the subimage there
+    int32_t tile_width = extra_x + 1;
+    for (int32_t y = 0; y <= extra_y; y++) {
+        for (int32_t x = 0; x <= extra_x; x++) {
+            int32_t subimage = ((tile_y + y) * matrix_width) + tile_x + x;
+            calculate_softmax((y * tile_width) + x, predictions + (subimage * softmax_positions.size()));
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef CNN_QUANTIZED_H
+#define CNN_QUANTIZED_H
+
+#include <vector>
+using std::vector;
+
+#include "cnn_edge.hxx"
+#include "cnn_node.hxx"
+#include "image_tools/image_set_interface.hxx"
+#include "stdint.h"
+
+// the largest magnitude of the int8 codes of the quantized activations and weights
+#define QUANTIZED_MAX 127
+
+/**
+ * A post-training int8 quantization of a genome, for inference.
+ *
+ * The batch normalization of a node scales and shifts its activations (see
+ * CNN_Node::get_normalization), so it is folded into the node's outgoing edges: the scale into
+ * the weights of its convolutions (and the pooled values), and the shift into a bias added to the
+ * edges' output nodes, which is the shift convolved with the weights over an input of ones. Each
+ * node's activations are quantized with a step calibrated from the largest activation over the
+ * calibration images, and each edge's weights with a step from its largest weight. The
+ * convolutions are accumulated in int32 and pooling takes the largest (or smallest, if the scale
+ * is negative) int8 code, and both are then scaled back to floats and added to their output
+ * nodes' inputs, whose activations are quantized in turn. The softmax is calculated in floats.
+ */
+class QuantizedCNN {
+   private:
+    // the genome's input and reachable nodes, and its reachable edges in propagation order
+    vector<CNN_Node*> nodes;
+    vector<CNN_Edge*> edges;
+
+    vector<int32_t> input_positions;
+    vector<int32_t> softmax_positions;
+
+    float input_dropout_probability;
+    float hidden_dropout_probability;
+
+    // the scale and shift of each node's batch normalization, and the step between the codes of
+    // its quantized activations
+    vector<float> scales;
+    vector<float> shifts;
+    vector<float> steps;
+
+    vector<int32_t> edge_inputs;
+    vector<int32_t> edge_outputs;
+
+    // the codes of the convolutions' weights, with the scales of their input nodes folded in; the
+    // sums of the codes are multiplied by the edge's factor (as are the pooled codes)
+    vector<vector<int8_t> > weight_codes;
+    vector<float> factors;
+
+    vector<vector<int> > y_pools;
+    vector<vector<int> > y_pool_offsets;
+    vector<vector<int> > x_pools;
+    vector<vector<int> > x_pool_offsets;
+
+    // the bias of each node for feature maps extra_y and extra_x larger than the nodes
+    vector<vector<float> > biases;
+    int32_t bias_extra_y, bias_extra_x;
+
+    vector<vector<float> > values;
+    vector<vector<int8_t> > codes;
+    vector<int32_t> accumulator;
+
+    int32_t get_size(int32_t position, int32_t extra_y, int32_t extra_x) const;
+
+    void calculate_biases(int32_t extra_y, int32_t extra_x);
+    void propagate(int32_t extra_y, int32_t extra_x);
+    void calculate_softmax(int32_t current, float* prediction) const;
+
+   public:
+    /**
+     * Quantizes the nodes and edges of a genome, where max_activations are the largest
+     * magnitudes of the nodes' activations (after their relu and dropout, or the input values of
+     * the input nodes) over the calibration images.
+     */
+    QuantizedCNN(
+        const vector<CNN_Node*>& _nodes, const vector<CNN_Edge*>& _edges, const vector<CNN_Node*>& input_nodes,
+        const vector<CNN_Node*>& softmax_nodes, const vector<float>& max_activations, float epsilon,
+        float _input_dropout_probability, float _hidden_dropout_probability
+    );
+
+    /**
+     * The predictions of a batch of images, from their values as written by
+     * ImagesInterface::get_batch, the same as CNN_Genome::evaluate_images. The predictions of each
+     * image in the batch are written one after another, one value per softmax node.
+     */
+    void evaluate_images(
+        const ImagesInterface& images, const vector<int>& batch, const float* batch_values, float* predictions
+    );
+
+    /**
+     * The predictions of a tile of the subimages of a large image, fully convolutionally (see
+     * CNN_Genome::evaluate_large_image_fully_convolutional). The tile's first subimage is at
+     * tile_y and tile_x, and it has extra_y + 1 rows and extra_x + 1 columns of subimages. The
+     * predictions of the large image's subimages are one after another, row by row.
+     */
+    void evaluate_tile(
+        const MultiImagesInterface& images, int image_number, int32_t tile_y, int32_t tile_x, int32_t extra_y,
+        int32_t extra_x, int32_t matrix_width, float* predictions
+    );
+};
+
+#endif
@@ -65,6 +65,11 @@ int main(int argc, char** argv) {
     // genome->initialize();
     genome->set_to_best();
 
+    // the quantized genome's predictions on the large images are written to the output directory
+    if (genome->quantize_from_arguments(arguments, test_images)) {
+        genome->evaluate_large_images(test_images, output_directory);
+    }
+
     cout << endl << "drawing image predictions." << endl;
     // TODO: update to use prediction matrix
     // genome->draw_predictions(test_images, output_directory);
@@ -26,7 +26,9 @@ using std::vector;
 #include "cnn/cnn_genome.hxx"
 #include "cnn/cnn_node.hxx"
 #include "cnn/exact.hxx"
+#include "cnn/propagation.hxx"
 #include "image_tools/large_image_set.hxx"
+#include "image_tools/mosaic_tiler.hxx"
 
 int main(int argc, char** argv) {
     vector<string> arguments = vector<string>(argv, argv + argc);
@@ -52,18 +54,52 @@ int main(int argc, char** argv) {
     string output_directory;
     get_argument(arguments, "--output_directory", true, output_directory);
 
+    // the number of rows of subimages predicted at a time when streaming a TIFF mosaic
+    int32_t band_rows = 256;
+    get_argument(arguments, "--band_rows", false, band_rows);
+
+    int32_t propagation_threads = 1;
+    get_argument(arguments, "--propagation_threads", false, propagation_threads);
+    set_propagation_threads(propagation_threads);
+
+    string extension = mosaic_filename.substr(mosaic_filename.find_last_of(".") + 1);
+    bool is_tiff = extension.compare("tif") == 0 || extension.compare("tiff") == 0;
+
     if (label_type.compare("POINT") == 0) {
         int32_t padding = 2;
         int32_t subimage_y = 32;
         int32_t subimage_x = 32;
 
+        ostringstream output_filename;
+        output_filename << output_directory << "/test_output";
+
+        if (is_tiff) {
+            // TIFF mosaics are streamed a band of rows at a time, and the predictions are written as
+            // their rows are completed, so the mosaic doesn't need to fit in memory
+            MosaicTiler tiler(mosaic_filename, padding, subimage_y, subimage_x, band_rows);
+            tiler.open_outputs(output_filename.str() + "_predictions.tif", output_filename.str() + "_merged.tif");
+            genome->quantize_from_arguments(arguments, tiler);
+
+            // the predictions of a band's subimages, one after another, reused for every band
+            vector<float> predictions;
+            while (tiler.next_band()) {
+                cout << "predicting band at row " << tiler.get_band_y() << " of " << tiler.get_mosaic_height() << endl;
+
+                genome->evaluate_large_image(tiler, 0, predictions);
+                tiler.add_predictions(predictions, genome->get_number_softmax_nodes(), 0);
+            }
+            tiler.finish();
+
+            cout << "prediction: " << tiler.get_max_prediction() << " at y: " << tiler.get_max_y()
+                 << ", x: " << tiler.get_max_x() << endl;
+            return 0;
+        }
+
         LargeImages mosaic_image(mosaic_filename, padding, subimage_y, subimage_x);
+        genome->quantize_from_arguments(arguments, mosaic_image);
 
         cout << endl << "drawing image predictions." << endl;
 
-        ostringstream output_filename;
-        output_filename << output_directory << "/test_output";
-
         LargeImage* image = mosaic_image.copy_image(0);
         image->draw_png(output_filename.str() + "_test.png");
 
@@ -26,6 +26,7 @@ using std::vector;
 #include "cnn/cnn_genome.hxx"
 #include "cnn/cnn_node.hxx"
 #include "cnn/exact.hxx"
+#include "cnn/propagation.hxx"
 #include "image_tools/mosaic_image_set.hxx"
 
 int main(int argc, char** argv) {
@@ -97,6 +98,10 @@ int main(int argc, char** argv) {
     string job_name;
     get_argument(arguments, "--job_name", true, job_name);
 
+    int32_t propagation_threads = 1;
+    get_argument(arguments, "--propagation_threads", false, propagation_threads);
+    set_propagation_threads(propagation_threads);
+
     input_directory += to_string(owner_id) + "/";
     output_directory += to_string(owner_id) + "/";
 
@@ -151,6 +156,7 @@ int main(int argc, char** argv) {
         MosaicImages point_mosaic_images(
             filenames, points, point_radius, point_classes, padding, subimage_y, subimage_x
         );
+        genome->quantize_from_arguments(arguments, point_mosaic_images);
 
         cout << endl << "drawing image predictions." << endl;
         // genome->draw_predictions(line_mosaic_images, output_directory);
@@ -276,6 +282,7 @@ int main(int argc, char** argv) {
         int32_t subimage_x = 64;
 
         MosaicImages line_mosaic_images(filenames, lines, line_height, line_classes, padding, subimage_y, subimage_x);
+        genome->quantize_from_arguments(arguments, line_mosaic_images);
 
         cout << endl << "drawing image predictions." << endl;
         // genome->draw_predictions(line_mosaic_images, output_directory);
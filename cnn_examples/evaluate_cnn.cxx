@@ -82,6 +82,26 @@ int main(int argc, char** argv) {
     cout << "test error: " << error << endl;
     cout << "test predictions " << predictions << endl;
 
+    if (argument_exists(arguments, "--quantize")) {
+        // the quantized activations are calibrated on the validation images if they are given,
+        // otherwise the training images
+        string calibration_data = training_data;
+        get_argument(arguments, "--validation_data", false, calibration_data);
+
+        Images calibration_images(
+            calibration_data, genome->get_padding(), training_images.get_average(), training_images.get_std_dev()
+        );
+        genome->quantize(calibration_images);
+
+        float quantized_error;
+        int quantized_predictions;
+        genome->evaluate("quantized", testing_images, quantized_error, quantized_predictions);
+
+        cout << "quantized test error: " << quantized_error << " (delta: " << (quantized_error - error) << ")" << endl;
+        cout << "quantized test predictions " << quantized_predictions
+             << " (delta: " << (quantized_predictions - predictions) << ")" << endl;
+    }
+
     genome->write_to_file("./genome_" + to_string(genome->get_generation_id()));
 
 #ifdef _MYSQL_
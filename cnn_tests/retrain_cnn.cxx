@@ -22,6 +22,7 @@ using std::vector;
 #include "cnn/cnn_genome.hxx"
 #include "cnn/cnn_node.hxx"
 #include "cnn/exact.hxx"
+#include "cnn/propagation.hxx"
 
 int main(int argc, char** argv) {
     vector<string> arguments = vector<string>(argv, argv + argc);
@@ -78,6 +79,10 @@ int main(int argc, char** argv) {
     bool reset_weights = false;
     get_argument(arguments, "--reset_weights", true, reset_weights);
 
+    int32_t propagation_threads = 1;
+    get_argument(arguments, "--propagation_threads", false, propagation_threads);
+    set_propagation_threads(propagation_threads);
+
     genome->reset(reset_weights);
     genome->initialize();
 
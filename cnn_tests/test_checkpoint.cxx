@@ -43,6 +43,10 @@ int main(int argc, char** argv) {
 
     CNN_Genome* genome_from_checkpoint = new CNN_Genome("temp_genome.txt", true);
 
+    genome_from_file->write_to_binary_file("temp_genome.bin");
+
+    CNN_Genome* genome_from_binary_checkpoint = new CNN_Genome("temp_genome.bin", true);
+
     Images training_images(training_data, genome_from_file->get_padding());
     Images testing_images(
         testing_data, genome_from_file->get_padding(), training_images.get_average(), training_images.get_std_dev()
@@ -57,6 +61,11 @@ int main(int argc, char** argv) {
         exit(1);
     }
 
+    if (!genome_from_file->is_identical(genome_from_binary_checkpoint, true)) {
+        cerr << "ERROR! genome from file and genome from binary checkpoint were not identical!" << endl;
+        exit(1);
+    }
+
     genome_from_file->set_to_best();
     genome_from_file->evaluate("testing", testing_images, error, predictions);
 
@@ -69,6 +78,12 @@ int main(int argc, char** argv) {
     cout << "GENOME FROM CHECKPOINT test error: " << error << endl;
     cout << "GENOME FROM CHECKPOINT test predictions " << predictions << endl;
 
+    genome_from_binary_checkpoint->set_to_best();
+    genome_from_binary_checkpoint->evaluate("testing", testing_images, error, predictions);
+
+    cout << "GENOME FROM BINARY CHECKPOINT test error: " << error << endl;
+    cout << "GENOME FROM BINARY CHECKPOINT test predictions " << predictions << endl;
+
     /*
     ostringstream query;
     query << "DELETE FROM cnn_edge WHERE genome_id = " << genome_id << endl;
@@ -0,0 +1,93 @@
+#include <cmath>
+using std::fabs;
+
+#include <iostream>
+using std::cerr;
+using std::cout;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+
+#include "cnn/cnn_edge.hxx"
+#include "cnn/cnn_genome.hxx"
+#include "cnn/cnn_node.hxx"
+#include "image_tools/image_set.hxx"
+
+/**
+ * Checks that the predictions of a (small, trained) genome quantized to int8 stay within
+ * --max_difference (default 0.2) of its float predictions on every softmax output of the
+ * testing images. The genome is calibrated on the training images, which are normalized the
+ * same way as the testing images.
+ */
+int main(int argc, char** argv) {
+    vector<string> arguments = vector<string>(argv, argv + argc);
+
+    string training_data;
+    get_argument(arguments, "--training_data", true, training_data);
+
+    string testing_data;
+    get_argument(arguments, "--testing_data", true, testing_data);
+
+    string genome_filename;
+    get_argument(arguments, "--genome_file", true, genome_filename);
+
+    float max_difference = 0.2;
+    get_argument(arguments, "--max_difference", false, max_difference);
+
+    bool is_checkpoint = false;
+    CNN_Genome* genome = new CNN_Genome(genome_filename, is_checkpoint);
+    genome->set_to_best();
+
+    Images training_images(training_data, genome->get_padding());
+    Images testing_images(
+        testing_data, genome->get_padding(), training_images.get_average(), training_images.get_std_dev()
+    );
+
+    vector<vector<float> > float_predictions;
+    genome->evaluate(testing_images, float_predictions);
+
+    genome->quantize(training_images);
+
+    vector<vector<float> > quantized_predictions;
+    genome->evaluate(testing_images, quantized_predictions);
+
+    float largest_difference = 0.0;
+    int same_classes = 0;
+    for (uint32_t i = 0; i < float_predictions.size(); i++) {
+        int float_class = 0, quantized_class = 0;
+        for (uint32_t j = 0; j < float_predictions[i].size(); j++) {
+            float difference = fabs(float_predictions[i][j] - quantized_predictions[i][j]);
+            if (difference > largest_difference) {
+                largest_difference = difference;
+            }
+
+            if (float_predictions[i][j] > float_predictions[i][float_class]) {
+                float_class = j;
+            }
+            if (quantized_predictions[i][j] > quantized_predictions[i][quantized_class]) {
+                quantized_class = j;
+            }
+        }
+
+        if (float_class == quantized_class) {
+            same_classes++;
+        }
+    }
+
+    cout << "largest difference between float and quantized predictions: " << largest_difference << endl;
+    cout << "images predicted as the same class: " << same_classes << "/" << float_predictions.size() << endl;
+
+    if (largest_difference > max_difference) {
+        cerr << "ERROR! quantized predictions differed from the float predictions by " << largest_difference
+             << ", more than the maximum of " << max_difference << endl;
+        exit(1);
+    }
+
+    delete genome;
+}
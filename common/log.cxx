@@ -120,6 +120,19 @@ void Log::set_id(string human_readable_id) {
     log_ids_mutex.unlock();
 }
 
+string Log::get_id() {
+    thread::id id = std::this_thread::get_id();
+
+    log_ids_mutex.lock();
+    string human_readable_id = "";
+    if (log_ids.count(id) > 0) {
+        human_readable_id = log_ids[id];
+    }
+    log_ids_mutex.unlock();
+
+    return human_readable_id;
+}
+
 void Log::release_id(string human_readable_id) {
     // cerr << "locking thread from human readable id: '" << human_readable_id << "'" << endl;
     log_ids_mutex.lock();
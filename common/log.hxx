@@ -182,6 +182,14 @@ class Log {
      */
     static void set_id(string human_readable_id);
 
+    /**
+     * Gets the human readable thread id set for this thread, so threads doing work
+     * on behalf of it can log under the same id.
+     *
+     * \return the human readable id of this thread, or an empty string if none was set
+     */
+    static string get_id();
+
     /**
      * Releases a the human readable thread id previously set
      * by by the provided human readable id;
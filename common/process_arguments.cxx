@@ -30,10 +30,6 @@ EXAMM* generate_examm_from_arguments(
         max_genomes
     );
 
-    // random_sequence_length = argument_exists(arguments, "--random_sequence_length");
-    // get_argument(arguments, "--sequence_length_lower_bound", false, sequence_length_lower_bound);
-    // get_argument(arguments, "--sequence_length_upper_bound", false, sequence_length_upper_bound);
-
     vector<string> dnas_node_type_strings;
     get_argument_vector(arguments, "--dnas_node_types", false, dnas_node_type_strings);
     if (dnas_node_type_strings.size() != 0) {
@@ -204,6 +200,51 @@ void get_train_validation_data(
     Log::info("Generating time series data finished! \n");
 }
 
+/**
+ * The same as above, but exporting into contiguous tensors; slicing into sequences only creates
+ * views of the exported series.
+ */
+void get_train_validation_data(
+    const vector<string>& arguments, TimeSeriesSets* time_series_sets, TimeSeriesTensor& train_inputs,
+    TimeSeriesTensor& train_outputs, TimeSeriesTensor& validation_inputs, TimeSeriesTensor& validation_outputs
+) {
+    int32_t time_offset = 1;
+    get_argument(arguments, "--time_offset", true, time_offset);
+
+    time_series_sets->export_training_series(time_offset, train_inputs, train_outputs);
+    time_series_sets->export_test_series(time_offset, validation_inputs, validation_outputs);
+
+    slice_input_data(arguments, train_inputs, train_outputs, validation_inputs, validation_outputs);
+
+    Log::info("Generating time series data finished! \n");
+}
+
+/**
+ * Slices tensors of training and validation data by the --train_sequence_length and
+ * --validation_sequence_length arguments, if given. If training windows are sampled each
+ * epoch (see WindowSampler) the training data is left whole for the sampler.
+ */
+void slice_input_data(
+    const vector<string>& arguments, TimeSeriesTensor& train_inputs, TimeSeriesTensor& train_outputs,
+    TimeSeriesTensor& validation_inputs, TimeSeriesTensor& validation_outputs
+) {
+    int32_t sequence_length = 0;
+    if (WindowSampler::is_requested(arguments)) {
+        Log::info("Not slicing input training data, training windows will be sampled each epoch\n");
+    } else if (get_argument(arguments, "--train_sequence_length", false, sequence_length)) {
+        Log::info("Slicing input training data with time sequence length: %d\n", sequence_length);
+        train_inputs.slice(sequence_length);
+        train_outputs.slice(sequence_length);
+    }
+
+    int32_t validation_sequence_length = 0;
+    if (get_argument(arguments, "--validation_sequence_length", false, validation_sequence_length)) {
+        Log::info("Slicing input validation data with time sequence length: %d\n", validation_sequence_length);
+        validation_inputs.slice(validation_sequence_length);
+        validation_outputs.slice(validation_sequence_length);
+    }
+}
+
 void slice_input_data(
     vector<vector<vector<double> > >& inputs, vector<vector<vector<double> > >& outputs, int32_t sequence_length
 ) {
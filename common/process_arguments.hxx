@@ -17,6 +17,8 @@ using std::vector;
 #include "examm/neat_speciation_strategy.hxx"
 #include "rnn/rnn_genome.hxx"
 #include "time_series/time_series.hxx"
+#include "time_series/time_series_tensor.hxx"
+#include "time_series/window_sampler.hxx"
 
 EXAMM* generate_examm_from_arguments(
     const vector<string>& arguments, TimeSeriesSets* time_series_sets, WeightRules* weight_rules,
@@ -44,6 +46,14 @@ void get_train_validation_data(
     vector<vector<vector<double> > >& train_outputs, vector<vector<vector<double> > >& test_inputs,
     vector<vector<vector<double> > >& test_outputs
 );
+void get_train_validation_data(
+    const vector<string>& arguments, TimeSeriesSets* time_series_sets, TimeSeriesTensor& train_inputs,
+    TimeSeriesTensor& train_outputs, TimeSeriesTensor& validation_inputs, TimeSeriesTensor& validation_outputs
+);
+void slice_input_data(
+    const vector<string>& arguments, TimeSeriesTensor& train_inputs, TimeSeriesTensor& train_outputs,
+    TimeSeriesTensor& validation_inputs, TimeSeriesTensor& validation_outputs
+);
 void slice_input_data(
     vector<vector<vector<double> > >& traing_inputs, vector<vector<vector<double> > >& train_outputs,
     int32_t sequence_length
@@ -998,6 +998,30 @@ void EXAMM::initialize_seed_genome() {
     seed_genome->best_parameters.clear();
 }
 
+/**
+ * Inserts a genome which was generated and trained by another EXAMM (e.g., a migrant between
+ * the sub-masters of examm_mpi_hierarchical). Its generation id is replaced with one from this
+ * EXAMM, as each EXAMM counts generation ids separately, and its generated_by map is cleared so
+ * the operators which made it are only counted by the EXAMM which generated it. As with
+ * insert_genome, a copy is inserted.
+ */
+bool EXAMM::insert_migrant(RNN_Genome* genome) {
+    genome->clear_generated_by();
+    speciation_strategy->set_migrant_generation_id(genome);
+    return insert_genome(genome);
+}
+
+/**
+ * Moves the innovation numbers given to new edges and nodes up by offset, so that
+ * EXAMM instances started from the same seed genome (e.g., the sub-masters of
+ * examm_mpi_hierarchical) never give the same innovation number to different
+ * structure, and genomes exchanged between them can still be crossed over.
+ */
+void EXAMM::offset_innovation_counts(int32_t offset) {
+    edge_innovation_count += offset;
+    node_innovation_count += offset;
+}
+
 void EXAMM::set_evolution_hyper_parameters() {
     more_fit_crossover_rate = 1.00;
     less_fit_crossover_rate = 0.50;
@@ -99,6 +99,7 @@ class EXAMM {
 
     RNN_Genome* generate_genome();
     bool insert_genome(RNN_Genome* genome);
+    bool insert_migrant(RNN_Genome* genome);
 
     void mutate(int32_t max_mutations, RNN_Genome* p1);
 
@@ -128,6 +129,7 @@ class EXAMM {
     void generate_log();
     void set_evolution_hyper_parameters();
     void initialize_seed_genome();
+    void offset_innovation_counts(int32_t offset);
     void update_op_log_statistics(RNN_Genome* genome, int32_t insert_position);
 };
 
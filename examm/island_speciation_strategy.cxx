@@ -156,6 +156,20 @@ bool IslandSpeciationStrategy::islands_full() const {
 
 // this will insert a COPY, original needs to be deleted
 // returns 0 if a new global best, < 0 if not inserted, > 0 otherwise
+/**
+ * The migrant is inserted into the island of its group id, which becomes the latest generation
+ * id of that island so a repopulating island doesn't treat the migrant as already erased.
+ */
+void IslandSpeciationStrategy::set_migrant_generation_id(RNN_Genome* genome) {
+    generated_genomes++;
+    genome->set_generation_id(generated_genomes);
+
+    int32_t island = genome->get_group_id();
+    if (island >= 0 && island < (int32_t) islands.size()) {
+        islands[island]->set_latest_generation_id(generated_genomes);
+    }
+}
+
 int32_t IslandSpeciationStrategy::insert_genome(RNN_Genome* genome) {
     Log::debug("inserting genome!\n");
     repopulate();
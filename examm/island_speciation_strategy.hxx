@@ -152,6 +152,8 @@ class IslandSpeciationStrategy : public SpeciationStrategy {
      */
     int32_t insert_genome(RNN_Genome* genome);
 
+    void set_migrant_generation_id(RNN_Genome* genome);
+
     /**
      * find the worst island in the population, the worst island's best genome is the worst among all the islands
      *
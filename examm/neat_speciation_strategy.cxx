@@ -136,6 +136,11 @@ double NeatSpeciationStrategy::get_worst_fitness() {
 
 // this will insert a COPY, original needs to be deleted
 // returns 0 if a new global best, < 0 if not inserted, > 0 otherwise
+void NeatSpeciationStrategy::set_migrant_generation_id(RNN_Genome* genome) {
+    generated_genomes++;
+    genome->set_generation_id(generated_genomes);
+}
+
 int32_t NeatSpeciationStrategy::insert_genome(RNN_Genome* genome) {
     bool inserted = false;
     bool erased_population = check_population();
@@ -96,6 +96,8 @@ class NeatSpeciationStrategy : public SpeciationStrategy {
      */
     int32_t insert_genome(RNN_Genome* genome);
 
+    void set_migrant_generation_id(RNN_Genome* genome);
+
     /**
      * Generates a new genome.
      *
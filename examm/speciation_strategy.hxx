@@ -57,6 +57,15 @@ class SpeciationStrategy {
      */
     virtual int32_t insert_genome(RNN_Genome* genome) = 0;
 
+    /**
+     * Gives a genome which was generated elsewhere (e.g., a migrant from another EXAMM) the next
+     * generation id of this speciation strategy, so it can't collide with the ids of the genomes
+     * generated here.
+     *
+     * \param genome is the genome to give the generation id to.
+     */
+    virtual void set_migrant_generation_id(RNN_Genome* genome) = 0;
+
     /**
      * Generates a new genome.
      *
@@ -0,0 +1,77 @@
+#include <condition_variable>
+using std::condition_variable;
+
+#include <mutex>
+using std::mutex;
+using std::unique_lock;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "batch_prefetcher.hxx"
+#include "image_set_interface.hxx"
+
+BatchPrefetcher::BatchPrefetcher(const ImagesInterface& _images, const vector<vector<int> >& _batches)
+    : images(_images), batches(_batches), next_batch(0), released(0), fetched(0), stopping(false) {
+    int32_t image_size = images.get_image_channels() * images.get_image_height() * images.get_image_width();
+
+    int32_t max_batch_size = 0;
+    for (int32_t i = 0; i < (int32_t) batches.size(); i++) {
+        if ((int32_t) batches[i].size() > max_batch_size) {
+            max_batch_size = batches[i].size();
+        }
+    }
+
+    buffers[0].resize(max_batch_size * image_size);
+    buffers[1].resize(max_batch_size * image_size);
+
+    fetcher = thread(&BatchPrefetcher::fetch_batches, this);
+}
+
+BatchPrefetcher::~BatchPrefetcher() {
+    {
+        unique_lock<mutex> lock(batch_mutex);
+        stopping = true;
+    }
+    batch_released.notify_all();
+    fetcher.join();
+}
+
+void BatchPrefetcher::fetch_batches() {
+    for (int32_t batch = 0; batch < (int32_t) batches.size(); batch++) {
+        {
+            // wait for the buffer to be released by the batch two before this one
+            unique_lock<mutex> lock(batch_mutex);
+            batch_released.wait(lock, [&] { return stopping || batch < released + 2; });
+            if (stopping) {
+                return;
+            }
+        }
+
+        images.get_batch(batches[batch], buffers[batch % 2].data());
+
+        {
+            unique_lock<mutex> lock(batch_mutex);
+            fetched = batch + 1;
+        }
+        batch_fetched.notify_one();
+    }
+}
+
+const float* BatchPrefetcher::get_next_batch() {
+    int32_t batch = next_batch;
+    next_batch++;
+
+    unique_lock<mutex> lock(batch_mutex);
+
+    // the batch returned before this one is done with, so its buffer can be fetched into
+    released = batch;
+    batch_released.notify_one();
+
+    batch_fetched.wait(lock, [&] { return fetched > batch; });
+
+    return buffers[batch % 2].data();
+}
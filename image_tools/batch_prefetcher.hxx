@@ -0,0 +1,56 @@
+#ifndef BATCH_PREFETCHER_HXX
+#define BATCH_PREFETCHER_HXX
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <mutex>
+using std::mutex;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "image_set_interface.hxx"
+
+/**
+ * Fetches the (normalized, contiguous) values of a list of batches with ImagesInterface::get_batch
+ * on a background thread, so the next batch is ready while the current one is being trained or
+ * evaluated. Two buffers are used, so the thread fetches at most one batch ahead.
+ */
+class BatchPrefetcher {
+   private:
+    const ImagesInterface& images;
+    vector<vector<int> > batches;
+
+    vector<float> buffers[2];
+
+    int32_t next_batch;
+
+    // batches [0, released) are no longer used, and [0, fetched) have been fetched
+    int32_t released;
+    int32_t fetched;
+    bool stopping;
+
+    mutex batch_mutex;
+    condition_variable batch_fetched;
+    condition_variable batch_released;
+
+    thread fetcher;
+
+    void fetch_batches();
+
+   public:
+    BatchPrefetcher(const ImagesInterface& _images, const vector<vector<int> >& _batches);
+    ~BatchPrefetcher();
+
+    /**
+     * Returns the values of the next batch, waiting for them to be fetched if needed. They are
+     * valid until the following call.
+     */
+    const float* get_next_batch();
+};
+
+#endif
@@ -1,4 +1,12 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <cmath>
+#include <cstring>
+using std::memcpy;
+
 #include <fstream>
 using std::ifstream;
 
@@ -22,41 +30,25 @@ using std::vector;
 #include "stdint.h"
 
 Image::Image(
-    ifstream& infile, int _channels, int _width, int _height, int _padding, int _classification, const Images* _images
+    const uint8_t* _pixels, int _channels, int _width, int _height, int _padding, int _classification,
+    const Images* _images
 ) {
+    pixels = _pixels;
     channels = _channels;
     width = _width;
     height = _height;
     padding = _padding;
     classification = _classification;
     images = _images;
-
-    pixels = vector<vector<vector<uint8_t> > >(channels, vector<vector<uint8_t> >(height, vector<uint8_t>(width, 0)));
-
-    char* c_pixels = new char[channels * width * height];
-
-    infile.read(c_pixels, sizeof(char) * channels * width * height);
-
-    int current = 0;
-    for (int32_t z = 0; z < channels; z++) {
-        for (int32_t y = 0; y < height; y++) {
-            for (int32_t x = 0; x < width; x++) {
-                pixels[z][y][x] = (uint8_t) c_pixels[current];
-                current++;
-            }
-        }
-    }
-
-    delete[] c_pixels;
 }
 
 float Image::get_pixel(int z, int y, int x) const {
     if (y < padding || x < padding) {
         return 0;
-    } else if (y >= width + padding || x >= height + padding) {
+    } else if (y >= height + padding || x >= width + padding) {
         return 0;
     } else {
-        return ((pixels[z][y - padding][x - padding] / 255.0) - images->get_channel_avg(z))
+        return ((pixels[(((z * height) + (y - padding)) * width) + (x - padding)] / 255.0) - images->get_channel_avg(z))
                / images->get_channel_std_dev(z);
     }
 }
@@ -72,7 +64,7 @@ void Image::get_pixel_avg(vector<float>& channel_avgs) const {
     for (int32_t z = 0; z < channels; z++) {
         for (int32_t y = 0; y < height; y++) {
             for (int32_t x = 0; x < width; x++) {
-                channel_avgs[z] += pixels[z][y][x] / 255.0;
+                channel_avgs[z] += pixels[(((z * height) + y) * width) + x] / 255.0;
             }
         }
         channel_avgs[z] /= (height * width);
@@ -87,7 +79,7 @@ void Image::get_pixel_variance(const vector<float>& channel_avgs, vector<float>&
     for (int32_t z = 0; z < channels; z++) {
         for (int32_t y = 0; y < height; y++) {
             for (int32_t x = 0; x < width; x++) {
-                tmp = channel_avgs[z] - (pixels[z][y][x] / 255.0);
+                tmp = channel_avgs[z] - (pixels[(((z * height) + y) * width) + x] / 255.0);
                 channel_variances[z] += tmp * tmp;
             }
         }
@@ -101,7 +93,7 @@ void Image::print(ostream& out) {
     for (int32_t z = 0; z < channels; z++) {
         for (int32_t y = 0; y < height; y++) {
             for (int32_t x = 0; x < width; x++) {
-                out << setw(7) << pixels[z][y][x];
+                out << setw(7) << pixels[(((z * height) + y) * width) + x];
             }
             out << endl;
         }
@@ -114,16 +106,35 @@ string Images::get_filename() const {
 
 int Images::read_images(string _filename) {
     filename = _filename;
+    number_images = 0;
 
-    ifstream infile(filename.c_str(), ios::in | ios::binary);
-
-    if (!infile.is_open()) {
+    int file_descriptor = open(filename.c_str(), O_RDONLY);
+    if (file_descriptor < 0) {
         cerr << "Could not open '" << filename << "' for reading." << endl;
         return 1;
     }
 
+    struct stat file_stat;
+    if (fstat(file_descriptor, &file_stat) < 0 || file_stat.st_size < (off_t) (4 * sizeof(int))) {
+        cerr << "Could not read the header of '" << filename << "'." << endl;
+        close(file_descriptor);
+        return 1;
+    }
+
+    // the pixels are used directly from the mapped file, which the kernel pages in as needed
+    mapped_size = file_stat.st_size;
+    void* mapping = mmap(NULL, mapped_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    close(file_descriptor);
+
+    if (mapping == MAP_FAILED) {
+        cerr << "Could not memory map '" << filename << "'." << endl;
+        mapped_size = 0;
+        return 1;
+    }
+    mapped_file = (uint8_t*) mapping;
+
     int initial_vals[4];
-    infile.read((char*) &initial_vals, sizeof(initial_vals));
+    memcpy(initial_vals, mapped_file, sizeof(initial_vals));
 
     number_classes = initial_vals[0];
     channels = initial_vals[1];
@@ -135,21 +146,40 @@ int Images::read_images(string _filename) {
     cerr << "width: " << width << endl;
     cerr << "height: " << height << endl;
 
+    size_t header_size = sizeof(initial_vals) + (sizeof(int) * number_classes);
+    if (number_classes < 0 || header_size > mapped_size) {
+        cerr << "Could not read the class sizes of '" << filename << "'." << endl;
+        return 1;
+    }
+
     class_sizes = vector<int>(number_classes, 0);
-    infile.read((char*) &class_sizes[0], sizeof(int) * number_classes);
+    memcpy(&class_sizes[0], mapped_file + sizeof(initial_vals), sizeof(int) * number_classes);
 
     int image_size = channels * width * height;
 
+    size_t total_images = 0;
+    for (int i = 0; i < number_classes; i++) {
+        total_images += class_sizes[i];
+    }
+
+    if (header_size + (total_images * image_size) > mapped_size) {
+        cerr << "'" << filename << "' is too small for " << total_images << " images of size " << image_size << "."
+             << endl;
+        return 1;
+    }
+    number_images = total_images;
+
+    // the images of each class are stored one after the other following the header
+    const uint8_t* pixels = mapped_file + header_size;
+    images.reserve(number_images);
     for (int i = 0; i < number_classes; i++) {
         cerr << "reading image set with " << class_sizes[i] << " images." << endl;
 
         for (int32_t j = 0; j < class_sizes[i]; j++) {
-            images.push_back(Image(infile, channels, width, height, padding, i, this));
+            images.push_back(Image(pixels, channels, width, height, padding, i, this));
+            pixels += image_size;
         }
     }
-    number_images = images.size();
-
-    infile.close();
 
     cerr << "image_size: " << channels << "x" << width << "x" << height << " = " << image_size << endl;
 
@@ -158,12 +188,6 @@ int Images::read_images(string _filename) {
         cerr << "    class " << setw(4) << i << ": " << class_sizes[i] << endl;
     }
 
-    /*
-   for (int i = 0; i < images.size(); i++) {
-       images[i].print(cerr);
-   }
-   */
-
     return 0;
 }
 
@@ -171,6 +195,8 @@ Images::Images(
     string _filename, int _padding, const vector<float>& _channel_avg, const vector<float>& _channel_std_dev
 ) {
     padding = _padding;
+    mapped_file = NULL;
+    mapped_size = 0;
 
     filename = _filename;
     had_error = read_images(filename);
@@ -181,6 +207,8 @@ Images::Images(
 
 Images::Images(string _filename, int _padding) {
     padding = _padding;
+    mapped_file = NULL;
+    mapped_size = 0;
 
     filename = _filename;
     had_error = read_images(filename);
@@ -188,6 +216,12 @@ Images::Images(string _filename, int _padding) {
     calculate_avg_std_dev();
 }
 
+Images::~Images() {
+    if (mapped_file != NULL) {
+        munmap(mapped_file, mapped_size);
+    }
+}
+
 bool Images::loaded_correctly() const {
     return !had_error;
 }
@@ -224,6 +258,56 @@ float Images::get_pixel(int image, int z, int y, int x) const {
     return images[image].get_pixel(z, y, x);
 }
 
+void Images::get_batch(const vector<int>& batch, float* values) const {
+    // the normalized value of every possible pixel of each channel, calculated the same way as
+    // get_pixel so the values are identical
+    vector<vector<float> > normalized(channels, vector<float>(256));
+    for (int32_t z = 0; z < channels; z++) {
+        for (int32_t pixel = 0; pixel < 256; pixel++) {
+            normalized[z][pixel] = ((pixel / 255.0) - channel_avg[z]) / channel_std_dev[z];
+        }
+    }
+
+    int padded_width = width + (2 * padding);
+
+    int current = 0;
+    for (int32_t i = 0; i < (int32_t) batch.size(); i++) {
+        const Image& image = images[batch[i]];
+
+        for (int32_t z = 0; z < channels; z++) {
+            const float* channel_normalized = &normalized[z][0];
+
+            for (int32_t y = 0; y < padding; y++) {
+                for (int32_t x = 0; x < padded_width; x++) {
+                    values[current++] = 0;
+                }
+            }
+
+            for (int32_t y = 0; y < height; y++) {
+                const uint8_t* row = image.pixels + (((z * height) + y) * width);
+
+                for (int32_t x = 0; x < padding; x++) {
+                    values[current++] = 0;
+                }
+
+                for (int32_t x = 0; x < width; x++) {
+                    values[current++] = channel_normalized[row[x]];
+                }
+
+                for (int32_t x = 0; x < padding; x++) {
+                    values[current++] = 0;
+                }
+            }
+
+            for (int32_t y = 0; y < padding; y++) {
+                for (int32_t x = 0; x < padded_width; x++) {
+                    values[current++] = 0;
+                }
+            }
+        }
+    }
+}
+
 const vector<float>& Images::get_average() const {
     return channel_avg;
 }
@@ -14,6 +14,7 @@ using std::string;
 using std::vector;
 
 #include "image_set_interface.hxx"
+#include "stdint.h"
 
 typedef class Images Images;
 
@@ -26,14 +27,16 @@ class Image : public ImageInterface {
     int height;
     int width;
     int classification;
-    vector<vector<vector<uint8_t> > > pixels;
+
+    // the image's channels, rows and columns in the memory mapped image file of its Images
+    const uint8_t* pixels;
 
     // reference to images to get channel avgs and std_Devs
     const Images* images;
 
    public:
     Image(
-        ifstream& infile, int _channels, int _width, int _height, int _padding, int _classification,
+        const uint8_t* _pixels, int _channels, int _width, int _height, int _padding, int _classification,
         const Images* _images
     );
 
@@ -64,6 +67,10 @@ class Images : public ImagesInterface {
 
     vector<Image> images;
 
+    // the image file is memory mapped, and the images point to their pixels in it
+    uint8_t* mapped_file;
+    size_t mapped_size;
+
     vector<float> channel_avg;
     vector<float> channel_std_dev;
 
@@ -76,6 +83,11 @@ class Images : public ImagesInterface {
     Images(
         string binary_filename, int _padding, const vector<float>& _channeL_avg, const vector<float>& channel_std_dev
     );
+    ~Images();
+
+    // the images point into the mapped file, so they cannot be copied
+    Images(const Images&) = delete;
+    Images& operator=(const Images&) = delete;
 
     string get_filename() const;
 
@@ -91,6 +103,7 @@ class Images : public ImagesInterface {
 
     int get_classification(int image) const;
     float get_pixel(int image, int z, int y, int x) const;
+    void get_batch(const vector<int>& batch, float* values) const;
 
     void calculate_avg_std_dev();
 
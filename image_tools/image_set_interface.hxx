@@ -41,6 +41,14 @@ class ImagesInterface {
     virtual int get_classification(int image) const = 0;
     virtual float get_pixel(int image, int z, int y, int x) const = 0;
 
+    /**
+     * Writes the normalized pixels of the batch's images to values, contiguously: image by image,
+     * and each image by channel, row and column (the same as get_pixel, including the zero
+     * padding), so each image takes get_image_channels() * get_image_height() *
+     * get_image_width() values.
+     */
+    virtual void get_batch(const vector<int>& batch, float* values) const = 0;
+
     virtual float get_channel_avg(int channel) const = 0;
     virtual float get_channel_std_dev(int channel) const = 0;
 
@@ -882,6 +882,61 @@ float LargeImages::get_pixel(int subimage, int z, int y, int x) const {
     return 0;
 }
 
+void LargeImages::get_batch(const vector<int>& batch, float* values) const {
+    // the normalized value of every possible pixel of each channel, calculated the same way as
+    // get_pixel so the values are identical
+    vector<vector<float> > normalized(channels, vector<float>(256));
+    for (int32_t z = 0; z < channels; z++) {
+        for (int32_t pixel = 0; pixel < 256; pixel++) {
+            normalized[z][pixel] = ((pixel / 255.0) - channel_avg[z]) / channel_std_dev[z];
+        }
+    }
+
+    int padded_height = subimage_height + (2 * padding);
+    int padded_width = subimage_width + (2 * padding);
+
+    int current = 0;
+    for (int32_t b = 0; b < (int32_t) batch.size(); b++) {
+        // find the large image of the subimage once, instead of for every pixel
+        int subimage = batch[b];
+        int32_t i = 0;
+        while (i < (int32_t) images.size() && subimage >= images[i].get_number_subimages()) {
+            subimage -= images[i].get_number_subimages();
+            i++;
+        }
+
+        if (i == (int32_t) images.size()) {
+            cerr << "Error getting batch, subimage was: " << batch[b] << " and there are not that many subimages!"
+                 << endl;
+            exit(1);
+        }
+
+        const LargeImage& image = images[i];
+
+        int subimages_along_width = image.get_width() - subimage_width + 1;
+
+        int subimage_y_offset = subimage / subimages_along_width;
+        int subimage_x_offset = subimage % subimages_along_width;
+
+        for (int32_t z = 0; z < channels; z++) {
+            const float* channel_normalized = &normalized[z][0];
+
+            for (int32_t y = 0; y < padded_height; y++) {
+                for (int32_t x = 0; x < padded_width; x++) {
+                    if (y < padding || x < padding || y >= subimage_height + padding
+                        || x >= subimage_width + padding) {
+                        values[current] = 0;
+                    } else {
+                        values[current] =
+                            channel_normalized[image.get_pixel(z, subimage_y_offset + y, subimage_x_offset + x)];
+                    }
+                    current++;
+                }
+            }
+        }
+    }
+}
+
 const vector<float>& LargeImages::get_average() const {
     return channel_avg;
 }
@@ -132,6 +132,7 @@ class LargeImages : public MultiImagesInterface {
     int get_image_classification(int image) const;
     int get_classification(int subimage) const;
     float get_pixel(int subimage, int z, int y, int x) const;
+    void get_batch(const vector<int>& batch, float* values) const;
     float get_raw_pixel(int subimage, int z, int y, int x) const;
 
     void calculate_avg_std_dev();
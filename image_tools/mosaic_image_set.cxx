@@ -24,6 +24,7 @@ using std::vector;
 
 #include "large_image_set.hxx"
 #include "mosaic_image_set.hxx"
+#include "mosaic_tiler.hxx"
 #include "stdint.h"
 using std::ostringstream;
 
@@ -39,44 +40,42 @@ Line::Line(int _y1, int _x1, int _y2, int _x2) : y1(_y1), x1(_x1), y2(_y2), x2(_
 Rectangle::Rectangle(int _y1, int _x1, int _y2, int _x2) : y1(_y1), x1(_x1), y2(_y2), x2(_x2) {
 }
 
-void MosaicImages::get_mosaic_pixels(
-    string filename, vector<vector<vector<uint8_t> > >& pixels, uint32_t& height, uint32_t& width
-) {
+TIFF* MosaicImages::open_mosaic(string filename, uint32_t& height, uint32_t& width) {
     TIFF* tif = TIFFOpen(filename.c_str(), "r");
+    if (tif == NULL) {
+        cerr << "ERROR: could not open mosaic '" << filename << "' for reading." << endl;
+        exit(1);
+    }
+
+    uint16_t samples_per_pixel;
     TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height);  // uint32 height;
     TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width);    // uint32 width;
-    TIFFGetField(tif, TIFFTAG_SAMPLESPERPIXEL, &channels);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &samples_per_pixel);
+    channels = samples_per_pixel > 4 ? 4 : samples_per_pixel;
 
     cout << filename << ", height: " << height << ", width: " << width << ", channels: " << channels << endl;
 
-    uint32_t* raster = (uint32_t*) _TIFFmalloc(height * width * sizeof(uint32_t));
-    TIFFReadRGBAImage(tif, width, height, raster, 0);
-
-    pixels.resize(channels, vector<vector<uint8_t> >(height, vector<uint8_t>(width, 0)));
-
-    // cout << "pixels: " << endl;
-    int current_y = 0;
-    int current_x = 0;
-    for (uint32_t i = 0; i < height * width; i++) {
-        pixels[0][height - 1 - current_y][current_x] = TIFFGetR(raster[i]);
-        if (channels > 1) {
-            pixels[1][height - 1 - current_y][current_x] = TIFFGetG(raster[i]);
-        }
-        if (channels > 2) {
-            pixels[2][height - 1 - current_y][current_x] = TIFFGetB(raster[i]);
-        }
-        if (channels > 3) {
-            pixels[3][height - 1 - current_y][current_x] = TIFFGetA(raster[i]);
-        }
+    return tif;
+}
 
-        current_x++;
-        if (current_x == width) {
-            current_x = 0;
-            current_y++;
+void MosaicImages::get_mosaic_pixels(
+    TIFF* tif, int32_t y, int32_t x, int32_t rows, int32_t columns, vector<vector<vector<uint8_t> > >& pixels
+) {
+    // only the region is decoded, so the whole mosaic never needs to be in memory
+    vector<uint8_t> region((size_t) rows * channels * columns);
+    read_tiff_region(tif, channels, y, x, rows, columns, region.data());
+
+    pixels.assign(channels, vector<vector<uint8_t> >(rows, vector<uint8_t>(columns, 0)));
+
+    int current = 0;
+    for (int32_t ry = 0; ry < rows; ry++) {
+        for (int32_t z = 0; z < channels; z++) {
+            for (int32_t rx = 0; rx < columns; rx++) {
+                pixels[z][ry][rx] = region[current];
+                current++;
+            }
         }
     }
-    _TIFFfree(raster);
-    TIFFClose(tif);
 }
 
 void MosaicImages::read_mosaic(
@@ -84,8 +83,7 @@ void MosaicImages::read_mosaic(
 ) {
     uint32_t height;
     uint32_t width;
-    vector<vector<vector<uint8_t> > > pixels;
-    get_mosaic_pixels(filename, pixels, height, width);
+    TIFF* tif = open_mosaic(filename, height, width);
 
     for (uint32_t i = 0; i < box_centers.size(); i++) {
         int32_t start_x = box_centers[i].x - box_radius;
@@ -117,16 +115,8 @@ void MosaicImages::read_mosaic(
         int subimages_along_height = (box_height - subimage_height) + 1;
         int number_subimages = subimages_along_width * subimages_along_height;
 
-        vector<vector<vector<uint8_t> > > box_pixels(
-            channels, vector<vector<uint8_t> >(box_height, vector<uint8_t>(box_width, 0))
-        );
-        for (uint32_t bz = 0; bz < channels; bz++) {
-            for (uint32_t by = 0; by < box_height; by++) {
-                for (uint32_t bx = 0; bx < box_width; bx++) {
-                    box_pixels[bz][by][bx] = pixels[bz][start_y + by][start_x + bx];
-                }
-            }
-        }
+        vector<vector<vector<uint8_t> > > box_pixels;
+        get_mosaic_pixels(tif, start_y, start_x, box_height, box_width, box_pixels);
 
         LargeImage mosaic_image(number_subimages, channels, box_width, box_height, padding, box_classes[i], box_pixels);
         images.push_back(mosaic_image);
@@ -137,6 +127,8 @@ void MosaicImages::read_mosaic(
         mosaic_image.draw_image(oss.str());
         */
     }
+
+    TIFFClose(tif);
 }
 
 void MosaicImages::read_mosaic(
@@ -144,8 +136,7 @@ void MosaicImages::read_mosaic(
 ) {
     uint32_t height;
     uint32_t width;
-    vector<vector<vector<uint8_t> > > pixels;
-    get_mosaic_pixels(filename, pixels, height, width);
+    TIFF* tif = open_mosaic(filename, height, width);
 
     for (uint32_t i = 0; i < lines.size(); i++) {
         int32_t y1 = lines[i].y1;
@@ -187,6 +178,18 @@ void MosaicImages::read_mosaic(
             channels, vector<vector<uint8_t> >(line_height, vector<uint8_t>(line_width, 0))
         );
 
+        // only the pixels of the mosaic which the rotated line can be over are decoded
+        int32_t radius = ceil(sqrt((double) (half_length * half_length) + (half_height * half_height)));
+        int32_t region_y = fmax(0, floor(y_center) - radius - 1);
+        int32_t region_x = fmax(0, floor(x_center) - radius - 1);
+        int32_t region_end_y = fmin(height, ceil(y_center) + radius + 2);
+        int32_t region_end_x = fmin(width, ceil(x_center) + radius + 2);
+
+        vector<vector<vector<uint8_t> > > pixels;
+        if (region_end_y > region_y && region_end_x > region_x) {
+            get_mosaic_pixels(tif, region_y, region_x, region_end_y - region_y, region_end_x - region_x, pixels);
+        }
+
         double cos_angle = cos(rotation_angle);
         double sin_angle = sin(rotation_angle);
 
@@ -215,9 +218,11 @@ void MosaicImages::read_mosaic(
 
                     double fy = tmy - (int32_t) tmy;
                     double fx = tmx - (int32_t) tmx;
+                    int32_t py = (int32_t) tmy - region_y;
+                    int32_t px = (int32_t) tmx - region_x;
                     line_pixels[bz][tly][tlx] =
-                        ((1 - fx) * (1 - fy) * pixels[bz][tmy][tmx]) + (fx * (1 - fy) * pixels[bz][tmy][tmx + 1])
-                        + ((1 - fx) * fy * pixels[bz][tmy + 1][tmx]) + (fx * fy * pixels[bz][tmy + 1][tmx + 1]);
+                        ((1 - fx) * (1 - fy) * pixels[bz][py][px]) + (fx * (1 - fy) * pixels[bz][py][px + 1])
+                        + ((1 - fx) * fy * pixels[bz][py + 1][px]) + (fx * fy * pixels[bz][py + 1][px + 1]);
                 }
             }
         }
@@ -241,6 +246,8 @@ void MosaicImages::read_mosaic(
         ".tif"; mosaic_image.draw_image(oss.str());
         */
     }
+
+    TIFFClose(tif);
 }
 
 void MosaicImages::initialize_counts(const vector<vector<int> >& classes) {
@@ -466,6 +473,61 @@ float MosaicImages::get_pixel(int subimage, int z, int y, int x) const {
     return 0;
 }
 
+void MosaicImages::get_batch(const vector<int>& batch, float* values) const {
+    // the normalized value of every possible pixel of each channel, calculated the same way as
+    // get_pixel so the values are identical
+    vector<vector<float> > normalized(channels, vector<float>(256));
+    for (int32_t z = 0; z < channels; z++) {
+        for (int32_t pixel = 0; pixel < 256; pixel++) {
+            normalized[z][pixel] = ((pixel / 255.0) - channel_avg[z]) / channel_std_dev[z];
+        }
+    }
+
+    int padded_height = subimage_height + (2 * padding);
+    int padded_width = subimage_width + (2 * padding);
+
+    int current = 0;
+    for (int32_t b = 0; b < (int32_t) batch.size(); b++) {
+        // find the large image of the subimage once, instead of for every pixel
+        int subimage = batch[b];
+        int32_t i = 0;
+        while (i < (int32_t) images.size() && subimage >= images[i].get_number_subimages()) {
+            subimage -= images[i].get_number_subimages();
+            i++;
+        }
+
+        if (i == (int32_t) images.size()) {
+            cerr << "Error getting batch, subimage was: " << batch[b] << " and there are not that many subimages!"
+                 << endl;
+            exit(1);
+        }
+
+        const LargeImage& image = images[i];
+
+        int subimages_along_width = image.get_width() - subimage_width + 1;
+
+        int subimage_y_offset = subimage / subimages_along_width;
+        int subimage_x_offset = subimage % subimages_along_width;
+
+        for (int32_t z = 0; z < channels; z++) {
+            const float* channel_normalized = &normalized[z][0];
+
+            for (int32_t y = 0; y < padded_height; y++) {
+                for (int32_t x = 0; x < padded_width; x++) {
+                    if (y < padding || x < padding || y >= subimage_height + padding
+                        || x >= subimage_width + padding) {
+                        values[current] = 0;
+                    } else {
+                        values[current] =
+                            channel_normalized[image.get_pixel(z, subimage_y_offset + y, subimage_x_offset + x)];
+                    }
+                    current++;
+                }
+            }
+        }
+    }
+}
+
 const vector<float>& MosaicImages::get_average() const {
     return channel_avg;
 }
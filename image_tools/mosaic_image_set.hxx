@@ -16,6 +16,9 @@ using std::vector;
 #include "image_set_interface.hxx"
 #include "large_image_set.hxx"
 
+// the same declaration as tiffio.h
+typedef struct tiff TIFF;
+
 typedef class MosaicImages MosaicImages;
 
 class Point {
@@ -65,8 +68,9 @@ class MosaicImages : public MultiImagesInterface {
     vector<float> channel_std_dev;
 
    public:
+    TIFF* open_mosaic(string filename, uint32_t& height, uint32_t& width);
     void get_mosaic_pixels(
-        string filename, vector<vector<vector<uint8_t> > >& pixels, uint32_t& height, uint32_t& width
+        TIFF* tif, int32_t y, int32_t x, int32_t rows, int32_t columns, vector<vector<vector<uint8_t> > >& pixels
     );
 
     void read_mosaic(string filename, const vector<Point>& box_centers, int box_radius, const vector<int>& box_classes);
@@ -119,6 +123,7 @@ class MosaicImages : public MultiImagesInterface {
     int get_image_classification(int image) const;
     int get_classification(int subimage) const;
     float get_pixel(int subimage, int z, int y, int x) const;
+    void get_batch(const vector<int>& batch, float* values) const;
     float get_raw_pixel(int subimage, int z, int y, int x) const;
 
     void calculate_avg_std_dev();
@@ -0,0 +1,559 @@
+#include <cmath>
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <iostream>
+using std::cerr;
+using std::cout;
+using std::endl;
+
+#include <mutex>
+using std::mutex;
+using std::unique_lock;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "mosaic_tiler.hxx"
+#include "stdint.h"
+#include "tiff.h"
+#include "tiffio.h"
+
+void read_tiff_region(
+    TIFF* tif, int32_t channels, int32_t y, int32_t x, int32_t rows, int32_t columns, uint8_t* pixels
+) {
+    char error[1024];
+    TIFFRGBAImage image;
+
+    if (!TIFFRGBAImageBegin(&image, tif, 0, error)) {
+        cerr << "ERROR: could not read TIFF: " << error << endl;
+        exit(1);
+    }
+
+    // the same as TIFFReadRGBAStrip does, but for any rows and columns of stripped or tiled TIFFs
+    image.req_orientation = ORIENTATION_TOPLEFT;
+    image.row_offset = y;
+    image.col_offset = x;
+
+    vector<uint32_t> raster((size_t) rows * columns);
+    if (!TIFFRGBAImageGet(&image, raster.data(), columns, rows)) {
+        cerr << "ERROR: could not read rows " << y << " to " << (y + rows) << " of TIFF." << endl;
+        exit(1);
+    }
+    TIFFRGBAImageEnd(&image);
+
+    for (int32_t row = 0; row < rows; row++) {
+        const uint32_t* raster_row = &raster[(size_t) row * columns];
+        uint8_t* row_pixels = &pixels[(size_t) row * channels * columns];
+
+        for (int32_t column = 0; column < columns; column++) {
+            row_pixels[column] = TIFFGetR(raster_row[column]);
+            if (channels > 1) {
+                row_pixels[columns + column] = TIFFGetG(raster_row[column]);
+            }
+            if (channels > 2) {
+                row_pixels[(2 * columns) + column] = TIFFGetB(raster_row[column]);
+            }
+            if (channels > 3) {
+                row_pixels[(3 * columns) + column] = TIFFGetA(raster_row[column]);
+            }
+        }
+    }
+}
+
+static TIFF* open_output_tiff(string filename, int32_t height, int32_t width, int32_t samples_per_pixel) {
+    // BigTIFF is needed once the image is over 4GB
+    const char* mode = (int64_t) height * width * samples_per_pixel > 4000000000LL ? "w8" : "w";
+
+    TIFF* output_tif = TIFFOpen(filename.c_str(), mode);
+    if (output_tif == NULL) {
+        cerr << "ERROR: could not open '" << filename << "' for writing." << endl;
+        exit(1);
+    }
+
+    TIFFSetField(output_tif, TIFFTAG_IMAGEWIDTH, width);
+    TIFFSetField(output_tif, TIFFTAG_IMAGELENGTH, height);
+    TIFFSetField(output_tif, TIFFTAG_SAMPLESPERPIXEL, samples_per_pixel);
+    TIFFSetField(output_tif, TIFFTAG_BITSPERSAMPLE, 8);
+    TIFFSetField(output_tif, TIFFTAG_ORIENTATION, (int) ORIENTATION_TOPLEFT);
+    TIFFSetField(output_tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(output_tif, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
+
+    if (samples_per_pixel == 1) {
+        TIFFSetField(output_tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+    } else {
+        uint16_t extra_samples[1] = {EXTRASAMPLE_UNASSALPHA};
+        TIFFSetField(output_tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+        TIFFSetField(output_tif, TIFFTAG_EXTRASAMPLES, 1, extra_samples);
+    }
+
+    // the rows are written as they are completed, so each strip should only be a few of them
+    TIFFSetField(output_tif, TIFFTAG_ROWSPERSTRIP, TIFFDefaultStripSize(output_tif, 0));
+
+    return output_tif;
+}
+
+MosaicTiler::MosaicTiler(string _filename, int _padding, int _subimage_height, int _subimage_width, int _band_rows)
+    : filename(_filename),
+      padding(_padding),
+      subimage_height(_subimage_height),
+      subimage_width(_subimage_width),
+      band_rows(_band_rows),
+      band_y(0),
+      band_height(0),
+      decoded_y(0),
+      decoded_height(0),
+      decoded_ready(false),
+      stopping(false),
+      written_rows(0),
+      max_prediction(0.0),
+      max_y(0),
+      max_x(0),
+      predictions_tif(NULL),
+      merged_tif(NULL) {
+    tif = TIFFOpen(filename.c_str(), "r");
+    if (tif == NULL) {
+        cerr << "ERROR: could not open mosaic '" << filename << "' for reading." << endl;
+        exit(1);
+    }
+
+    uint32_t tiff_height, tiff_width;
+    uint16_t samples_per_pixel;
+    TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &tiff_height);
+    TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &tiff_width);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &samples_per_pixel);
+
+    height = tiff_height;
+    width = tiff_width;
+    channels = samples_per_pixel > 4 ? 4 : samples_per_pixel;
+
+    cout << filename << ", height: " << height << ", width: " << width << ", channels: " << channels << endl;
+
+    if (height < subimage_height || width < subimage_width) {
+        cerr << "ERROR: mosaic '" << filename << "' (" << height << "x" << width << ") is smaller than a subimage ("
+             << subimage_height << "x" << subimage_width << ")" << endl;
+        exit(1);
+    }
+
+    if (band_rows < 1) {
+        band_rows = 1;
+    }
+
+    cout << "predicting bands of " << band_rows << " rows of subimages, "
+         << ((int64_t) (band_rows + subimage_height - 1) * channels * width) << " bytes each" << endl;
+
+    // the number of subimages over the pixels covered by the most of them, as in
+    // CNN_Genome::get_expanded_prediction_matrix
+    max_count = fmin(subimage_height, height - subimage_height + 1) * fmin(subimage_width, width - subimage_width + 1);
+    expanded.assign(subimage_height, vector<float>(width, 0.0));
+
+    calculate_avg_std_dev();
+
+    decoder = thread(&MosaicTiler::decode_bands, this);
+}
+
+MosaicTiler::~MosaicTiler() {
+    {
+        unique_lock<mutex> lock(decode_mutex);
+        stopping = true;
+    }
+    band_taken.notify_all();
+    decoder.join();
+
+    if (predictions_tif != NULL) {
+        TIFFClose(predictions_tif);
+    }
+    if (merged_tif != NULL) {
+        TIFFClose(merged_tif);
+    }
+    TIFFClose(tif);
+}
+
+/**
+ * The mosaic can't be held in memory to average, so the pixel values are counted a band at a time
+ * and the average and standard deviation of each channel are calculated from the counts.
+ */
+void MosaicTiler::calculate_avg_std_dev() {
+    vector<vector<int64_t> > counts(channels, vector<int64_t>(256, 0));
+
+    int32_t rows = band_rows + subimage_height - 1;
+    vector<uint8_t> pixels((size_t) rows * channels * width);
+
+    for (int32_t y = 0; y < height; y += rows) {
+        int32_t read_rows = y + rows > height ? height - y : rows;
+        read_tiff_region(tif, channels, y, 0, read_rows, width, pixels.data());
+
+        for (int32_t row = 0; row < read_rows; row++) {
+            for (int32_t z = 0; z < channels; z++) {
+                const uint8_t* channel_pixels = &pixels[(((size_t) row * channels) + z) * width];
+                for (int32_t x = 0; x < width; x++) {
+                    counts[z][channel_pixels[x]]++;
+                }
+            }
+        }
+    }
+
+    double number_pixels = (double) height * width;
+
+    channel_avg.assign(channels, 0.0);
+    channel_std_dev.assign(channels, 0.0);
+    for (int32_t z = 0; z < channels; z++) {
+        double avg = 0.0;
+        for (int32_t pixel = 0; pixel < 256; pixel++) {
+            avg += counts[z][pixel] * (pixel / 255.0);
+        }
+        avg /= number_pixels;
+
+        double variance = 0.0;
+        for (int32_t pixel = 0; pixel < 256; pixel++) {
+            double difference = avg - (pixel / 255.0);
+            variance += counts[z][pixel] * difference * difference;
+        }
+        variance /= number_pixels;
+
+        channel_avg[z] = avg;
+        channel_std_dev[z] = sqrt(variance);
+
+        cerr << "average pixel value for channel " << z << ": " << channel_avg[z] << endl;
+        cerr << "pixel standard deviation for channel " << z << ": " << channel_std_dev[z] << endl;
+    }
+}
+
+void MosaicTiler::decode_bands() {
+    // the first band needs all of its rows, the following ones only the band_rows after the
+    // previous band
+    int32_t y = 0;
+    int32_t rows = band_rows + subimage_height - 1;
+
+    while (y < height) {
+        if (y + rows > height) {
+            rows = height - y;
+        }
+
+        {
+            // wait for the previously decoded rows to be moved into a band
+            unique_lock<mutex> lock(decode_mutex);
+            band_taken.wait(lock, [&] { return stopping || !decoded_ready; });
+            if (stopping) {
+                return;
+            }
+        }
+
+        decoded.resize((size_t) rows * channels * width);
+        read_tiff_region(tif, channels, y, 0, rows, width, decoded.data());
+
+        {
+            unique_lock<mutex> lock(decode_mutex);
+            decoded_y = y;
+            decoded_height = rows;
+            decoded_ready = true;
+        }
+        band_decoded.notify_one();
+
+        y += rows;
+        rows = band_rows;
+    }
+}
+
+bool MosaicTiler::next_band() {
+    int32_t next_y = band_height == 0 ? 0 : band_y + band_rows;
+    if (next_y > height - subimage_height) {
+        return false;
+    }
+
+    unique_lock<mutex> lock(decode_mutex);
+    band_decoded.wait(lock, [&] { return decoded_ready; });
+
+    if (decoded_y != band_y + band_height) {
+        cerr << "ERROR: decoded rows of mosaic start at " << decoded_y << " but the band ends at "
+             << (band_y + band_height) << endl;
+        exit(1);
+    }
+
+    // the halo is the rows of the current band which the next band's subimages overlap
+    int32_t halo = band_y + band_height - next_y;
+    size_t row_size = (size_t) channels * width;
+
+    band.erase(band.begin(), band.begin() + ((band_height - halo) * row_size));
+    band.insert(band.end(), decoded.begin(), decoded.begin() + (decoded_height * row_size));
+
+    band_y = next_y;
+    band_height = halo + decoded_height;
+
+    decoded_ready = false;
+    lock.unlock();
+    band_taken.notify_one();
+
+    return true;
+}
+
+int32_t MosaicTiler::get_band_y() const {
+    return band_y;
+}
+
+int32_t MosaicTiler::get_mosaic_height() const {
+    return height;
+}
+
+int32_t MosaicTiler::get_mosaic_width() const {
+    return width;
+}
+
+void MosaicTiler::open_outputs(string predictions_filename, string merged_filename) {
+    if (written_rows > 0) {
+        cerr << "ERROR: the outputs of a mosaic must be opened before any of its predictions are added." << endl;
+        exit(1);
+    }
+
+    predictions_tif = open_output_tiff(predictions_filename, height, width, 1);
+    merged_tif = open_output_tiff(merged_filename, height, width, 4);
+}
+
+void MosaicTiler::add_predictions(const vector<float>& predictions, int32_t number_classes, int32_t prediction_class) {
+    int32_t subimages_along_height = band_height - subimage_height + 1;
+    int32_t subimages_along_width = width - subimage_width + 1;
+
+    if ((int64_t) predictions.size() != (int64_t) subimages_along_height * subimages_along_width * number_classes) {
+        cerr << "ERROR: " << (predictions.size() / number_classes) << " predictions were added to a band of mosaic '"
+             << filename << "' with " << (subimages_along_height * subimages_along_width) << " subimages." << endl;
+        exit(1);
+    }
+
+    // the subimages are added in the same order as get_expanded_prediction_matrix does, so the
+    // sums are the same
+    int32_t current = 0;
+    for (int32_t sy = 0; sy < subimages_along_height; sy++) {
+        int32_t y = band_y + sy;
+
+        for (int32_t sx = 0; sx < subimages_along_width; sx++) {
+            float prediction = predictions[(current * number_classes) + prediction_class];
+            current++;
+
+            for (int32_t oy = 0; oy < subimage_height; oy++) {
+                float* row = &expanded[(y + oy) % subimage_height][sx];
+                for (int32_t ox = 0; ox < subimage_width; ox++) {
+                    row[ox] += prediction;
+                }
+            }
+        }
+
+        // no later subimages cover this row
+        write_row(y);
+    }
+}
+
+void MosaicTiler::write_row(int32_t y) {
+    vector<float>& row = expanded[y % subimage_height];
+    vector<uint8_t> alpha(width);
+
+    for (int32_t x = 0; x < width; x++) {
+        row[x] /= max_count;
+
+        if (row[x] > max_prediction) {
+            max_prediction = row[x];
+            max_y = y;
+            max_x = x;
+        }
+
+        alpha[x] = row[x] * 255.0;
+    }
+
+    if (predictions_tif != NULL) {
+        if (TIFFWriteScanline(predictions_tif, alpha.data(), y, 0) < 0) {
+            cerr << "ERROR: could not write row " << y << " of the predictions." << endl;
+            exit(1);
+        }
+
+        // grayscale mosaics are drawn in every color channel
+        const uint8_t* pixels = &band[(size_t) (y - band_y) * channels * width];
+        vector<uint8_t> merged(width * 4);
+        for (int32_t x = 0; x < width; x++) {
+            for (int32_t z = 0; z < 3; z++) {
+                merged[(x * 4) + z] = pixels[((z < channels ? z : 0) * width) + x];
+            }
+            merged[(x * 4) + 3] = alpha[x];
+        }
+
+        if (TIFFWriteScanline(merged_tif, merged.data(), y, 0) < 0) {
+            cerr << "ERROR: could not write row " << y << " of the merged predictions." << endl;
+            exit(1);
+        }
+    }
+
+    row.assign(width, 0.0);
+    written_rows = y + 1;
+}
+
+void MosaicTiler::finish() {
+    if (written_rows != height - subimage_height + 1) {
+        cerr << "ERROR: finished mosaic '" << filename << "' before every band was predicted." << endl;
+        exit(1);
+    }
+
+    // the rows below the last subimages are in the last band
+    for (int32_t y = written_rows; y < height; y++) {
+        write_row(y);
+    }
+
+    if (predictions_tif != NULL) {
+        TIFFClose(predictions_tif);
+        TIFFClose(merged_tif);
+        predictions_tif = NULL;
+        merged_tif = NULL;
+    }
+}
+
+float MosaicTiler::get_max_prediction() const {
+    return max_prediction;
+}
+
+int32_t MosaicTiler::get_max_y() const {
+    return max_y;
+}
+
+int32_t MosaicTiler::get_max_x() const {
+    return max_x;
+}
+
+string MosaicTiler::get_filename() const {
+    return filename;
+}
+
+// the subimages of a mosaic are unlabeled, so they are all given class 0
+
+int MosaicTiler::get_class_size(int i) const {
+    return i == 0 ? get_number_images() : 0;
+}
+
+int MosaicTiler::get_number_classes() const {
+    return 1;
+}
+
+int MosaicTiler::get_number_images() const {
+    return get_number_subimages(0);
+}
+
+int MosaicTiler::get_number_large_images() const {
+    return 1;
+}
+
+int MosaicTiler::get_number_subimages(int i) const {
+    return (band_height - subimage_height + 1) * (width - subimage_width + 1);
+}
+
+int MosaicTiler::get_padding() const {
+    return padding;
+}
+
+int MosaicTiler::get_image_channels() const {
+    return channels;
+}
+
+int MosaicTiler::get_image_width() const {
+    return subimage_width + (2 * padding);
+}
+
+int MosaicTiler::get_image_height() const {
+    return subimage_height + (2 * padding);
+}
+
+int MosaicTiler::get_large_image_channels(int image) const {
+    return channels;
+}
+
+int MosaicTiler::get_large_image_width(int image) const {
+    return width;
+}
+
+int MosaicTiler::get_large_image_height(int image) const {
+    return band_height;
+}
+
+int MosaicTiler::get_image_classification(int image) const {
+    return 0;
+}
+
+int MosaicTiler::get_classification(int subimage) const {
+    return 0;
+}
+
+float MosaicTiler::get_pixel(int subimage, int z, int y, int x) const {
+    if (y < padding || x < padding || y >= subimage_height + padding || x >= subimage_width + padding) {
+        return 0;
+    }
+
+    int subimages_along_width = width - subimage_width + 1;
+    int row = (subimage / subimages_along_width) + y - padding;
+    int column = (subimage % subimages_along_width) + x - padding;
+
+    return ((band[((((size_t) row * channels) + z) * width) + column] / 255.0) - channel_avg[z]) / channel_std_dev[z];
+}
+
+void MosaicTiler::get_batch(const vector<int>& batch, float* values) const {
+    // the normalized value of every possible pixel of each channel, calculated the same way as
+    // get_pixel so the values are identical
+    vector<vector<float> > normalized(channels, vector<float>(256));
+    for (int32_t z = 0; z < channels; z++) {
+        for (int32_t pixel = 0; pixel < 256; pixel++) {
+            normalized[z][pixel] = ((pixel / 255.0) - channel_avg[z]) / channel_std_dev[z];
+        }
+    }
+
+    int padded_height = subimage_height + (2 * padding);
+    int padded_width = subimage_width + (2 * padding);
+    int subimages_along_width = width - subimage_width + 1;
+
+    int current = 0;
+    for (int32_t b = 0; b < (int32_t) batch.size(); b++) {
+        int subimage_y_offset = batch[b] / subimages_along_width;
+        int subimage_x_offset = batch[b] % subimages_along_width;
+
+        for (int32_t z = 0; z < channels; z++) {
+            const float* channel_normalized = &normalized[z][0];
+
+            for (int32_t y = 0; y < padded_height; y++) {
+                const uint8_t* row = NULL;
+                if (y >= padding && y < subimage_height + padding) {
+                    row = &band[((((size_t) (subimage_y_offset + y - padding) * channels) + z) * width)
+                                + subimage_x_offset];
+                }
+
+                for (int32_t x = 0; x < padded_width; x++) {
+                    if (row == NULL || x < padding || x >= subimage_width + padding) {
+                        values[current] = 0;
+                    } else {
+                        values[current] = channel_normalized[row[x - padding]];
+                    }
+                    current++;
+                }
+            }
+        }
+    }
+}
+
+float MosaicTiler::get_raw_pixel(int subimage, int z, int y, int x) const {
+    return band[((((size_t) y * channels) + z) * width) + x];
+}
+
+float MosaicTiler::get_channel_avg(int channel) const {
+    return channel_avg[channel];
+}
+
+float MosaicTiler::get_channel_std_dev(int channel) const {
+    return channel_std_dev[channel];
+}
+
+const vector<float>& MosaicTiler::get_average() const {
+    return channel_avg;
+}
+
+const vector<float>& MosaicTiler::get_std_dev() const {
+    return channel_std_dev;
+}
@@ -0,0 +1,171 @@
+#ifndef MOSAIC_TILER_HXX
+#define MOSAIC_TILER_HXX
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <mutex>
+using std::mutex;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "image_set_interface.hxx"
+
+// the same declaration as tiffio.h, so users of the tiler don't need the libtiff headers
+typedef struct tiff TIFF;
+
+/**
+ * Reads rows [y, y + rows) and columns [x, x + columns) of a TIFF, decoding only the strips or
+ * tiles they are in. The pixels are written row by row, with the channels of each row one after
+ * another: pixels[(((row * channels) + z) * columns) + column].
+ */
+void read_tiff_region(
+    TIFF* tif, int32_t channels, int32_t y, int32_t x, int32_t rows, int32_t columns, uint8_t* pixels
+);
+
+/**
+ * Streams a TIFF mosaic too large to fit in memory through a CNN, a band of rows at a time. Each
+ * band holds the rows of band_rows rows of subimages, so along with the band's own rows it keeps
+ * the subimage_height - 1 rows (the halo) of the next band that its last subimages overlap. The
+ * halo is moved to the front of the next band so only the new rows are decoded, which is done on
+ * a background thread while the current band is being predicted.
+ *
+ * The current band is the only large image of the MultiImagesInterface, so it can be given to
+ * CNN_Genome::evaluate_large_image. The predictions of each band are then given to
+ * add_predictions, which expands them over the pixels of their subimages (as
+ * CNN_Genome::get_expanded_prediction_matrix does) and writes every row whose subimages have all
+ * been predicted to the output TIFFs, so only subimage_height rows of them are kept.
+ */
+class MosaicTiler : public MultiImagesInterface {
+   private:
+    string filename;
+    TIFF* tif;
+
+    int32_t channels;
+    int32_t height, width;
+
+    int32_t padding;
+    int32_t subimage_height, subimage_width;
+    int32_t band_rows;
+
+    vector<float> channel_avg;
+    vector<float> channel_std_dev;
+
+    // rows [band_y, band_y + band_height) of the mosaic, laid out like read_tiff_region's
+    vector<uint8_t> band;
+    int32_t band_y;
+    int32_t band_height;
+
+    // the rows after the current band, [decoded_y, decoded_y + decoded_height), decoded by the
+    // background thread
+    vector<uint8_t> decoded;
+    int32_t decoded_y;
+    int32_t decoded_height;
+    bool decoded_ready;
+    bool stopping;
+
+    mutex decode_mutex;
+    condition_variable band_decoded;
+    condition_variable band_taken;
+
+    thread decoder;
+
+    // the sums of the predictions of the subimages over each pixel of the subimage_height rows
+    // after the last row written, row y is expanded[y % subimage_height]
+    vector<vector<float> > expanded;
+    int32_t written_rows;
+    int32_t max_count;
+
+    float max_prediction;
+    int32_t max_y, max_x;
+
+    TIFF* predictions_tif;
+    TIFF* merged_tif;
+
+    void calculate_avg_std_dev();
+    void decode_bands();
+    void write_row(int32_t y);
+
+   public:
+    MosaicTiler(string _filename, int _padding, int _subimage_height, int _subimage_width, int _band_rows);
+    ~MosaicTiler();
+
+    MosaicTiler(const MosaicTiler&) = delete;
+    MosaicTiler& operator=(const MosaicTiler&) = delete;
+
+    int32_t get_mosaic_height() const;
+    int32_t get_mosaic_width() const;
+
+    /**
+     * Moves on to the next band, waiting for its rows to be decoded if needed. Returns false once
+     * every band has been.
+     */
+    bool next_band();
+
+    // the row of the mosaic the current band's first subimages start at
+    int32_t get_band_y() const;
+
+    /**
+     * Opens the TIFFs the expanded predictions are written to: a grayscale image of the
+     * predictions, and the mosaic with the predictions as its alpha channel.
+     */
+    void open_outputs(string predictions_filename, string merged_filename);
+
+    /**
+     * Adds the predictions of the current band's subimages (from evaluate_large_image, with
+     * number_classes values for each subimage) for prediction_class to the pixels they cover, and
+     * writes the rows which are complete.
+     */
+    void add_predictions(const vector<float>& predictions, int32_t number_classes, int32_t prediction_class);
+
+    /**
+     * Writes the rows below the last subimages once every band has been predicted, and closes
+     * the outputs.
+     */
+    void finish();
+
+    float get_max_prediction() const;
+    int32_t get_max_y() const;
+    int32_t get_max_x() const;
+
+    string get_filename() const;
+
+    int get_class_size(int i) const;
+
+    int get_number_classes() const;
+
+    int get_number_images() const;
+    int get_number_large_images() const;
+    int get_number_subimages(int i) const;
+
+    int get_padding() const;
+
+    int get_image_channels() const;
+    int get_image_width() const;
+    int get_image_height() const;
+
+    int get_large_image_channels(int image) const;
+    int get_large_image_width(int image) const;
+    int get_large_image_height(int image) const;
+
+    int get_image_classification(int image) const;
+    int get_classification(int subimage) const;
+    float get_pixel(int subimage, int z, int y, int x) const;
+    void get_batch(const vector<int>& batch, float* values) const;
+    float get_raw_pixel(int subimage, int z, int y, int x) const;
+
+    float get_channel_avg(int channel) const;
+    float get_channel_std_dev(int channel) const;
+
+    const vector<float>& get_average() const;
+    const vector<float>& get_std_dev() const;
+};
+
+#endif
@@ -4,6 +4,9 @@ using std::fixed;
 using std::setprecision;
 using std::setw;
 
+#include <map>
+using std::map;
+
 #include <mutex>
 using std::mutex;
 
@@ -20,7 +23,9 @@ using std::vector;
 #include "common/process_arguments.hxx"
 #include "examm/examm.hxx"
 #include "mpi.h"
+#include "node_shared_time_series.hxx"
 #include "rnn/generate_nn.hxx"
+#include "rnn/genome_wire.hxx"
 #include "time_series/time_series.hxx"
 #include "weights/weight_rules.hxx"
 #include "weights/weight_update.hxx"
@@ -36,17 +41,21 @@ vector<string> arguments;
 
 EXAMM* examm;
 WeightUpdate* weight_update_method;
+WindowSampler* window_sampler;
 
 bool finished = false;
 
-vector<vector<vector<double> > > training_inputs;
-vector<vector<vector<double> > > training_outputs;
-vector<vector<vector<double> > > validation_inputs;
-vector<vector<vector<double> > > validation_outputs;
+// compress the parameters sent in genome wire messages (--wire_compression)
+bool wire_compression = false;
+
+// genomes which have been sent to workers, by generation id; workers only send back the
+// trained parameters which are applied to these
+map<int32_t, RNN_Genome*> sent_genomes;
 
-// bool random_sequence_length;
-// int32_t sequence_length_lower_bound = 30;
-// int32_t sequence_length_upper_bound = 100;
+TimeSeriesTensor training_inputs;
+TimeSeriesTensor training_outputs;
+TimeSeriesTensor validation_inputs;
+TimeSeriesTensor validation_outputs;
 
 void send_work_request(int32_t target) {
     int32_t work_request_message[1];
@@ -60,46 +69,27 @@ void receive_work_request(int32_t source) {
     MPI_Recv(work_request_message, 1, MPI_INT, source, WORK_REQUEST_TAG, MPI_COMM_WORLD, &status);
 }
 
-RNN_Genome* receive_genome_from(int32_t source) {
+void receive_message_from(int32_t source, vector<char>& message) {
     MPI_Status status;
     int32_t length_message[1];
     MPI_Recv(length_message, 1, MPI_INT, source, GENOME_LENGTH_TAG, MPI_COMM_WORLD, &status);
 
     int32_t length = length_message[0];
 
-    Log::debug("receiving genome of length: %d from: %d\n", length, source);
-
-    char* genome_str = new char[length + 1];
-
-    Log::debug("receiving genome from: %d\n", source);
-    MPI_Recv(genome_str, length, MPI_CHAR, source, GENOME_TAG, MPI_COMM_WORLD, &status);
+    Log::debug("receiving genome message of length: %d from: %d\n", length, source);
 
-    genome_str[length] = '\0';
-
-    Log::trace("genome_str:\n%s\n", genome_str);
-
-    RNN_Genome* genome = new RNN_Genome(genome_str, length);
-
-    delete[] genome_str;
-    return genome;
+    message.resize(length);
+    MPI_Recv(&message[0], length, MPI_CHAR, source, GENOME_TAG, MPI_COMM_WORLD, &status);
 }
 
-void send_genome_to(int32_t target, RNN_Genome* genome) {
-    char* byte_array;
-    int32_t length;
-
-    genome->write_to_array(&byte_array, length);
-
-    Log::debug("sending genome of length: %d to: %d\n", length, target);
+void send_message_to(int32_t target, const vector<char>& message) {
+    Log::debug("sending genome message of length: %d to: %d\n", message.size(), target);
 
     int32_t length_message[1];
-    length_message[0] = length;
+    length_message[0] = (int32_t) message.size();
     MPI_Send(length_message, 1, MPI_INT, target, GENOME_LENGTH_TAG, MPI_COMM_WORLD);
 
-    Log::debug("sending genome to: %d\n", target);
-    MPI_Send(byte_array, length, MPI_CHAR, target, GENOME_TAG, MPI_COMM_WORLD);
-
-    free(byte_array);
+    MPI_Send(&message[0], (int32_t) message.size(), MPI_CHAR, target, GENOME_TAG, MPI_COMM_WORLD);
 }
 
 void send_terminate_message(int32_t target) {
@@ -156,16 +146,27 @@ void master(int32_t max_rank) {
                 // genome->write_to_file( examm->get_output_directory() + "/before_send_gen_" +
                 // to_string(genome->get_generation_id()) );
 
-                // send genome
+                // send genome, keeping it until the worker returns its trained parameters
                 Log::debug("sending genome to: %d\n", source);
-                send_genome_to(source, genome);
+                vector<char> message;
+                GenomeWire::write_genome(genome, wire_compression, message);
+                send_message_to(source, message);
 
-                // delete this genome as it will not be used again
-                delete genome;
+                sent_genomes[genome->get_generation_id()] = genome;
             }
         } else if (tag == GENOME_LENGTH_TAG) {
-            Log::debug("received genome from: %d\n", source);
-            RNN_Genome* genome = receive_genome_from(source);
+            Log::debug("received genome result from: %d\n", source);
+            vector<char> message;
+            receive_message_from(source, message);
+
+            int32_t generation_id = GenomeWire::get_generation_id(&message[0], (int32_t) message.size());
+            if (sent_genomes.count(generation_id) == 0) {
+                Log::fatal("ERROR: received result from %d for unknown genome: %d\n", source, generation_id);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            RNN_Genome* genome = sent_genomes[generation_id];
+            sent_genomes.erase(generation_id);
+            GenomeWire::read_result(&message[0], (int32_t) message.size(), genome);
 
             examm_mutex.lock();
             examm->insert_genome(genome);
@@ -202,20 +203,24 @@ void worker(int32_t rank) {
 
         } else if (tag == GENOME_LENGTH_TAG) {
             Log::debug("received genome!\n");
-            RNN_Genome* genome = receive_genome_from(0);
+            vector<char> message;
+            receive_message_from(0, message);
+            RNN_Genome* genome = GenomeWire::read_genome(&message[0], (int32_t) message.size());
 
             // have each worker write the backproagation to a separate log file
             string log_id = "genome_" + to_string(genome->get_generation_id()) + "_worker_" + to_string(rank);
             Log::set_id(log_id);
             genome->backpropagate_stochastic(
-                training_inputs, training_outputs, validation_inputs, validation_outputs, weight_update_method
+                training_inputs, training_outputs, validation_inputs, validation_outputs, weight_update_method,
+                window_sampler
             );
             Log::release_id(log_id);
 
             // go back to the worker's log for MPI communication
             Log::set_id("worker_" + to_string(rank));
 
-            send_genome_to(0, genome);
+            GenomeWire::write_result(genome, wire_compression, message);
+            send_message_to(0, message);
 
             delete genome;
         } else {
@@ -245,23 +250,29 @@ int main(int argc, char** argv) {
     Log::restrict_to_rank(0);
     std::cout << "initailized log!" << std::endl;
 
-    TimeSeriesSets* time_series_sets = NULL;
-    time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
-    get_train_validation_data(
-        arguments, time_series_sets, training_inputs, training_outputs, validation_inputs, validation_outputs
+    wire_compression = argument_exists(arguments, "--wire_compression");
+
+    // the time series are only loaded once per node, rank 0 also gets the TimeSeriesSets
+    NodeSharedTimeSeries* shared_time_series = new NodeSharedTimeSeries(arguments);
+    shared_time_series->get_train_validation_data(
+        arguments, training_inputs, training_outputs, validation_inputs, validation_outputs
     );
 
     weight_update_method = new WeightUpdate();
     weight_update_method->generate_from_arguments(arguments);
 
+    window_sampler = new WindowSampler();
+    window_sampler->generate_from_arguments(arguments);
+
     WeightRules* weight_rules = new WeightRules();
     weight_rules->initialize_from_args(arguments);
 
-    RNN_Genome* seed_genome = get_seed_genome(arguments, time_series_sets, weight_rules);
-
     Log::clear_rank_restriction();
 
     if (rank == 0) {
+        TimeSeriesSets* time_series_sets = shared_time_series->get_time_series_sets();
+        RNN_Genome* seed_genome = get_seed_genome(arguments, time_series_sets, weight_rules);
+
         write_time_series_to_file(arguments, time_series_sets);
         examm = generate_examm_from_arguments(arguments, time_series_sets, weight_rules, seed_genome);
         master(max_rank);
@@ -272,8 +283,8 @@ int main(int argc, char** argv) {
     finished = true;
     Log::debug("rank %d completed!\n");
     Log::release_id("main_" + to_string(rank));
+    delete shared_time_series;
     MPI_Finalize();
 
-    delete time_series_sets;
     return 0;
 }
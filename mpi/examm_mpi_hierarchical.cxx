@@ -0,0 +1,565 @@
+#include <algorithm>
+using std::min;
+
+#include <chrono>
+#include <iomanip>
+using std::fixed;
+using std::setprecision;
+using std::setw;
+
+#include <cstdint>
+#include <cstring>
+using std::memcpy;
+
+#include <fstream>
+using std::ofstream;
+
+#include <map>
+using std::map;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "common/files.hxx"
+#include "common/log.hxx"
+#include "common/process_arguments.hxx"
+#include "examm/examm.hxx"
+#include "mpi.h"
+#include "rnn/generate_nn.hxx"
+#include "rnn/genome_wire.hxx"
+#include "time_series/time_series.hxx"
+#include "weights/weight_rules.hxx"
+#include "weights/weight_update.hxx"
+
+/**
+ * Hierarchical version of examm_mpi for very large runs, where a single master would become
+ * a bottleneck. Rank 0 is the root, ranks 1 .. --number_sub_masters are sub-masters, and the
+ * remaining ranks are workers. Each sub-master runs its own EXAMM over its share of the islands
+ * and genomes and serves its own group of workers with the same protocol as examm_mpi. Every
+ * --exchange_interval inserted genomes a sub-master sends its best genome and statistics to the
+ * root, which keeps the global statistics and replies with the global best genome (if it was
+ * found by another sub-master) to migrate into one of the sub-master's islands.
+ */
+
+#define WORK_REQUEST_TAG  1
+#define GENOME_LENGTH_TAG 2
+#define GENOME_TAG        3
+#define TERMINATE_TAG     4
+#define EXCHANGE_TAG      5
+#define MIGRANT_TAG       6
+
+// sub-masters are given disjoint blocks of innovation numbers this large, or smaller if that
+// many blocks would not fit in the int32_t innovation numbers
+#define SUB_MASTER_INNOVATION_STRIDE 10000000
+
+vector<string> arguments;
+
+EXAMM* examm;
+WeightUpdate* weight_update_method;
+WindowSampler* window_sampler;
+
+// compress the parameters sent in genome wire messages (--wire_compression)
+bool wire_compression = false;
+
+int32_t number_sub_masters = 1;
+int32_t exchange_interval = 50;
+
+// genomes which have been sent to workers, by generation id; workers only send back the
+// trained parameters which are applied to these
+map<int32_t, RNN_Genome*> sent_genomes;
+
+TimeSeriesTensor training_inputs;
+TimeSeriesTensor training_outputs;
+TimeSeriesTensor validation_inputs;
+TimeSeriesTensor validation_outputs;
+
+/**
+ * Exchange messages from a sub-master to the root start with this header, followed by
+ * the sub-master's best genome (if it has one) in the RNN_Genome::write_to_array format.
+ */
+struct ExchangeHeader {
+    int32_t final;
+    int32_t inserted_genomes;
+    int32_t has_genome;
+    int32_t padding;
+    double best_fitness;
+};
+
+int32_t get_sub_master(int32_t worker_rank) {
+    return 1 + ((worker_rank - number_sub_masters - 1) % number_sub_masters);
+}
+
+int32_t get_number_workers(int32_t sub_master_rank, int32_t max_rank) {
+    int32_t number_workers = 0;
+    for (int32_t rank = number_sub_masters + 1; rank < max_rank; rank++) {
+        if (get_sub_master(rank) == sub_master_rank) {
+            number_workers++;
+        }
+    }
+    return number_workers;
+}
+
+/**
+ * Replaces the value of an argument (or adds it if it was not given).
+ */
+void set_argument(vector<string>& args, string argument, string value) {
+    for (int32_t i = 0; i < (int32_t) args.size() - 1; i++) {
+        if (args[i].compare(argument) == 0) {
+            args[i + 1] = value;
+            return;
+        }
+    }
+    args.push_back(argument);
+    args.push_back(value);
+}
+
+void send_work_request(int32_t target) {
+    int32_t work_request_message[1];
+    work_request_message[0] = 0;
+    MPI_Send(work_request_message, 1, MPI_INT, target, WORK_REQUEST_TAG, MPI_COMM_WORLD);
+}
+
+void receive_work_request(int32_t source) {
+    MPI_Status status;
+    int32_t work_request_message[1];
+    MPI_Recv(work_request_message, 1, MPI_INT, source, WORK_REQUEST_TAG, MPI_COMM_WORLD, &status);
+}
+
+void receive_message_from(int32_t source, vector<char>& message) {
+    MPI_Status status;
+    int32_t length_message[1];
+    MPI_Recv(length_message, 1, MPI_INT, source, GENOME_LENGTH_TAG, MPI_COMM_WORLD, &status);
+
+    int32_t length = length_message[0];
+
+    Log::debug("receiving genome message of length: %d from: %d\n", length, source);
+
+    message.resize(length);
+    MPI_Recv(&message[0], length, MPI_CHAR, source, GENOME_TAG, MPI_COMM_WORLD, &status);
+}
+
+void send_message_to(int32_t target, const vector<char>& message) {
+    Log::debug("sending genome message of length: %d to: %d\n", message.size(), target);
+
+    int32_t length_message[1];
+    length_message[0] = (int32_t) message.size();
+    MPI_Send(length_message, 1, MPI_INT, target, GENOME_LENGTH_TAG, MPI_COMM_WORLD);
+
+    MPI_Send(&message[0], (int32_t) message.size(), MPI_CHAR, target, GENOME_TAG, MPI_COMM_WORLD);
+}
+
+void send_terminate_message(int32_t target) {
+    int32_t terminate_message[1];
+    terminate_message[0] = 0;
+    MPI_Send(terminate_message, 1, MPI_INT, target, TERMINATE_TAG, MPI_COMM_WORLD);
+}
+
+void receive_terminate_message(int32_t source) {
+    MPI_Status status;
+    int32_t terminate_message[1];
+    MPI_Recv(terminate_message, 1, MPI_INT, source, TERMINATE_TAG, MPI_COMM_WORLD, &status);
+}
+
+/**
+ * Receives a message of unknown length (which may be empty) with the given tag.
+ */
+void receive_bytes_from(int32_t source, int32_t tag, vector<char>& bytes) {
+    MPI_Status status;
+    MPI_Probe(source, tag, MPI_COMM_WORLD, &status);
+
+    int32_t length;
+    MPI_Get_count(&status, MPI_CHAR, &length);
+    bytes.resize(length);
+    MPI_Recv(bytes.data(), length, MPI_CHAR, source, tag, MPI_COMM_WORLD, &status);
+}
+
+void write_genome_bytes(RNN_Genome* genome, vector<char>& bytes) {
+    char* byte_array;
+    int32_t length;
+    genome->write_to_array(&byte_array, length);
+    bytes.insert(bytes.end(), byte_array, byte_array + length);
+    free(byte_array);
+}
+
+/**
+ * Sends the sub-master's statistics and best genome to the root. If this is not the final
+ * exchange, returns the genome the root sent back to migrate (or NULL if there was none).
+ */
+RNN_Genome* exchange_with_root(bool final, int32_t inserted_genomes) {
+    ExchangeHeader header;
+    header.final = final;
+    header.inserted_genomes = inserted_genomes;
+    header.has_genome = 0;
+    header.padding = 0;
+    header.best_fitness = examm->get_best_fitness();
+
+    vector<char> message(sizeof(ExchangeHeader));
+    RNN_Genome* best_genome = examm->get_best_genome();
+    if (best_genome != NULL) {
+        header.has_genome = 1;
+        write_genome_bytes(best_genome, message);
+    }
+    memcpy(&message[0], &header, sizeof(ExchangeHeader));
+
+    Log::debug("sending exchange of length: %d to root, final: %d\n", message.size(), final);
+    MPI_Send(message.data(), (int32_t) message.size(), MPI_CHAR, 0, EXCHANGE_TAG, MPI_COMM_WORLD);
+    if (final) {
+        return NULL;
+    }
+
+    vector<char> migrant_message;
+    receive_bytes_from(0, MIGRANT_TAG, migrant_message);
+    if (migrant_message.size() == 0) {
+        return NULL;
+    }
+    return new RNN_Genome(&migrant_message[0], (int32_t) migrant_message.size());
+}
+
+void root(int32_t max_rank) {
+    string output_directory = "";
+    get_argument(arguments, "--output_directory", false, output_directory);
+
+    ofstream* log_file = NULL;
+    if (output_directory != "") {
+        mkpath(output_directory.c_str(), 0777);
+        log_file = new ofstream(output_directory + "/global_fitness_log.csv");
+        (*log_file) << "Time, Sub Master, Final, Inserted Genomes, Sub Master Best Fitness, Global Best Fitness, "
+                       "Global Best Sub Master, Migrants Sent"
+                    << endl;
+    }
+
+    vector<int32_t> inserted_genomes(number_sub_masters + 1, 0);
+    // the version of the global best genome last sent to each sub-master, so each migrant
+    // is only sent once
+    vector<int32_t> sent_version(number_sub_masters + 1, 0);
+
+    RNN_Genome* global_best_genome = NULL;
+    int32_t global_best_sub_master = -1;
+    int32_t global_best_version = 0;
+    int32_t migrants_sent = 0;
+    int32_t finished_sub_masters = 0;
+
+    std::chrono::time_point<std::chrono::system_clock> start_clock = std::chrono::system_clock::now();
+
+    while (finished_sub_masters < number_sub_masters) {
+        vector<char> message;
+        MPI_Status status;
+        MPI_Probe(MPI_ANY_SOURCE, EXCHANGE_TAG, MPI_COMM_WORLD, &status);
+        int32_t source = status.MPI_SOURCE;
+        receive_bytes_from(source, EXCHANGE_TAG, message);
+
+        ExchangeHeader header;
+        memcpy(&header, &message[0], sizeof(ExchangeHeader));
+        inserted_genomes[source] = header.inserted_genomes;
+
+        if (header.has_genome
+            && (global_best_genome == NULL || header.best_fitness < global_best_genome->get_fitness())) {
+            if (global_best_genome != NULL) {
+                delete global_best_genome;
+            }
+            global_best_genome = new RNN_Genome(
+                &message[sizeof(ExchangeHeader)], (int32_t) (message.size() - sizeof(ExchangeHeader))
+            );
+            global_best_sub_master = source;
+            global_best_version++;
+            // the sub-master which found it already has it
+            sent_version[source] = global_best_version;
+            Log::info(
+                "new global best fitness: %lf from sub-master: %d\n", global_best_genome->get_fitness(), source
+            );
+        }
+
+        if (header.final) {
+            finished_sub_masters++;
+            Log::info(
+                "sub-master %d finished, %d of %d sub-masters finished\n", source, finished_sub_masters,
+                number_sub_masters
+            );
+        } else {
+            vector<char> migrant_message;
+            if (global_best_genome != NULL && sent_version[source] < global_best_version) {
+                write_genome_bytes(global_best_genome, migrant_message);
+                sent_version[source] = global_best_version;
+                migrants_sent++;
+            }
+            MPI_Send(
+                migrant_message.data(), (int32_t) migrant_message.size(), MPI_CHAR, source, MIGRANT_TAG, MPI_COMM_WORLD
+            );
+        }
+
+        if (log_file != NULL) {
+            int32_t total_inserted = 0;
+            for (int32_t i = 1; i <= number_sub_masters; i++) {
+                total_inserted += inserted_genomes[i];
+            }
+            long milliseconds =
+                std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - start_clock)
+                    .count();
+            (*log_file) << milliseconds << ", " << source << ", " << header.final << ", " << total_inserted << ", "
+                        << header.best_fitness << ", "
+                        << (global_best_genome == NULL ? EXAMM_MAX_DOUBLE : global_best_genome->get_fitness()) << ", "
+                        << global_best_sub_master << ", " << migrants_sent << endl;
+        }
+    }
+
+    if (global_best_genome != NULL) {
+        Log::info(
+            "global best fitness: %lf found by sub-master: %d\n", global_best_genome->get_fitness(),
+            global_best_sub_master
+        );
+        if (output_directory != "") {
+            global_best_genome->write_graphviz(output_directory + "/global_best_genome.gv");
+            global_best_genome->write_to_file(output_directory + "/global_best_genome.bin");
+        }
+        delete global_best_genome;
+    }
+
+    if (log_file != NULL) {
+        log_file->close();
+        delete log_file;
+    }
+}
+
+void sub_master(int32_t rank, int32_t number_workers, int32_t number_islands) {
+    int32_t terminates_sent = 0;
+    int32_t inserted_genomes = 0;
+    int32_t migrants_received = 0;
+
+    while (true) {
+        // wait for a incoming message from one of this sub-master's workers
+        MPI_Status status;
+        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+
+        int32_t source = status.MPI_SOURCE;
+        int32_t tag = status.MPI_TAG;
+        Log::debug("probe returned message from: %d with tag: %d\n", source, tag);
+
+        if (tag == WORK_REQUEST_TAG) {
+            receive_work_request(source);
+
+            RNN_Genome* genome = examm->generate_genome();
+
+            if (genome == NULL) {  // search was completed if it returns NULL for an individual
+                Log::info("terminating worker: %d\n", source);
+                send_terminate_message(source);
+                terminates_sent++;
+
+                Log::debug("sent: %d terminates of %d\n", terminates_sent, number_workers);
+                if (terminates_sent >= number_workers) {
+                    exchange_with_root(true, inserted_genomes);
+                    return;
+                }
+
+            } else {
+                Log::debug("sending genome to: %d\n", source);
+                vector<char> message;
+                GenomeWire::write_genome(genome, wire_compression, message);
+                send_message_to(source, message);
+
+                sent_genomes[genome->get_generation_id()] = genome;
+            }
+        } else if (tag == GENOME_LENGTH_TAG) {
+            Log::debug("received genome result from: %d\n", source);
+            vector<char> message;
+            receive_message_from(source, message);
+
+            int32_t generation_id = GenomeWire::get_generation_id(&message[0], (int32_t) message.size());
+            if (sent_genomes.count(generation_id) == 0) {
+                Log::fatal("ERROR: received result from %d for unknown genome: %d\n", source, generation_id);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            RNN_Genome* genome = sent_genomes[generation_id];
+            sent_genomes.erase(generation_id);
+            GenomeWire::read_result(&message[0], (int32_t) message.size(), genome);
+
+            examm->insert_genome(genome);
+            inserted_genomes++;
+
+            // delete the genome as it won't be used again, a copy was inserted
+            delete genome;
+
+            if (inserted_genomes % exchange_interval == 0) {
+                RNN_Genome* migrant = exchange_with_root(false, inserted_genomes);
+                if (migrant != NULL) {
+                    // place migrants into the islands round robin
+                    int32_t island = migrants_received % number_islands;
+                    Log::info(
+                        "sub-master %d inserting migrant with fitness: %lf into island: %d\n", rank,
+                        migrant->get_fitness(), island
+                    );
+                    migrant->set_group_id(island);
+                    examm->insert_migrant(migrant);
+                    delete migrant;
+                    migrants_received++;
+                }
+            }
+        } else {
+            Log::fatal("ERROR: received message from %d with unknown tag: %d", source, tag);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+}
+
+void worker(int32_t rank) {
+    Log::set_id("worker_" + to_string(rank));
+    int32_t master = get_sub_master(rank);
+
+    while (true) {
+        Log::debug("sending work request!\n");
+        send_work_request(master);
+        Log::debug("sent work request!\n");
+
+        MPI_Status status;
+        MPI_Probe(master, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+        int32_t tag = status.MPI_TAG;
+
+        Log::debug("probe received message with tag: %d\n", tag);
+
+        if (tag == TERMINATE_TAG) {
+            Log::debug("received terminate tag!\n");
+            receive_terminate_message(master);
+            break;
+
+        } else if (tag == GENOME_LENGTH_TAG) {
+            Log::debug("received genome!\n");
+            vector<char> message;
+            receive_message_from(master, message);
+            RNN_Genome* genome = GenomeWire::read_genome(&message[0], (int32_t) message.size());
+
+            // have each worker write the backproagation to a separate log file
+            string log_id = "genome_" + to_string(genome->get_generation_id()) + "_worker_" + to_string(rank);
+            Log::set_id(log_id);
+            genome->backpropagate_stochastic(
+                training_inputs, training_outputs, validation_inputs, validation_outputs, weight_update_method,
+                window_sampler
+            );
+            Log::release_id(log_id);
+
+            // go back to the worker's log for MPI communication
+            Log::set_id("worker_" + to_string(rank));
+
+            GenomeWire::write_result(genome, wire_compression, message);
+            send_message_to(master, message);
+
+            delete genome;
+        } else {
+            Log::fatal("ERROR: received message with unknown tag: %d\n", tag);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+
+    // release the log file for the worker communication
+    Log::release_id("worker_" + to_string(rank));
+}
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+    int32_t rank, max_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &max_rank);
+    arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_rank(rank);
+    Log::set_id("main_" + to_string(rank));
+    Log::restrict_to_rank(0);
+
+    wire_compression = argument_exists(arguments, "--wire_compression");
+    get_argument(arguments, "--number_sub_masters", true, number_sub_masters);
+    get_argument(arguments, "--exchange_interval", false, exchange_interval);
+
+    int32_t number_islands, max_genomes;
+    get_argument(arguments, "--number_islands", true, number_islands);
+    get_argument(arguments, "--max_genomes", true, max_genomes);
+
+    if (number_sub_masters < 1 || max_rank < (2 * number_sub_masters) + 1) {
+        Log::fatal(
+            "ERROR: %d sub-masters need at least %d MPI ranks (a root, the sub-masters and a worker for each), but "
+            "there were %d\n",
+            number_sub_masters, (2 * number_sub_masters) + 1, max_rank
+        );
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    if (number_islands < number_sub_masters) {
+        Log::fatal(
+            "ERROR: --number_islands (%d) must be at least --number_sub_masters (%d)\n", number_islands,
+            number_sub_masters
+        );
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    if (exchange_interval < 1) {
+        Log::fatal("ERROR: --exchange_interval must be at least 1, was %d\n", exchange_interval);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    TimeSeriesSets* time_series_sets = NULL;
+    time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
+    get_train_validation_data(
+        arguments, time_series_sets, training_inputs, training_outputs, validation_inputs, validation_outputs
+    );
+
+    weight_update_method = new WeightUpdate();
+    weight_update_method->generate_from_arguments(arguments);
+
+    window_sampler = new WindowSampler();
+    window_sampler->generate_from_arguments(arguments);
+
+    WeightRules* weight_rules = new WeightRules();
+    weight_rules->initialize_from_args(arguments);
+
+    RNN_Genome* seed_genome = get_seed_genome(arguments, time_series_sets, weight_rules);
+
+    Log::clear_rank_restriction();
+
+    if (rank == 0) {
+        write_time_series_to_file(arguments, time_series_sets);
+        root(max_rank);
+    } else if (rank <= number_sub_masters) {
+        // each sub-master gets its share of the islands and genomes, and its own output directory
+        int32_t sub_master_index = rank - 1;
+        int32_t sub_master_islands =
+            (number_islands / number_sub_masters) + (sub_master_index < number_islands % number_sub_masters);
+        int32_t sub_master_genomes =
+            (max_genomes / number_sub_masters) + (sub_master_index < max_genomes % number_sub_masters);
+
+        vector<string> sub_master_arguments = arguments;
+        set_argument(sub_master_arguments, "--number_islands", to_string(sub_master_islands));
+        set_argument(sub_master_arguments, "--max_genomes", to_string(sub_master_genomes));
+
+        string output_directory = "";
+        get_argument(arguments, "--output_directory", false, output_directory);
+        if (output_directory != "") {
+            set_argument(
+                sub_master_arguments, "--output_directory", output_directory + "/sub_master_" + to_string(rank)
+            );
+        }
+
+        int32_t number_workers = get_number_workers(rank, max_rank);
+        Log::info(
+            "sub-master %d running %d islands and %d genomes with %d workers\n", rank, sub_master_islands,
+            sub_master_genomes, number_workers
+        );
+
+        examm = generate_examm_from_arguments(sub_master_arguments, time_series_sets, weight_rules, seed_genome);
+        // one block per sub-master and one more for the innovation numbers of the seed genome,
+        // computed in 64 bits as the blocks can't overflow the int32_t innovation numbers
+        int64_t innovation_block =
+            min((int64_t) SUB_MASTER_INNOVATION_STRIDE, (int64_t) INT32_MAX / (number_sub_masters + 1));
+        examm->offset_innovation_counts((int32_t) (sub_master_index * innovation_block));
+        sub_master(rank, number_workers, sub_master_islands);
+    } else {
+        worker(rank);
+    }
+    Log::set_id("main_" + to_string(rank));
+    Log::debug("rank %d completed!\n", rank);
+    Log::release_id("main_" + to_string(rank));
+    MPI_Finalize();
+
+    delete time_series_sets;
+    return 0;
+}
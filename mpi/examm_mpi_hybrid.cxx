@@ -0,0 +1,454 @@
+#include <condition_variable>
+using std::condition_variable;
+
+#include <cstring>
+using std::memcpy;
+
+#include <deque>
+using std::deque;
+
+#include <map>
+using std::map;
+
+#include <mutex>
+using std::mutex;
+using std::unique_lock;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "common/log.hxx"
+#include "common/process_arguments.hxx"
+#include "examm/examm.hxx"
+#include "mpi.h"
+#include "rnn/generate_nn.hxx"
+#include "rnn/genome_wire.hxx"
+#include "time_series/time_series.hxx"
+#include "weights/weight_rules.hxx"
+#include "weights/weight_update.hxx"
+
+/**
+ * Hybrid MPI + threads version of EXAMM. The intended layout is one MPI rank per node, with each
+ * worker rank running --number_threads training threads which all share the same in memory copy
+ * of the training and validation data.
+ *
+ * Only the main thread of each rank makes MPI calls. Worker ranks aggregate their communication:
+ * a single WORK_BATCH_TAG message carries every genome trained since the last message along with
+ * a request for as many new genomes as the rank has idle threads, and the master replies with a
+ * single GENOME_BATCH_TAG message holding up to that many genomes.
+ *
+ * The master rank can also train genomes with --master_threads local threads, which access EXAMM
+ * directly (as in examm_mt) instead of going through MPI.
+ */
+
+#define WORK_BATCH_TAG   1
+#define GENOME_BATCH_TAG 2
+#define TERMINATE_TAG    4
+
+mutex examm_mutex;
+
+vector<string> arguments;
+
+EXAMM* examm;
+WeightUpdate* weight_update_method;
+WindowSampler* window_sampler;
+
+// compress the parameters sent in genome wire messages (--wire_compression)
+bool wire_compression = false;
+
+TimeSeriesTensor training_inputs;
+TimeSeriesTensor training_outputs;
+TimeSeriesTensor validation_inputs;
+TimeSeriesTensor validation_outputs;
+
+// the worker side queues, shared between the communication (main) thread and the training threads
+mutex queue_mutex;
+condition_variable queue_condition;
+deque<RNN_Genome*> work_queue;
+vector<vector<char> > result_queue;
+bool terminate_threads = false;
+
+/**
+ * Batches are packed as: int32 header, int32 number of messages, then for each genome wire
+ * message its int32 length followed by its bytes.
+ */
+void pack_batch(int32_t header, const vector<vector<char> >& messages, vector<char>& buffer) {
+    buffer.clear();
+
+    int32_t n_messages = (int32_t) messages.size();
+    buffer.resize(2 * sizeof(int32_t));
+    memcpy(&buffer[0], &header, sizeof(int32_t));
+    memcpy(&buffer[sizeof(int32_t)], &n_messages, sizeof(int32_t));
+
+    for (int32_t i = 0; i < n_messages; i++) {
+        int32_t length = (int32_t) messages[i].size();
+
+        int32_t position = (int32_t) buffer.size();
+        buffer.resize(position + sizeof(int32_t) + length);
+        memcpy(&buffer[position], &length, sizeof(int32_t));
+        memcpy(&buffer[position + sizeof(int32_t)], &messages[i][0], length);
+    }
+}
+
+void unpack_batch(char* buffer, int32_t buffer_length, int32_t& header, vector<vector<char> >& messages) {
+    messages.clear();
+
+    int32_t n_messages;
+    memcpy(&header, buffer, sizeof(int32_t));
+    memcpy(&n_messages, buffer + sizeof(int32_t), sizeof(int32_t));
+
+    int32_t position = 2 * sizeof(int32_t);
+    for (int32_t i = 0; i < n_messages; i++) {
+        int32_t length;
+        memcpy(&length, buffer + position, sizeof(int32_t));
+        position += sizeof(int32_t);
+
+        if (position + length > buffer_length) {
+            Log::fatal(
+                "ERROR: message %d of batch has length %d which goes past the end of the batch (%d bytes)\n", i,
+                length, buffer_length
+            );
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+
+        messages.push_back(vector<char>(buffer + position, buffer + position + length));
+        position += length;
+    }
+}
+
+void send_batch(int32_t target, int32_t tag, int32_t header, const vector<vector<char> >& messages) {
+    vector<char> buffer;
+    pack_batch(header, messages, buffer);
+
+    Log::debug("sending batch of %d genomes (%d bytes) to: %d\n", messages.size(), buffer.size(), target);
+    MPI_Send(&buffer[0], (int32_t) buffer.size(), MPI_CHAR, target, tag, MPI_COMM_WORLD);
+}
+
+void receive_batch(int32_t source, int32_t tag, int32_t& header, vector<vector<char> >& messages) {
+    MPI_Status status;
+    MPI_Probe(source, tag, MPI_COMM_WORLD, &status);
+
+    int32_t length;
+    MPI_Get_count(&status, MPI_CHAR, &length);
+
+    char* buffer = new char[length];
+    MPI_Recv(buffer, length, MPI_CHAR, source, tag, MPI_COMM_WORLD, &status);
+
+    unpack_batch(buffer, length, header, messages);
+    Log::debug("received batch of %d genomes (%d bytes) from: %d\n", messages.size(), length, source);
+
+    delete[] buffer;
+}
+
+void send_terminate_message(int32_t target) {
+    int32_t terminate_message[1];
+    terminate_message[0] = 0;
+    MPI_Send(terminate_message, 1, MPI_INT, target, TERMINATE_TAG, MPI_COMM_WORLD);
+}
+
+void receive_terminate_message(int32_t source) {
+    MPI_Status status;
+    int32_t terminate_message[1];
+    MPI_Recv(terminate_message, 1, MPI_INT, source, TERMINATE_TAG, MPI_COMM_WORLD, &status);
+}
+
+void train_genome(RNN_Genome* genome, string thread_name) {
+    string log_id = "genome_" + to_string(genome->get_generation_id()) + "_" + thread_name;
+    Log::set_id(log_id);
+    genome->backpropagate_stochastic(
+        training_inputs, training_outputs, validation_inputs, validation_outputs, weight_update_method,
+        window_sampler
+    );
+    Log::release_id(log_id);
+}
+
+/**
+ * Threads on the master rank pull genomes straight from EXAMM, the same as examm_mt.
+ */
+void master_thread(int32_t id) {
+    string thread_name = "master_thread_" + to_string(id);
+
+    while (true) {
+        examm_mutex.lock();
+        Log::set_id("main_0");
+        RNN_Genome* genome = examm->generate_genome();
+        examm_mutex.unlock();
+
+        if (genome == NULL) {
+            break;
+        }
+
+        train_genome(genome, thread_name);
+
+        examm_mutex.lock();
+        Log::set_id("main_0");
+        examm->insert_genome(genome);
+        examm_mutex.unlock();
+
+        delete genome;
+    }
+}
+
+void master(int32_t max_rank) {
+    // the "main" id will have already been set by the main function so we do not need to re-set it here
+    int32_t terminates_sent = 0;
+
+    // the number of genomes each worker rank currently has out for training
+    vector<int32_t> outstanding(max_rank, 0);
+
+    // genomes which have been sent to workers, by generation id; workers only send back the
+    // trained parameters which are applied to these
+    map<int32_t, RNN_Genome*> sent_genomes;
+
+    while (terminates_sent < max_rank - 1) {
+        MPI_Status status;
+        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+
+        int32_t source = status.MPI_SOURCE;
+        int32_t tag = status.MPI_TAG;
+        Log::debug("probe returned message from: %d with tag: %d\n", source, tag);
+
+        if (tag != WORK_BATCH_TAG) {
+            Log::fatal("ERROR: received message from %d with unknown tag: %d", source, tag);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+
+        int32_t requested;
+        vector<vector<char> > results;
+        receive_batch(source, WORK_BATCH_TAG, requested, results);
+        outstanding[source] -= (int32_t) results.size();
+
+        vector<vector<char> > messages;
+        examm_mutex.lock();
+        for (int32_t i = 0; i < (int32_t) results.size(); i++) {
+            int32_t generation_id = GenomeWire::get_generation_id(&results[i][0], (int32_t) results[i].size());
+            if (sent_genomes.count(generation_id) == 0) {
+                Log::fatal("ERROR: received result from %d for unknown genome: %d\n", source, generation_id);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            RNN_Genome* genome = sent_genomes[generation_id];
+            sent_genomes.erase(generation_id);
+            GenomeWire::read_result(&results[i][0], (int32_t) results[i].size(), genome);
+
+            examm->insert_genome(genome);
+            // delete the genome as it won't be used again, a copy was inserted
+            delete genome;
+        }
+
+        for (int32_t i = 0; i < requested; i++) {
+            RNN_Genome* genome = examm->generate_genome();
+            if (genome == NULL) {
+                break;
+            }
+            messages.push_back(vector<char>());
+            GenomeWire::write_genome(genome, wire_compression, messages.back());
+            sent_genomes[genome->get_generation_id()] = genome;
+        }
+        examm_mutex.unlock();
+
+        if (messages.size() == 0 && outstanding[source] == 0) {
+            // search was completed and this rank has nothing left in flight
+            Log::info("terminating worker: %d\n", source);
+            send_terminate_message(source);
+            terminates_sent++;
+            Log::debug("sent: %d terminates of %d\n", terminates_sent, (max_rank - 1));
+
+        } else {
+            // an empty batch tells the worker the search is done, it will
+            // report back when its remaining genomes have been trained
+            send_batch(source, GENOME_BATCH_TAG, 0, messages);
+            outstanding[source] += (int32_t) messages.size();
+        }
+    }
+}
+
+void worker_thread(int32_t rank, int32_t id) {
+    string thread_name = "worker_" + to_string(rank) + "_thread_" + to_string(id);
+
+    while (true) {
+        RNN_Genome* genome = NULL;
+        {
+            unique_lock<mutex> lock(queue_mutex);
+            queue_condition.wait(lock, [] { return terminate_threads || work_queue.size() > 0; });
+
+            if (work_queue.size() == 0) {
+                break;
+            }
+            genome = work_queue.front();
+            work_queue.pop_front();
+        }
+
+        train_genome(genome, thread_name);
+
+        vector<char> result;
+        GenomeWire::write_result(genome, wire_compression, result);
+        delete genome;
+
+        {
+            unique_lock<mutex> lock(queue_mutex);
+            result_queue.push_back(result);
+        }
+        queue_condition.notify_all();
+    }
+}
+
+void worker(int32_t rank, int32_t number_threads) {
+    string worker_id = "worker_" + to_string(rank);
+    Log::set_id(worker_id);
+
+    vector<thread> threads;
+    for (int32_t i = 0; i < number_threads; i++) {
+        threads.push_back(thread(worker_thread, rank, i));
+    }
+
+    // genomes received by this rank which have not yet been sent back
+    int32_t in_flight = 0;
+    bool search_finished = false;
+
+    while (true) {
+        vector<vector<char> > results;
+        {
+            // wait until there are results to return, or there are idle threads and
+            // the master may still have work for them
+            unique_lock<mutex> lock(queue_mutex);
+            queue_condition.wait(lock, [&] {
+                return result_queue.size() > 0 || (!search_finished && in_flight < number_threads);
+            });
+            results.swap(result_queue);
+        }
+        in_flight -= (int32_t) results.size();
+
+        int32_t requested = number_threads - in_flight;
+        Log::debug("returning %d genomes and requesting %d\n", results.size(), requested);
+        send_batch(0, WORK_BATCH_TAG, requested, results);
+
+        MPI_Status status;
+        MPI_Probe(0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+        int32_t tag = status.MPI_TAG;
+
+        if (tag == TERMINATE_TAG) {
+            Log::debug("received terminate tag!\n");
+            receive_terminate_message(0);
+            break;
+
+        } else if (tag == GENOME_BATCH_TAG) {
+            int32_t header;
+            vector<vector<char> > messages;
+            receive_batch(0, GENOME_BATCH_TAG, header, messages);
+
+            vector<RNN_Genome*> genomes;
+            for (int32_t i = 0; i < (int32_t) messages.size(); i++) {
+                genomes.push_back(GenomeWire::read_genome(&messages[i][0], (int32_t) messages[i].size()));
+            }
+
+            if (genomes.size() == 0) {
+                search_finished = true;
+            }
+            in_flight += (int32_t) genomes.size();
+
+            {
+                unique_lock<mutex> lock(queue_mutex);
+                work_queue.insert(work_queue.end(), genomes.begin(), genomes.end());
+            }
+            queue_condition.notify_all();
+
+        } else {
+            Log::fatal("ERROR: received message with unknown tag: %d\n", tag);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+
+    {
+        unique_lock<mutex> lock(queue_mutex);
+        terminate_threads = true;
+    }
+    queue_condition.notify_all();
+
+    for (int32_t i = 0; i < number_threads; i++) {
+        threads[i].join();
+    }
+
+    // release the log file for the worker communication
+    Log::release_id(worker_id);
+}
+
+int main(int argc, char** argv) {
+    int32_t provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    int32_t rank, max_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &max_rank);
+    arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_rank(rank);
+    Log::set_id("main_" + to_string(rank));
+    Log::debug("started rank %d of %d\n", rank, max_rank);
+    Log::restrict_to_rank(0);
+
+    if (provided < MPI_THREAD_FUNNELED) {
+        Log::fatal("ERROR: MPI implementation does not provide MPI_THREAD_FUNNELED support.\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    int32_t number_threads;
+    get_argument(arguments, "--number_threads", true, number_threads);
+    int32_t master_threads = 0;
+    get_argument(arguments, "--master_threads", false, master_threads);
+    wire_compression = argument_exists(arguments, "--wire_compression");
+
+    if (max_rank < 2 && master_threads < 1) {
+        Log::fatal("ERROR: examm_mpi_hybrid needs either more than one rank or --master_threads > 0.\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    TimeSeriesSets* time_series_sets = NULL;
+    time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
+    get_train_validation_data(
+        arguments, time_series_sets, training_inputs, training_outputs, validation_inputs, validation_outputs
+    );
+
+    weight_update_method = new WeightUpdate();
+    weight_update_method->generate_from_arguments(arguments);
+
+    window_sampler = new WindowSampler();
+    window_sampler->generate_from_arguments(arguments);
+
+    WeightRules* weight_rules = new WeightRules();
+    weight_rules->initialize_from_args(arguments);
+
+    RNN_Genome* seed_genome = get_seed_genome(arguments, time_series_sets, weight_rules);
+
+    Log::clear_rank_restriction();
+
+    if (rank == 0) {
+        write_time_series_to_file(arguments, time_series_sets);
+        examm = generate_examm_from_arguments(arguments, time_series_sets, weight_rules, seed_genome);
+
+        vector<thread> threads;
+        for (int32_t i = 0; i < master_threads; i++) {
+            threads.push_back(thread(master_thread, i));
+        }
+
+        master(max_rank);
+
+        for (int32_t i = 0; i < master_threads; i++) {
+            threads[i].join();
+        }
+    } else {
+        worker(rank, number_threads);
+    }
+    Log::set_id("main_" + to_string(rank));
+    Log::debug("rank %d completed!\n", rank);
+    Log::release_id("main_" + to_string(rank));
+    MPI_Finalize();
+
+    delete time_series_sets;
+    return 0;
+}
@@ -22,6 +22,7 @@ using std::vector;
 #include "common/process_arguments.hxx"
 #include "examm/examm.hxx"
 #include "mpi.h"
+#include "node_shared_time_series.hxx"
 #include "rnn/generate_nn.hxx"
 #include "time_series/time_series.hxx"
 #include "weights/weight_update.hxx"
@@ -38,11 +39,12 @@ vector<string> arguments;
 EXAMM* examm;
 
 WeightUpdate* weight_update_method;
+WindowSampler* window_sampler;
 
-vector<vector<vector<double> > > training_inputs;
-vector<vector<vector<double> > > training_outputs;
-vector<vector<vector<double> > > validation_inputs;
-vector<vector<vector<double> > > validation_outputs;
+TimeSeriesTensor training_inputs;
+TimeSeriesTensor training_outputs;
+TimeSeriesTensor validation_inputs;
+TimeSeriesTensor validation_outputs;
 
 int32_t global_slice;
 int32_t global_repeat;
@@ -202,7 +204,8 @@ void worker(int32_t rank) {
                             + to_string(genome->get_generation_id()) + "_worker_" + to_string(rank);
             Log::set_id(log_id);
             genome->backpropagate_stochastic(
-                training_inputs, training_outputs, validation_inputs, validation_outputs, weight_update_method
+                training_inputs, training_outputs, validation_inputs, validation_outputs, weight_update_method,
+                window_sampler
             );
             Log::release_id(log_id);
 
@@ -245,27 +248,34 @@ int main(int argc, char** argv) {
     int32_t repeats;
     get_argument(arguments, "--repeats", true, repeats);
 
-    TimeSeriesSets* time_series_sets = NULL;
-    time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
-    get_train_validation_data(
-        arguments, time_series_sets, training_inputs, training_outputs, validation_inputs, validation_outputs
+    // the time series are only loaded once per node, rank 0 also gets the TimeSeriesSets
+    NodeSharedTimeSeries* shared_time_series = new NodeSharedTimeSeries(arguments);
+    TimeSeriesSets* time_series_sets = shared_time_series->get_time_series_sets();
+    shared_time_series->get_train_validation_data(
+        arguments, training_inputs, training_outputs, validation_inputs, validation_outputs
     );
 
     weight_update_method = new WeightUpdate();
     weight_update_method->generate_from_arguments(arguments);
 
+    window_sampler = new WindowSampler();
+    window_sampler->generate_from_arguments(arguments);
+
     WeightRules* weight_rules = new WeightRules();
     weight_rules->initialize_from_args(arguments);
 
-    RNN_Genome* seed_genome = get_seed_genome(arguments, time_series_sets, weight_rules);
+    RNN_Genome* seed_genome = NULL;
+    if (rank == 0) {
+        seed_genome = get_seed_genome(arguments, time_series_sets, weight_rules);
+    }
 
     Log::clear_rank_restriction();
 
-    for (int32_t i = 0; i < time_series_sets->get_number_series(); i += fold_size) {
+    for (int32_t i = 0; i < shared_time_series->get_number_series(); i += fold_size) {
         vector<int32_t> training_indexes;
         vector<int32_t> test_indexes;
 
-        for (int32_t j = 0; j < time_series_sets->get_number_series(); j += fold_size) {
+        for (int32_t j = 0; j < shared_time_series->get_number_series(); j += fold_size) {
             if (j == i) {
                 for (int32_t k = 0; k < fold_size; k++) {
                     test_indexes.push_back(j + k);
@@ -277,8 +287,10 @@ int main(int argc, char** argv) {
             }
         }
 
-        time_series_sets->set_training_indexes(training_indexes);
-        time_series_sets->set_test_indexes(test_indexes);
+        if (rank == 0) {
+            time_series_sets->set_training_indexes(training_indexes);
+            time_series_sets->set_test_indexes(test_indexes);
+        }
 
         // time_series_sets->export_training_series(time_offset, training_inputs, training_outputs);
         // time_series_sets->export_test_series(time_offset, validation_inputs, validation_outputs);
@@ -328,7 +340,7 @@ int main(int argc, char** argv) {
 
             MPI_Barrier(MPI_COMM_WORLD);
             Log::debug(
-                "rank %d completed slice %d of %d repeat %d of %d\n", rank, i, time_series_sets->get_number_series(), k,
+                "rank %d completed slice %d of %d repeat %d of %d\n", rank, i, shared_time_series->get_number_series(), k,
                 repeats
             );
         }
@@ -336,6 +348,7 @@ int main(int argc, char** argv) {
         slice_times_file.close();
     }
 
+    delete shared_time_series;
     MPI_Finalize();
     Log::release_id("main_" + to_string(rank));
 
@@ -0,0 +1,286 @@
+#include <cstring>
+using std::memcpy;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "common/process_arguments.hxx"
+#include "node_shared_time_series.hxx"
+
+/**
+ * The window starts with a header of int64_t values:
+ *     header length (bytes, including the parameter names), number of series, number of inputs,
+ *     number of outputs, number of training indexes, number of test indexes,
+ *     the training indexes, the test indexes, the rows of each exported series,
+ * followed by the input and then output parameter names (each terminated by '\0'), padded to a
+ * multiple of 8 bytes. Then for each series come its inputs and its outputs, each stored
+ * parameter by parameter.
+ */
+
+static void push_int64(vector<char>& bytes, int64_t value) {
+    bytes.insert(bytes.end(), (char*) &value, (char*) &value + sizeof(int64_t));
+}
+
+static int64_t read_int64(const char*& position) {
+    int64_t value;
+    memcpy(&value, position, sizeof(int64_t));
+    position += sizeof(int64_t);
+    return value;
+}
+
+NodeSharedTimeSeries::NodeSharedTimeSeries(const vector<string>& arguments) : time_series_sets(NULL) {
+    int32_t rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    int32_t node_rank, node_size;
+    MPI_Comm_rank(node_comm, &node_rank);
+    MPI_Comm_size(node_comm, &node_size);
+
+    vector<char> header;
+    vector<vector<vector<double> > > inputs;
+    vector<vector<vector<double> > > outputs;
+    MPI_Aint window_size = 0;
+
+    if (node_rank == 0) {
+        Log::info("rank %d loading time series for the %d ranks on its node\n", rank, node_size);
+
+        time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
+
+        int32_t time_offset = 1;
+        get_argument(arguments, "--time_offset", true, time_offset);
+
+        vector<int> all_indexes;
+        for (int32_t i = 0; i < time_series_sets->get_number_series(); i++) {
+            all_indexes.push_back(i);
+        }
+        time_series_sets->export_time_series(all_indexes, time_offset, inputs, outputs);
+
+        vector<int> training = time_series_sets->get_training_indexes();
+        vector<int> test = time_series_sets->get_test_indexes();
+        vector<string> input_names = time_series_sets->get_input_parameter_names();
+        vector<string> output_names = time_series_sets->get_output_parameter_names();
+
+        int64_t number_values = 0;
+        vector<char> names;
+        for (int32_t i = 0; i < (int32_t) inputs.size(); i++) {
+            number_values += (input_names.size() + output_names.size()) * inputs[i][0].size();
+        }
+        for (const string& name : input_names) {
+            names.insert(names.end(), name.c_str(), name.c_str() + name.size() + 1);
+        }
+        for (const string& name : output_names) {
+            names.insert(names.end(), name.c_str(), name.c_str() + name.size() + 1);
+        }
+        while (names.size() % sizeof(int64_t) != 0) {
+            names.push_back('\0');
+        }
+
+        int64_t header_length = sizeof(int64_t) * (6 + training.size() + test.size() + inputs.size()) + names.size();
+        push_int64(header, header_length);
+        push_int64(header, inputs.size());
+        push_int64(header, input_names.size());
+        push_int64(header, output_names.size());
+        push_int64(header, training.size());
+        push_int64(header, test.size());
+        for (int index : training) {
+            push_int64(header, index);
+        }
+        for (int index : test) {
+            push_int64(header, index);
+        }
+        for (int32_t i = 0; i < (int32_t) inputs.size(); i++) {
+            push_int64(header, inputs[i][0].size());
+        }
+        header.insert(header.end(), names.begin(), names.end());
+
+        window_size = header_length + number_values * sizeof(double);
+
+        // only the master needs the time series sets, for the seed genome and EXAMM
+        if (rank != 0) {
+            delete time_series_sets;
+            time_series_sets = NULL;
+        }
+    }
+
+    char* window_data = NULL;
+    MPI_Win_allocate_shared(window_size, sizeof(double), MPI_INFO_NULL, node_comm, &window_data, &window);
+
+    MPI_Aint leader_size;
+    int32_t displacement_unit;
+    MPI_Win_shared_query(window, 0, &leader_size, &displacement_unit, &window_data);
+
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+    if (node_rank == 0) {
+        write_window(window_data, header, inputs, outputs);
+    }
+    MPI_Win_sync(window);
+    MPI_Barrier(node_comm);
+    MPI_Win_sync(window);
+
+    read_window(window_data);
+
+    Log::info(
+        "rank %d mapped %ld bytes of shared time series data, %d series, %d inputs, %d outputs\n", rank,
+        (int64_t) leader_size, number_series, (int32_t) input_parameter_names.size(),
+        (int32_t) output_parameter_names.size()
+    );
+}
+
+NodeSharedTimeSeries::~NodeSharedTimeSeries() {
+    MPI_Win_unlock_all(window);
+    MPI_Win_free(&window);
+    MPI_Comm_free(&node_comm);
+
+    if (time_series_sets != NULL) {
+        delete time_series_sets;
+    }
+}
+
+void NodeSharedTimeSeries::write_window(
+    char* window_data, const vector<char>& header, const vector<vector<vector<double> > >& inputs,
+    const vector<vector<vector<double> > >& outputs
+) {
+    memcpy(window_data, header.data(), header.size());
+
+    double* values = (double*) (window_data + header.size());
+    for (int32_t i = 0; i < (int32_t) inputs.size(); i++) {
+        for (const vector<double>& parameter : inputs[i]) {
+            memcpy(values, parameter.data(), parameter.size() * sizeof(double));
+            values += parameter.size();
+        }
+        for (const vector<double>& parameter : outputs[i]) {
+            memcpy(values, parameter.data(), parameter.size() * sizeof(double));
+            values += parameter.size();
+        }
+    }
+}
+
+void NodeSharedTimeSeries::read_window(const char* window_data) {
+    const char* position = window_data;
+
+    int64_t header_length = read_int64(position);
+    number_series = (int32_t) read_int64(position);
+    int64_t number_inputs = read_int64(position);
+    int64_t number_outputs = read_int64(position);
+    int64_t number_training = read_int64(position);
+    int64_t number_test = read_int64(position);
+
+    training_indexes.resize(number_training);
+    for (int64_t i = 0; i < number_training; i++) {
+        training_indexes[i] = (int) read_int64(position);
+    }
+    test_indexes.resize(number_test);
+    for (int64_t i = 0; i < number_test; i++) {
+        test_indexes[i] = (int) read_int64(position);
+    }
+    series_rows.resize(number_series);
+    for (int32_t i = 0; i < number_series; i++) {
+        series_rows[i] = read_int64(position);
+    }
+
+    input_parameter_names.clear();
+    for (int64_t i = 0; i < number_inputs; i++) {
+        input_parameter_names.push_back(string(position));
+        position += input_parameter_names.back().size() + 1;
+    }
+    output_parameter_names.clear();
+    for (int64_t i = 0; i < number_outputs; i++) {
+        output_parameter_names.push_back(string(position));
+        position += output_parameter_names.back().size() + 1;
+    }
+
+    const double* values = (const double*) (window_data + header_length);
+    series_values.resize(number_series);
+    for (int32_t i = 0; i < number_series; i++) {
+        series_values[i] = values;
+        values += (number_inputs + number_outputs) * series_rows[i];
+    }
+}
+
+TimeSeriesSets* NodeSharedTimeSeries::get_time_series_sets() {
+    return time_series_sets;
+}
+
+int32_t NodeSharedTimeSeries::get_number_series() const {
+    return number_series;
+}
+
+int32_t NodeSharedTimeSeries::get_number_inputs() const {
+    return (int32_t) input_parameter_names.size();
+}
+
+int32_t NodeSharedTimeSeries::get_number_outputs() const {
+    return (int32_t) output_parameter_names.size();
+}
+
+vector<string> NodeSharedTimeSeries::get_input_parameter_names() const {
+    return input_parameter_names;
+}
+
+vector<string> NodeSharedTimeSeries::get_output_parameter_names() const {
+    return output_parameter_names;
+}
+
+/**
+ * Sets the tensors to views of the given series in the shared window, without copying them.
+ */
+void NodeSharedTimeSeries::export_time_series(
+    const vector<int>& series_indexes, TimeSeriesTensor& inputs, TimeSeriesTensor& outputs
+) const {
+    int32_t number_inputs = get_number_inputs();
+    int32_t number_outputs = get_number_outputs();
+
+    vector<SeriesView> input_views;
+    vector<SeriesView> output_views;
+
+    for (int32_t i = 0; i < (int32_t) series_indexes.size(); i++) {
+        int32_t series_index = series_indexes[i];
+        if (series_index < 0 || series_index >= number_series) {
+            Log::fatal("ERROR: exporting series %d but there are only %d series\n", series_index, number_series);
+            exit(1);
+        }
+
+        // each series is its input columns followed by its output columns, all rows long
+        int64_t rows = series_rows[series_index];
+        const double* values = series_values[series_index];
+        input_views.push_back(SeriesView(values, number_inputs, (int32_t) rows, rows));
+        output_views.push_back(SeriesView(values + number_inputs * rows, number_outputs, (int32_t) rows, rows));
+    }
+
+    inputs.set_views(number_inputs, input_views);
+    outputs.set_views(number_outputs, output_views);
+}
+
+/**
+ * The same as get_train_validation_data in common/process_arguments, but the tensors are views
+ * of the shared window.
+ */
+void NodeSharedTimeSeries::get_train_validation_data(
+    const vector<string>& arguments, TimeSeriesTensor& train_inputs, TimeSeriesTensor& train_outputs,
+    TimeSeriesTensor& validation_inputs, TimeSeriesTensor& validation_outputs
+) const {
+    if (training_indexes.size() == 0) {
+        Log::fatal(
+            "ERROR: attempting to export training time series, however the training_indexes were not specified.\n"
+        );
+        exit(1);
+    }
+
+    if (test_indexes.size() == 0) {
+        Log::fatal("ERROR: attempting to export test time series, however the test_indexes were not specified.\n");
+        exit(1);
+    }
+
+    export_time_series(training_indexes, train_inputs, train_outputs);
+    export_time_series(test_indexes, validation_inputs, validation_outputs);
+
+    slice_input_data(arguments, train_inputs, train_outputs, validation_inputs, validation_outputs);
+
+    Log::info("Generating time series data finished! \n");
+}
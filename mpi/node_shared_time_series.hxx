@@ -0,0 +1,75 @@
+#ifndef EXAMM_NODE_SHARED_TIME_SERIES_HXX
+#define EXAMM_NODE_SHARED_TIME_SERIES_HXX
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "mpi.h"
+#include "time_series/time_series.hxx"
+#include "time_series/time_series_tensor.hxx"
+
+/**
+ * Loads the time series once per node for MPI programs. The first rank on each node parses
+ * and normalizes the time series (as TimeSeriesSets::generate_from_arguments), exports every
+ * series with the --time_offset, and places the resulting contiguous input and output values
+ * in an MPI-3 shared memory window. Every rank on the node (including the first) trains on
+ * TimeSeriesTensor views of the window, so the values are stored once per node rather than
+ * once per rank.
+ *
+ * Only rank 0 of MPI_COMM_WORLD keeps the full TimeSeriesSets (for the seed genome and EXAMM);
+ * get_time_series_sets() returns NULL on every other rank.
+ *
+ * Construction and destruction are collective over MPI_COMM_WORLD, and the object must be
+ * deleted before MPI_Finalize.
+ */
+class NodeSharedTimeSeries {
+   private:
+    MPI_Comm node_comm;
+    MPI_Win window;
+
+    TimeSeriesSets* time_series_sets;
+
+    int32_t number_series;
+    vector<int> training_indexes;
+    vector<int> test_indexes;
+
+    vector<string> input_parameter_names;
+    vector<string> output_parameter_names;
+
+    // number of rows of each exported series and where its values start in the window
+    vector<int64_t> series_rows;
+    vector<const double*> series_values;
+
+    void write_window(
+        char* window_data, const vector<char>& header, const vector<vector<vector<double> > >& inputs,
+        const vector<vector<vector<double> > >& outputs
+    );
+    void read_window(const char* window_data);
+
+   public:
+    NodeSharedTimeSeries(const vector<string>& arguments);
+    ~NodeSharedTimeSeries();
+
+    TimeSeriesSets* get_time_series_sets();
+
+    int32_t get_number_series() const;
+    int32_t get_number_inputs() const;
+    int32_t get_number_outputs() const;
+
+    vector<string> get_input_parameter_names() const;
+    vector<string> get_output_parameter_names() const;
+
+    void export_time_series(
+        const vector<int>& series_indexes, TimeSeriesTensor& inputs, TimeSeriesTensor& outputs
+    ) const;
+
+    void get_train_validation_data(
+        const vector<string>& arguments, TimeSeriesTensor& train_inputs, TimeSeriesTensor& train_outputs,
+        TimeSeriesTensor& validation_inputs, TimeSeriesTensor& validation_outputs
+    ) const;
+};
+
+#endif
@@ -35,6 +35,7 @@ typedef struct stat Stat;
 #include "common/arguments.hxx"
 #include "common/log.hxx"
 #include "mpi.h"
+#include "node_shared_time_series.hxx"
 #include "rnn/generate_nn.hxx"
 #include "rnn/lstm_node.hxx"
 #include "rnn/rnn_edge.hxx"
@@ -60,6 +61,7 @@ string weight_initialize_string = "xavier";
 string process_name;
 
 WeightUpdate* weight_update_method;
+WindowSampler* window_sampler;
 WeightRules* weight_rules;
 
 vector<string> rnn_types(
@@ -68,7 +70,7 @@ vector<string> rnn_types(
      "two_layer_lstm"}
 );
 
-TimeSeriesSets* time_series_sets = NULL;
+NodeSharedTimeSeries* shared_time_series = NULL;
 
 struct ResultSet {
     int32_t job;
@@ -215,12 +217,12 @@ void master(int32_t max_rank) {
 
     // initialize the results with -1 as the job so we can determine if a particular rnn type has completed
     results = vector<ResultSet>(
-        rnn_types.size() * time_series_sets->get_number_series() * repeats, {-1, 0.0, 0.0, 0.0, 0.0, 0}
+        rnn_types.size() * shared_time_series->get_number_series() * repeats, {-1, 0.0, 0.0, 0.0, 0.0, 0}
     );
 
     int32_t terminates_sent = 0;
     int32_t current_job = 0;
-    int32_t last_job = rnn_types.size() * (time_series_sets->get_number_series() / fold_size) * repeats;
+    int32_t last_job = rnn_types.size() * (shared_time_series->get_number_series() / fold_size) * repeats;
 
     while (true) {
         // wait for a incoming message
@@ -264,7 +266,7 @@ void master(int32_t max_rank) {
             // TODO:
             // check and see if this particular set of jobs for rnn_type has completed,
             // then write the file for that type if it has
-            int32_t jobs_per_rnn = (time_series_sets->get_number_series() / fold_size) * repeats;
+            int32_t jobs_per_rnn = (shared_time_series->get_number_series() / fold_size) * repeats;
 
             // get the particular rnn type this job was for, and which results should be there
             int32_t rnn = result.job / jobs_per_rnn;
@@ -293,7 +295,7 @@ void master(int32_t max_rank) {
                 ofstream outfile(output_directory + "/combined_" + rnn_types[rnn] + ".csv");
 
                 int32_t current = rnn_job_start;
-                for (int32_t j = 0; j < (time_series_sets->get_number_series() / fold_size); j++) {
+                for (int32_t j = 0; j < (shared_time_series->get_number_series() / fold_size); j++) {
                     for (int32_t k = 0; k < repeats; k++) {
                         outfile << j << "," << k << "," << results[current].milliseconds << ","
                                 << results[current].training_mse << "," << results[current].training_mae << ","
@@ -317,7 +319,7 @@ void master(int32_t max_rank) {
 }
 
 ResultSet handle_job(int32_t rank, int32_t current_job) {
-    int32_t jobs_per_rnn = (time_series_sets->get_number_series() / fold_size) * repeats;
+    int32_t jobs_per_rnn = (shared_time_series->get_number_series() / fold_size) * repeats;
 
     // get rnn_type
     string rnn_type = rnn_types[current_job / jobs_per_rnn];
@@ -333,7 +335,7 @@ ResultSet handle_job(int32_t rank, int32_t current_job) {
     vector<int32_t> training_indexes;
     vector<int32_t> test_indexes;
 
-    for (int32_t k = 0; k < time_series_sets->get_number_series(); k += fold_size) {
+    for (int32_t k = 0; k < shared_time_series->get_number_series(); k += fold_size) {
         if (j == (k / fold_size)) {
             for (int32_t l = 0; l < fold_size; l++) {
                 test_indexes.push_back(k + l);
@@ -347,22 +349,20 @@ ResultSet handle_job(int32_t rank, int32_t current_job) {
 
     Log::debug("test_indexes.size(): %d, training_indexes.size(): %d\n", test_indexes.size(), training_indexes.size());
 
-    time_series_sets->set_training_indexes(training_indexes);
-    time_series_sets->set_test_indexes(test_indexes);
+    TimeSeriesTensor training_inputs;
+    TimeSeriesTensor training_outputs;
+    TimeSeriesTensor validation_inputs;
+    TimeSeriesTensor validation_outputs;
 
-    vector<vector<vector<double> > > training_inputs;
-    vector<vector<vector<double> > > training_outputs;
-    vector<vector<vector<double> > > validation_inputs;
-    vector<vector<vector<double> > > validation_outputs;
+    // the series were exported with the time offset when they were loaded
+    shared_time_series->export_time_series(training_indexes, training_inputs, training_outputs);
+    shared_time_series->export_time_series(test_indexes, validation_inputs, validation_outputs);
 
-    time_series_sets->export_training_series(time_offset, training_inputs, training_outputs);
-    time_series_sets->export_test_series(time_offset, validation_inputs, validation_outputs);
+    vector<string> input_parameter_names = shared_time_series->get_input_parameter_names();
+    vector<string> output_parameter_names = shared_time_series->get_output_parameter_names();
 
-    vector<string> input_parameter_names = time_series_sets->get_input_parameter_names();
-    vector<string> output_parameter_names = time_series_sets->get_output_parameter_names();
-
-    int32_t number_inputs = time_series_sets->get_number_inputs();
-    // int32_t number_outputs = time_series_sets->get_number_outputs();
+    int32_t number_inputs = shared_time_series->get_number_inputs();
+    // int32_t number_outputs = shared_time_series->get_number_outputs();
 
     RNN_Genome* genome = NULL;
     if (rnn_type == "one_layer_lstm") {
@@ -445,7 +445,8 @@ ResultSet handle_job(int32_t rank, int32_t current_job) {
 
     std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
     genome->backpropagate_stochastic(
-        training_inputs, training_outputs, validation_inputs, validation_outputs, weight_update_method
+        training_inputs, training_outputs, validation_inputs, validation_outputs, weight_update_method,
+        window_sampler
     );
     std::chrono::time_point<std::chrono::system_clock> end = std::chrono::system_clock::now();
 
@@ -553,12 +554,11 @@ int main(int argc, char** argv) {
     weight_update_method = new WeightUpdate();
     weight_update_method->generate_from_arguments(arguments);
 
-    if (rank == 0) {
-        // only print verbose info from the master process
-        time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
-    } else {
-        time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
-    }
+    window_sampler = new WindowSampler();
+    window_sampler->generate_from_arguments(arguments);
+
+    // the time series are only loaded once per node
+    shared_time_series = new NodeSharedTimeSeries(arguments);
 
     // MPI_Barrier(MPI_COMM_WORLD);
 
@@ -571,5 +571,6 @@ int main(int argc, char** argv) {
     }
 
     Log::release_id("main_" + to_string(rank));
+    delete shared_time_series;
     MPI_Finalize();
 }
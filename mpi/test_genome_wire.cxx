@@ -0,0 +1,188 @@
+#include <chrono>
+#include <iomanip>
+using std::fixed;
+using std::setprecision;
+using std::setw;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "common/log.hxx"
+#include "common/process_arguments.hxx"
+#include "examm/examm.hxx"
+#include "rnn/generate_nn.hxx"
+#include "rnn/genome_wire.hxx"
+#include "time_series/time_series.hxx"
+#include "weights/weight_rules.hxx"
+#include "weights/weight_update.hxx"
+
+/**
+ * Benchmarks the bytes and time per genome needed to send a genome to a worker and get it back,
+ * comparing the RNN_Genome::write_to_array format (which is sent both ways) to the genome wire
+ * format (full genome out, only the trained parameters back), with and without compression.
+ *
+ * Takes the usual EXAMM arguments, plus --benchmark_genomes <n> (default 10).
+ */
+
+vector<string> arguments;
+
+vector<vector<vector<double> > > training_inputs;
+vector<vector<vector<double> > > training_outputs;
+vector<vector<vector<double> > > validation_inputs;
+vector<vector<vector<double> > > validation_outputs;
+
+double seconds_since(std::chrono::time_point<std::chrono::high_resolution_clock> start) {
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+/**
+ * Sends the genome out and back using the legacy format, returning the total bytes sent.
+ */
+int64_t legacy_round_trip(RNN_Genome* genome, double& seconds) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    char* byte_array;
+    int32_t length_out;
+    genome->write_to_array(&byte_array, length_out);
+    RNN_Genome* worker_genome = new RNN_Genome(byte_array, length_out);
+    free(byte_array);
+
+    int32_t length_back;
+    worker_genome->write_to_array(&byte_array, length_back);
+    RNN_Genome* master_genome = new RNN_Genome(byte_array, length_back);
+    free(byte_array);
+
+    seconds = seconds_since(start);
+
+    delete worker_genome;
+    delete master_genome;
+    return (int64_t) length_out + length_back;
+}
+
+/**
+ * Sends the genome out and back using the genome wire format, returning the total bytes sent.
+ */
+int64_t wire_round_trip(RNN_Genome* genome, bool compress, double& seconds) {
+    RNN_Genome* master_genome = genome->copy();
+    master_genome->set_best_parameters(vector<double>());
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    vector<char> message_out;
+    GenomeWire::write_genome(master_genome, compress, message_out);
+    RNN_Genome* worker_genome = GenomeWire::read_genome(&message_out[0], (int32_t) message_out.size());
+
+    // stand in for training on the worker
+    worker_genome->set_best_parameters(genome->get_best_parameters());
+
+    vector<char> message_back;
+    GenomeWire::write_result(worker_genome, compress, message_back);
+    GenomeWire::read_result(&message_back[0], (int32_t) message_back.size(), master_genome);
+
+    seconds = seconds_since(start);
+
+    if (master_genome->get_best_parameters() != genome->get_best_parameters()) {
+        Log::fatal("ERROR: best parameters did not survive the genome wire round trip!\n");
+        exit(1);
+    }
+
+    // the worker only gets the graph and initial parameters, which need to give the same network
+    vector<double> initial_parameters = master_genome->get_initial_parameters();
+    if (worker_genome->get_initial_parameters() != initial_parameters
+        || worker_genome->get_mse(initial_parameters, validation_inputs, validation_outputs)
+               != master_genome->get_mse(initial_parameters, validation_inputs, validation_outputs)) {
+        Log::fatal("ERROR: the worker's genome does not match the genome sent by the master!\n");
+        exit(1);
+    }
+
+    delete worker_genome;
+    delete master_genome;
+    return (int64_t) message_out.size() + message_back.size();
+}
+
+int main(int argc, char** argv) {
+    arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_id("main");
+
+    int32_t benchmark_genomes = 10;
+    get_argument(arguments, "--benchmark_genomes", false, benchmark_genomes);
+
+    TimeSeriesSets* time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
+    get_train_validation_data(
+        arguments, time_series_sets, training_inputs, training_outputs, validation_inputs, validation_outputs
+    );
+
+    WeightUpdate* weight_update_method = new WeightUpdate();
+    weight_update_method->generate_from_arguments(arguments);
+
+    WeightRules* weight_rules = new WeightRules();
+    weight_rules->initialize_from_args(arguments);
+
+    RNN_Genome* seed_genome = get_seed_genome(arguments, time_series_sets, weight_rules);
+    EXAMM* examm = generate_examm_from_arguments(arguments, time_series_sets, weight_rules, seed_genome);
+
+    int64_t legacy_bytes = 0, wire_bytes = 0, compressed_bytes = 0;
+    double legacy_seconds = 0.0, wire_seconds = 0.0, compressed_seconds = 0.0;
+    int32_t genomes = 0;
+
+    Log::info("%10s %10s %14s %14s %14s\n", "genome", "weights", "legacy bytes", "wire bytes", "compressed");
+    for (int32_t i = 0; i < benchmark_genomes; i++) {
+        RNN_Genome* genome = examm->generate_genome();
+        if (genome == NULL) {
+            break;
+        }
+
+        genome->backpropagate_stochastic(
+            training_inputs, training_outputs, validation_inputs, validation_outputs, weight_update_method
+        );
+
+        double seconds;
+        int64_t legacy = legacy_round_trip(genome, seconds);
+        legacy_bytes += legacy;
+        legacy_seconds += seconds;
+
+        int64_t wire = wire_round_trip(genome, false, seconds);
+        wire_bytes += wire;
+        wire_seconds += seconds;
+
+        int64_t compressed = wire_round_trip(genome, true, seconds);
+        compressed_bytes += compressed;
+        compressed_seconds += seconds;
+
+        Log::info(
+            "%10d %10d %14ld %14ld %14ld\n", genome->get_generation_id(), genome->get_number_weights(), legacy, wire,
+            compressed
+        );
+
+        examm->insert_genome(genome);
+        delete genome;
+        genomes++;
+    }
+
+    if (genomes == 0) {
+        Log::fatal("ERROR: no genomes were generated.\n");
+        exit(1);
+    }
+
+    Log::info("averages per genome round trip over %d genomes:\n", genomes);
+    Log::info(
+        "\tlegacy:          %12.1lf bytes, %10.2lf us\n", (double) legacy_bytes / genomes,
+        1e6 * legacy_seconds / genomes
+    );
+    Log::info(
+        "\twire:            %12.1lf bytes, %10.2lf us\n", (double) wire_bytes / genomes, 1e6 * wire_seconds / genomes
+    );
+    Log::info(
+        "\twire compressed: %12.1lf bytes, %10.2lf us\n", (double) compressed_bytes / genomes,
+        1e6 * compressed_seconds / genomes
+    );
+
+    Log::release_id("main");
+    delete time_series_sets;
+    return 0;
+}
@@ -10,6 +10,9 @@ using std::cerr;
 using std::cout;
 using std::endl;
 
+#include <functional>
+using std::cref;
+
 #include <mutex>
 using std::mutex;
 
@@ -23,6 +26,7 @@ using std::thread;
 using std::vector;
 
 #include "cnn/exact.hxx"
+#include "cnn/propagation.hxx"
 #include "common/arguments.hxx"
 #include "image_tools/image_set.hxx"
 
@@ -68,6 +72,12 @@ int main(int argc, char** argv) {
     int32_t number_threads;
     get_argument(arguments, "--number_threads", true, number_threads);
 
+    // threads for the convolutions of a genome, used by whichever genome's convolutions get them
+    // first (e.g. the last genomes trained in a search, when the other threads are done)
+    int32_t propagation_threads = 1;
+    get_argument(arguments, "--propagation_threads", false, propagation_threads);
+    set_propagation_threads(propagation_threads);
+
     int32_t padding;
     get_argument(arguments, "--padding", true, padding);
 
@@ -129,7 +139,10 @@ int main(int argc, char** argv) {
 
     vector<thread> threads;
     for (int32_t i = 0; i < number_threads; i++) {
-        threads.push_back(thread(exact_thread, training_images, validation_images, testing_images, i));
+        // the images can't be copied, so the threads share them
+        threads.push_back(
+            thread(exact_thread, cref(training_images), cref(validation_images), cref(testing_images), i)
+        );
     }
 
     for (int32_t i = 0; i < number_threads; i++) {
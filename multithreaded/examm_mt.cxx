@@ -22,6 +22,7 @@ using std::vector;
 #include "examm/examm.hxx"
 #include "rnn/generate_nn.hxx"
 #include "time_series/time_series.hxx"
+#include "time_series/time_series_stream.hxx"
 #include "weights/weight_rules.hxx"
 #include "weights/weight_update.hxx"
 
@@ -32,13 +33,17 @@ vector<string> arguments;
 EXAMM* examm;
 
 WeightUpdate* weight_update_method;
+WindowSampler* window_sampler;
 
 bool finished = false;
 
-vector<vector<vector<double> > > training_inputs;
-vector<vector<vector<double> > > training_outputs;
-vector<vector<vector<double> > > validation_inputs;
-vector<vector<vector<double> > > validation_outputs;
+TimeSeriesTensor training_inputs;
+TimeSeriesTensor training_outputs;
+TimeSeriesTensor validation_inputs;
+TimeSeriesTensor validation_outputs;
+
+// set with --stream_training_data, in which case the training tensors are empty
+TimeSeriesStream* time_series_stream = NULL;
 
 void examm_thread(int32_t id) {
     while (true) {
@@ -54,9 +59,16 @@ void examm_thread(int32_t id) {
         string log_id = "genome_" + to_string(genome->get_generation_id()) + "_thread_" + to_string(id);
         Log::set_id(log_id);
         // genome->backpropagate(training_inputs, training_outputs, validation_inputs, validation_outputs);
-        genome->backpropagate_stochastic(
-            training_inputs, training_outputs, validation_inputs, validation_outputs, weight_update_method
-        );
+        if (time_series_stream != NULL) {
+            genome->backpropagate_stochastic(
+                time_series_stream, validation_inputs, validation_outputs, weight_update_method, window_sampler
+            );
+        } else {
+            genome->backpropagate_stochastic(
+                training_inputs, training_outputs, validation_inputs, validation_outputs, weight_update_method,
+                window_sampler
+            );
+        }
         Log::release_id(log_id);
 
         examm_mutex.lock();
@@ -91,14 +103,28 @@ int main(int argc, char** argv) {
     get_argument(arguments, "--number_threads", true, number_threads);
 
     TimeSeriesSets* time_series_sets = NULL;
-    time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
-    get_train_validation_data(
-        arguments, time_series_sets, training_inputs, training_outputs, validation_inputs, validation_outputs
-    );
+    if (argument_exists(arguments, "--stream_training_data")) {
+        // only the test files are loaded, with the normalization values of the streamed data
+        time_series_stream = TimeSeriesStream::generate_from_arguments(arguments);
+        time_series_sets = time_series_stream->generate_test_sets();
+
+        int32_t time_offset = 1;
+        get_argument(arguments, "--time_offset", true, time_offset);
+        time_series_sets->export_test_series(time_offset, validation_inputs, validation_outputs);
+        slice_input_data(arguments, training_inputs, training_outputs, validation_inputs, validation_outputs);
+    } else {
+        time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
+        get_train_validation_data(
+            arguments, time_series_sets, training_inputs, training_outputs, validation_inputs, validation_outputs
+        );
+    }
 
     weight_update_method = new WeightUpdate();
     weight_update_method->generate_from_arguments(arguments);
 
+    window_sampler = new WindowSampler();
+    window_sampler->generate_from_arguments(arguments);
+
     WeightRules* weight_rules = new WeightRules();
     weight_rules->initialize_from_args(arguments);
 
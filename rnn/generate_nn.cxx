@@ -193,6 +193,19 @@ RNN_Genome* create_dnas_nn(
     );
 }
 
+/**
+ * Creates a genome with a learned embedding layer between its inputs and outputs, a layer of
+ * embedding_size linear nodes fully connected to the inputs and to the outputs. For one-hot
+ * encoded inputs (e.g., words) each input's edges are its embedding, which the sparse input
+ * path only uses when the input is active.
+ */
+RNN_Genome* create_embedding_nn(
+    const vector<string>& input_parameter_names, int32_t embedding_size, const vector<string>& output_parameter_names,
+    WeightRules* weight_rules
+) {
+    return create_sum(input_parameter_names, 1, embedding_size, output_parameter_names, 0, weight_rules);
+}
+
 RNN_Genome* get_seed_genome(
     const vector<string>& arguments, TimeSeriesSets* time_series_sets, WeightRules* weight_rules
 ) {
@@ -228,6 +241,16 @@ RNN_Genome* get_seed_genome(
             transfer_learning_version, epigenetic_weights, min_recurrent_depth, max_recurrent_depth
         );
         Log::info("Finished transfering seed genome\n");
+    } else if (argument_exists(arguments, "--embedding_size")) {
+        int32_t embedding_size;
+        get_argument(arguments, "--embedding_size", true, embedding_size);
+
+        seed_genome = create_embedding_nn(
+            time_series_sets->get_input_parameter_names(), embedding_size,
+            time_series_sets->get_output_parameter_names(), weight_rules
+        );
+        seed_genome->initialize_randomly();
+        Log::info("Generated seed genome with an embedding layer of %d nodes\n", embedding_size);
     } else {
         if (seed_genome == NULL) {
             seed_genome = create_ff(
@@ -125,6 +125,11 @@ RNN_Genome* create_nn(
     const vector<string>& input_parameter_names, int32_t number_hidden_layers, int32_t number_hidden_nodes,
     const vector<string>& output_parameter_names, int32_t max_recurrent_depth, WeightRules* weight_rules
 );
+RNN_Genome* create_embedding_nn(
+    const vector<string>& input_parameter_names, int32_t embedding_size, const vector<string>& output_parameter_names,
+    WeightRules* weight_rules
+);
+
 RNN_Genome* get_seed_genome(
     const vector<string>& arguments, TimeSeriesSets* time_series_sets, WeightRules* weight_rules
 );
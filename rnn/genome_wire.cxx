@@ -0,0 +1,329 @@
+#include <cstring>
+using std::memcpy;
+
+#include <sstream>
+using std::istringstream;
+using std::ostringstream;
+
+#include <string>
+using std::stoul;
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#ifdef _HAS_ZLIB_
+#include <zlib.h>
+#endif
+
+#include "common/log.hxx"
+#include "genome_wire.hxx"
+#include "rnn_genome.hxx"
+
+static const char GENOME_WIRE_MAGIC[4] = {'E', 'X', 'G', 'W'};
+
+/**
+ * Transposes the bytes of an array of doubles so that byte b of every value is stored
+ * contiguously, which makes the (highly repetitive) sign and exponent bytes compress well.
+ */
+static void shuffle_bytes(vector<char>& bytes) {
+    int32_t n_values = (int32_t) bytes.size() / sizeof(double);
+    vector<char> shuffled(bytes.size());
+    for (int32_t i = 0; i < n_values; i++) {
+        for (int32_t b = 0; b < (int32_t) sizeof(double); b++) {
+            shuffled[b * n_values + i] = bytes[i * sizeof(double) + b];
+        }
+    }
+    bytes.swap(shuffled);
+}
+
+static void unshuffle_bytes(vector<char>& bytes) {
+    int32_t n_values = (int32_t) bytes.size() / sizeof(double);
+    vector<char> unshuffled(bytes.size());
+    for (int32_t i = 0; i < n_values; i++) {
+        for (int32_t b = 0; b < (int32_t) sizeof(double); b++) {
+            unshuffled[i * sizeof(double) + b] = bytes[b * n_values + i];
+        }
+    }
+    bytes.swap(unshuffled);
+}
+
+void GenomeWire::write_header(
+    vector<char>& message, int32_t type, int32_t flags, int32_t generation_id, int32_t payload_length,
+    int32_t stored_length, uint32_t seed
+) {
+    message.resize(HEADER_LENGTH + stored_length);
+
+    memcpy(&message[0], GENOME_WIRE_MAGIC, 4);
+    message[4] = (char) GENOME_WIRE_VERSION;
+    message[5] = (char) type;
+    message[6] = (char) flags;
+    message[7] = 0;
+    memcpy(&message[8], &generation_id, sizeof(int32_t));
+    memcpy(&message[12], &payload_length, sizeof(int32_t));
+    memcpy(&message[16], &stored_length, sizeof(int32_t));
+    memcpy(&message[20], &seed, sizeof(uint32_t));
+}
+
+void GenomeWire::compress_payload(const vector<char>& payload, vector<char>& stored) {
+#ifdef _HAS_ZLIB_
+    uLongf compressed_length = compressBound(payload.size());
+    stored.resize(compressed_length);
+    int result = compress2(
+        (Bytef*) &stored[0], &compressed_length, (const Bytef*) payload.data(), payload.size(), Z_BEST_SPEED
+    );
+    if (result != Z_OK) {
+        Log::fatal("ERROR: zlib could not compress genome wire payload, error: %d\n", result);
+        exit(1);
+    }
+    stored.resize(compressed_length);
+#else
+    stored = payload;
+#endif
+}
+
+void GenomeWire::decompress_payload(const char* stored, int32_t stored_length, vector<char>& payload) {
+#ifdef _HAS_ZLIB_
+    uLongf payload_length = payload.size();
+    int result = uncompress((Bytef*) payload.data(), &payload_length, (const Bytef*) stored, stored_length);
+    if (result != Z_OK || payload_length != payload.size()) {
+        Log::fatal(
+            "ERROR: zlib could not decompress genome wire payload, error: %d, length: %d, expected: %d\n", result,
+            (int32_t) payload_length, (int32_t) payload.size()
+        );
+        exit(1);
+    }
+#else
+    Log::fatal("ERROR: received a compressed genome wire message but EXAMM was compiled without zlib.\n");
+    exit(1);
+#endif
+}
+
+void GenomeWire::read_payload(const char* message, int32_t length, int32_t expected_type, vector<char>& payload) {
+    int32_t type = get_type(message, length);
+    if (type != expected_type) {
+        Log::fatal("ERROR: expected genome wire message of type %d but got type %d\n", expected_type, type);
+        exit(1);
+    }
+
+    int32_t flags = message[6];
+    int32_t payload_length, stored_length;
+    memcpy(&payload_length, message + 12, sizeof(int32_t));
+    memcpy(&stored_length, message + 16, sizeof(int32_t));
+
+    if (HEADER_LENGTH + stored_length != length) {
+        Log::fatal(
+            "ERROR: genome wire message length %d does not match header length %d + stored length %d\n", length,
+            HEADER_LENGTH, stored_length
+        );
+        exit(1);
+    }
+
+    payload.resize(payload_length);
+    if (flags & GENOME_WIRE_COMPRESSED) {
+        decompress_payload(message + HEADER_LENGTH, stored_length, payload);
+    } else if (payload_length > 0) {
+        memcpy(&payload[0], message + HEADER_LENGTH, payload_length);
+    }
+}
+
+int32_t GenomeWire::get_type(const char* message, int32_t length) {
+    if (length < HEADER_LENGTH || memcmp(message, GENOME_WIRE_MAGIC, 4) != 0) {
+        Log::fatal("ERROR: message of length %d is not a genome wire message\n", length);
+        exit(1);
+    }
+
+    if (message[4] != GENOME_WIRE_VERSION) {
+        Log::fatal(
+            "ERROR: genome wire message has version %d, this EXAMM uses version %d\n", (int32_t) message[4],
+            GENOME_WIRE_VERSION
+        );
+        exit(1);
+    }
+
+    return message[5];
+}
+
+int32_t GenomeWire::get_generation_id(const char* message, int32_t length) {
+    get_type(message, length);
+
+    int32_t generation_id;
+    memcpy(&generation_id, message + 8, sizeof(int32_t));
+    return generation_id;
+}
+
+void GenomeWire::write_genome(RNN_Genome* genome, bool compress, vector<char>& message) {
+    // only what a worker reads when it trains the genome: its training settings, initial parameters and
+    // graph (the generation id is in the header)
+    ostringstream oss;
+    oss.write((char*) &genome->group_id, sizeof(int32_t));
+    oss.write((char*) &genome->bp_iterations, sizeof(int32_t));
+    oss.write((char*) &genome->use_dropout, sizeof(bool));
+    oss.write((char*) &genome->dropout_probability, sizeof(double));
+
+    int32_t n_initial_parameters = (int32_t) genome->initial_parameters.size();
+    oss.write((char*) &n_initial_parameters, sizeof(int32_t));
+    if (n_initial_parameters > 0) {
+        oss.write((char*) &genome->initial_parameters[0], sizeof(double) * n_initial_parameters);
+    }
+
+    genome->write_graph_to_stream(oss);
+
+    string payload_str = oss.str();
+    vector<char> payload(payload_str.begin(), payload_str.end());
+
+    int32_t flags = 0;
+    vector<char> stored;
+#ifdef _HAS_ZLIB_
+    if (compress) {
+        flags |= GENOME_WIRE_COMPRESSED;
+        compress_payload(payload, stored);
+    } else {
+        stored.swap(payload);
+    }
+#else
+    stored.swap(payload);
+#endif
+
+    // minstd_rand0's state is a single value below its modulus, which it can be reseeded with
+    ostringstream generator_state;
+    generator_state << genome->generator;
+    uint32_t seed = (uint32_t) stoul(generator_state.str());
+
+    write_header(
+        message, GENOME_WIRE_FULL, flags, genome->generation_id, (int32_t) payload_str.size(), (int32_t) stored.size(),
+        seed
+    );
+    if (stored.size() > 0) {
+        memcpy(&message[HEADER_LENGTH], &stored[0], stored.size());
+    }
+}
+
+void GenomeWire::write_result(RNN_Genome* genome, bool compress, vector<char>& message) {
+    int32_t n_parameters = (int32_t) genome->best_parameters.size();
+
+    vector<char> payload(sizeof(double) * (2 + n_parameters));
+    memcpy(&payload[0], &genome->best_validation_mse, sizeof(double));
+    memcpy(&payload[sizeof(double)], &genome->best_validation_mae, sizeof(double));
+    if (n_parameters > 0) {
+        memcpy(&payload[2 * sizeof(double)], &genome->best_parameters[0], sizeof(double) * n_parameters);
+    }
+    int32_t payload_length = (int32_t) payload.size();
+
+    int32_t flags = 0;
+    vector<char> stored;
+#ifdef _HAS_ZLIB_
+    if (compress) {
+        flags |= GENOME_WIRE_COMPRESSED;
+        shuffle_bytes(payload);
+        compress_payload(payload, stored);
+    } else {
+        stored.swap(payload);
+    }
+#else
+    stored.swap(payload);
+#endif
+
+    write_header(
+        message, GENOME_WIRE_RESULT, flags, genome->generation_id, payload_length, (int32_t) stored.size(), 0
+    );
+    memcpy(&message[HEADER_LENGTH], &stored[0], stored.size());
+}
+
+RNN_Genome* GenomeWire::read_genome(const char* message, int32_t length) {
+    int32_t generation_id = get_generation_id(message, length);
+    uint32_t seed;
+    memcpy(&seed, message + 20, sizeof(uint32_t));
+
+    vector<char> payload;
+    read_payload(message, length, GENOME_WIRE_FULL, payload);
+    istringstream iss(string(payload.begin(), payload.end()));
+
+    int32_t group_id, bp_iterations;
+    bool use_dropout;
+    double dropout_probability;
+    iss.read((char*) &group_id, sizeof(int32_t));
+    iss.read((char*) &bp_iterations, sizeof(int32_t));
+    iss.read((char*) &use_dropout, sizeof(bool));
+    iss.read((char*) &dropout_probability, sizeof(double));
+
+    int32_t n_initial_parameters = 0;
+    iss.read((char*) &n_initial_parameters, sizeof(int32_t));
+    if (!iss || n_initial_parameters < 0) {
+        Log::fatal("ERROR: could not read the genome wire message for genome %d\n", generation_id);
+        exit(1);
+    }
+    vector<double> initial_parameters(n_initial_parameters);
+    if (n_initial_parameters > 0) {
+        iss.read((char*) &initial_parameters[0], sizeof(double) * n_initial_parameters);
+    }
+
+    vector<string> input_parameter_names, output_parameter_names;
+    vector<RNN_Node_Interface*> nodes;
+    vector<RNN_Edge*> edges;
+    vector<RNN_Recurrent_Edge*> recurrent_edges;
+    RNN_Genome::read_graph_from_stream(
+        iss, input_parameter_names, output_parameter_names, nodes, edges, recurrent_edges
+    );
+    if (!iss) {
+        Log::fatal("ERROR: could not read the genome wire message for genome %d\n", generation_id);
+        exit(1);
+    }
+
+    // the constructor only takes a 16 bit seed, so the generator is reseeded with the sender's state after;
+    // the weight rules are only used when generating genomes, which workers do not do
+    WeightRules weight_rules;
+    RNN_Genome* genome = new RNN_Genome(nodes, edges, recurrent_edges, 0, &weight_rules);
+    genome->generator.seed(seed);
+
+    // the constructor sorts the nodes and edges, keep the sender's order so the parameters line up
+    genome->nodes = nodes;
+    genome->edges = edges;
+    genome->recurrent_edges = recurrent_edges;
+
+    genome->set_parameter_names(input_parameter_names, output_parameter_names);
+    genome->generation_id = generation_id;
+    genome->group_id = group_id;
+    genome->bp_iterations = bp_iterations;
+    genome->use_dropout = use_dropout;
+    genome->dropout_probability = dropout_probability;
+    genome->initial_parameters = initial_parameters;
+
+    return genome;
+}
+
+void GenomeWire::read_result(const char* message, int32_t length, RNN_Genome* genome) {
+    int32_t generation_id = get_generation_id(message, length);
+    if (generation_id != genome->generation_id) {
+        Log::fatal(
+            "ERROR: applying genome wire result for generation id %d to genome with generation id %d\n", generation_id,
+            genome->generation_id
+        );
+        exit(1);
+    }
+
+    vector<char> payload;
+    read_payload(message, length, GENOME_WIRE_RESULT, payload);
+    if (message[6] & GENOME_WIRE_COMPRESSED) {
+        unshuffle_bytes(payload);
+    }
+
+    int32_t n_parameters = (int32_t) (payload.size() / sizeof(double)) - 2;
+    if (n_parameters != genome->get_number_weights()) {
+        Log::fatal(
+            "ERROR: genome wire result for genome %d has %d parameters, but the genome has %d weights\n", generation_id,
+            n_parameters, genome->get_number_weights()
+        );
+        exit(1);
+    }
+
+    memcpy(&genome->best_validation_mse, &payload[0], sizeof(double));
+    memcpy(&genome->best_validation_mae, &payload[sizeof(double)], sizeof(double));
+    genome->best_parameters.resize(n_parameters);
+    if (n_parameters > 0) {
+        memcpy(&genome->best_parameters[0], &payload[2 * sizeof(double)], sizeof(double) * n_parameters);
+    }
+
+    // same as the end of backpropagation
+    genome->set_weights(genome->best_parameters);
+}
@@ -0,0 +1,61 @@
+#ifndef EXAMM_GENOME_WIRE_HXX
+#define EXAMM_GENOME_WIRE_HXX
+
+#include <cstdint>
+
+#include <vector>
+using std::vector;
+
+#include "rnn_genome.hxx"
+
+#define GENOME_WIRE_VERSION 3
+
+#define GENOME_WIRE_FULL   0
+#define GENOME_WIRE_RESULT 1
+
+#define GENOME_WIRE_COMPRESSED 1
+
+/**
+ * A compact, versioned binary format for sending genomes between EXAMM processes.
+ *
+ * Every message starts with a fixed size header (magic, version, message type, flags, generation id,
+ * uncompressed and stored payload lengths, seed). There are two message types:
+ *
+ *  - GENOME_WIRE_FULL: only what a worker needs to train the genome, its group id, bp iterations, dropout
+ *    settings and initial parameters followed by its graph (see RNN_Genome::write_graph_to_stream). Fields
+ *    the worker never reads (best parameters, generated by map, log filename, normalization) are left out.
+ *    The seed in the header is the state of the genome's generator, which the worker's copy is given so
+ *    it trains the same way the genome would have on the master. Sent by the master to a worker.
+ *
+ *  - GENOME_WIRE_RESULT: only the best validation MSE/MAE and the best parameters of a trained genome.
+ *    Sent by a worker back to the master, which still holds the genome it sent out and applies the
+ *    result to it with read_result.
+ *
+ * If compression is requested (and zlib was found at build time) the payload is deflated; result
+ * payloads are byte-shuffled first so the exponent bytes of the parameters compress together.
+ */
+class GenomeWire {
+   private:
+    static void write_header(
+        vector<char>& message, int32_t type, int32_t flags, int32_t generation_id, int32_t payload_length,
+        int32_t stored_length, uint32_t seed
+    );
+    static void read_payload(const char* message, int32_t length, int32_t expected_type, vector<char>& payload);
+
+    static void compress_payload(const vector<char>& payload, vector<char>& stored);
+    static void decompress_payload(const char* stored, int32_t stored_length, vector<char>& payload);
+
+   public:
+    static const int32_t HEADER_LENGTH = 24;
+
+    static void write_genome(RNN_Genome* genome, bool compress, vector<char>& message);
+    static void write_result(RNN_Genome* genome, bool compress, vector<char>& message);
+
+    static int32_t get_type(const char* message, int32_t length);
+    static int32_t get_generation_id(const char* message, int32_t length);
+
+    static RNN_Genome* read_genome(const char* message, int32_t length);
+    static void read_result(const char* message, int32_t length, RNN_Genome* genome);
+};
+
+#endif
@@ -14,11 +14,15 @@ using std::setw;
 using std::cout;
 using std::endl;
 
+#include <map>
+using std::map;
+
 #include <fstream>
 using std::ofstream;
 
 #include <random>
 using std::minstd_rand0;
+using std::uniform_int_distribution;
 using std::uniform_real_distribution;
 
 #include <vector>
@@ -182,6 +186,9 @@ RNN::RNN(
 ) {
     nodes = _nodes;
     edges = _edges;
+    sparse_initialized = false;
+    sparse_outputs_skippable = false;
+    sampling_outputs = false;
 
     // sort edges by depth
     sort(edges.begin(), edges.end(), sort_RNN_Edges_by_depth());
@@ -205,6 +212,9 @@ RNN::RNN(
     nodes = _nodes;
     edges = _edges;
     recurrent_edges = _recurrent_edges;
+    sparse_initialized = false;
+    sparse_outputs_skippable = false;
+    sampling_outputs = false;
 
     // sort nodes by depth
     // sort edges by depth
@@ -348,15 +358,13 @@ int32_t RNN::get_number_weights() {
     return number_weights;
 }
 
-void RNN::forward_pass(
-    const vector<vector<double> >& series_data, bool using_dropout, bool training, double dropout_probability
-) {
-    series_length = series_data[0].size();
+void RNN::forward_pass(const SeriesView& series_data, bool using_dropout, bool training, double dropout_probability) {
+    series_length = series_data.get_length();
 
-    if (input_nodes.size() != series_data.size()) {
+    if ((int32_t) input_nodes.size() != series_data.get_number_parameters()) {
         Log::fatal(
             "ERROR: number of input nodes (%d) != number of time series data input fields (%d)\n", input_nodes.size(),
-            series_data.size()
+            series_data.get_number_parameters()
         );
         for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
             Log::fatal(
@@ -393,7 +401,7 @@ void RNN::forward_pass(
     for (int32_t time = 0; time < series_length; time++) {
         for (int32_t i = 0; i < (int32_t) input_nodes.size(); i++) {
             if (input_nodes[i]->is_reachable()) {
-                input_nodes[i]->input_fired(time, series_data[i][time]);
+                input_nodes[i]->input_fired(time, series_data.get(i, time));
             }
         }
 
@@ -457,121 +465,689 @@ void RNN::backward_pass(double error, bool using_dropout, bool training, double
     }
 }
 
-double RNN::calculate_error_softmax(const vector<vector<double> >& expected_outputs) {
-    double cross_entropy_sum = 0.0;
-    double error;
-    double softmax = 0.0;
+void RNN::initialize_sparse_inputs() {
+    map<RNN_Node_Interface*, int32_t> input_indexes;
+    for (int32_t i = 0; i < (int32_t) input_nodes.size(); i++) {
+        if (dynamic_cast<RNN_Node*>(input_nodes[i]) == NULL) {
+            Log::fatal(
+                "ERROR: sparse inputs require simple input nodes, input node %d had node type: %d\n",
+                input_nodes[i]->innovation_number, input_nodes[i]->node_type
+            );
+            exit(1);
+        }
+        input_indexes[input_nodes[i]] = i;
+    }
+
+    sparse_hidden_edges.clear();
+    sparse_input_edges.clear();
+    sparse_input_edge_targets.clear();
+    sparse_node_input_edges.assign(input_nodes.size(), vector<int32_t>());
+    sparse_node_recurrent.assign(input_nodes.size(), false);
+    sparse_targets.clear();
+    sparse_target_inputs.clear();
+
+    map<RNN_Node_Interface*, int32_t> target_indexes;
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        if (!edges[i]->is_reachable()) {
+            continue;
+        }
+
+        if (edges[i]->input_node->layer_type != INPUT_LAYER) {
+            sparse_hidden_edges.push_back(edges[i]);
+            continue;
+        }
+
+        // the input edges into a node are summed together, which multiply nodes do not do, and edges into GP
+        // nodes do not calculate their gradients
+        RNN_Node_Interface* target = edges[i]->output_node;
+        int32_t node_type = target->node_type;
+        if (node_type == MULTIPLY_NODE || node_type == MULTIPLY_NODE_GP || node_type == OUTPUT_NODE_GP
+            || node_type == SIN_NODE_GP || node_type == COS_NODE_GP || node_type == TANH_NODE_GP
+            || node_type == SIGMOID_NODE_GP || node_type == SUM_NODE_GP || node_type == INVERSE_NODE_GP) {
+            Log::fatal(
+                "ERROR: sparse inputs do not support input edges into node %d with node type: %d\n",
+                target->innovation_number, node_type
+            );
+            exit(1);
+        }
+
+        if (target_indexes.count(target) == 0) {
+            target_indexes[target] = (int32_t) sparse_targets.size();
+            sparse_targets.push_back(target);
+            sparse_target_inputs.push_back(0);
+        }
+        int32_t target_index = target_indexes[target];
+        sparse_target_inputs[target_index]++;
+
+        sparse_node_input_edges[input_indexes[edges[i]->input_node]].push_back((int32_t) sparse_input_edges.size());
+        sparse_input_edges.push_back(edges[i]);
+        sparse_input_edge_targets.push_back(target_index);
+    }
 
+    map<RNN_Node_Interface*, int32_t> output_indexes;
     for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
-        output_nodes[i]->error_values.resize(expected_outputs[i].size());
+        output_indexes[output_nodes[i]] = i;
     }
 
-    // for each time step j
-    for (int32_t j = 0; j < (int32_t) expected_outputs[0].size(); j++) {
-        double softmax_sum = 0.0;
-        double cross_entropy = 0.0;
-        // get sum of all the outputs of the timestep j from all output node i
-        for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
-            softmax_sum += exp(output_nodes[i]->output_values[j]);
+    sparse_internal_edges.clear();
+    sparse_output_edges.assign(output_nodes.size(), vector<RNN_Edge*>());
+    sparse_output_edge_sources.assign(output_nodes.size(), vector<int32_t>());
+    sparse_output_sources.clear();
+    sparse_output_source_edges.clear();
+
+    // the edges into the outputs which are not sampled can only be skipped in the forward pass if nothing uses the
+    // values of the output nodes
+    sparse_outputs_skippable = true;
+
+    map<RNN_Node_Interface*, int32_t> source_indexes;
+    for (int32_t i = 0; i < (int32_t) sparse_hidden_edges.size(); i++) {
+        RNN_Edge* edge = sparse_hidden_edges[i];
+        if (edge->input_node->layer_type == OUTPUT_LAYER) {
+            sparse_outputs_skippable = false;
+        }
+
+        if (edge->output_node->layer_type != OUTPUT_LAYER) {
+            sparse_internal_edges.push_back(edge);
+            continue;
+        }
+
+        if (source_indexes.count(edge->input_node) == 0) {
+            source_indexes[edge->input_node] = (int32_t) sparse_output_sources.size();
+            sparse_output_sources.push_back(edge->input_node);
+            sparse_output_source_edges.push_back(0);
+        }
+        int32_t source_index = source_indexes[edge->input_node];
+        sparse_output_source_edges[source_index]++;
+
+        int32_t output_index = output_indexes[edge->output_node];
+        sparse_output_edges[output_index].push_back(edge);
+        sparse_output_edge_sources[output_index].push_back(source_index);
+    }
+
+    // input nodes with recurrent edges out of them still need their outputs at every time step
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        if (!recurrent_edges[i]->is_reachable()) {
+            continue;
+        }
+
+        if (recurrent_edges[i]->input_node->layer_type == INPUT_LAYER) {
+            sparse_node_recurrent[input_indexes[recurrent_edges[i]->input_node]] = true;
+        } else if (recurrent_edges[i]->input_node->layer_type == OUTPUT_LAYER) {
+            sparse_outputs_skippable = false;
+        }
+    }
+
+    sparse_initialized = true;
+}
+
+void RNN::sample_outputs(const vector<int32_t>& expected_tokens, int32_t number_samples, minstd_rand0& generator) {
+    int32_t number_outputs = (int32_t) output_nodes.size();
+    int32_t length = (int32_t) expected_tokens.size();
+
+    sampled_outputs.resize(length);
+    output_sampled.assign(number_outputs, false);
+    uniform_int_distribution<int32_t> output_distribution(0, number_outputs - 1);
+
+    for (int32_t j = 0; j < length; j++) {
+        int32_t expected = expected_tokens[j];
+        if (expected < 0 || expected >= number_outputs) {
+            Log::fatal(
+                "ERROR: expected token %d at time %d is not one of the %d outputs\n", expected, j, number_outputs
+            );
+            exit(1);
+        }
+
+        // the expected output is always first, followed by the (distinct) sampled outputs; as the samples are
+        // uniform the correction for their sampling probability is the same for every output and cancels out
+        vector<int32_t>& outputs = sampled_outputs[j];
+        outputs.assign(1, expected);
+        output_sampled[expected] = true;
+
+        for (int32_t k = 0; k < number_samples; k++) {
+            int32_t output = output_distribution(generator);
+            if (!output_sampled[output]) {
+                output_sampled[output] = true;
+                outputs.push_back(output);
+            }
+        }
+
+        for (int32_t k = 0; k < (int32_t) outputs.size(); k++) {
+            output_sampled[outputs[k]] = false;
+        }
+    }
+
+    sampling_outputs = true;
+}
+
+void RNN::sparse_forward_pass(const vector<int32_t>& input_tokens) {
+    sampling_outputs = false;
+    sparse_propagate_forward(input_tokens);
+}
+
+void RNN::sparse_forward_pass(
+    const vector<int32_t>& input_tokens, const vector<int32_t>& expected_tokens, int32_t number_samples,
+    minstd_rand0& generator
+) {
+    if (input_tokens.size() != expected_tokens.size()) {
+        Log::fatal(
+            "ERROR: %d input tokens but %d expected tokens\n", (int32_t) input_tokens.size(),
+            (int32_t) expected_tokens.size()
+        );
+        exit(1);
+    }
+
+    sample_outputs(expected_tokens, number_samples, generator);
+    sparse_propagate_forward(input_tokens);
+}
+
+void RNN::sparse_propagate_forward(const vector<int32_t>& input_tokens) {
+    if (!sparse_initialized) {
+        initialize_sparse_inputs();
+    }
+
+    series_length = (int32_t) input_tokens.size();
+    sparse_tokens = input_tokens;
+
+    vector<bool> active(input_nodes.size(), false);
+    for (int32_t time = 0; time < series_length; time++) {
+        if (input_tokens[time] < 0 || input_tokens[time] >= (int32_t) input_nodes.size()) {
+            Log::fatal(
+                "ERROR: input token %d at time %d is not one of the %d inputs\n", input_tokens[time], time,
+                input_nodes.size()
+            );
+            exit(1);
+        }
+        active[input_tokens[time]] = true;
+    }
+
+    vector<int32_t> recurrent_inputs;
+    for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
+        if (nodes[i]->layer_type != INPUT_LAYER) {
+            nodes[i]->reset(series_length);
+        }
+    }
+
+    // inputs which are never active and have no recurrent edges are never fired
+    for (int32_t i = 0; i < (int32_t) input_nodes.size(); i++) {
+        if (sparse_node_recurrent[i]) {
+            recurrent_inputs.push_back(i);
         }
 
-        // for each
+        if (active[i] || sparse_node_recurrent[i]) {
+            input_nodes[i]->reset(series_length);
+        } else {
+            input_nodes[i]->reset(0);
+        }
+    }
+
+    // the outputs and deltas of the input edges are not used, so only their gradients are reset
+    for (int32_t i = 0; i < (int32_t) sparse_hidden_edges.size(); i++) {
+        sparse_hidden_edges[i]->reset(series_length);
+    }
+
+    for (int32_t i = 0; i < (int32_t) sparse_input_edges.size(); i++) {
+        sparse_input_edges[i]->d_weight = 0.0;
+    }
+
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        recurrent_edges[i]->reset(series_length);
+    }
+
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        if (recurrent_edges[i]->is_reachable()) {
+            recurrent_edges[i]->first_propagate_forward();
+        }
+    }
+
+    // the output (and derivative) of each input node when its input is 0, which are the same at every time step
+    // so the sum of the input edges from all the inactive inputs into each node only needs to be calculated once
+    sparse_inactive_outputs.resize(input_nodes.size());
+    sparse_inactive_derivatives.resize(input_nodes.size());
+    sparse_target_bases.assign(sparse_targets.size(), 0.0);
+
+    for (int32_t i = 0; i < (int32_t) input_nodes.size(); i++) {
+        RNN_Node* input_node = (RNN_Node*) input_nodes[i];
+        double input_plus_bias = input_node->node_type == INPUT_NODE_GP ? 0.0 : input_node->bias;
 
+        sparse_inactive_outputs[i] = input_node->activation_function(input_plus_bias);
+        sparse_inactive_derivatives[i] = input_node->derivative_function(input_plus_bias);
+
+        const vector<int32_t>& input_edges = sparse_node_input_edges[i];
+        for (int32_t j = 0; j < (int32_t) input_edges.size(); j++) {
+            sparse_target_bases[sparse_input_edge_targets[input_edges[j]]] +=
+                sparse_input_edges[input_edges[j]]->weight * sparse_inactive_outputs[i];
+        }
+    }
+
+    for (int32_t time = 0; time < series_length; time++) {
+        int32_t token = input_tokens[time];
+        RNN_Node_Interface* token_node = input_nodes[token];
+
+        if (token_node->is_reachable()) {
+            token_node->input_fired(time, 1.0);
+        }
+
+        for (int32_t i = 0; i < (int32_t) recurrent_inputs.size(); i++) {
+            if (recurrent_inputs[i] != token && input_nodes[recurrent_inputs[i]]->is_reachable()) {
+                input_nodes[recurrent_inputs[i]]->input_fired(time, 0.0);
+            }
+        }
+
+        // replace the active input's inactive output with its actual output
+        sparse_target_values = sparse_target_bases;
+
+        const vector<int32_t>& input_edges = sparse_node_input_edges[token];
+        double output_change = token_node->output_values[time] - sparse_inactive_outputs[token];
+        for (int32_t j = 0; j < (int32_t) input_edges.size(); j++) {
+            sparse_target_values[sparse_input_edge_targets[input_edges[j]]] +=
+                sparse_input_edges[input_edges[j]]->weight * output_change;
+        }
+
+        for (int32_t i = 0; i < (int32_t) sparse_targets.size(); i++) {
+            sparse_targets[i]->inputs_fired[time] += sparse_target_inputs[i] - 1;
+            sparse_targets[i]->input_fired(time, sparse_target_values[i]);
+        }
+
+        if (sampling_outputs && sparse_outputs_skippable) {
+            // only the sampled outputs are used, so the others are never calculated; the edges into them are still
+            // counted as fired on their input nodes in sparse_backward_pass
+            for (int32_t i = 0; i < (int32_t) sparse_internal_edges.size(); i++) {
+                sparse_internal_edges[i]->propagate_forward(time);
+            }
+
+            const vector<int32_t>& outputs = sampled_outputs[time];
+            for (int32_t i = 0; i < (int32_t) outputs.size(); i++) {
+                const vector<RNN_Edge*>& output_edges = sparse_output_edges[outputs[i]];
+                for (int32_t j = 0; j < (int32_t) output_edges.size(); j++) {
+                    output_edges[j]->propagate_forward(time);
+                }
+            }
+        } else {
+            for (int32_t i = 0; i < (int32_t) sparse_hidden_edges.size(); i++) {
+                sparse_hidden_edges[i]->propagate_forward(time);
+            }
+        }
+
+        for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+            if (recurrent_edges[i]->is_reachable()) {
+                recurrent_edges[i]->propagate_forward(time);
+            }
+        }
+    }
+}
+
+void RNN::sparse_backward_pass(double error) {
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        if (recurrent_edges[i]->is_reachable()) {
+            recurrent_edges[i]->first_propagate_backward();
+        }
+    }
+
+    vector<int32_t> recurrent_inputs;
+    for (int32_t i = 0; i < (int32_t) input_nodes.size(); i++) {
+        if (sparse_node_recurrent[i]) {
+            recurrent_inputs.push_back(i);
+        }
+    }
+
+    sparse_target_delta_sums.assign(sparse_targets.size(), 0.0);
+    sparse_edge_active_delta_sums.assign(sparse_input_edges.size(), 0.0);
+    sparse_edge_active_gradients.assign(sparse_input_edges.size(), 0.0);
+
+    for (int32_t time = series_length - 1; time >= 0; time--) {
         for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
-            softmax = exp(output_nodes[i]->output_values[j]) / softmax_sum;
-            error = softmax - expected_outputs[i][j];
-            output_nodes[i]->error_values[j] = error;
+            output_nodes[i]->error_fired(time, error);
+        }
+
+        if (sampling_outputs) {
+            // the outputs which were not sampled have no error, so the edges into them only need to be counted as
+            // fired on their input nodes
+            sparse_output_source_remaining = sparse_output_source_edges;
 
-            // std::cout<<"softmax ::::: "<<error<<" "<<output_nodes[i]->output_values[j]<<"
-            // "<<expected_outputs[i][j]<<"\n"<<std::endl;
-            cross_entropy = -expected_outputs[i][j] * log(softmax);
-            // if(cross_entropy)std::cout<<"cross_entropy ::::: "<<cross_entropy<<"\n"<<std::endl;
+            const vector<int32_t>& outputs = sampled_outputs[time];
+            for (int32_t i = 0; i < (int32_t) outputs.size(); i++) {
+                const vector<RNN_Edge*>& output_edges = sparse_output_edges[outputs[i]];
+                const vector<int32_t>& output_edge_sources = sparse_output_edge_sources[outputs[i]];
+
+                for (int32_t j = 0; j < (int32_t) output_edges.size(); j++) {
+                    output_edges[j]->propagate_backward(time);
+                    sparse_output_source_remaining[output_edge_sources[j]]--;
+                }
+            }
+
+            for (int32_t i = 0; i < (int32_t) sparse_output_sources.size(); i++) {
+                if (sparse_output_source_remaining[i] > 0) {
+                    sparse_output_sources[i]->outputs_fired[time] += sparse_output_source_remaining[i] - 1;
+                    sparse_output_sources[i]->output_fired(time, 0.0);
+                }
+            }
+
+            for (int32_t i = (int32_t) sparse_internal_edges.size() - 1; i >= 0; i--) {
+                sparse_internal_edges[i]->propagate_backward(time);
+            }
+        } else {
+            for (int32_t i = (int32_t) sparse_hidden_edges.size() - 1; i >= 0; i--) {
+                sparse_hidden_edges[i]->propagate_backward(time);
+            }
+        }
 
-            cross_entropy_sum += cross_entropy;
+        for (int32_t i = 0; i < (int32_t) sparse_targets.size(); i++) {
+            sparse_target_delta_sums[i] += sparse_targets[i]->d_input[time];
+        }
+
+        // only the active input's edges are backpropagated through, the gradients from the inactive inputs are
+        // added at the end of the pass
+        int32_t token = sparse_tokens[time];
+        RNN_Node_Interface* token_node = input_nodes[token];
+        const vector<int32_t>& input_edges = sparse_node_input_edges[token];
+
+        if (input_edges.size() > 0) {
+            double output_change = token_node->output_values[time] - sparse_inactive_outputs[token];
+            double delta_sum = 0.0;
+
+            for (int32_t j = 0; j < (int32_t) input_edges.size(); j++) {
+                int32_t edge = input_edges[j];
+                double delta = sparse_targets[sparse_input_edge_targets[edge]]->d_input[time];
+
+                sparse_edge_active_delta_sums[edge] += delta;
+                sparse_edge_active_gradients[edge] += delta * output_change;
+                delta_sum += delta * sparse_input_edges[edge]->weight;
+            }
+
+            token_node->outputs_fired[time] += (int32_t) input_edges.size() - 1;
+            token_node->output_fired(time, delta_sum);
+        }
+
+        // the inactive inputs with recurrent edges still need their recurrent deltas
+        for (int32_t i = 0; i < (int32_t) recurrent_inputs.size(); i++) {
+            int32_t input = recurrent_inputs[i];
+            int32_t number_input_edges = (int32_t) sparse_node_input_edges[input].size();
+
+            if (input != token && number_input_edges > 0) {
+                input_nodes[input]->outputs_fired[time] += number_input_edges - 1;
+                input_nodes[input]->output_fired(time, 0.0);
+            }
+        }
+
+        for (int32_t i = (int32_t) recurrent_edges.size() - 1; i >= 0; i--) {
+            if (recurrent_edges[i]->is_reachable()) {
+                recurrent_edges[i]->propagate_backward(time);
+            }
+        }
+    }
+
+    // each input edge's output is the input node's inactive output at every time step except when the input is
+    // active, so its gradient is that output times the sum of the deltas, corrected for the active time steps
+    for (int32_t i = 0; i < (int32_t) input_nodes.size(); i++) {
+        const vector<int32_t>& input_edges = sparse_node_input_edges[i];
+        double inactive_delta = 0.0;
+
+        for (int32_t j = 0; j < (int32_t) input_edges.size(); j++) {
+            int32_t edge = input_edges[j];
+            double delta_sum = sparse_target_delta_sums[sparse_input_edge_targets[edge]];
+
+            sparse_input_edges[edge]->d_weight =
+                sparse_inactive_outputs[i] * delta_sum + sparse_edge_active_gradients[edge];
+            inactive_delta += sparse_input_edges[edge]->weight * (delta_sum - sparse_edge_active_delta_sums[edge]);
+        }
+
+        RNN_Node* input_node = (RNN_Node*) input_nodes[i];
+        if (input_node->node_type != INPUT_NODE_GP) {
+            input_node->d_bias += sparse_inactive_derivatives[i] * inactive_delta;
+        }
+    }
+}
+
+/**
+ * Returns the log of the sum of the exponentials of the values, shifted by the largest value so the
+ * exponentials cannot overflow. The loops use independent accumulators over contiguous values so
+ * they vectorize across the output nodes.
+ */
+static double log_sum_exp(const double* values, int32_t number_values) {
+    double max_0 = -numeric_limits<double>::max();
+    double max_1 = max_0, max_2 = max_0, max_3 = max_0;
+
+    int32_t i = 0;
+    for (; i + 4 <= number_values; i += 4) {
+        max_0 = values[i] > max_0 ? values[i] : max_0;
+        max_1 = values[i + 1] > max_1 ? values[i + 1] : max_1;
+        max_2 = values[i + 2] > max_2 ? values[i + 2] : max_2;
+        max_3 = values[i + 3] > max_3 ? values[i + 3] : max_3;
+    }
+    for (; i < number_values; i++) {
+        max_0 = values[i] > max_0 ? values[i] : max_0;
+    }
+    max_0 = max_1 > max_0 ? max_1 : max_0;
+    max_2 = max_3 > max_2 ? max_3 : max_2;
+    double max = max_2 > max_0 ? max_2 : max_0;
+
+    double sum_0 = 0.0, sum_1 = 0.0, sum_2 = 0.0, sum_3 = 0.0;
+    for (i = 0; i + 4 <= number_values; i += 4) {
+        sum_0 += exp(values[i] - max);
+        sum_1 += exp(values[i + 1] - max);
+        sum_2 += exp(values[i + 2] - max);
+        sum_3 += exp(values[i + 3] - max);
+    }
+    for (; i < number_values; i++) {
+        sum_0 += exp(values[i] - max);
+    }
+
+    return max + log((sum_0 + sum_1) + (sum_2 + sum_3));
+}
+
+double RNN::calculate_error_softmax(const SeriesView& expected_outputs) {
+    double cross_entropy_sum = 0.0;
+    int32_t number_outputs = (int32_t) output_nodes.size();
+
+    for (int32_t i = 0; i < number_outputs; i++) {
+        output_nodes[i]->error_values.resize(expected_outputs.get_length());
+    }
+
+    vector<double> logits(number_outputs);
+
+    // for each time step j
+    for (int32_t j = 0; j < expected_outputs.get_length(); j++) {
+        for (int32_t i = 0; i < number_outputs; i++) {
+            logits[i] = output_nodes[i]->output_values[j];
+        }
+        double log_softmax_sum = log_sum_exp(&logits[0], number_outputs);
+
+        for (int32_t i = 0; i < number_outputs; i++) {
+            double log_softmax = logits[i] - log_softmax_sum;
+            output_nodes[i]->error_values[j] = exp(log_softmax) - expected_outputs.get(i, j);
+            cross_entropy_sum -= expected_outputs.get(i, j) * log_softmax;
         }
     }
 
     return cross_entropy_sum;
 }
 
-double RNN::calculate_error_mse(const vector<vector<double> >& expected_outputs) {
+double RNN::calculate_error_softmax(const vector<int32_t>& expected_tokens) {
+    double cross_entropy_sum = 0.0;
+    int32_t number_outputs = (int32_t) output_nodes.size();
+    int32_t length = (int32_t) expected_tokens.size();
+
+    if (sampling_outputs) {
+        Log::fatal("ERROR: the exact softmax cannot be calculated after a sampled sparse forward pass\n");
+        exit(1);
+    }
+
+    for (int32_t i = 0; i < number_outputs; i++) {
+        output_nodes[i]->error_values.resize(length);
+    }
+
+    vector<double> logits(number_outputs);
+
+    for (int32_t j = 0; j < length; j++) {
+        int32_t expected = expected_tokens[j];
+        if (expected < 0 || expected >= number_outputs) {
+            Log::fatal(
+                "ERROR: expected token %d at time %d is not one of the %d outputs\n", expected, j, number_outputs
+            );
+            exit(1);
+        }
+
+        for (int32_t i = 0; i < number_outputs; i++) {
+            logits[i] = output_nodes[i]->output_values[j];
+        }
+        double log_softmax_sum = log_sum_exp(&logits[0], number_outputs);
+
+        for (int32_t i = 0; i < number_outputs; i++) {
+            output_nodes[i]->error_values[j] = exp(logits[i] - log_softmax_sum);
+        }
+        output_nodes[expected]->error_values[j] -= 1.0;
+        cross_entropy_sum += log_softmax_sum - logits[expected];
+    }
+
+    return cross_entropy_sum;
+}
+
+double RNN::calculate_error_sampled_softmax(const vector<int32_t>& expected_tokens) {
+    double cross_entropy_sum = 0.0;
+    int32_t number_outputs = (int32_t) output_nodes.size();
+    int32_t length = (int32_t) expected_tokens.size();
+
+    if (!sampling_outputs || length != (int32_t) sampled_outputs.size()) {
+        Log::fatal("ERROR: the sampled softmax needs the outputs sampled by a sampled sparse forward pass\n");
+        exit(1);
+    }
+
+    // the outputs which are not sampled have no error
+    for (int32_t i = 0; i < number_outputs; i++) {
+        output_nodes[i]->error_values.assign(length, 0.0);
+    }
+
+    vector<double> logits;
+
+    for (int32_t j = 0; j < length; j++) {
+        const vector<int32_t>& outputs = sampled_outputs[j];
+
+        logits.resize(outputs.size());
+        for (int32_t k = 0; k < (int32_t) outputs.size(); k++) {
+            logits[k] = output_nodes[outputs[k]]->output_values[j];
+        }
+        double log_softmax_sum = log_sum_exp(&logits[0], (int32_t) logits.size());
+
+        for (int32_t k = 0; k < (int32_t) outputs.size(); k++) {
+            output_nodes[outputs[k]]->error_values[j] = exp(logits[k] - log_softmax_sum);
+        }
+        output_nodes[outputs[0]]->error_values[j] -= 1.0;
+        cross_entropy_sum += log_softmax_sum - logits[0];
+    }
+
+    return cross_entropy_sum;
+}
+
+double RNN::calculate_error_mse(const SeriesView& expected_outputs) {
     double mse_sum = 0.0;
     double mse;
     double error;
 
     for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
-        output_nodes[i]->error_values.resize(expected_outputs[i].size());
+        output_nodes[i]->error_values.resize(expected_outputs.get_length());
 
         mse = 0.0;
-        for (int32_t j = 0; j < (int32_t) expected_outputs[i].size(); j++) {
-            error = output_nodes[i]->output_values[j] - expected_outputs[i][j];
+        for (int32_t j = 0; j < expected_outputs.get_length(); j++) {
+            error = output_nodes[i]->output_values[j] - expected_outputs.get(i, j);
 
             // std::cout<<"why this  ???? mse ::::: "<<error<<" "<<output_nodes[i]->output_values[j]<<"
-            // "<<expected_outputs[i][j]<<std::endl;
+            // "<<expected_outputs.get(i, j)<<std::endl;
 
             output_nodes[i]->error_values[j] = error;
             mse += error * error;
         }
-        mse_sum += mse / expected_outputs[i].size();
+        mse_sum += mse / expected_outputs.get_length();
     }
 
     return mse_sum;
 }
 
-double RNN::calculate_error_mae(const vector<vector<double> >& expected_outputs) {
+double RNN::calculate_error_mae(const SeriesView& expected_outputs) {
     double mae_sum = 0.0;
     double mae;
     double error;
 
     for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
-        output_nodes[i]->error_values.resize(expected_outputs[i].size());
+        output_nodes[i]->error_values.resize(expected_outputs.get_length());
 
         mae = 0.0;
-        for (int32_t j = 0; j < (int32_t) expected_outputs[i].size(); j++) {
-            error = fabs(output_nodes[i]->output_values[j] - expected_outputs[i][j]);
+        for (int32_t j = 0; j < expected_outputs.get_length(); j++) {
+            error = fabs(output_nodes[i]->output_values[j] - expected_outputs.get(i, j));
 
             mae += error;
 
             if (error == 0) {
                 error = 0;
             } else {
-                error = (output_nodes[i]->output_values[j] - expected_outputs[i][j]) / error;
+                error = (output_nodes[i]->output_values[j] - expected_outputs.get(i, j)) / error;
             }
             output_nodes[i]->error_values[j] = error;
         }
-        mae_sum += mae / expected_outputs[i].size();
+        mae_sum += mae / expected_outputs.get_length();
     }
 
     return mae_sum;
 }
 
 double RNN::prediction_softmax(
-    const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
-    bool training, double dropout_probability
+    const SeriesView& series_data, const SeriesView& expected_outputs, bool using_dropout, bool training,
+    double dropout_probability
 ) {
     forward_pass(series_data, using_dropout, training, dropout_probability);
     return calculate_error_softmax(expected_outputs);
 }
 
 double RNN::prediction_mse(
-    const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
-    bool training, double dropout_probability
+    const SeriesView& series_data, const SeriesView& expected_outputs, bool using_dropout, bool training,
+    double dropout_probability
 ) {
     forward_pass(series_data, using_dropout, training, dropout_probability);
     return calculate_error_mse(expected_outputs);
 }
 
 double RNN::prediction_mae(
-    const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
-    bool training, double dropout_probability
+    const SeriesView& series_data, const SeriesView& expected_outputs, bool using_dropout, bool training,
+    double dropout_probability
 ) {
     forward_pass(series_data, using_dropout, training, dropout_probability);
     return calculate_error_mae(expected_outputs);
 }
 
-vector<double> RNN::get_predictions(
+double RNN::prediction_softmax(const vector<int32_t>& input_tokens, const SeriesView& expected_outputs) {
+    sparse_forward_pass(input_tokens);
+    return calculate_error_softmax(expected_outputs);
+}
+
+double RNN::prediction_softmax(const vector<int32_t>& input_tokens, const vector<int32_t>& expected_tokens) {
+    sparse_forward_pass(input_tokens);
+    return calculate_error_softmax(expected_tokens);
+}
+
+double RNN::prediction_mse(const vector<int32_t>& input_tokens, const SeriesView& expected_outputs) {
+    sparse_forward_pass(input_tokens);
+    return calculate_error_mse(expected_outputs);
+}
+
+double RNN::prediction_mse(
     const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
-    double dropout_probability
+    bool training, double dropout_probability
+) {
+    TimeSeriesTensor input_tensor(vector<vector<vector<double> > >(1, series_data));
+    TimeSeriesTensor output_tensor(vector<vector<vector<double> > >(1, expected_outputs));
+    return prediction_mse(input_tensor[0], output_tensor[0], using_dropout, training, dropout_probability);
+}
+
+double RNN::prediction_mae(
+    const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
+    bool training, double dropout_probability
+) {
+    TimeSeriesTensor input_tensor(vector<vector<vector<double> > >(1, series_data));
+    TimeSeriesTensor output_tensor(vector<vector<vector<double> > >(1, expected_outputs));
+    return prediction_mae(input_tensor[0], output_tensor[0], using_dropout, training, dropout_probability);
+}
+
+vector<double> RNN::get_predictions(
+    const SeriesView& series_data, const SeriesView& expected_outputs, bool using_dropout, double dropout_probability
 ) {
     forward_pass(series_data, using_dropout, false, dropout_probability);
 
@@ -591,8 +1167,8 @@ vector<double> RNN::get_predictions(
 
 void RNN::write_predictions(
     string output_filename, const vector<string>& input_parameter_names, const vector<string>& output_parameter_names,
-    const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs,
-    TimeSeriesSets* time_series_sets, bool using_dropout, double dropout_probability
+    const SeriesView& series_data, const SeriesView& expected_outputs, TimeSeriesSets* time_series_sets,
+    bool using_dropout, double dropout_probability
 ) {
     forward_pass(series_data, using_dropout, false, dropout_probability);
 
@@ -629,14 +1205,14 @@ void RNN::write_predictions(
             if (i > 0) {
                 outfile << ",";
             }
-            // outfile << series_data[i][j];
-            outfile << time_series_sets->denormalize(input_parameter_names[i], series_data[i][j]);
+            // outfile << series_data.get(i, j);
+            outfile << time_series_sets->denormalize(input_parameter_names[i], series_data.get(i, j));
         }
 
         for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
             outfile << ",";
-            // outfile << expected_outputs[i][j];
-            outfile << time_series_sets->denormalize(output_parameter_names[i], expected_outputs[i][j]);
+            // outfile << expected_outputs.get(i, j);
+            outfile << time_series_sets->denormalize(output_parameter_names[i], expected_outputs.get(i, j));
         }
 
         for (int32_t i = 0; i < (int32_t) output_nodes.size(); i++) {
@@ -650,9 +1226,8 @@ void RNN::write_predictions(
 }
 
 void RNN::get_analytic_gradient(
-    const vector<double>& test_parameters, const vector<vector<double> >& inputs,
-    const vector<vector<double> >& outputs, double& mse, vector<double>& analytic_gradient, bool using_dropout,
-    bool training, double dropout_probability
+    const vector<double>& test_parameters, const SeriesView& inputs, const SeriesView& outputs, double& mse,
+    vector<double>& analytic_gradient, bool using_dropout, bool training, double dropout_probability
 ) {
     analytic_gradient.assign(test_parameters.size(), 0.0);
 
@@ -660,8 +1235,47 @@ void RNN::get_analytic_gradient(
     forward_pass(inputs, using_dropout, training, dropout_probability);
 
     mse = calculate_error_mse(outputs);
-    backward_pass(mse * (1.0 / outputs[0].size()) * 2.0, using_dropout, training, dropout_probability);
+    backward_pass(mse * (1.0 / outputs.get_length()) * 2.0, using_dropout, training, dropout_probability);
+
+    get_gradients(analytic_gradient);
+}
+
+void RNN::get_analytic_gradient(
+    const vector<double>& test_parameters, const vector<int32_t>& input_tokens, const SeriesView& outputs, double& mse,
+    vector<double>& analytic_gradient
+) {
+    analytic_gradient.assign(test_parameters.size(), 0.0);
+
+    set_weights(test_parameters);
+    sparse_forward_pass(input_tokens);
+
+    mse = calculate_error_mse(outputs);
+    sparse_backward_pass(mse * (1.0 / outputs.get_length()) * 2.0);
+
+    get_gradients(analytic_gradient);
+}
+
+void RNN::get_analytic_gradient(
+    const vector<double>& test_parameters, const vector<int32_t>& input_tokens, const vector<int32_t>& output_tokens,
+    int32_t number_samples, minstd_rand0& generator, double& cross_entropy, vector<double>& analytic_gradient
+) {
+    analytic_gradient.assign(test_parameters.size(), 0.0);
+
+    set_weights(test_parameters);
 
+    if (number_samples > 0) {
+        sparse_forward_pass(input_tokens, output_tokens, number_samples, generator);
+        cross_entropy = calculate_error_sampled_softmax(output_tokens);
+    } else {
+        sparse_forward_pass(input_tokens);
+        cross_entropy = calculate_error_softmax(output_tokens);
+    }
+    sparse_backward_pass(1.0);
+
+    get_gradients(analytic_gradient);
+}
+
+void RNN::get_gradients(vector<double>& analytic_gradient) {
     vector<double> current_gradients;
 
     int32_t current = 0;
@@ -692,14 +1306,11 @@ void RNN::get_analytic_gradient(
 }
 
 void RNN::get_empirical_gradient(
-    const vector<double>& test_parameters, const vector<vector<double> >& inputs,
-    const vector<vector<double> >& outputs, double& mse, vector<double>& empirical_gradient, bool using_dropout,
-    bool training, double dropout_probability
+    const vector<double>& test_parameters, const SeriesView& inputs, const SeriesView& outputs, double& mse,
+    vector<double>& empirical_gradient, bool using_dropout, bool training, double dropout_probability
 ) {
     empirical_gradient.assign(test_parameters.size(), 0.0);
 
-    vector<vector<double> > deltas;
-
     set_weights(test_parameters);
     forward_pass(inputs, using_dropout, training, dropout_probability);
     double original_mse = calculate_error_mse(outputs);
@@ -715,12 +1326,12 @@ void RNN::get_empirical_gradient(
         parameters[i] = save - diff;
         set_weights(parameters);
         forward_pass(inputs, using_dropout, training, dropout_probability);
-        get_mse(this, outputs, mse1, deltas);
+        mse1 = calculate_error_mse(outputs);
 
         parameters[i] = save + diff;
         set_weights(parameters);
         forward_pass(inputs, using_dropout, training, dropout_probability);
-        get_mse(this, outputs, mse2, deltas);
+        mse2 = calculate_error_mse(outputs);
 
         empirical_gradient[i] = (mse2 - mse1) / (2.0 * diff);
         empirical_gradient[i] *= original_mse;
@@ -731,6 +1342,32 @@ void RNN::get_empirical_gradient(
     mse = original_mse;
 }
 
+void RNN::get_analytic_gradient(
+    const vector<double>& test_parameters, const vector<vector<double> >& inputs,
+    const vector<vector<double> >& outputs, double& mse, vector<double>& analytic_gradient, bool using_dropout,
+    bool training, double dropout_probability
+) {
+    TimeSeriesTensor input_tensor(vector<vector<vector<double> > >(1, inputs));
+    TimeSeriesTensor output_tensor(vector<vector<vector<double> > >(1, outputs));
+    get_analytic_gradient(
+        test_parameters, input_tensor[0], output_tensor[0], mse, analytic_gradient, using_dropout, training,
+        dropout_probability
+    );
+}
+
+void RNN::get_empirical_gradient(
+    const vector<double>& test_parameters, const vector<vector<double> >& inputs,
+    const vector<vector<double> >& outputs, double& mse, vector<double>& empirical_gradient, bool using_dropout,
+    bool training, double dropout_probability
+) {
+    TimeSeriesTensor input_tensor(vector<vector<vector<double> > >(1, inputs));
+    TimeSeriesTensor output_tensor(vector<vector<vector<double> > >(1, outputs));
+    get_empirical_gradient(
+        test_parameters, input_tensor[0], output_tensor[0], mse, empirical_gradient, using_dropout, training,
+        dropout_probability
+    );
+}
+
 void RNN::initialize_randomly() {
     int32_t number_of_weights = get_number_weights();
     vector<double> parameters(number_of_weights, 0.0);
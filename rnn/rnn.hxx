@@ -1,6 +1,9 @@
 #ifndef EXAMM_RNN_GENOME_HXX
 #define EXAMM_RNN_GENOME_HXX
 
+#include <random>
+using std::minstd_rand0;
+
 #include <string>
 using std::string;
 
@@ -11,6 +14,7 @@ using std::vector;
 #include "rnn_node_interface.hxx"
 #include "rnn_recurrent_edge.hxx"
 #include "time_series/time_series.hxx"
+#include "time_series/time_series_tensor.hxx"
 // #include "word_series/word_series.hxx"
 
 class RNN {
@@ -24,6 +28,45 @@ class RNN {
     vector<RNN_Edge*> edges;
     vector<RNN_Recurrent_Edge*> recurrent_edges;
 
+    // the sparse input path (see sparse_forward_pass), which is set up on its first use
+    bool sparse_initialized;
+    vector<int32_t> sparse_tokens;
+    vector<RNN_Edge*> sparse_hidden_edges;
+    vector<RNN_Edge*> sparse_input_edges;
+    vector<int32_t> sparse_input_edge_targets;
+    vector<vector<int32_t> > sparse_node_input_edges;
+    vector<bool> sparse_node_recurrent;
+    vector<RNN_Node_Interface*> sparse_targets;
+    vector<int32_t> sparse_target_inputs;
+
+    vector<double> sparse_inactive_outputs;
+    vector<double> sparse_inactive_derivatives;
+    vector<double> sparse_target_bases;
+    vector<double> sparse_target_values;
+    vector<double> sparse_target_delta_sums;
+    vector<double> sparse_edge_active_delta_sums;
+    vector<double> sparse_edge_active_gradients;
+
+    // the edges into each output node from hidden nodes, for only backpropagating through the sampled outputs
+    vector<RNN_Edge*> sparse_internal_edges;
+    vector<vector<RNN_Edge*> > sparse_output_edges;
+    vector<vector<int32_t> > sparse_output_edge_sources;
+    vector<RNN_Node_Interface*> sparse_output_sources;
+    vector<int32_t> sparse_output_source_edges;
+    vector<int32_t> sparse_output_source_remaining;
+
+    // the outputs sampled at each time step for the sampled softmax (see sample_outputs), only the edges into
+    // them are propagated unless the output nodes have recurrent edges out of them
+    bool sampling_outputs;
+    bool sparse_outputs_skippable;
+    vector<vector<int32_t> > sampled_outputs;
+    vector<bool> output_sampled;
+
+    void initialize_sparse_inputs();
+    void sample_outputs(const vector<int32_t>& expected_tokens, int32_t number_samples, minstd_rand0& generator);
+    void sparse_propagate_forward(const vector<int32_t>& input_tokens);
+    void get_gradients(vector<double>& analytic_gradient);
+
    public:
     RNN(vector<RNN_Node_Interface*>& _nodes, vector<RNN_Edge*>& _edges, const vector<string>& input_parameter_names,
         const vector<string>& output_parameter_names);
@@ -42,19 +85,58 @@ class RNN {
     RNN_Node_Interface* get_node(int32_t i);
     RNN_Edge* get_edge(int32_t i);
 
-    void forward_pass(
-        const vector<vector<double> >& series_data, bool using_dropout, bool training, double dropout_probability
-    );
+    void forward_pass(const SeriesView& series_data, bool using_dropout, bool training, double dropout_probability);
     void backward_pass(double error, bool using_dropout, bool training, double dropout_probability);
 
-    double calculate_error_softmax(const vector<vector<double> >& expected_outputs);
-    double calculate_error_mse(const vector<vector<double> >& expected_outputs);
-    double calculate_error_mae(const vector<vector<double> >& expected_outputs);
+    /**
+     * Forward and backward passes for one-hot encoded inputs (e.g., the words of a word series), given as the
+     * index of the input which is 1 at each time step. Only the input edges out of that input are used each time
+     * step; the contribution of all the other inputs (which are 0) is calculated once per pass, so these give the
+     * same outputs and gradients as the passes over the one-hot series. Edge dropout is not supported.
+     */
+    void sparse_forward_pass(const vector<int32_t>& input_tokens);
+    void sparse_backward_pass(double error);
+
+    /**
+     * The sparse forward pass for the sampled softmax, which first samples the outputs used at each time step (the
+     * expected output and number_samples outputs sampled uniformly), and then only propagates the edges into those
+     * outputs.
+     */
+    void sparse_forward_pass(
+        const vector<int32_t>& input_tokens, const vector<int32_t>& expected_tokens, int32_t number_samples,
+        minstd_rand0& generator
+    );
+
+    double calculate_error_softmax(const SeriesView& expected_outputs);
+
+    /**
+     * The softmax cross entropy (summed over the time steps) for outputs which are the index of the expected output
+     * at each time step. The sampled softmax only uses the outputs sampled by the sampled sparse_forward_pass, and
+     * sparse_backward_pass then only backpropagates through the edges into those outputs, so it should be used for
+     * training and the exact softmax for validation.
+     */
+    double calculate_error_softmax(const vector<int32_t>& expected_tokens);
+    double calculate_error_sampled_softmax(const vector<int32_t>& expected_tokens);
+
+    double calculate_error_mse(const SeriesView& expected_outputs);
+    double calculate_error_mae(const SeriesView& expected_outputs);
 
     double prediction_softmax(
-        const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
-        bool training, double dropout_probability
+        const SeriesView& series_data, const SeriesView& expected_outputs, bool using_dropout, bool training,
+        double dropout_probability
+    );
+    double prediction_mse(
+        const SeriesView& series_data, const SeriesView& expected_outputs, bool using_dropout, bool training,
+        double dropout_probability
+    );
+    double prediction_mae(
+        const SeriesView& series_data, const SeriesView& expected_outputs, bool using_dropout, bool training,
+        double dropout_probability
     );
+    double prediction_softmax(const vector<int32_t>& input_tokens, const SeriesView& expected_outputs);
+    double prediction_softmax(const vector<int32_t>& input_tokens, const vector<int32_t>& expected_tokens);
+    double prediction_mse(const vector<int32_t>& input_tokens, const SeriesView& expected_outputs);
+
     double prediction_mse(
         const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool using_dropout,
         bool training, double dropout_probability
@@ -65,15 +147,13 @@ class RNN {
     );
 
     vector<double> get_predictions(
-        const vector<vector<double> >& series_data, const vector<vector<double> >& expected_outputs, bool usng_dropout,
-        double dropout_probability
+        const SeriesView& series_data, const SeriesView& expected_outputs, bool usng_dropout, double dropout_probability
     );
 
     void write_predictions(
         string output_filename, const vector<string>& input_parameter_names,
-        const vector<string>& output_parameter_names, const vector<vector<double> >& series_data,
-        const vector<vector<double> >& expected_outputs, TimeSeriesSets* time_series_sets, bool using_dropout,
-        double dropout_probability
+        const vector<string>& output_parameter_names, const SeriesView& series_data, const SeriesView& expected_outputs,
+        TimeSeriesSets* time_series_sets, bool using_dropout, double dropout_probability
     );
 
     void initialize_randomly();
@@ -82,6 +162,28 @@ class RNN {
 
     int32_t get_number_weights();
 
+    void get_analytic_gradient(
+        const vector<double>& test_parameters, const SeriesView& inputs, const SeriesView& outputs, double& mse,
+        vector<double>& analytic_gradient, bool using_dropout, bool training, double dropout_probability
+    );
+    void get_empirical_gradient(
+        const vector<double>& test_parameters, const SeriesView& inputs, const SeriesView& outputs, double& mae,
+        vector<double>& empirical_gradient, bool using_dropout, bool training, double dropout_probability
+    );
+
+    void get_analytic_gradient(
+        const vector<double>& test_parameters, const vector<int32_t>& input_tokens, const SeriesView& outputs,
+        double& mse, vector<double>& analytic_gradient
+    );
+
+    // the gradient of the softmax cross entropy, sampled if number_samples > 0
+    void get_analytic_gradient(
+        const vector<double>& test_parameters, const vector<int32_t>& input_tokens,
+        const vector<int32_t>& output_tokens, int32_t number_samples, minstd_rand0& generator, double& cross_entropy,
+        vector<double>& analytic_gradient
+    );
+
+    // the same as above for a single series which is not in a tensor, these copy the series into one
     void get_analytic_gradient(
         const vector<double>& test_parameters, const vector<vector<double> >& inputs,
         const vector<vector<double> >& outputs, double& mse, vector<double>& analytic_gradient, bool using_dropout,
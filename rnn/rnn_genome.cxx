@@ -66,6 +66,7 @@ using std::map;
 #include "rnn_genome.hxx"
 #include "rnn_node.hxx"
 #include "time_series/time_series.hxx"
+#include "time_series/time_series_stream.hxx"
 #include "ugrnn_node.hxx"
 
 vector<int32_t> dnas_node_types = {SIMPLE_NODE, UGRNN_NODE, MGU_NODE, GRU_NODE, DELTA_NODE, LSTM_NODE};
@@ -496,6 +497,14 @@ void RNN_Genome::enable_dropout(double _dropout_probability) {
     dropout_probability = _dropout_probability;
 }
 
+bool RNN_Genome::get_use_dropout() const {
+    return use_dropout;
+}
+
+double RNN_Genome::get_dropout_probability() const {
+    return dropout_probability;
+}
+
 void RNN_Genome::set_log_filename(string _log_filename) {
     log_filename = _log_filename;
 }
@@ -929,9 +938,8 @@ bool RNN_Genome::sanity_check() {
 }
 
 void forward_pass_thread_regression(
-    RNN* rnn, const vector<double>& parameters, const vector<vector<double> >& inputs,
-    const vector<vector<double> >& outputs, int32_t i, double* mses, bool use_dropout, bool training,
-    double dropout_probability
+    RNN* rnn, const vector<double>& parameters, const SeriesView& inputs, const SeriesView& outputs, int32_t i,
+    double* mses, bool use_dropout, bool training, double dropout_probability
 ) {
     rnn->set_weights(parameters);
     rnn->forward_pass(inputs, use_dropout, training, dropout_probability);
@@ -942,9 +950,8 @@ void forward_pass_thread_regression(
 }
 
 void forward_pass_thread_classification(
-    RNN* rnn, const vector<double>& parameters, const vector<vector<double> >& inputs,
-    const vector<vector<double> >& outputs, int32_t i, double* mses, bool use_dropout, bool training,
-    double dropout_probability
+    RNN* rnn, const vector<double>& parameters, const SeriesView& inputs, const SeriesView& outputs, int32_t i,
+    double* mses, bool use_dropout, bool training, double dropout_probability
 ) {
     rnn->set_weights(parameters);
     rnn->forward_pass(inputs, use_dropout, training, dropout_probability);
@@ -955,8 +962,8 @@ void forward_pass_thread_classification(
 }
 
 void RNN_Genome::get_analytic_gradient(
-    vector<RNN*>& rnns, const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
-    const vector<vector<vector<double> > >& outputs, double& mse, vector<double>& analytic_gradient, bool training
+    vector<RNN*>& rnns, const vector<double>& parameters, const TimeSeriesTensor& inputs,
+    const TimeSeriesTensor& outputs, double& mse, vector<double>& analytic_gradient, bool training
 ) {
     double* mses = new double[rnns.size()];
     double mse_sum = 0.0;
@@ -976,7 +983,7 @@ void RNN_Genome::get_analytic_gradient(
 
     for (int32_t i = 0; i < (int32_t) rnns.size(); i++) {
         double d_mse = 0.0;
-        d_mse = mse_sum * (1.0 / outputs[i][0].size()) * 2.0;
+        d_mse = mse_sum * (1.0 / outputs[i].get_length()) * 2.0;
         rnns[i]->backward_pass(d_mse, use_dropout, training, dropout_probability);
     }
 
@@ -1003,9 +1010,8 @@ void RNN_Genome::get_analytic_gradient(
 }
 
 void RNN_Genome::backpropagate(
-    const vector<vector<vector<double> > >& inputs, const vector<vector<vector<double> > >& outputs,
-    const vector<vector<vector<double> > >& validation_inputs,
-    const vector<vector<vector<double> > >& validation_outputs, WeightUpdate* weight_update_method
+    const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs, const TimeSeriesTensor& validation_inputs,
+    const TimeSeriesTensor& validation_outputs, WeightUpdate* weight_update_method
 ) {
     // double learning_rate = weight_update_method->get_learning_rate() / inputs.size();
     // double low_threshold = sqrt(weight_update_method->get_low_threshold() * inputs.size());
@@ -1070,9 +1076,17 @@ void RNN_Genome::backpropagate(
 }
 
 void RNN_Genome::backpropagate_stochastic(
-    const vector<vector<vector<double> > >& inputs, const vector<vector<vector<double> > >& outputs,
-    const vector<vector<vector<double> > >& validation_inputs,
-    const vector<vector<vector<double> > >& validation_outputs, WeightUpdate* weight_update_method
+    const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs, const TimeSeriesTensor& validation_inputs,
+    const TimeSeriesTensor& validation_outputs, WeightUpdate* weight_update_method
+) {
+    backpropagate_stochastic(
+        inputs, outputs, validation_inputs, validation_outputs, weight_update_method, (WindowSampler*) NULL
+    );
+}
+
+void RNN_Genome::backpropagate_stochastic(
+    const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs, const TimeSeriesTensor& validation_inputs,
+    const TimeSeriesTensor& validation_outputs, WeightUpdate* weight_update_method, WindowSampler* window_sampler
 ) {
     int32_t n_parameters = this->get_number_weights();
     int32_t n_series = (int32_t) inputs.size();
@@ -1081,10 +1095,8 @@ void RNN_Genome::backpropagate_stochastic(
     vector<double> velocity(n_parameters, 0.0);
     vector<double> prev_velocity(n_parameters, 0.0);
     vector<double> analytic_gradient;
-    vector<double> prev_gradient(n_parameters, 0.0);
 
     double mse;
-    double norm = 0.0;
     RNN* rnn = get_rnn();
     rnn->set_weights(parameters);
 
@@ -1101,7 +1113,6 @@ void RNN_Genome::backpropagate_stochastic(
             parameters, inputs[i], outputs[i], mse, analytic_gradient, use_dropout, true, dropout_probability
         );
         Log::trace("got analytic gradient.\n");
-        norm = weight_update_method->get_norm(analytic_gradient);
     }
     Log::trace("initialized previous values.\n");
 
@@ -1121,40 +1132,162 @@ void RNN_Genome::backpropagate_stochastic(
     ofstream* output_log = create_log_file();
 
     for (int32_t iteration = 0; iteration < bp_iterations; iteration++) {
-        vector<int32_t> shuffle_order;
-        for (int32_t i = 0; i < n_series; i++) {
-            shuffle_order.push_back(i);
+        double avg_norm = 0.0;
+        double total_mse = 0.0;
+        int32_t number_windows = 0;
+        if (!train_on_windows(
+                rnn, inputs, outputs, window_sampler, weight_update_method, iteration, parameters, velocity,
+                prev_velocity, analytic_gradient, avg_norm, total_mse, number_windows
+            )) {
+            // This genome is getting NANs for gradients so it is a
+            // genetic dead end, delete it.
+            // TODO: figure out why and maybe use clipping or another
+            // method to handle it.
+            delete rnn;
+            best_parameters = parameters;
+            this->best_validation_mse = NAN;
+            this->best_validation_mae = NAN;
+            return;
         }
-        fisher_yates_shuffle(generator, shuffle_order);
+        this->set_weights(parameters);
+        double training_mse = get_mse(parameters, inputs, outputs);
+        validation_mse = get_mse(parameters, validation_inputs, validation_outputs);
+
+        if (validation_mse < best_validation_mse) {
+            best_validation_mse = validation_mse;
+            best_validation_mae = get_mae(parameters, validation_inputs, validation_outputs);
+            best_parameters = parameters;
+        }
+        if (output_log != NULL) {
+            std::chrono::time_point<std::chrono::system_clock> currentClock = std::chrono::system_clock::now();
+            long milliseconds =
+                std::chrono::duration_cast<std::chrono::milliseconds>(currentClock - startClock).count();
+            update_log_file(output_log, iteration, milliseconds, training_mse, validation_mse, avg_norm);
+        }
+        Log::info(
+            "iteration %4d, mse: %5.10lf, v_mse: %5.10lf, bv_mse: %5.10lf, avg_norm: %5.10lf\n", iteration,
+            training_mse, validation_mse, best_validation_mse, avg_norm
+        );
+    }
+    delete rnn;
+    this->set_weights(best_parameters);
+    Log::info("backpropagation completed, getting mu/sigma\n");
+    double _mu, _sigma;
+    get_mu_sigma(best_parameters, _mu, _sigma);
+}
+
+/**
+ * Does an epoch of stochastic gradient descent over the windows of the inputs and outputs given
+ * by the window sampler (or every sequence as a whole without one), in a random order. Adds each
+ * window's norm and mse to total_norm and total_mse. Returns false if the gradients became NaN or
+ * infinite.
+ */
+bool RNN_Genome::train_on_windows(
+    RNN* rnn, const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs, WindowSampler* window_sampler,
+    WeightUpdate* weight_update_method, int32_t iteration, vector<double>& parameters, vector<double>& velocity,
+    vector<double>& prev_velocity, vector<double>& analytic_gradient, double& total_norm, double& total_mse,
+    int32_t& number_windows
+) {
+    vector<SeriesWindow> windows;
+    if (window_sampler != NULL && window_sampler->is_enabled()) {
+        window_sampler->get_epoch_windows(inputs, generator, windows);
+    } else {
+        for (int32_t i = 0; i < inputs.size(); i++) {
+            windows.push_back({i, 0, inputs[i].get_length()});
+        }
+    }
+
+    vector<int32_t> shuffle_order;
+    for (int32_t i = 0; i < (int32_t) windows.size(); i++) {
+        shuffle_order.push_back(i);
+    }
+    fisher_yates_shuffle(generator, shuffle_order);
+
+    for (int32_t k = 0; k < (int32_t) shuffle_order.size(); k++) {
+        const SeriesWindow& window = windows[shuffle_order[k]];
+        double mse;
+        rnn->get_analytic_gradient(
+            parameters, inputs[window.sequence].window(window.start, window.length),
+            outputs[window.sequence].window(window.start, window.length), mse, analytic_gradient, use_dropout, true,
+            dropout_probability
+        );
+
+        double norm = weight_update_method->get_norm(analytic_gradient);
+        if (isnan(norm) || isinf(norm)) {
+            return false;
+        }
+
+        total_norm += norm;
+        total_mse += mse;
+        number_windows++;
+        weight_update_method->norm_gradients(analytic_gradient, norm);
+        weight_update_method->update_weights(parameters, velocity, prev_velocity, analytic_gradient, iteration);
+    }
+    return true;
+}
+
+/**
+ * The same as above, but reading the training data from a stream each epoch. As the training
+ * data is not kept in memory, the training mse logged for each epoch is the average mse of the
+ * windows trained on during it.
+ */
+void RNN_Genome::backpropagate_stochastic(
+    const TimeSeriesStream* stream, const TimeSeriesTensor& validation_inputs,
+    const TimeSeriesTensor& validation_outputs, WeightUpdate* weight_update_method, WindowSampler* window_sampler
+) {
+    int32_t n_parameters = this->get_number_weights();
+
+    vector<double> parameters = initial_parameters;
+    vector<double> velocity(n_parameters, 0.0);
+    vector<double> prev_velocity(n_parameters, 0.0);
+    vector<double> analytic_gradient;
+
+    RNN* rnn = get_rnn();
+    rnn->set_weights(parameters);
+
+    std::chrono::time_point<std::chrono::system_clock> startClock = std::chrono::system_clock::now();
+
+    double validation_mse = get_mse(parameters, validation_inputs, validation_outputs);
+    best_validation_mse = validation_mse;
+    best_validation_mae = get_mae(parameters, validation_inputs, validation_outputs);
+    best_parameters = parameters;
+
+    Log::info("initial validation_mse: %lf, best validation mse: %lf\n", validation_mse, best_validation_mse);
+
+    ofstream* output_log = create_log_file();
+
+    for (int32_t iteration = 0; iteration < bp_iterations; iteration++) {
+        vector<int32_t> file_order;
+        for (int32_t i = 0; i < stream->get_number_files(); i++) {
+            file_order.push_back(i);
+        }
+        fisher_yates_shuffle(generator, file_order);
+
         double avg_norm = 0.0;
-        for (int32_t k = 0; k < (int32_t) shuffle_order.size(); k++) {
-            int32_t random_selection = shuffle_order[k];
-            prev_gradient = analytic_gradient;
-            rnn->get_analytic_gradient(
-                parameters, inputs[random_selection], outputs[random_selection], mse, analytic_gradient, use_dropout,
-                true, dropout_probability
+        double total_mse = 0.0;
+        int32_t number_windows = 0;
+
+        TimeSeriesStreamReader reader(stream, file_order);
+        TimeSeriesChunk* chunk;
+        while ((chunk = reader.next_chunk()) != NULL) {
+            bool trained = train_on_windows(
+                rnn, chunk->inputs, chunk->outputs, window_sampler, weight_update_method, iteration, parameters,
+                velocity, prev_velocity, analytic_gradient, avg_norm, total_mse, number_windows
             );
+            delete chunk;
 
-            norm = weight_update_method->get_norm(analytic_gradient);
-
-            if (isnan(norm) || isinf(norm)) {
-                // This genome is getting NANs for gradients so it is a
-                // genetic dead end, delete it.
-                // TODO: figure out why and maybe use clipping or another
-                // method to handle it.
+            if (!trained) {
+                // a genetic dead end, the same as above
                 delete rnn;
                 best_parameters = parameters;
                 this->best_validation_mse = NAN;
                 this->best_validation_mae = NAN;
                 return;
             }
-
-            avg_norm += norm;
-            weight_update_method->norm_gradients(analytic_gradient, norm);
-            weight_update_method->update_weights(parameters, velocity, prev_velocity, analytic_gradient, iteration);
         }
+
         this->set_weights(parameters);
-        double training_mse = get_mse(parameters, inputs, outputs);
+        double training_mse = number_windows > 0 ? total_mse / number_windows : 0.0;
         validation_mse = get_mse(parameters, validation_inputs, validation_outputs);
 
         if (validation_mse < best_validation_mse) {
@@ -1180,6 +1313,99 @@ void RNN_Genome::backpropagate_stochastic(
     get_mu_sigma(best_parameters, _mu, _sigma);
 }
 
+void RNN_Genome::backpropagate_stochastic(
+    const vector<vector<int32_t> >& input_tokens, const vector<vector<int32_t> >& output_tokens,
+    const vector<vector<int32_t> >& validation_input_tokens, const vector<vector<int32_t> >& validation_output_tokens,
+    WeightUpdate* weight_update_method, int32_t number_samples
+) {
+    int32_t n_parameters = this->get_number_weights();
+
+    vector<double> parameters = initial_parameters;
+    vector<double> velocity(n_parameters, 0.0);
+    vector<double> prev_velocity(n_parameters, 0.0);
+    vector<double> analytic_gradient;
+
+    RNN* rnn = get_rnn();
+    rnn->set_weights(parameters);
+
+    std::chrono::time_point<std::chrono::system_clock> startClock = std::chrono::system_clock::now();
+
+    double validation_cross_entropy = get_softmax(parameters, validation_input_tokens, validation_output_tokens);
+    best_validation_mse = validation_cross_entropy;
+    best_validation_mae = validation_cross_entropy;
+    best_parameters = parameters;
+
+    Log::info("initial validation cross entropy: %lf\n", validation_cross_entropy);
+
+    ofstream* output_log = create_log_file();
+
+    int32_t total_tokens = 0;
+    for (int32_t i = 0; i < (int32_t) output_tokens.size(); i++) {
+        total_tokens += (int32_t) output_tokens[i].size();
+    }
+
+    vector<int32_t> shuffle_order;
+    for (int32_t i = 0; i < (int32_t) input_tokens.size(); i++) {
+        shuffle_order.push_back(i);
+    }
+
+    for (int32_t iteration = 0; iteration < bp_iterations; iteration++) {
+        fisher_yates_shuffle(generator, shuffle_order);
+
+        double avg_norm = 0.0;
+        double training_cross_entropy = 0.0;
+
+        for (int32_t k = 0; k < (int32_t) shuffle_order.size(); k++) {
+            int32_t series = shuffle_order[k];
+            double cross_entropy;
+            rnn->get_analytic_gradient(
+                parameters, input_tokens[series], output_tokens[series], number_samples, generator, cross_entropy,
+                analytic_gradient
+            );
+
+            double norm = weight_update_method->get_norm(analytic_gradient);
+            if (isnan(norm) || isinf(norm)) {
+                // a genetic dead end, the same as the time series training
+                delete rnn;
+                best_parameters = parameters;
+                this->best_validation_mse = NAN;
+                this->best_validation_mae = NAN;
+                return;
+            }
+
+            avg_norm += norm;
+            training_cross_entropy += cross_entropy;
+            weight_update_method->norm_gradients(analytic_gradient, norm);
+            weight_update_method->update_weights(parameters, velocity, prev_velocity, analytic_gradient, iteration);
+        }
+        training_cross_entropy /= total_tokens;
+
+        this->set_weights(parameters);
+        validation_cross_entropy = get_softmax(parameters, validation_input_tokens, validation_output_tokens);
+
+        if (validation_cross_entropy < best_validation_mse) {
+            best_validation_mse = validation_cross_entropy;
+            best_validation_mae = validation_cross_entropy;
+            best_parameters = parameters;
+        }
+        if (output_log != NULL) {
+            std::chrono::time_point<std::chrono::system_clock> currentClock = std::chrono::system_clock::now();
+            long milliseconds =
+                std::chrono::duration_cast<std::chrono::milliseconds>(currentClock - startClock).count();
+            update_log_file(
+                output_log, iteration, milliseconds, training_cross_entropy, validation_cross_entropy, avg_norm
+            );
+        }
+        Log::info(
+            "iteration %4d, cross entropy: %5.10lf, v_cross entropy: %5.10lf, bv_cross entropy: %5.10lf, avg_norm: "
+            "%5.10lf\n",
+            iteration, training_cross_entropy, validation_cross_entropy, best_validation_mse, avg_norm
+        );
+    }
+    delete rnn;
+    this->set_weights(best_parameters);
+}
+
 ofstream* RNN_Genome::create_log_file() {
     ofstream* output_log = NULL;
     if (log_filename != "") {
@@ -1219,8 +1445,7 @@ void RNN_Genome::update_log_file(
 }
 
 double RNN_Genome::get_softmax(
-    const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
-    const vector<vector<vector<double> > >& outputs
+    const vector<double>& parameters, const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs
 ) {
     RNN* rnn = get_rnn();
     rnn->set_weights(parameters);
@@ -1243,9 +1468,30 @@ double RNN_Genome::get_softmax(
     return avg_softmax;
 }
 
+double RNN_Genome::get_softmax(
+    const vector<double>& parameters, const vector<vector<int32_t> >& input_tokens,
+    const vector<vector<int32_t> >& output_tokens
+) {
+    RNN* rnn = get_rnn();
+    rnn->set_weights(parameters);
+
+    double cross_entropy = 0.0;
+    int32_t total_tokens = 0;
+
+    for (int32_t i = 0; i < (int32_t) input_tokens.size(); i++) {
+        cross_entropy += rnn->prediction_softmax(input_tokens[i], output_tokens[i]);
+        total_tokens += (int32_t) output_tokens[i].size();
+    }
+
+    delete rnn;
+
+    cross_entropy /= total_tokens;
+    Log::trace("average cross entropy: %5.10lf\n", cross_entropy);
+    return cross_entropy;
+}
+
 double RNN_Genome::get_mse(
-    const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
-    const vector<vector<vector<double> > >& outputs
+    const vector<double>& parameters, const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs
 ) {
     RNN* rnn = get_rnn();
     rnn->set_weights(parameters);
@@ -1269,8 +1515,7 @@ double RNN_Genome::get_mse(
 }
 
 double RNN_Genome::get_mae(
-    const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
-    const vector<vector<vector<double> > >& outputs
+    const vector<double>& parameters, const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs
 ) {
     RNN* rnn = get_rnn();
     rnn->set_weights(parameters);
@@ -1294,8 +1539,7 @@ double RNN_Genome::get_mae(
 }
 
 vector<vector<double> > RNN_Genome::get_predictions(
-    const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
-    const vector<vector<vector<double> > >& outputs
+    const vector<double>& parameters, const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs
 ) {
     RNN* rnn = get_rnn();
     rnn->set_weights(parameters);
@@ -1314,8 +1558,7 @@ vector<vector<double> > RNN_Genome::get_predictions(
 
 void RNN_Genome::write_predictions(
     string output_directory, const vector<string>& input_filenames, const vector<double>& parameters,
-    const vector<vector<vector<double> > >& inputs, const vector<vector<vector<double> > >& outputs,
-    TimeSeriesSets* time_series_sets
+    const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs, TimeSeriesSets* time_series_sets
 ) {
     RNN* rnn = get_rnn();
     rnn->set_weights(parameters);
@@ -1342,6 +1585,71 @@ void RNN_Genome::write_predictions(
     delete rnn;
 }
 
+void RNN_Genome::backpropagate(
+    const vector<vector<vector<double> > >& inputs, const vector<vector<vector<double> > >& outputs,
+    const vector<vector<vector<double> > >& validation_inputs,
+    const vector<vector<vector<double> > >& validation_outputs, WeightUpdate* weight_update_method
+) {
+    TimeSeriesTensor input_tensor(inputs), output_tensor(outputs);
+    TimeSeriesTensor validation_input_tensor(validation_inputs), validation_output_tensor(validation_outputs);
+    backpropagate(
+        input_tensor, output_tensor, validation_input_tensor, validation_output_tensor, weight_update_method
+    );
+}
+
+void RNN_Genome::backpropagate_stochastic(
+    const vector<vector<vector<double> > >& inputs, const vector<vector<vector<double> > >& outputs,
+    const vector<vector<vector<double> > >& validation_inputs,
+    const vector<vector<vector<double> > >& validation_outputs, WeightUpdate* weight_update_method
+) {
+    TimeSeriesTensor input_tensor(inputs), output_tensor(outputs);
+    TimeSeriesTensor validation_input_tensor(validation_inputs), validation_output_tensor(validation_outputs);
+    backpropagate_stochastic(
+        input_tensor, output_tensor, validation_input_tensor, validation_output_tensor, weight_update_method
+    );
+}
+
+double RNN_Genome::get_softmax(
+    const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
+    const vector<vector<vector<double> > >& outputs
+) {
+    TimeSeriesTensor input_tensor(inputs), output_tensor(outputs);
+    return get_softmax(parameters, input_tensor, output_tensor);
+}
+
+double RNN_Genome::get_mse(
+    const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
+    const vector<vector<vector<double> > >& outputs
+) {
+    TimeSeriesTensor input_tensor(inputs), output_tensor(outputs);
+    return get_mse(parameters, input_tensor, output_tensor);
+}
+
+double RNN_Genome::get_mae(
+    const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
+    const vector<vector<vector<double> > >& outputs
+) {
+    TimeSeriesTensor input_tensor(inputs), output_tensor(outputs);
+    return get_mae(parameters, input_tensor, output_tensor);
+}
+
+vector<vector<double> > RNN_Genome::get_predictions(
+    const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
+    const vector<vector<vector<double> > >& outputs
+) {
+    TimeSeriesTensor input_tensor(inputs), output_tensor(outputs);
+    return get_predictions(parameters, input_tensor, output_tensor);
+}
+
+void RNN_Genome::write_predictions(
+    string output_directory, const vector<string>& input_filenames, const vector<double>& parameters,
+    const vector<vector<vector<double> > >& inputs, const vector<vector<vector<double> > >& outputs,
+    TimeSeriesSets* time_series_sets
+) {
+    TimeSeriesTensor input_tensor(inputs), output_tensor(outputs);
+    write_predictions(output_directory, input_filenames, parameters, input_tensor, output_tensor, time_series_sets);
+}
+
 // void RNN_Genome::write_predictions(string output_directory, const vector<string> &input_filenames, const
 // vector<double> &parameters, const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> >
 // > &outputs, Corpus *word_series_sets) {
@@ -3343,79 +3651,10 @@ RNN_Node_Interface* RNN_Genome::read_node_from_stream(istream& bin_istream) {
     node->enabled = enabled;
     return node;
 }
-void RNN_Genome::read_from_stream(istream& bin_istream) {
-    Log::debug("READING GENOME FROM STREAM\n");
-
-    bin_istream.read((char*) &generation_id, sizeof(int32_t));
-    bin_istream.read((char*) &group_id, sizeof(int32_t));
-    bin_istream.read((char*) &bp_iterations, sizeof(int32_t));
-
-    bin_istream.read((char*) &use_dropout, sizeof(bool));
-    bin_istream.read((char*) &dropout_probability, sizeof(double));
-
-    WeightType weight_initialize = WeightType::NONE;
-    WeightType weight_inheritance = WeightType::NONE;
-    WeightType mutated_component_weight = WeightType::NONE;
-
-    bin_istream.read((char*) &weight_initialize, sizeof(int32_t));
-    bin_istream.read((char*) &weight_inheritance, sizeof(int32_t));
-    bin_istream.read((char*) &mutated_component_weight, sizeof(int32_t));
-
-    weight_rules = new WeightRules();
-    weight_rules->set_weight_initialize_method(weight_initialize);
-    weight_rules->set_weight_inheritance_method(weight_inheritance);
-    weight_rules->set_mutated_components_weight_method(mutated_component_weight);
-
-    Log::debug("generation_id: %d\n", generation_id);
-    Log::debug("bp_iterations: %d\n", bp_iterations);
-
-    Log::debug("use_dropout: %d\n", use_dropout);
-    Log::debug("dropout_probability: %lf\n", dropout_probability);
-
-    Log::debug(": %s\n", WEIGHT_TYPES_STRING[weight_initialize].c_str());
-    Log::debug("weight inheritance: %s\n", WEIGHT_TYPES_STRING[weight_inheritance].c_str());
-    Log::debug("new component weight: %s\n", WEIGHT_TYPES_STRING[mutated_component_weight].c_str());
-
-    read_binary_string(bin_istream, log_filename, "log_filename");
-    string generator_str;
-    read_binary_string(bin_istream, generator_str, "generator");
-    istringstream generator_iss(generator_str);
-    generator_iss >> generator;
-
-    string rng_0_1_str;
-    read_binary_string(bin_istream, rng_0_1_str, "rng_0_1");
-    // So for some reason this was serialized incorrectly for some genomes,
-    // but the value should always be the same so we really don't need to de-serialize it anways and can just
-    // assign it a constant value
-    rng_0_1 = uniform_real_distribution<double>(0.0, 1.0);
-    // Formerly:
-    // istringstream rng_0_1_iss(rng_0_1_str);
-    // rng_0_1_iss >> rng_0_1;
-
-    string generated_by_map_str;
-    read_binary_string(bin_istream, generated_by_map_str, "generated_by_map");
-    istringstream generated_by_map_iss(generated_by_map_str);
-    read_map(generated_by_map_iss, generated_by_map);
-
-    bin_istream.read((char*) &best_validation_mse, sizeof(double));
-    bin_istream.read((char*) &best_validation_mae, sizeof(double));
-
-    int32_t n_initial_parameters;
-    bin_istream.read((char*) &n_initial_parameters, sizeof(int32_t));
-    Log::debug("reading %d initial parameters.\n", n_initial_parameters);
-    double* initial_parameters_v = new double[n_initial_parameters];
-    bin_istream.read((char*) initial_parameters_v, sizeof(double) * n_initial_parameters);
-    initial_parameters.assign(initial_parameters_v, initial_parameters_v + n_initial_parameters);
-    delete[] initial_parameters_v;
-
-    int32_t n_best_parameters;
-    bin_istream.read((char*) &n_best_parameters, sizeof(int32_t));
-    Log::debug("reading %d best parameters.\n", n_best_parameters);
-    double* best_parameters_v = new double[n_best_parameters];
-    bin_istream.read((char*) best_parameters_v, sizeof(double) * n_best_parameters);
-    best_parameters.assign(best_parameters_v, best_parameters_v + n_best_parameters);
-    delete[] best_parameters_v;
-
+void RNN_Genome::read_graph_from_stream(
+    istream& bin_istream, vector<string>& input_parameter_names, vector<string>& output_parameter_names,
+    vector<RNN_Node_Interface*>& nodes, vector<RNN_Edge*>& edges, vector<RNN_Recurrent_Edge*>& recurrent_edges
+) {
     input_parameter_names.clear();
     int32_t n_input_parameter_names;
     bin_istream.read((char*) &n_input_parameter_names, sizeof(int32_t));
@@ -3442,7 +3681,7 @@ void RNN_Genome::read_from_stream(istream& bin_istream) {
 
     nodes.clear();
     for (int32_t i = 0; i < n_nodes; i++) {
-        nodes.push_back(RNN_Genome::read_node_from_stream(bin_istream));
+        nodes.push_back(read_node_from_stream(bin_istream));
     }
 
     int32_t n_edges;
@@ -3501,6 +3740,84 @@ void RNN_Genome::read_from_stream(istream& bin_istream) {
         recurrent_edge->enabled = enabled;
         recurrent_edges.push_back(recurrent_edge);
     }
+}
+
+void RNN_Genome::read_from_stream(istream& bin_istream) {
+    Log::debug("READING GENOME FROM STREAM\n");
+
+    bin_istream.read((char*) &generation_id, sizeof(int32_t));
+    bin_istream.read((char*) &group_id, sizeof(int32_t));
+    bin_istream.read((char*) &bp_iterations, sizeof(int32_t));
+
+    bin_istream.read((char*) &use_dropout, sizeof(bool));
+    bin_istream.read((char*) &dropout_probability, sizeof(double));
+
+    WeightType weight_initialize = WeightType::NONE;
+    WeightType weight_inheritance = WeightType::NONE;
+    WeightType mutated_component_weight = WeightType::NONE;
+
+    bin_istream.read((char*) &weight_initialize, sizeof(int32_t));
+    bin_istream.read((char*) &weight_inheritance, sizeof(int32_t));
+    bin_istream.read((char*) &mutated_component_weight, sizeof(int32_t));
+
+    weight_rules = new WeightRules();
+    weight_rules->set_weight_initialize_method(weight_initialize);
+    weight_rules->set_weight_inheritance_method(weight_inheritance);
+    weight_rules->set_mutated_components_weight_method(mutated_component_weight);
+
+    Log::debug("generation_id: %d\n", generation_id);
+    Log::debug("bp_iterations: %d\n", bp_iterations);
+
+    Log::debug("use_dropout: %d\n", use_dropout);
+    Log::debug("dropout_probability: %lf\n", dropout_probability);
+
+    Log::debug(": %s\n", WEIGHT_TYPES_STRING[weight_initialize].c_str());
+    Log::debug("weight inheritance: %s\n", WEIGHT_TYPES_STRING[weight_inheritance].c_str());
+    Log::debug("new component weight: %s\n", WEIGHT_TYPES_STRING[mutated_component_weight].c_str());
+
+    read_binary_string(bin_istream, log_filename, "log_filename");
+    string generator_str;
+    read_binary_string(bin_istream, generator_str, "generator");
+    istringstream generator_iss(generator_str);
+    generator_iss >> generator;
+
+    string rng_0_1_str;
+    read_binary_string(bin_istream, rng_0_1_str, "rng_0_1");
+    // So for some reason this was serialized incorrectly for some genomes,
+    // but the value should always be the same so we really don't need to de-serialize it anways and can just
+    // assign it a constant value
+    rng_0_1 = uniform_real_distribution<double>(0.0, 1.0);
+    // Formerly:
+    // istringstream rng_0_1_iss(rng_0_1_str);
+    // rng_0_1_iss >> rng_0_1;
+
+    string generated_by_map_str;
+    read_binary_string(bin_istream, generated_by_map_str, "generated_by_map");
+    istringstream generated_by_map_iss(generated_by_map_str);
+    read_map(generated_by_map_iss, generated_by_map);
+
+    bin_istream.read((char*) &best_validation_mse, sizeof(double));
+    bin_istream.read((char*) &best_validation_mae, sizeof(double));
+
+    int32_t n_initial_parameters;
+    bin_istream.read((char*) &n_initial_parameters, sizeof(int32_t));
+    Log::debug("reading %d initial parameters.\n", n_initial_parameters);
+    double* initial_parameters_v = new double[n_initial_parameters];
+    bin_istream.read((char*) initial_parameters_v, sizeof(double) * n_initial_parameters);
+    initial_parameters.assign(initial_parameters_v, initial_parameters_v + n_initial_parameters);
+    delete[] initial_parameters_v;
+
+    int32_t n_best_parameters;
+    bin_istream.read((char*) &n_best_parameters, sizeof(int32_t));
+    Log::debug("reading %d best parameters.\n", n_best_parameters);
+    double* best_parameters_v = new double[n_best_parameters];
+    bin_istream.read((char*) best_parameters_v, sizeof(double) * n_best_parameters);
+    best_parameters.assign(best_parameters_v, best_parameters_v + n_best_parameters);
+    delete[] best_parameters_v;
+
+    read_graph_from_stream(
+        bin_istream, input_parameter_names, output_parameter_names, nodes, edges, recurrent_edges
+    );
 
     read_binary_string(bin_istream, normalize_type, "normalize_type");
 
@@ -3545,6 +3862,59 @@ void RNN_Genome::write_to_file(string bin_filename) {
     bin_outfile.close();
 }
 
+void RNN_Genome::write_graph_to_stream(ostream& bin_ostream) {
+    int32_t n_input_parameter_names = (int32_t) input_parameter_names.size();
+    bin_ostream.write((char*) &n_input_parameter_names, sizeof(int32_t));
+    for (int32_t i = 0; i < (int32_t) input_parameter_names.size(); i++) {
+        write_binary_string(bin_ostream, input_parameter_names[i], "input_parameter_names[" + std::to_string(i) + "]");
+    }
+
+    int32_t n_output_parameter_names = (int32_t) output_parameter_names.size();
+    bin_ostream.write((char*) &n_output_parameter_names, sizeof(int32_t));
+    for (int32_t i = 0; i < (int32_t) output_parameter_names.size(); i++) {
+        write_binary_string(
+            bin_ostream, output_parameter_names[i], "output_parameter_names[" + std::to_string(i) + "]"
+        );
+    }
+
+    int32_t n_nodes = (int32_t) nodes.size();
+    bin_ostream.write((char*) &n_nodes, sizeof(int32_t));
+    Log::debug("writing %d nodes.\n", n_nodes);
+
+    for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
+        Log::debug(
+            "NODE: %d %d %d %lf '%s'\n", nodes[i]->innovation_number, nodes[i]->layer_type, nodes[i]->node_type,
+            nodes[i]->depth, nodes[i]->parameter_name.c_str()
+        );
+        nodes[i]->write_to_stream(bin_ostream);
+    }
+
+    int32_t n_edges = (int32_t) edges.size();
+    bin_ostream.write((char*) &n_edges, sizeof(int32_t));
+    Log::debug("writing %d edges.\n", n_edges);
+
+    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
+        Log::debug(
+            "EDGE: %d %d %d\n", edges[i]->innovation_number, edges[i]->input_innovation_number,
+            edges[i]->output_innovation_number
+        );
+        edges[i]->write_to_stream(bin_ostream);
+    }
+
+    int32_t n_recurrent_edges = (int32_t) recurrent_edges.size();
+    bin_ostream.write((char*) &n_recurrent_edges, sizeof(int32_t));
+    Log::debug("writing %d recurrent edges.\n", n_recurrent_edges);
+
+    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
+        Log::debug(
+            "RECURRENT EDGE: %d %d %d %d\n", recurrent_edges[i]->innovation_number, recurrent_edges[i]->recurrent_depth,
+            recurrent_edges[i]->input_innovation_number, recurrent_edges[i]->output_innovation_number
+        );
+
+        recurrent_edges[i]->write_to_stream(bin_ostream);
+    }
+}
+
 void RNN_Genome::write_to_stream(ostream& bin_ostream) {
     Log::debug("WRITING GENOME TO STREAM\n");
     bin_ostream.write((char*) &generation_id, sizeof(int32_t));
@@ -3602,56 +3972,7 @@ void RNN_Genome::write_to_stream(ostream& bin_ostream) {
         bin_ostream.write((char*) &best_parameters[0], sizeof(double) * best_parameters.size());
     }
 
-    int32_t n_input_parameter_names = (int32_t) input_parameter_names.size();
-    bin_ostream.write((char*) &n_input_parameter_names, sizeof(int32_t));
-    for (int32_t i = 0; i < (int32_t) input_parameter_names.size(); i++) {
-        write_binary_string(bin_ostream, input_parameter_names[i], "input_parameter_names[" + std::to_string(i) + "]");
-    }
-
-    int32_t n_output_parameter_names = (int32_t) output_parameter_names.size();
-    bin_ostream.write((char*) &n_output_parameter_names, sizeof(int32_t));
-    for (int32_t i = 0; i < (int32_t) output_parameter_names.size(); i++) {
-        write_binary_string(
-            bin_ostream, output_parameter_names[i], "output_parameter_names[" + std::to_string(i) + "]"
-        );
-    }
-
-    int32_t n_nodes = (int32_t) nodes.size();
-    bin_ostream.write((char*) &n_nodes, sizeof(int32_t));
-    Log::debug("writing %d nodes.\n", n_nodes);
-
-    for (int32_t i = 0; i < (int32_t) nodes.size(); i++) {
-        Log::debug(
-            "NODE: %d %d %d %lf '%s'\n", nodes[i]->innovation_number, nodes[i]->layer_type, nodes[i]->node_type,
-            nodes[i]->depth, nodes[i]->parameter_name.c_str()
-        );
-        nodes[i]->write_to_stream(bin_ostream);
-    }
-
-    int32_t n_edges = (int32_t) edges.size();
-    bin_ostream.write((char*) &n_edges, sizeof(int32_t));
-    Log::debug("writing %d edges.\n", n_edges);
-
-    for (int32_t i = 0; i < (int32_t) edges.size(); i++) {
-        Log::debug(
-            "EDGE: %d %d %d\n", edges[i]->innovation_number, edges[i]->input_innovation_number,
-            edges[i]->output_innovation_number
-        );
-        edges[i]->write_to_stream(bin_ostream);
-    }
-
-    int32_t n_recurrent_edges = (int32_t) recurrent_edges.size();
-    bin_ostream.write((char*) &n_recurrent_edges, sizeof(int32_t));
-    Log::debug("writing %d recurrent edges.\n", n_recurrent_edges);
-
-    for (int32_t i = 0; i < (int32_t) recurrent_edges.size(); i++) {
-        Log::debug(
-            "RECURRENT EDGE: %d %d %d %d\n", recurrent_edges[i]->innovation_number, recurrent_edges[i]->recurrent_depth,
-            recurrent_edges[i]->input_innovation_number, recurrent_edges[i]->output_innovation_number
-        );
-
-        recurrent_edges[i]->write_to_stream(bin_ostream);
-    }
+    write_graph_to_stream(bin_ostream);
 
     write_binary_string(bin_ostream, normalize_type, "normalize_type");
 
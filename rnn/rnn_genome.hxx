@@ -25,6 +25,8 @@ using std::vector;
 #include "rnn_node_interface.hxx"
 #include "rnn_recurrent_edge.hxx"
 #include "time_series/time_series.hxx"
+#include "time_series/time_series_stream.hxx"
+#include "time_series/window_sampler.hxx"
 #include "weights/weight_rules.hxx"
 #include "weights/weight_update.hxx"
 // #include "word_series/word_series.hxx"
@@ -104,6 +106,14 @@ class RNN_Genome {
 
     static RNN_Node_Interface* read_node_from_stream(istream& bin_istream);
 
+    // the parameter names, nodes, edges and recurrent edges of the genome, the part of write_to_stream
+    // which is also used by the genome wire format (see GenomeWire)
+    void write_graph_to_stream(ostream& bin_ostream);
+    static void read_graph_from_stream(
+        istream& bin_istream, vector<string>& input_parameter_names, vector<string>& output_parameter_names,
+        vector<RNN_Node_Interface*>& nodes, vector<RNN_Edge*>& edges, vector<RNN_Recurrent_Edge*>& recurrent_edges
+    );
+
     void set_parameter_names(
         const vector<string>& _input_parameter_names, const vector<string>& _output_parameter_names
     );
@@ -153,6 +163,8 @@ class RNN_Genome {
     void set_stochastic(bool stochastic);
     void disable_dropout();
     void enable_dropout(double _dropout_probability);
+    bool get_use_dropout() const;
+    double get_dropout_probability() const;
     void set_log_filename(string _log_filename);
 
     void get_weights(vector<double>& parameters);
@@ -193,10 +205,73 @@ class RNN_Genome {
     void set_initial_parameters(vector<double> parameters);  // INFO: ADDED BY ABDELRAHMAN TO USE FOR TRANSFER LEARNING
 
     void get_analytic_gradient(
-        vector<RNN*>& rnns, const vector<double>& parameters, const vector<vector<vector<double> > >& inputs,
-        const vector<vector<vector<double> > >& outputs, double& mse, vector<double>& analytic_gradient, bool training
+        vector<RNN*>& rnns, const vector<double>& parameters, const TimeSeriesTensor& inputs,
+        const TimeSeriesTensor& outputs, double& mse, vector<double>& analytic_gradient, bool training
+    );
+
+    void backpropagate(
+        const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs, const TimeSeriesTensor& validation_inputs,
+        const TimeSeriesTensor& validation_outputs, WeightUpdate* weight_update_method
+    );
+
+    void backpropagate_stochastic(
+        const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs, const TimeSeriesTensor& validation_inputs,
+        const TimeSeriesTensor& validation_outputs, WeightUpdate* weight_update_method
+    );
+
+    /**
+     * Trains on the windows given by the window sampler each epoch, instead of on each of the
+     * sequences as a whole, when it is enabled.
+     */
+    void backpropagate_stochastic(
+        const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs, const TimeSeriesTensor& validation_inputs,
+        const TimeSeriesTensor& validation_outputs, WeightUpdate* weight_update_method, WindowSampler* window_sampler
+    );
+
+    /**
+     * Trains on the training data read from the stream each epoch, rather than from memory.
+     */
+    void backpropagate_stochastic(
+        const TimeSeriesStream* stream, const TimeSeriesTensor& validation_inputs,
+        const TimeSeriesTensor& validation_outputs, WeightUpdate* weight_update_method, WindowSampler* window_sampler
+    );
+
+    /**
+     * Trains on word series given as the index of the word at each time step (see
+     * RNN::sparse_forward_pass), with the softmax cross entropy of the expected words as the
+     * error. If number_samples > 0 training uses the sampled softmax over that many uniformly
+     * sampled words (plus the expected word), and validation always uses the exact softmax.
+     * The genome's best validation mse and mae are its best validation cross entropy.
+     */
+    void backpropagate_stochastic(
+        const vector<vector<int32_t> >& input_tokens, const vector<vector<int32_t> >& output_tokens,
+        const vector<vector<int32_t> >& validation_input_tokens,
+        const vector<vector<int32_t> >& validation_output_tokens, WeightUpdate* weight_update_method,
+        int32_t number_samples
+    );
+
+    double get_softmax(
+        const vector<double>& parameters, const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs
+    );
+
+    // the softmax cross entropy of word series given as tokens, averaged over the words
+    double get_softmax(
+        const vector<double>& parameters, const vector<vector<int32_t> >& input_tokens,
+        const vector<vector<int32_t> >& output_tokens
     );
 
+    double get_mse(const vector<double>& parameters, const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs);
+    double get_mae(const vector<double>& parameters, const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs);
+
+    vector<vector<double> > get_predictions(
+        const vector<double>& parameters, const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs
+    );
+    void write_predictions(
+        string output_directory, const vector<string>& input_filenames, const vector<double>& parameters,
+        const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs, TimeSeriesSets* time_series_sets
+    );
+
+    // the same as above for data which is not in tensors, these copy the data into tensors first
     void backpropagate(
         const vector<vector<vector<double> > >& inputs, const vector<vector<vector<double> > >& outputs,
         const vector<vector<vector<double> > >& validation_inputs,
@@ -346,6 +421,13 @@ class RNN_Genome {
      */
     int32_t get_max_edge_innovation_count();
 
+    bool train_on_windows(
+        RNN* rnn, const TimeSeriesTensor& inputs, const TimeSeriesTensor& outputs, WindowSampler* window_sampler,
+        WeightUpdate* weight_update_method, int32_t iteration, vector<double>& parameters, vector<double>& velocity,
+        vector<double>& prev_velocity, vector<double>& analytic_gradient, double& total_norm, double& total_mse,
+        int32_t& number_windows
+    );
+
     ofstream* create_log_file();
     void update_log_file(
         ofstream* output_log, int32_t iteration, long milliseconds, double training_mse, double validation_mse,
@@ -363,6 +445,7 @@ class RNN_Genome {
     friend class NeatSpeciationStrategy;
     friend class RecDepthFrequencyTable;
     friend class GenomeProperty;
+    friend class GenomeWire;
 };
 
 struct sort_genomes_by_fitness {
@@ -53,6 +53,7 @@ class RNN_Node : public RNN_Node_Interface {
     void write_to_stream(ostream& out);
 
     friend class RNN_Edge;
+    friend class RNN;
 };
 
 #endif
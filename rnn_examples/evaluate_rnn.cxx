@@ -43,21 +43,19 @@ int main(int argc, char** argv) {
     vector<string> testing_filenames;
     get_argument_vector(arguments, "--testing_filenames", true, testing_filenames);
 
+    // the test series are normalized with the genome's normalization values, and can be cached
+    // with --time_series_cache so repeated evaluations skip parsing the CSV files
+    string cache_directory = "";
+    get_argument(arguments, "--time_series_cache", false, cache_directory);
+
+    string normalize_type = genome->get_normalize_type();
     TimeSeriesSets* time_series_sets = TimeSeriesSets::generate_test(
-        testing_filenames, genome->get_input_parameter_names(), genome->get_output_parameter_names()
+        testing_filenames, genome->get_input_parameter_names(), genome->get_output_parameter_names(), normalize_type,
+        genome->get_normalize_mins(), genome->get_normalize_maxs(), genome->get_normalize_avgs(),
+        genome->get_normalize_std_devs(), cache_directory
     );
     Log::debug("got time series sets.\n");
 
-    string normalize_type = genome->get_normalize_type();
-    if (normalize_type.compare("min_max") == 0) {
-        time_series_sets->normalize_min_max(genome->get_normalize_mins(), genome->get_normalize_maxs());
-    } else if (normalize_type.compare("avg_std_dev") == 0) {
-        time_series_sets->normalize_avg_std_dev(
-            genome->get_normalize_avgs(), genome->get_normalize_std_devs(), genome->get_normalize_mins(),
-            genome->get_normalize_maxs()
-        );
-    }
-
     Log::info("normalized type: %s \n", normalize_type.c_str());
 
     int32_t time_offset = 1;
@@ -0,0 +1,295 @@
+/**
+ * Evaluates many saved genomes on the same testing files at once, for re-scoring the genomes of a
+ * sweep. Example usage:
+ *
+ * ./rnn_examples/evaluate_rnns_batch --genome_filenames results/genome_*.bin --time_offsets 1 2 4 8
+ * --testing_filenames datasets/2018_coal/burner_0.csv --output_directory results/evaluation --number_threads 8
+ *
+ * Each genome is evaluated at every time offset, or with --paired_time_offsets at the offset with
+ * the same index as the genome (like evaluate_rnns_multi_offset). The testing files are loaded
+ * and normalized once for all the genomes which have the same parameters and normalization, and
+ * the genomes are evaluated on --number_threads threads (defaulting to the number of hardware
+ * threads), each thread running all of a genome's (time offset, testing file) evaluations.
+ *
+ * The MSE and MAE of each genome and time offset, averaged over the testing files and for each
+ * file, are written to --output_filename (batch_evaluation.csv in the output directory by
+ * default). With --write_predictions the predictions of each evaluation are also written to
+ * <genome>_offset_<time offset>_<testing file>_predictions.csv in the output directory.
+ */
+
+#include <atomic>
+using std::atomic;
+
+#include <fstream>
+using std::ofstream;
+
+#include <iomanip>
+using std::setprecision;
+
+#include <map>
+using std::map;
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/files.hxx"
+#include "common/log.hxx"
+#include "rnn/rnn.hxx"
+#include "rnn/rnn_genome.hxx"
+#include "time_series/time_series.hxx"
+
+/**
+ * The testing files loaded and normalized for a group of genomes with the same input and output
+ * parameters and normalization values, exported once for each time offset they are evaluated at.
+ */
+struct TestingData {
+    RNN_Genome* genome;
+    TimeSeriesSets* time_series_sets;
+    map<int32_t, TimeSeriesTensor*> inputs;
+    map<int32_t, TimeSeriesTensor*> outputs;
+};
+
+struct Evaluation {
+    int32_t genome;
+    int32_t time_offset;
+    int32_t file;
+    double mse;
+    double mae;
+};
+
+bool same_testing_data(RNN_Genome* a, RNN_Genome* b) {
+    return a->get_input_parameter_names() == b->get_input_parameter_names()
+           && a->get_output_parameter_names() == b->get_output_parameter_names()
+           && a->get_normalize_type() == b->get_normalize_type() && a->get_normalize_mins() == b->get_normalize_mins()
+           && a->get_normalize_maxs() == b->get_normalize_maxs() && a->get_normalize_avgs() == b->get_normalize_avgs()
+           && a->get_normalize_std_devs() == b->get_normalize_std_devs();
+}
+
+string file_stem(string filename) {
+    filename = filename.substr(filename.find_last_of("/") + 1);
+    return filename.substr(0, filename.find_last_of("."));
+}
+
+int main(int argc, char** argv) {
+    vector<string> arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_id("main");
+
+    vector<string> genome_filenames;
+    get_argument_vector(arguments, "--genome_filenames", true, genome_filenames);
+
+    vector<string> testing_filenames;
+    get_argument_vector(arguments, "--testing_filenames", true, testing_filenames);
+
+    string output_directory;
+    get_argument(arguments, "--output_directory", true, output_directory);
+    mkpath(output_directory.c_str(), 0777);
+
+    string output_filename = output_directory + "/batch_evaluation.csv";
+    get_argument(arguments, "--output_filename", false, output_filename);
+
+    vector<int32_t> time_offsets;
+    if (argument_exists(arguments, "--time_offsets")) {
+        get_argument_vector(arguments, "--time_offsets", true, time_offsets);
+    } else {
+        time_offsets.push_back(1);
+    }
+
+    bool paired_time_offsets = argument_exists(arguments, "--paired_time_offsets");
+    if (paired_time_offsets && time_offsets.size() != genome_filenames.size()) {
+        Log::fatal(
+            "ERROR: number of time_offsets (%d) != number of genome_files: (%d)\n", time_offsets.size(),
+            genome_filenames.size()
+        );
+        exit(1);
+    }
+
+    bool write_predictions = argument_exists(arguments, "--write_predictions");
+
+    int32_t number_threads = thread::hardware_concurrency();
+    get_argument(arguments, "--number_threads", false, number_threads);
+    if (number_threads < 1) {
+        number_threads = 1;
+    }
+
+    vector<RNN_Genome*> genomes;
+    vector<vector<double> > best_parameters;
+    for (int32_t i = 0; i < (int32_t) genome_filenames.size(); i++) {
+        Log::info("reading genome filename: %s\n", genome_filenames[i].c_str());
+        genomes.push_back(new RNN_Genome(genome_filenames[i]));
+        best_parameters.push_back(genomes[i]->get_best_parameters());
+    }
+
+    // load the testing files once for each group of genomes which use the same data
+    vector<TestingData> testing_data;
+    vector<int32_t> genome_data(genomes.size());
+    for (int32_t i = 0; i < (int32_t) genomes.size(); i++) {
+        int32_t data = 0;
+        while (data < (int32_t) testing_data.size() && !same_testing_data(testing_data[data].genome, genomes[i])) {
+            data++;
+        }
+
+        if (data == (int32_t) testing_data.size()) {
+            Log::info("loading testing files for the parameters and normalization of genome %d\n", i);
+            TestingData loaded;
+            loaded.genome = genomes[i];
+            loaded.time_series_sets = TimeSeriesSets::generate_test(
+                testing_filenames, genomes[i]->get_input_parameter_names(),
+                genomes[i]->get_output_parameter_names(), genomes[i]->get_normalize_type(),
+                genomes[i]->get_normalize_mins(), genomes[i]->get_normalize_maxs(), genomes[i]->get_normalize_avgs(),
+                genomes[i]->get_normalize_std_devs(), ""
+            );
+            testing_data.push_back(loaded);
+        }
+        genome_data[i] = data;
+    }
+
+    // the work list, ordered by genome, with the evaluations of genome i from genome_evaluations[i]
+    // up to genome_evaluations[i + 1]
+    vector<Evaluation> evaluations;
+    vector<int32_t> genome_evaluations;
+    for (int32_t i = 0; i < (int32_t) genomes.size(); i++) {
+        TestingData& data = testing_data[genome_data[i]];
+        genome_evaluations.push_back((int32_t) evaluations.size());
+
+        for (int32_t j = 0; j < (int32_t) time_offsets.size(); j++) {
+            if (paired_time_offsets && j != i) {
+                continue;
+            }
+
+            int32_t time_offset = time_offsets[j];
+            if (data.inputs.count(time_offset) == 0) {
+                data.inputs[time_offset] = new TimeSeriesTensor();
+                data.outputs[time_offset] = new TimeSeriesTensor();
+                data.time_series_sets->export_test_series(
+                    time_offset, *data.inputs[time_offset], *data.outputs[time_offset]
+                );
+            }
+
+            for (int32_t file = 0; file < (int32_t) testing_filenames.size(); file++) {
+                evaluations.push_back({i, time_offset, file, 0.0, 0.0});
+            }
+        }
+    }
+    genome_evaluations.push_back((int32_t) evaluations.size());
+
+    Log::info(
+        "running %d evaluations of %d genomes on %d threads\n", evaluations.size(), genomes.size(), number_threads
+    );
+
+    // each thread takes a genome at a time and runs all of its evaluations with one RNN
+    atomic<int32_t> next_genome(0);
+
+    auto evaluate = [&](int32_t thread_number) {
+        string log_id = "evaluator_" + to_string(thread_number);
+        Log::set_id(log_id);
+
+        for (int32_t g = next_genome++; g < (int32_t) genomes.size(); g = next_genome++) {
+            RNN_Genome* genome = genomes[g];
+            TestingData& data = testing_data[genome_data[g]];
+
+            RNN* rnn = genome->get_rnn();
+            rnn->set_weights(best_parameters[g]);
+
+            for (int32_t e = genome_evaluations[g]; e < genome_evaluations[g + 1]; e++) {
+                Evaluation& evaluation = evaluations[e];
+
+                const SeriesView& inputs = (*data.inputs[evaluation.time_offset])[evaluation.file];
+                const SeriesView& outputs = (*data.outputs[evaluation.time_offset])[evaluation.file];
+
+                // writing the predictions does the forward pass the errors are calculated from
+                if (write_predictions) {
+                    string predictions_filename = output_directory + "/" + file_stem(genome_filenames[g]) + "_offset_"
+                                                  + to_string(evaluation.time_offset) + "_"
+                                                  + file_stem(testing_filenames[evaluation.file]) + "_predictions.csv";
+                    rnn->write_predictions(
+                        predictions_filename, genome->get_input_parameter_names(),
+                        genome->get_output_parameter_names(), inputs, outputs, data.time_series_sets,
+                        genome->get_use_dropout(), genome->get_dropout_probability()
+                    );
+                } else {
+                    rnn->forward_pass(inputs, genome->get_use_dropout(), false, genome->get_dropout_probability());
+                }
+
+                evaluation.mse = rnn->calculate_error_mse(outputs);
+                evaluation.mae = rnn->calculate_error_mae(outputs);
+
+                Log::debug(
+                    "genome %d, time offset %d, file %d: MSE: %lf, MAE: %lf\n", g, evaluation.time_offset,
+                    evaluation.file, evaluation.mse, evaluation.mae
+                );
+            }
+
+            delete rnn;
+        }
+
+        Log::release_id(log_id);
+    };
+
+    vector<thread> threads;
+    for (int32_t i = 0; i < number_threads; i++) {
+        threads.push_back(thread(evaluate, i));
+    }
+    for (int32_t i = 0; i < number_threads; i++) {
+        threads[i].join();
+    }
+
+    ofstream outfile(output_filename);
+    outfile << setprecision(15);
+
+    outfile << "#genome,time_offset,mse,mae";
+    for (int32_t file = 0; file < (int32_t) testing_filenames.size(); file++) {
+        string stem = file_stem(testing_filenames[file]);
+        outfile << "," << stem << "_mse," << stem << "_mae";
+    }
+    outfile << endl;
+
+    int32_t number_files = (int32_t) testing_filenames.size();
+    for (int32_t e = 0; e < (int32_t) evaluations.size(); e += number_files) {
+        double mse = 0.0;
+        double mae = 0.0;
+        for (int32_t file = 0; file < number_files; file++) {
+            mse += evaluations[e + file].mse;
+            mae += evaluations[e + file].mae;
+        }
+        mse /= number_files;
+        mae /= number_files;
+
+        Log::info(
+            "%s, time offset %d: MSE: %lf, MAE: %lf\n", genome_filenames[evaluations[e].genome].c_str(),
+            evaluations[e].time_offset, mse, mae
+        );
+
+        outfile << genome_filenames[evaluations[e].genome] << "," << evaluations[e].time_offset << "," << mse << ","
+                << mae;
+        for (int32_t file = 0; file < number_files; file++) {
+            outfile << "," << evaluations[e + file].mse << "," << evaluations[e + file].mae;
+        }
+        outfile << endl;
+    }
+    outfile.close();
+
+    for (int32_t i = 0; i < (int32_t) testing_data.size(); i++) {
+        for (auto it = testing_data[i].inputs.begin(); it != testing_data[i].inputs.end(); it++) {
+            delete it->second;
+            delete testing_data[i].outputs[it->first];
+        }
+        delete testing_data[i].time_series_sets;
+    }
+
+    for (int32_t i = 0; i < (int32_t) genomes.size(); i++) {
+        delete genomes[i];
+    }
+
+    Log::release_id("main");
+    return 0;
+}
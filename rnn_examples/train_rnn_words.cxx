@@ -0,0 +1,145 @@
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/files.hxx"
+#include "common/log.hxx"
+#include "rnn/generate_nn.hxx"
+#include "rnn/rnn_genome.hxx"
+#include "weights/weight_rules.hxx"
+#include "weights/weight_update.hxx"
+#include "word_series/word_series.hxx"
+
+/**
+ * Trains an RNN to predict the next word of word series, with the words given as tokens (the index
+ * of each word) instead of one-hot series, using the sparse input path and the softmax cross
+ * entropy (see RNN_Genome::backpropagate_stochastic), or the sampled softmax with --softmax_samples.
+ */
+int main(int argc, char** argv) {
+    vector<string> arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_id("main");
+
+    if (!argument_exists(arguments, "--sparse_word_series")) {
+        // the tokens are all that is needed, so the one-hot word series are never created
+        arguments.push_back("--sparse_word_series");
+    }
+    Corpus* corpus = Corpus::generate_from_arguments(arguments);
+
+    int32_t word_offset = 1;
+    get_argument(arguments, "--word_offset", false, word_offset);
+
+    vector<vector<int32_t> > training_inputs;
+    vector<vector<int32_t> > training_outputs;
+    vector<vector<int32_t> > test_inputs;
+    vector<vector<int32_t> > test_outputs;
+
+    corpus->export_training_tokens(word_offset, training_inputs, training_outputs);
+    corpus->export_test_tokens(word_offset, test_inputs, test_outputs);
+
+    vector<string> input_parameter_names = corpus->get_input_parameter_names();
+    vector<string> output_parameter_names = corpus->get_output_parameter_names();
+
+    Log::info(
+        "vocabulary of %d words, %d training and %d test sequences\n", (int32_t) input_parameter_names.size(),
+        (int32_t) training_inputs.size(), (int32_t) test_inputs.size()
+    );
+
+    WeightRules* weight_rules = new WeightRules(arguments);
+
+    WeightUpdate* weight_update_method = new WeightUpdate();
+    weight_update_method->generate_from_arguments(arguments);
+
+    string rnn_type = "embedding";
+    get_argument(arguments, "--rnn_type", false, rnn_type);
+
+    RNN_Genome* genome;
+    if (rnn_type == "embedding") {
+        int32_t embedding_size;
+        get_argument(arguments, "--embedding_size", true, embedding_size);
+
+        genome = create_embedding_nn(input_parameter_names, embedding_size, output_parameter_names, weight_rules);
+    } else {
+        int32_t num_hidden_layers;
+        get_argument(arguments, "--num_hidden_layers", true, num_hidden_layers);
+
+        int32_t hidden_layer_size;
+        get_argument(arguments, "--hidden_layer_size", true, hidden_layer_size);
+
+        int32_t max_recurrent_depth = 1;
+        get_argument(arguments, "--max_recurrent_depth", false, max_recurrent_depth);
+
+        if (rnn_type == "ff") {
+            genome = create_ff(
+                input_parameter_names, num_hidden_layers, hidden_layer_size, output_parameter_names,
+                max_recurrent_depth, weight_rules
+            );
+        } else if (rnn_type == "lstm") {
+            genome = create_lstm(
+                input_parameter_names, num_hidden_layers, hidden_layer_size, output_parameter_names,
+                max_recurrent_depth, weight_rules
+            );
+        } else if (rnn_type == "gru") {
+            genome = create_gru(
+                input_parameter_names, num_hidden_layers, hidden_layer_size, output_parameter_names,
+                max_recurrent_depth, weight_rules
+            );
+        } else {
+            Log::fatal("ERROR: incorrect rnn type '%s'\n", rnn_type.c_str());
+            Log::fatal("Possibilities are:\n");
+            Log::fatal("    embedding\n");
+            Log::fatal("    ff\n");
+            Log::fatal("    lstm\n");
+            Log::fatal("    gru\n");
+            exit(1);
+        }
+    }
+
+    int32_t bp_iterations;
+    get_argument(arguments, "--bp_iterations", true, bp_iterations);
+    genome->set_bp_iterations(bp_iterations);
+
+    string output_directory = "";
+    get_argument(arguments, "--output_directory", false, output_directory);
+    if (output_directory != "") {
+        mkpath(output_directory.c_str(), 0777);
+    }
+    if (argument_exists(arguments, "--log_filename")) {
+        string log_filename;
+        get_argument(arguments, "--log_filename", true, log_filename);
+        genome->set_log_filename(output_directory + "/" + log_filename);
+    }
+
+    genome->disable_dropout();
+    genome->initialize_randomly();
+
+    Log::info("RNN has %d weights.\n", genome->get_number_weights());
+
+    // the number of words sampled for the sampled softmax at each time step, 0 uses the exact softmax
+    int32_t softmax_samples = 0;
+    get_argument(arguments, "--softmax_samples", false, softmax_samples);
+
+    genome->backpropagate_stochastic(
+        training_inputs, training_outputs, test_inputs, test_outputs, weight_update_method, softmax_samples
+    );
+
+    vector<double> best_parameters;
+    genome->get_weights(best_parameters);
+
+    Log::info("Training finished\n");
+    Log::info("TRAINING CROSS ENTROPY: %lf\n", genome->get_softmax(best_parameters, training_inputs, training_outputs));
+    Log::info("TEST CROSS ENTROPY: %lf\n", genome->get_softmax(best_parameters, test_inputs, test_outputs));
+
+    if (output_directory != "") {
+        genome->write_to_file(output_directory + "/trained_genome.bin");
+    }
+
+    delete genome;
+    delete corpus;
+
+    Log::release_id("main");
+}
@@ -5,6 +5,7 @@ using std::ifstream;
 
 #include <random>
 using std::minstd_rand0;
+using std::uniform_int_distribution;
 using std::uniform_real_distribution;
 
 #include <string>
@@ -43,6 +44,172 @@ void generate_random_vector(int number_parameters, vector<double>& v) {
     }
 }
 
+void generate_random_tokens(int number_tokens, int number_inputs, vector<int32_t>& tokens) {
+    uniform_int_distribution<int32_t> token_rng(0, number_inputs - 1);
+    tokens.resize(number_tokens);
+
+    for (int32_t i = 0; i < number_tokens; i++) {
+        tokens[i] = token_rng(generator);
+    }
+}
+
+/**
+ * Checks that the sparse input path gives the same gradient as the dense one-hot encoding of the tokens.
+ */
+void sparse_gradient_test(
+    string name, RNN_Genome* genome, const vector<int32_t>& input_tokens, const vector<vector<double> >& outputs
+) {
+    genome->set_stochastic(false);
+    double dense_mse, sparse_mse;
+    vector<double> parameters;
+    vector<double> dense_gradient, sparse_gradient;
+
+    Log::info("\ttesting sparse gradient on '%s'...\n", name.c_str());
+    bool failed = false;
+
+    genome->initialize_randomly();
+    RNN* rnn = genome->get_rnn();
+
+    vector<vector<double> > inputs(genome->get_number_inputs(), vector<double>(input_tokens.size(), 0.0));
+    for (int32_t j = 0; j < (int32_t) input_tokens.size(); j++) {
+        inputs[input_tokens[j]][j] = 1.0;
+    }
+
+    TimeSeriesTensor output_tensor(vector<vector<vector<double> > >(1, outputs));
+
+    for (int32_t i = 0; i < test_iterations; i++) {
+        generate_random_vector(rnn->get_number_weights(), parameters);
+
+        rnn->get_analytic_gradient(parameters, inputs, outputs, dense_mse, dense_gradient, false, true, 0.0);
+        rnn->get_analytic_gradient(parameters, input_tokens, output_tensor[0], sparse_mse, sparse_gradient);
+
+        bool iteration_failed = false;
+
+        if (fabs(dense_mse - sparse_mse) > 10e-10) {
+            failed = true;
+            iteration_failed = true;
+            Log::info("\t\tFAILED dense mse: %lf, sparse mse: %lf\n", dense_mse, sparse_mse);
+        }
+
+        for (uint32_t j = 0; j < dense_gradient.size(); j++) {
+            double difference = dense_gradient[j] - sparse_gradient[j];
+
+            if (fabs(difference) > 10e-10) {
+                failed = true;
+                iteration_failed = true;
+                Log::info(
+                    "\t\tFAILED dense gradient[%d]: %lf, sparse gradient[%d]: %lf, difference: %lf\n", j,
+                    dense_gradient[j], j, sparse_gradient[j], difference
+                );
+            }
+        }
+
+        if (iteration_failed) {
+            Log::info("\tITERATION %d FAILED!\n\n", i);
+        } else {
+            Log::debug("\tITERATION %d PASSED!\n\n", i);
+        }
+    }
+
+    delete rnn;
+
+    if (!failed) {
+        Log::info("ALL PASSED!\n");
+    } else {
+        Log::info("SOME FAILED!\n");
+    }
+}
+
+/**
+ * Checks the gradient of the (sampled if number_samples > 0) softmax cross entropy against the empirical
+ * gradient, sampling the same outputs for each evaluation.
+ */
+void softmax_gradient_test(
+    string name, RNN_Genome* genome, const vector<int32_t>& input_tokens, const vector<int32_t>& output_tokens,
+    int32_t number_samples
+) {
+    genome->set_stochastic(false);
+    double cross_entropy;
+    vector<double> parameters;
+    vector<double> analytic_gradient;
+
+    Log::info("\ttesting softmax gradient on '%s' with %d samples...\n", name.c_str(), number_samples);
+    bool failed = false;
+
+    genome->initialize_randomly();
+    RNN* rnn = genome->get_rnn();
+
+    for (int32_t i = 0; i < test_iterations; i++) {
+        generate_random_vector(rnn->get_number_weights(), parameters);
+
+        minstd_rand0 sample_generator = generator;
+        rnn->get_analytic_gradient(
+            parameters, input_tokens, output_tokens, number_samples, sample_generator, cross_entropy, analytic_gradient
+        );
+
+        bool iteration_failed = false;
+
+        double diff = 0.00001;
+        for (uint32_t j = 0; j < analytic_gradient.size(); j++) {
+            double save = parameters[j];
+            double cross_entropy1, cross_entropy2;
+
+            parameters[j] = save - diff;
+            rnn->set_weights(parameters);
+            sample_generator = generator;
+            if (number_samples > 0) {
+                rnn->sparse_forward_pass(input_tokens, output_tokens, number_samples, sample_generator);
+                cross_entropy1 = rnn->calculate_error_sampled_softmax(output_tokens);
+            } else {
+                rnn->sparse_forward_pass(input_tokens);
+                cross_entropy1 = rnn->calculate_error_softmax(output_tokens);
+            }
+
+            parameters[j] = save + diff;
+            rnn->set_weights(parameters);
+            sample_generator = generator;
+            if (number_samples > 0) {
+                rnn->sparse_forward_pass(input_tokens, output_tokens, number_samples, sample_generator);
+                cross_entropy2 = rnn->calculate_error_sampled_softmax(output_tokens);
+            } else {
+                rnn->sparse_forward_pass(input_tokens);
+                cross_entropy2 = rnn->calculate_error_softmax(output_tokens);
+            }
+
+            parameters[j] = save;
+
+            double empirical_gradient = (cross_entropy2 - cross_entropy1) / (2.0 * diff);
+            double difference = analytic_gradient[j] - empirical_gradient;
+
+            if (fabs(difference) > 10e-7) {
+                failed = true;
+                iteration_failed = true;
+                Log::info(
+                    "\t\tFAILED analytic gradient[%d]: %lf, empirical gradient[%d]: %lf, difference: %lf\n", j,
+                    analytic_gradient[j], j, empirical_gradient, difference
+                );
+            }
+        }
+
+        // use different samples for the next iteration
+        generator.discard(1);
+
+        if (iteration_failed) {
+            Log::info("\tITERATION %d FAILED!\n\n", i);
+        } else {
+            Log::debug("\tITERATION %d PASSED!\n\n", i);
+        }
+    }
+
+    delete rnn;
+
+    if (!failed) {
+        Log::info("ALL PASSED!\n");
+    } else {
+        Log::info("SOME FAILED!\n");
+    }
+}
+
 void gradient_test(
     string name, RNN_Genome* genome, const vector<vector<double> >& inputs, const vector<vector<double> >& outputs
 ) {
@@ -32,4 +32,15 @@ void gradient_test(
     string name, RNN_Genome* genome, const vector<vector<double> >& inputs, const vector<vector<double> >& outputs
 );
 
+void generate_random_tokens(int number_tokens, int number_inputs, vector<int32_t>& tokens);
+
+void sparse_gradient_test(
+    string name, RNN_Genome* genome, const vector<int32_t>& input_tokens, const vector<vector<double> >& outputs
+);
+
+void softmax_gradient_test(
+    string name, RNN_Genome* genome, const vector<int32_t>& input_tokens, const vector<int32_t>& output_tokens,
+    int32_t number_samples
+);
+
 #endif
@@ -0,0 +1,67 @@
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "gradient_test.hxx"
+#include "rnn/generate_nn.hxx"
+#include "rnn/rnn_genome.hxx"
+#include "weights/weight_rules.hxx"
+
+int main(int argc, char** argv) {
+    vector<string> arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_id("main");
+
+    initialize_generator();
+
+    RNN_Genome* genome;
+
+    Log::info("TESTING SOFTMAX\n");
+
+    int input_length = 10;
+    get_argument(arguments, "--input_length", true, input_length);
+
+    WeightRules* weight_rules = new WeightRules();
+    weight_rules->initialize_from_args(arguments);
+
+    vector<string> inputs{"word 1", "word 2", "word 3", "word 4", "word 5", "word 6"};
+    vector<string> outputs{"next word 1", "next word 2", "next word 3", "next word 4", "next word 5", "next word 6"};
+
+    vector<int32_t> input_tokens;
+    vector<int32_t> output_tokens;
+
+    for (int32_t max_recurrent_depth = 1; max_recurrent_depth <= 2; max_recurrent_depth++) {
+        Log::info("testing with max recurrent depth: %d\n", max_recurrent_depth);
+
+        generate_random_tokens(input_length, (int) inputs.size(), input_tokens);
+        generate_random_tokens(input_length, (int) outputs.size(), output_tokens);
+
+        // exact softmax, then sampling fewer outputs than there are
+        for (int32_t number_samples = 0; number_samples <= 2; number_samples += 2) {
+            genome = create_ff(inputs, 0, 0, outputs, max_recurrent_depth, weight_rules);
+            softmax_gradient_test("FF: 6 Input, 6 Output", genome, input_tokens, output_tokens, number_samples);
+            delete genome;
+
+            genome = create_ff(inputs, 2, 3, outputs, max_recurrent_depth, weight_rules);
+            softmax_gradient_test(
+                "FF: 6 Input, 2x3 Hidden, 6 Output", genome, input_tokens, output_tokens, number_samples
+            );
+            delete genome;
+
+            genome = create_lstm(inputs, 2, 3, outputs, max_recurrent_depth, weight_rules);
+            softmax_gradient_test(
+                "LSTM: 6 Input, 2x3 Hidden, 6 Output", genome, input_tokens, output_tokens, number_samples
+            );
+            delete genome;
+        }
+    }
+
+    genome = create_embedding_nn(inputs, 3, outputs, weight_rules);
+    softmax_gradient_test("Embedding: 6 Input, 3 Embedding, 6 Output", genome, input_tokens, output_tokens, 2);
+    delete genome;
+}
@@ -0,0 +1,66 @@
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "gradient_test.hxx"
+#include "rnn/generate_nn.hxx"
+#include "rnn/rnn_genome.hxx"
+#include "weights/weight_rules.hxx"
+
+int main(int argc, char** argv) {
+    vector<string> arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_id("main");
+
+    initialize_generator();
+
+    RNN_Genome* genome;
+
+    Log::info("TESTING SPARSE INPUTS\n");
+
+    int input_length = 10;
+    get_argument(arguments, "--input_length", true, input_length);
+
+    WeightRules* weight_rules = new WeightRules();
+    weight_rules->initialize_from_args(arguments);
+
+    vector<string> inputs{"word 1", "word 2", "word 3", "word 4", "word 5", "word 6"};
+    vector<string> outputs{"output 1", "output 2"};
+
+    vector<int32_t> input_tokens;
+    vector<vector<double> > output_values(outputs.size());
+
+    for (int32_t max_recurrent_depth = 1; max_recurrent_depth <= 3; max_recurrent_depth++) {
+        Log::info("testing with max recurrent depth: %d\n", max_recurrent_depth);
+
+        generate_random_tokens(input_length, (int) inputs.size(), input_tokens);
+        for (int32_t i = 0; i < (int32_t) outputs.size(); i++) {
+            generate_random_vector(input_length, output_values[i]);
+        }
+
+        genome = create_ff(inputs, 0, 0, outputs, max_recurrent_depth, weight_rules);
+        sparse_gradient_test("FF: 6 Input, 2 Output", genome, input_tokens, output_values);
+        delete genome;
+
+        genome = create_ff(inputs, 2, 3, outputs, max_recurrent_depth, weight_rules);
+        sparse_gradient_test("FF: 6 Input, 2x3 Hidden, 2 Output", genome, input_tokens, output_values);
+        delete genome;
+
+        genome = create_lstm(inputs, 2, 3, outputs, max_recurrent_depth, weight_rules);
+        sparse_gradient_test("LSTM: 6 Input, 2x3 Hidden, 2 Output", genome, input_tokens, output_values);
+        delete genome;
+
+        genome = create_gru(inputs, 2, 3, outputs, max_recurrent_depth, weight_rules);
+        sparse_gradient_test("GRU: 6 Input, 2x3 Hidden, 2 Output", genome, input_tokens, output_values);
+        delete genome;
+    }
+
+    genome = create_embedding_nn(inputs, 3, outputs, weight_rules);
+    sparse_gradient_test("Embedding: 6 Input, 3 Embedding, 2 Output", genome, input_tokens, output_values);
+    delete genome;
+}
@@ -6,6 +6,12 @@
 #   --random_sequence_length: use uniform random chunk if this argument exists
 #   --sequence_length_lower_bound: lower bound for the uniform random chunksize range, 30 if not specified
 #   --sequence_length_upper_bound: upper bound for the uniform random chunksize range, 100 if not specified
+#   --windows_per_epoch: number of random chunks trained on each epoch, by default enough to cover the
+#                        training data once
+#
+# Chunks are new each epoch and are windows into the training series, so the data is never copied.
+# Overlapping fixed length chunks can be used instead with --train_sequence_length <length> and
+# --train_sequence_stride <stride>.
 
 
 cd build
@@ -0,0 +1,289 @@
+#include <chrono>
+#include <cstring>
+
+#include <deque>
+using std::deque;
+
+#include <map>
+using std::map;
+
+#include <set>
+using std::set;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "common/log.hxx"
+#include "common/process_arguments.hxx"
+#include "examm/examm.hxx"
+#include "rnn/generate_nn.hxx"
+#include "rnn/genome_wire.hxx"
+#include "socket_protocol.hxx"
+#include "time_series/time_series.hxx"
+#include "weights/weight_rules.hxx"
+
+/**
+ * Master for running EXAMM with workers (examm_socket_worker) which connect over TCP or a unix
+ * socket instead of MPI. Workers can join at any time, and the genomes held by a worker which
+ * disconnects or stops sending heartbeats are reissued to other workers.
+ */
+
+vector<string> arguments;
+
+EXAMM* examm;
+
+// compress the parameters sent in genome wire messages (--wire_compression)
+bool wire_compression = false;
+
+// seconds without any message from a worker before it is considered dead
+int32_t heartbeat_timeout = 30;
+
+struct WorkerConnection {
+    int32_t fd;
+    int32_t id;
+    vector<char> buffer;
+    std::chrono::time_point<std::chrono::steady_clock> last_seen;
+
+    // generation ids of the genomes this worker is training
+    set<int32_t> outstanding;
+};
+
+map<int32_t, WorkerConnection> workers;
+int32_t next_worker_id = 0;
+
+// genomes which have been sent to workers, by generation id; workers only send back the
+// trained parameters which are applied to these
+map<int32_t, RNN_Genome*> sent_genomes;
+
+// genomes held by workers that died, to be sent out again
+deque<int32_t> reissue_queue;
+
+bool search_finished = false;
+
+void accept_worker(int32_t listen_fd) {
+    int32_t fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+        Log::error("could not accept worker connection: %s\n", strerror(errno));
+        return;
+    }
+
+    WorkerConnection worker;
+    worker.fd = fd;
+    worker.id = next_worker_id++;
+    worker.last_seen = std::chrono::steady_clock::now();
+    workers[fd] = worker;
+
+    Log::info("worker %d connected, %d workers connected\n", worker.id, (int32_t) workers.size());
+}
+
+void remove_worker(int32_t fd, string reason) {
+    WorkerConnection& worker = workers[fd];
+    Log::info(
+        "removing worker %d (%s), reissuing %d genomes\n", worker.id, reason.c_str(),
+        (int32_t) worker.outstanding.size()
+    );
+
+    for (int32_t generation_id : worker.outstanding) {
+        reissue_queue.push_back(generation_id);
+    }
+
+    close(fd);
+    workers.erase(fd);
+}
+
+bool work_outstanding() {
+    for (auto it = workers.begin(); it != workers.end(); it++) {
+        if (it->second.outstanding.size() > 0) {
+            return true;
+        }
+    }
+    return reissue_queue.size() > 0;
+}
+
+/**
+ * Sends the worker a reissued genome if there is one, otherwise a new genome, otherwise
+ * tells it to wait (if other workers may still fail) or terminate.
+ */
+bool handle_work_request(WorkerConnection& worker) {
+    RNN_Genome* genome = NULL;
+
+    if (reissue_queue.size() > 0) {
+        genome = sent_genomes[reissue_queue.front()];
+        reissue_queue.pop_front();
+        Log::info("reissuing genome %d to worker %d\n", genome->get_generation_id(), worker.id);
+    } else if (!search_finished) {
+        genome = examm->generate_genome();
+        if (genome == NULL) {
+            search_finished = true;
+        } else {
+            sent_genomes[genome->get_generation_id()] = genome;
+        }
+    }
+
+    if (genome == NULL) {
+        if (work_outstanding()) {
+            return send_socket_message(worker.fd, SOCKET_WAIT, vector<char>());
+        } else {
+            Log::info("terminating worker: %d\n", worker.id);
+            return send_socket_message(worker.fd, SOCKET_TERMINATE, vector<char>());
+        }
+    }
+
+    vector<char> message;
+    GenomeWire::write_genome(genome, wire_compression, message);
+    worker.outstanding.insert(genome->get_generation_id());
+    return send_socket_message(worker.fd, SOCKET_GENOME, message);
+}
+
+void handle_result(WorkerConnection& worker, const vector<char>& message) {
+    int32_t generation_id = GenomeWire::get_generation_id(&message[0], (int32_t) message.size());
+
+    if (worker.outstanding.count(generation_id) == 0 || sent_genomes.count(generation_id) == 0) {
+        Log::warning("ignoring result from worker %d for genome %d it was not training\n", worker.id, generation_id);
+        return;
+    }
+    worker.outstanding.erase(generation_id);
+
+    RNN_Genome* genome = sent_genomes[generation_id];
+    sent_genomes.erase(generation_id);
+    GenomeWire::read_result(&message[0], (int32_t) message.size(), genome);
+
+    examm->insert_genome(genome);
+
+    // delete the genome as it won't be used again, a copy was inserted
+    delete genome;
+}
+
+/**
+ * Handles all complete messages in the worker's buffer, returning false if the worker
+ * should be removed.
+ */
+bool handle_messages(WorkerConnection& worker) {
+    int32_t type;
+    vector<char> payload;
+    bool corrupt;
+
+    while (extract_socket_message(worker.buffer, type, payload, corrupt)) {
+        if (type == SOCKET_WORK_REQUEST) {
+            if (!handle_work_request(worker)) {
+                return false;
+            }
+        } else if (type == SOCKET_RESULT) {
+            handle_result(worker, payload);
+        } else if (type == SOCKET_HEARTBEAT) {
+            Log::debug("heartbeat from worker %d\n", worker.id);
+        } else {
+            Log::error("received message with unknown type %d from worker %d\n", type, worker.id);
+            return false;
+        }
+    }
+
+    return !corrupt;
+}
+
+void master(int32_t listen_fd) {
+    while (!(search_finished && !work_outstanding())) {
+        vector<struct pollfd> poll_fds;
+        poll_fds.push_back({listen_fd, POLLIN, 0});
+        for (auto it = workers.begin(); it != workers.end(); it++) {
+            poll_fds.push_back({it->first, POLLIN, 0});
+        }
+
+        // wake up at least every second to check the heartbeats
+        int32_t ready = poll(poll_fds.data(), poll_fds.size(), 1000);
+        if (ready < 0 && errno != EINTR) {
+            Log::fatal("ERROR: poll failed: %s\n", strerror(errno));
+            exit(1);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+
+        for (int32_t i = 1; i < (int32_t) poll_fds.size(); i++) {
+            if (poll_fds[i].revents == 0) {
+                continue;
+            }
+
+            int32_t fd = poll_fds[i].fd;
+            WorkerConnection& worker = workers[fd];
+
+            char bytes[65536];
+            ssize_t received = recv(fd, bytes, sizeof(bytes), 0);
+            if (received <= 0) {
+                remove_worker(fd, "disconnected");
+                continue;
+            }
+
+            worker.buffer.insert(worker.buffer.end(), bytes, bytes + received);
+            worker.last_seen = now;
+
+            if (!handle_messages(worker)) {
+                remove_worker(fd, "connection error");
+            }
+        }
+
+        vector<int32_t> timed_out;
+        for (auto it = workers.begin(); it != workers.end(); it++) {
+            if (std::chrono::duration_cast<std::chrono::seconds>(now - it->second.last_seen).count()
+                > heartbeat_timeout) {
+                timed_out.push_back(it->first);
+            }
+        }
+        for (int32_t fd : timed_out) {
+            remove_worker(fd, "heartbeat timed out");
+        }
+
+        if (poll_fds[0].revents & POLLIN) {
+            accept_worker(listen_fd);
+        }
+    }
+
+    // tell the workers which are still connected that the search is done
+    for (auto it = workers.begin(); it != workers.end(); it++) {
+        send_socket_message(it->first, SOCKET_TERMINATE, vector<char>());
+        close(it->first);
+    }
+    workers.clear();
+}
+
+int main(int argc, char** argv) {
+    arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_id("main");
+
+    wire_compression = argument_exists(arguments, "--wire_compression");
+    get_argument(arguments, "--heartbeat_timeout", false, heartbeat_timeout);
+
+    TimeSeriesSets* time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
+
+    WeightRules* weight_rules = new WeightRules();
+    weight_rules->initialize_from_args(arguments);
+
+    RNN_Genome* seed_genome = get_seed_genome(arguments, time_series_sets, weight_rules);
+
+    write_time_series_to_file(arguments, time_series_sets);
+    examm = generate_examm_from_arguments(arguments, time_series_sets, weight_rules, seed_genome);
+
+    int32_t listen_fd = listen_on_socket(arguments);
+    master(listen_fd);
+    close(listen_fd);
+
+    string unix_socket_path;
+    if (get_argument(arguments, "--unix_socket", false, unix_socket_path)) {
+        unlink(unix_socket_path.c_str());
+    }
+
+    Log::info("completed!\n");
+    Log::release_id("main");
+
+    delete time_series_sets;
+    return 0;
+}
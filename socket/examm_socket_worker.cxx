@@ -0,0 +1,166 @@
+#include <chrono>
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <mutex>
+using std::mutex;
+using std::unique_lock;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include <unistd.h>
+
+#include "common/log.hxx"
+#include "common/process_arguments.hxx"
+#include "rnn/genome_wire.hxx"
+#include "socket_protocol.hxx"
+#include "time_series/time_series.hxx"
+#include "weights/weight_update.hxx"
+
+/**
+ * Worker for examm_socket_master. Takes the same time series and training arguments as the
+ * master, plus the master's --port (and --host) or --unix_socket. Workers can be started and
+ * stopped at any time during the search.
+ */
+
+vector<string> arguments;
+
+WeightUpdate* weight_update_method;
+WindowSampler* window_sampler;
+
+// compress the parameters sent in genome wire messages (--wire_compression)
+bool wire_compression = false;
+
+// seconds between heartbeats sent to the master
+int32_t heartbeat_interval = 5;
+
+int32_t master_fd;
+
+// the heartbeat thread and the training loop both write to the master
+mutex send_mutex;
+
+mutex heartbeat_mutex;
+condition_variable heartbeat_condition;
+bool finished = false;
+
+TimeSeriesTensor training_inputs;
+TimeSeriesTensor training_outputs;
+TimeSeriesTensor validation_inputs;
+TimeSeriesTensor validation_outputs;
+
+bool send_to_master(int32_t type, const vector<char>& payload) {
+    send_mutex.lock();
+    bool sent = send_socket_message(master_fd, type, payload);
+    send_mutex.unlock();
+    return sent;
+}
+
+void heartbeat_thread() {
+    unique_lock<mutex> lock(heartbeat_mutex);
+    while (!finished) {
+        heartbeat_condition.wait_for(lock, std::chrono::seconds(heartbeat_interval));
+        if (!finished) {
+            // if the master went away the training loop will find out on its next receive
+            send_to_master(SOCKET_HEARTBEAT, vector<char>());
+        }
+    }
+}
+
+void worker() {
+    while (true) {
+        Log::debug("sending work request!\n");
+        if (!send_to_master(SOCKET_WORK_REQUEST, vector<char>())) {
+            Log::info("lost connection to the master, exiting\n");
+            break;
+        }
+
+        int32_t type;
+        vector<char> message;
+        if (!receive_socket_message(master_fd, type, message)) {
+            Log::info("lost connection to the master, exiting\n");
+            break;
+        }
+
+        if (type == SOCKET_TERMINATE) {
+            Log::info("received terminate message, exiting\n");
+            break;
+
+        } else if (type == SOCKET_WAIT) {
+            Log::debug("no work available, waiting\n");
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        } else if (type == SOCKET_GENOME) {
+            RNN_Genome* genome = GenomeWire::read_genome(&message[0], (int32_t) message.size());
+
+            // have each genome write the backproagation to a separate log file
+            string log_id = "genome_" + to_string(genome->get_generation_id()) + "_worker";
+            Log::set_id(log_id);
+            genome->backpropagate_stochastic(
+                training_inputs, training_outputs, validation_inputs, validation_outputs, weight_update_method,
+                window_sampler
+            );
+            Log::release_id(log_id);
+
+            // go back to the worker's log for communication with the master
+            Log::set_id("worker");
+
+            GenomeWire::write_result(genome, wire_compression, message);
+            delete genome;
+
+            if (!send_to_master(SOCKET_RESULT, message)) {
+                Log::info("lost connection to the master, exiting\n");
+                break;
+            }
+
+        } else {
+            Log::fatal("ERROR: received message with unknown type: %d\n", type);
+            exit(1);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_id("worker");
+
+    wire_compression = argument_exists(arguments, "--wire_compression");
+    get_argument(arguments, "--heartbeat_interval", false, heartbeat_interval);
+
+    TimeSeriesSets* time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
+    get_train_validation_data(
+        arguments, time_series_sets, training_inputs, training_outputs, validation_inputs, validation_outputs
+    );
+
+    weight_update_method = new WeightUpdate();
+    weight_update_method->generate_from_arguments(arguments);
+
+    window_sampler = new WindowSampler();
+    window_sampler->generate_from_arguments(arguments);
+
+    master_fd = connect_to_master(arguments);
+
+    thread heartbeat(heartbeat_thread);
+    worker();
+
+    heartbeat_mutex.lock();
+    finished = true;
+    heartbeat_mutex.unlock();
+    heartbeat_condition.notify_all();
+    heartbeat.join();
+
+    close(master_fd);
+
+    Log::release_id("worker");
+    delete time_series_sets;
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include <cstring>
+using std::memcpy;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "socket_protocol.hxx"
+
+int32_t listen_on_socket(const vector<string>& arguments) {
+    int32_t fd;
+
+    string unix_socket_path;
+    if (get_argument(arguments, "--unix_socket", false, unix_socket_path)) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            Log::fatal("ERROR: could not create unix socket: %s\n", strerror(errno));
+            exit(1);
+        }
+
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (unix_socket_path.size() >= sizeof(address.sun_path)) {
+            Log::fatal("ERROR: unix socket path '%s' is too long\n", unix_socket_path.c_str());
+            exit(1);
+        }
+        strcpy(address.sun_path, unix_socket_path.c_str());
+
+        // remove a socket file left over from a previous run
+        unlink(unix_socket_path.c_str());
+
+        if (bind(fd, (struct sockaddr*) &address, sizeof(address)) < 0) {
+            Log::fatal("ERROR: could not bind unix socket '%s': %s\n", unix_socket_path.c_str(), strerror(errno));
+            exit(1);
+        }
+        Log::info("listening on unix socket: '%s'\n", unix_socket_path.c_str());
+
+    } else {
+        int32_t port;
+        get_argument(arguments, "--port", true, port);
+
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            Log::fatal("ERROR: could not create TCP socket: %s\n", strerror(errno));
+            exit(1);
+        }
+
+        int32_t reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+
+        if (bind(fd, (struct sockaddr*) &address, sizeof(address)) < 0) {
+            Log::fatal("ERROR: could not bind TCP port %d: %s\n", port, strerror(errno));
+            exit(1);
+        }
+        Log::info("listening on TCP port: %d\n", port);
+    }
+
+    if (listen(fd, 128) < 0) {
+        Log::fatal("ERROR: could not listen on socket: %s\n", strerror(errno));
+        exit(1);
+    }
+
+    return fd;
+}
+
+int32_t connect_to_master(const vector<string>& arguments) {
+    int32_t fd;
+
+    string unix_socket_path;
+    if (get_argument(arguments, "--unix_socket", false, unix_socket_path)) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            Log::fatal("ERROR: could not create unix socket: %s\n", strerror(errno));
+            exit(1);
+        }
+
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (unix_socket_path.size() >= sizeof(address.sun_path)) {
+            Log::fatal("ERROR: unix socket path '%s' is too long\n", unix_socket_path.c_str());
+            exit(1);
+        }
+        strcpy(address.sun_path, unix_socket_path.c_str());
+
+        if (connect(fd, (struct sockaddr*) &address, sizeof(address)) < 0) {
+            Log::fatal("ERROR: could not connect to unix socket '%s': %s\n", unix_socket_path.c_str(), strerror(errno));
+            exit(1);
+        }
+        Log::info("connected to master on unix socket: '%s'\n", unix_socket_path.c_str());
+
+    } else {
+        string host = "127.0.0.1";
+        get_argument(arguments, "--host", false, host);
+        string port;
+        get_argument(arguments, "--port", true, port);
+
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        struct addrinfo* addresses;
+        int32_t result = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+        if (result != 0) {
+            Log::fatal(
+                "ERROR: could not resolve master '%s:%s': %s\n", host.c_str(), port.c_str(), gai_strerror(result)
+            );
+            exit(1);
+        }
+
+        fd = -1;
+        for (struct addrinfo* address = addresses; address != NULL; address = address->ai_next) {
+            fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (fd < 0) {
+                continue;
+            }
+            if (connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+                break;
+            }
+            close(fd);
+            fd = -1;
+        }
+        freeaddrinfo(addresses);
+
+        if (fd < 0) {
+            Log::fatal("ERROR: could not connect to master '%s:%s'\n", host.c_str(), port.c_str());
+            exit(1);
+        }
+
+        int32_t no_delay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+        Log::info("connected to master on: '%s:%s'\n", host.c_str(), port.c_str());
+    }
+
+    return fd;
+}
+
+static bool send_all(int32_t fd, const char* bytes, int64_t length) {
+    while (length > 0) {
+        // MSG_NOSIGNAL so a closed connection is an error instead of a SIGPIPE
+        ssize_t sent = send(fd, bytes, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        bytes += sent;
+        length -= sent;
+    }
+    return true;
+}
+
+static bool receive_all(int32_t fd, char* bytes, int64_t length) {
+    while (length > 0) {
+        ssize_t received = recv(fd, bytes, length, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        bytes += received;
+        length -= received;
+    }
+    return true;
+}
+
+bool send_socket_message(int32_t fd, int32_t type, const vector<char>& payload) {
+    vector<char> message(SOCKET_HEADER_LENGTH + payload.size());
+    int32_t length = (int32_t) payload.size();
+    memcpy(&message[0], &type, sizeof(int32_t));
+    memcpy(&message[4], &length, sizeof(int32_t));
+    if (length > 0) {
+        memcpy(&message[SOCKET_HEADER_LENGTH], payload.data(), length);
+    }
+
+    return send_all(fd, message.data(), message.size());
+}
+
+bool receive_socket_message(int32_t fd, int32_t& type, vector<char>& payload) {
+    char header[SOCKET_HEADER_LENGTH];
+    if (!receive_all(fd, header, SOCKET_HEADER_LENGTH)) {
+        return false;
+    }
+
+    int32_t length;
+    memcpy(&type, &header[0], sizeof(int32_t));
+    memcpy(&length, &header[4], sizeof(int32_t));
+    if (length < 0 || length > SOCKET_MAX_MESSAGE_LENGTH) {
+        Log::error("received socket message with invalid length: %d\n", length);
+        return false;
+    }
+
+    payload.resize(length);
+    return length == 0 || receive_all(fd, payload.data(), length);
+}
+
+bool extract_socket_message(vector<char>& buffer, int32_t& type, vector<char>& payload, bool& corrupt) {
+    corrupt = false;
+    if (buffer.size() < SOCKET_HEADER_LENGTH) {
+        return false;
+    }
+
+    int32_t length;
+    memcpy(&type, &buffer[0], sizeof(int32_t));
+    memcpy(&length, &buffer[4], sizeof(int32_t));
+    if (length < 0 || length > SOCKET_MAX_MESSAGE_LENGTH) {
+        corrupt = true;
+        return false;
+    }
+
+    if ((int64_t) buffer.size() < SOCKET_HEADER_LENGTH + (int64_t) length) {
+        return false;
+    }
+
+    payload.assign(buffer.begin() + SOCKET_HEADER_LENGTH, buffer.begin() + SOCKET_HEADER_LENGTH + length);
+    buffer.erase(buffer.begin(), buffer.begin() + SOCKET_HEADER_LENGTH + length);
+    return true;
+}
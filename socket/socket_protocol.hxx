@@ -0,0 +1,61 @@
+#ifndef EXAMM_SOCKET_PROTOCOL_HXX
+#define EXAMM_SOCKET_PROTOCOL_HXX
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+/**
+ * Messages between examm_socket_master and examm_socket_worker are framed with an 8 byte
+ * header: the message type and the payload length (both int32_t), followed by the payload.
+ *
+ *  - WORK_REQUEST (worker -> master): empty, asks for a genome to train.
+ *  - GENOME (master -> worker): a genome wire message (rnn/genome_wire.hxx) with the full genome.
+ *  - RESULT (worker -> master): a genome wire message with the trained parameters.
+ *  - HEARTBEAT (worker -> master): empty, sent periodically so the master knows the worker is alive.
+ *  - WAIT (master -> worker): empty, no work is available right now but the search is not done.
+ *  - TERMINATE (master -> worker): empty, the search is done.
+ */
+#define SOCKET_WORK_REQUEST 1
+#define SOCKET_GENOME       2
+#define SOCKET_RESULT       3
+#define SOCKET_HEARTBEAT    4
+#define SOCKET_WAIT         5
+#define SOCKET_TERMINATE    6
+
+#define SOCKET_HEADER_LENGTH 8
+
+// messages are never expected to be this large, so a larger length means a corrupt stream
+#define SOCKET_MAX_MESSAGE_LENGTH (1 << 30)
+
+/**
+ * Opens a listening socket, on --unix_socket <path> if given, otherwise on TCP --port <port>.
+ */
+int32_t listen_on_socket(const vector<string>& arguments);
+
+/**
+ * Connects to the master, on --unix_socket <path> if given, otherwise on TCP --host <host>
+ * (default 127.0.0.1) and --port <port>.
+ */
+int32_t connect_to_master(const vector<string>& arguments);
+
+/**
+ * Sends a framed message, returning false if the connection was lost.
+ */
+bool send_socket_message(int32_t fd, int32_t type, const vector<char>& payload);
+
+/**
+ * Blocks until a full message has been received, returning false if the connection was lost.
+ */
+bool receive_socket_message(int32_t fd, int32_t& type, vector<char>& payload);
+
+/**
+ * Removes the first complete message from a buffer of received bytes, if there is one.
+ * Returns false if the buffer does not yet hold a complete message. Sets corrupt if the
+ * header is invalid.
+ */
+bool extract_socket_message(vector<char>& buffer, int32_t& type, vector<char>& payload, bool& corrupt);
+
+#endif
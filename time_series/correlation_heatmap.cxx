@@ -39,6 +39,19 @@ int main(int argc, char** argv) {
 
     vector<string> parameter_names = time_series_sets->get_input_parameter_names();
 
+    vector<string> correlated_names;
+    for (int32_t j = 0; j < (int32_t) parameter_names.size(); j++) {
+        if (parameter_names[j].compare(target_parameter_name) != 0) {
+            correlated_names.push_back(parameter_names[j]);
+        }
+    }
+
+    // correlations[series][0][parameter][lag] of the target parameter with the others
+    vector<vector<vector<vector<double> > > > correlations;
+    time_series_sets->get_lagged_correlations(
+        vector<string>(1, target_parameter_name), correlated_names, max_lag, correlations
+    );
+
     for (int32_t i = 0; i < time_series_sets->get_number_series(); i++) {
         TimeSeriesSet* tss = time_series_sets->get_set(i);
 
@@ -62,22 +75,16 @@ int main(int argc, char** argv) {
         ofstream correlations_csv(correlations_csv_filename);
         ofstream headers_txt(headers_txt_filename);
 
-        for (int32_t j = 0; j < (int32_t) parameter_names.size(); j++) {
-            if (parameter_names[j].compare(target_parameter_name) == 0) {
-                continue;
-            }
-
+        for (int32_t j = 0; j < (int32_t) correlated_names.size(); j++) {
             for (int32_t k = 1; k < max_lag; k++) {
-                double correlation = tss->get_correlation(target_parameter_name, parameter_names[j], k);
-
                 if (k > 1) {
                     correlations_csv << ",";
                 }
-                correlations_csv << correlation;
+                correlations_csv << correlations[i][0][j][k];
             }
             correlations_csv << endl;
 
-            headers_txt << parameter_names[j] << endl;
+            headers_txt << correlated_names[j] << endl;
         }
 
         correlations_csv.close();
@@ -0,0 +1,75 @@
+#include <cmath>
+
+#include <complex>
+using std::complex;
+using std::conj;
+using std::polar;
+
+#include <utility>
+using std::swap;
+
+#include <vector>
+using std::vector;
+
+#include "common/log.hxx"
+#include "fft.hxx"
+
+FFT::FFT(int32_t minimum_size) {
+    size = 1;
+    while (size < minimum_size) {
+        size *= 2;
+    }
+
+    // each root is calculated directly, rather than by repeated multiplication, so the error
+    // does not grow with the size
+    roots.resize(size / 2);
+    for (int32_t i = 0; i < size / 2; i++) {
+        roots[i] = polar(1.0, -2.0 * M_PI * i / size);
+    }
+}
+
+int32_t FFT::get_size() const {
+    return size;
+}
+
+void FFT::transform(vector<complex<double> >& values, bool inverse) const {
+    if ((int32_t) values.size() != size) {
+        Log::fatal("ERROR: FFT of %d values, but the FFT size is %d\n", (int32_t) values.size(), size);
+        exit(1);
+    }
+
+    // bit reversal permutation
+    for (int32_t i = 1, j = 0; i < size; i++) {
+        int32_t bit = size >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+
+        if (i < j) {
+            swap(values[i], values[j]);
+        }
+    }
+
+    for (int32_t length = 2; length <= size; length *= 2) {
+        int32_t half = length / 2;
+        int32_t root_stride = size / length;
+
+        for (int32_t start = 0; start < size; start += length) {
+            for (int32_t k = 0; k < half; k++) {
+                complex<double> root = inverse ? conj(roots[k * root_stride]) : roots[k * root_stride];
+                complex<double> even = values[start + k];
+                complex<double> odd = values[start + k + half] * root;
+
+                values[start + k] = even + odd;
+                values[start + k + half] = even - odd;
+            }
+        }
+    }
+
+    if (inverse) {
+        for (int32_t i = 0; i < size; i++) {
+            values[i] /= size;
+        }
+    }
+}
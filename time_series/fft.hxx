@@ -0,0 +1,32 @@
+#ifndef EXAMM_FFT_HXX
+#define EXAMM_FFT_HXX
+
+#include <complex>
+using std::complex;
+
+#include <vector>
+using std::vector;
+
+/**
+ * An iterative radix-2 fast Fourier transform of a fixed size (the smallest power of two which
+ * is at least the requested size), with the roots of unity calculated once so one FFT can be
+ * shared by any number of threads.
+ */
+class FFT {
+   private:
+    int32_t size;
+    vector<complex<double> > roots;
+
+   public:
+    explicit FFT(int32_t minimum_size);
+
+    int32_t get_size() const;
+
+    /**
+     * Transforms values (which must have get_size() values) in place. The inverse transform is
+     * scaled by 1 / size, so it undoes the forward transform.
+     */
+    void transform(vector<complex<double> >& values, bool inverse) const;
+};
+
+#endif
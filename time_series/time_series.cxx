@@ -1,9 +1,20 @@
 #include <algorithm>
+#include <atomic>
+#include <charconv>
 #include <cmath>
+#include <cstring>
 using std::find;
 
+#include <complex>
+using std::complex;
+using std::conj;
+
 #include <fstream>
 using std::ifstream;
+using std::ofstream;
+
+#include <functional>
+using std::function;
 
 #include <iomanip>
 using std::setw;
@@ -24,65 +35,147 @@ using std::invalid_argument;
 #include <string>
 using std::string;
 
+#include <thread>
+using std::thread;
+
 #include <vector>
 using std::vector;
 
+// for memory mapping the time series files
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "common/arguments.hxx"
+#include "common/files.hxx"
 #include "common/log.hxx"
+#include "fft.hxx"
 #include "time_series.hxx"
 
-TimeSeries::TimeSeries(string _name) {
-    name = _name;
+TimeSeries::TimeSeries(string _name) : name(_name), mapped_values(NULL), number_mapped_values(0) {
+}
+
+const double* TimeSeries::get_data() const {
+    return mapped_values != NULL ? mapped_values : values.data();
+}
+
+void TimeSeries::copy_mapped_values() {
+    if (mapped_values != NULL) {
+        values.assign(mapped_values, mapped_values + number_mapped_values);
+        mapped_values = NULL;
+        number_mapped_values = 0;
+    }
 }
 
 void TimeSeries::add_value(double value) {
+    copy_mapped_values();
     values.push_back(value);
 }
 
+void TimeSeries::reserve(int64_t number_values) {
+    copy_mapped_values();
+    values.reserve(number_values);
+}
+
 double TimeSeries::get_value(int32_t i) {
-    return values[i];
+    return get_data()[i];
 }
 
+// values are summarized in blocks small enough to stay in the L1 cache, each with this many
+// independent accumulators so the sums, mins and maxs do not wait on each other
+#define TIME_SERIES_STATISTICS_BLOCK 512
+#define TIME_SERIES_STATISTICS_LANES 4
+
+/**
+ * Calculates the statistics in a single pass over the values. Each block of values has its
+ * average and sum of squared differences calculated while it is in cache, and the blocks are
+ * merged in order with Chan et al.'s parallel form of Welford's algorithm.
+ */
 void TimeSeries::calculate_statistics() {
+    const int32_t lanes = TIME_SERIES_STATISTICS_LANES;
+
     min = numeric_limits<double>::max();
     min_change = numeric_limits<double>::max();
     average = 0.0;
     max = -numeric_limits<double>::max();
     max_change = -numeric_limits<double>::max();
 
-    std_dev = 0.0;
-    variance = 0.0;
-
-    for (uint32_t i = 0; i < values.size(); i++) {
-        average += values[i];
-
-        if (min > values[i]) {
-            min = values[i];
+    double sum_squared_differences = 0.0;
+
+    const double* data = get_data();
+    int64_t number_values = get_number_values();
+    for (int64_t start = 0; start < number_values; start += TIME_SERIES_STATISTICS_BLOCK) {
+        int64_t block_size = std::min((int64_t) TIME_SERIES_STATISTICS_BLOCK, number_values - start);
+        const double* block = data + start;
+
+        double sums[lanes], squared_differences[lanes], mins[lanes], maxs[lanes], min_changes[lanes],
+            max_changes[lanes];
+        for (int32_t l = 0; l < lanes; l++) {
+            sums[l] = 0.0;
+            squared_differences[l] = 0.0;
+            mins[l] = min;
+            maxs[l] = max;
+            min_changes[l] = min_change;
+            max_changes[l] = max_change;
         }
-        if (max < values[i]) {
-            max = values[i];
+
+        // the sums, mins and maxs (and the changes below) of the values which do not fill all the
+        // lanes still go into their own lanes, the inner loops stop at the end of the block
+        int64_t full = block_size / lanes * lanes;
+        for (int64_t i = 0; i < block_size; i += lanes) {
+            for (int32_t l = 0; l < lanes && i + l < block_size; l++) {
+                double value = block[i + l];
+                sums[l] += value;
+                mins[l] = value < mins[l] ? value : mins[l];
+                maxs[l] = value > maxs[l] ? value : maxs[l];
+            }
         }
 
-        if (i > 0) {
-            double diff = values[i] - values[i - 1];
+        double block_sum = 0.0;
+        for (int32_t l = 0; l < lanes; l++) {
+            block_sum += sums[l];
+        }
+        double block_average = block_sum / block_size;
 
-            if (diff < min_change) {
-                min_change = diff;
+        for (int64_t i = 0; i < full; i += lanes) {
+            for (int32_t l = 0; l < lanes; l++) {
+                double diff = block[i + l] - block_average;
+                squared_differences[l] += diff * diff;
             }
-            if (diff > max_change) {
-                max_change = diff;
+        }
+        // only the squared differences of the values which do not fill all the lanes are added to the first
+        for (int64_t i = full; i < block_size; i++) {
+            double diff = block[i] - block_average;
+            squared_differences[0] += diff * diff;
+        }
+
+        // the change into the first value of a block is from the last value of the previous one
+        for (int64_t i = (start == 0 ? 1 : 0); i < block_size; i += lanes) {
+            for (int32_t l = 0; l < lanes && i + l < block_size; l++) {
+                double diff = block[i + l] - block[i + l - 1];
+                min_changes[l] = diff < min_changes[l] ? diff : min_changes[l];
+                max_changes[l] = diff > max_changes[l] ? diff : max_changes[l];
             }
         }
-    }
 
-    average /= values.size();
+        double block_squared_differences = 0.0;
+        for (int32_t l = 0; l < lanes; l++) {
+            block_squared_differences += squared_differences[l];
+            min = mins[l] < min ? mins[l] : min;
+            max = maxs[l] > max ? maxs[l] : max;
+            min_change = min_changes[l] < min_change ? min_changes[l] : min_change;
+            max_change = max_changes[l] > max_change ? max_changes[l] : max_change;
+        }
 
-    for (uint32_t i = 0; i < values.size(); i++) {
-        double diff = values[i] - average;
-        variance += diff * diff;
+        double delta = block_average - average;
+        average += delta * block_size / (start + block_size);
+        sum_squared_differences +=
+            block_squared_differences + delta * delta * start * block_size / (start + block_size);
     }
-    variance /= values.size() - 1;
 
+    variance = sum_squared_differences / (number_values - 1);
     std_dev = sqrt(variance);
 }
 
@@ -94,7 +187,7 @@ void TimeSeries::print_statistics() {
 }
 
 int32_t TimeSeries::get_number_values() const {
-    return values.size();
+    return mapped_values != NULL ? number_mapped_values : values.size();
 }
 
 double TimeSeries::get_min() const {
@@ -130,23 +223,33 @@ void TimeSeries::normalize_min_max(double min, double max) {
         "normalizing time series '%s' with min: %lf and max: %lf, series min: %lf, series max: %lf\n", name.c_str(),
         min, max, this->min, this->max
     );
+    copy_mapped_values();
+
+    // only look for the values outside of the bounds if there are any, so normalizing is a
+    // simple loop the compiler can vectorize
+    if (this->min < min || this->max > max) {
+        for (int32_t i = 0; i < (int32_t) values.size(); i++) {
+            if (values[i] < min) {
+                Log::warning(
+                    "normalizing series %s, value[%d] %lf was less than min for normalization: %lf\n", name.c_str(), i,
+                    values[i], min
+                );
+            }
 
-    for (int32_t i = 0; i < (int32_t) values.size(); i++) {
-        if (values[i] < min) {
-            Log::warning(
-                "normalizing series %s, value[%d] %lf was less than min for normalization: %lf\n", name.c_str(), i,
-                values[i], min
-            );
-        }
-
-        if (values[i] > max) {
-            Log::warning(
-                "normalizing series %s, value[%d] %lf was greater than max for normalization: %lf\n", name.c_str(), i,
-                values[i], max
-            );
+            if (values[i] > max) {
+                Log::warning(
+                    "normalizing series %s, value[%d] %lf was greater than max for normalization: %lf\n",
+                    name.c_str(), i, values[i], max
+                );
+            }
         }
+    }
 
-        values[i] = (values[i] - min) / (max - min);
+    double* data = values.data();
+    int32_t number_values = (int32_t) values.size();
+    double range = max - min;
+    for (int32_t i = 0; i < number_values; i++) {
+        data[i] = (data[i] - min) / range;
     }
 }
 
@@ -157,16 +260,20 @@ void TimeSeries::normalize_avg_std_dev(double avg, double std_dev, double norm_m
         "std_dev: %lf\n",
         name.c_str(), avg, std_dev, norm_max, this->average, this->std_dev
     );
+    copy_mapped_values();
 
-    for (int32_t i = 0; i < (int32_t) values.size(); i++) {
-        values[i] = ((values[i] - avg) / std_dev) / norm_max;
+    double* data = values.data();
+    int32_t number_values = (int32_t) values.size();
+    for (int32_t i = 0; i < number_values; i++) {
+        data[i] = ((data[i] - avg) / std_dev) / norm_max;
     }
 }
 
 void TimeSeries::cut(int32_t start, int32_t stop) {
-    auto first = values.begin() + start;
-    auto last = values.begin() + stop;
-    values = vector<double>(first, last);
+    const double* data = get_data();
+    values = vector<double>(data + start, data + stop);
+    mapped_values = NULL;
+    number_mapped_values = 0;
 
     // update the statistics after the cut
     calculate_statistics();
@@ -175,11 +282,13 @@ void TimeSeries::cut(int32_t start, int32_t stop) {
 double TimeSeries::get_correlation(const TimeSeries* other, int32_t lag) const {
     double other_average = other->get_average();
 
-    int32_t length = fmin(values.size(), other->values.size()) - lag;
+    int32_t length = fmin(get_number_values(), other->get_number_values()) - lag;
 
+    const double* data = get_data();
+    const double* other_data = other->get_data();
     double covariance_sum = 0.0;
     for (int32_t i = 0; i < length; i++) {
-        covariance_sum += (values[i + lag] - average) * (other->values[i] - other_average);
+        covariance_sum += (data[i + lag] - average) * (other_data[i] - other_average);
     }
 
     double other_variance = other->get_variance();
@@ -193,7 +302,7 @@ double TimeSeries::get_correlation(const TimeSeries* other, int32_t lag) const {
     return correlation;
 }
 
-TimeSeries::TimeSeries() {
+TimeSeries::TimeSeries() : mapped_values(NULL), number_mapped_values(0) {
 }
 
 TimeSeries* TimeSeries::copy() {
@@ -208,13 +317,14 @@ TimeSeries* TimeSeries::copy() {
     ts->min_change = min_change;
     ts->max_change = max_change;
 
-    ts->values = values;
+    // copies never share the cache's memory, so they can outlive it
+    ts->values.assign(get_data(), get_data() + get_number_values());
 
     return ts;
 }
 
 void TimeSeries::copy_values(vector<double>& series) {
-    series = values;
+    series.assign(get_data(), get_data() + get_number_values());
 }
 
 void string_split(const string& s, char delim, vector<string>& result) {
@@ -227,6 +337,53 @@ void string_split(const string& s, char delim, vector<string>& result) {
     }
 }
 
+static const char* find_line_end(const char* position, const char* end) {
+    const char* line_end = (const char*) memchr(position, '\n', end - position);
+    return line_end == NULL ? end : line_end;
+}
+
+/**
+ * Parses a double the way stod does: leading whitespace and a '+' are allowed and
+ * anything after the number (e.g., a '\r') is ignored.
+ */
+bool parse_time_series_value(const char* start, const char* end, double& value) {
+    while (start < end && (*start == ' ' || *start == '\t')) {
+        start++;
+    }
+    if (start < end && *start == '+') {
+        start++;
+    }
+
+    std::from_chars_result result = std::from_chars(start, end, value);
+    return result.ec == std::errc();
+}
+
+/**
+ * Runs task(0) to task(number_tasks - 1) spread over the hardware threads, with the threads
+ * logging under the calling thread's id.
+ */
+static void run_in_parallel(int32_t number_tasks, const function<void(int32_t)>& task) {
+    std::atomic<int32_t> next_task(0);
+    string log_id = Log::get_id();
+
+    auto run_tasks = [&]() {
+        Log::set_id(log_id);
+        for (int32_t i = next_task++; i < number_tasks; i = next_task++) {
+            task(i);
+        }
+    };
+
+    int32_t number_threads = std::min(number_tasks, (int32_t) thread::hardware_concurrency());
+    vector<thread> threads;
+    for (int32_t i = 1; i < number_threads; i++) {
+        threads.push_back(thread(run_tasks));
+    }
+    run_tasks();
+    for (int32_t i = 0; i < (int32_t) threads.size(); i++) {
+        threads[i].join();
+    }
+}
+
 void TimeSeriesSet::add_time_series(string name) {
     if (time_series.count(name) == 0) {
         time_series[name] = new TimeSeries(name);
@@ -242,13 +399,31 @@ TimeSeriesSet::TimeSeriesSet(string _filename, const vector<string>& _fields) {
     filename = _filename;
     fields = _fields;
 
-    ifstream ts_file(filename);
+    // the file is memory mapped and parsed in place, rather than copying each line and value into strings
+    int32_t fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        Log::fatal("ERROR: could not open time series file '%s': %s\n", filename.c_str(), strerror(errno));
+        exit(1);
+    }
 
-    string line;
-    if (!getline(ts_file, line)) {
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
         Log::error("ERROR! Could not get headers from the CSV file. File potentially empty!\n");
         exit(1);
     }
+    size_t file_size = file_stat.st_size;
+
+    const char* file_data = (const char*) mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (file_data == MAP_FAILED) {
+        Log::fatal("ERROR: could not memory map time series file '%s': %s\n", filename.c_str(), strerror(errno));
+        exit(1);
+    }
+    madvise((void*) file_data, file_size, MADV_SEQUENTIAL);
+    const char* file_end = file_data + file_size;
+
+    const char* line_end = find_line_end(file_data, file_end);
+    string line(file_data, line_end);
 
     vector<string> file_fields;
     string_split(line, ',', file_fields);
@@ -300,44 +475,74 @@ TimeSeriesSet::TimeSeriesSet(string _filename, const vector<string>& _fields) {
         add_time_series(fields[i]);
     }
 
+    // the series each column of the file is added to, or NULL if it is not used
+    vector<TimeSeries*> column_series(file_fields.size(), NULL);
+    for (int32_t i = 0; i < (int32_t) file_fields.size(); i++) {
+        if (file_fields_used[i]) {
+            column_series[i] = time_series[file_fields[i]];
+        }
+    }
+
+    // pre-size the columns with an upper bound on the number of rows
+    int64_t number_lines = std::count(line_end, file_end, '\n') + 1;
+    for (auto series = time_series.begin(); series != time_series.end(); series++) {
+        series->second->reserve(number_lines);
+    }
+
     int32_t row = 1;
-    while (getline(ts_file, line)) {
-        if (line.size() == 0 || line[0] == '#' || row < 0) {
+    const char* position = line_end < file_end ? line_end + 1 : file_end;
+    while (position < file_end) {
+        line_end = find_line_end(position, file_end);
+
+        if (line_end == position || position[0] == '#') {
             row++;
+            position = line_end + 1;
             continue;
         }
 
-        vector<string> parts;
-        string_split(line, ',', parts);
+        // count the values the same way as splitting the line with getline would,
+        // which does not give an empty value after a trailing comma
+        int32_t number_values = (int32_t) std::count(position, line_end, ',') + 1;
+        if (line_end[-1] == ',') {
+            number_values--;
+        }
 
-        if (parts.size() != file_fields.size()) {
+        if (number_values != (int32_t) file_fields.size()) {
             Log::fatal(
                 "ERROR! number of values in row %d was %d, but there were %d fields in the header.\n", row,
-                parts.size(), file_fields.size()
+                number_values, file_fields.size()
             );
             exit(1);
         }
 
-        for (int32_t i = 0; i < (int32_t) parts.size(); i++) {
-            if (!file_fields_used[i]) {
-                continue;
+        const char* value_start = position;
+        for (int32_t i = 0; i < number_values; i++) {
+            const char* value_end = (const char*) memchr(value_start, ',', line_end - value_start);
+            if (value_end == NULL) {
+                value_end = line_end;
             }
 
-            Log::trace("parts[%d]: %s being added to '%s'\n", i, parts[i].c_str(), file_fields[i].c_str());
-
-            try {
-                time_series[file_fields[i]]->add_value(stod(parts[i]));
-            } catch (const invalid_argument& ia) {
-                Log::error(
-                    "file: '%s' -- invalid argument: '%s' on row %d and column %d: '%s', value: '%s'\n",
-                    filename.c_str(), ia.what(), row, i, file_fields[i].c_str(), parts[i].c_str()
-                );
+            if (column_series[i] != NULL) {
+                double value;
+                if (parse_time_series_value(value_start, value_end, value)) {
+                    column_series[i]->add_value(value);
+                } else {
+                    Log::error(
+                        "file: '%s' -- invalid value on row %d and column %d: '%s', value: '%s'\n", filename.c_str(),
+                        row, i, file_fields[i].c_str(), string(value_start, value_end).c_str()
+                    );
+                }
             }
+
+            value_start = value_end + 1;
         }
 
         row++;
+        position = line_end + 1;
     }
 
+    munmap((void*) file_data, file_size);
+
     number_rows = time_series.begin()->second->get_number_values();
     if (number_rows <= 0) {
         Log::fatal("ERROR, number rows: %d <= 0\n", number_rows);
@@ -345,16 +550,6 @@ TimeSeriesSet::TimeSeriesSet(string _filename, const vector<string>& _fields) {
     }
 
     for (auto series = time_series.begin(); series != time_series.end(); series++) {
-        series->second->calculate_statistics();
-        if (series->second->get_min_change() == 0 && series->second->get_max_change() == 0) {
-            Log::warning("WARNING: unchanging series: '%s'\n", series->first.c_str());
-            // Log::warning("removing unchanging series: '%s'\n", series->first.c_str());
-            series->second->print_statistics();
-            // time_series.erase(series);
-        } else {
-            series->second->print_statistics();
-        }
-
         int32_t series_rows = series->second->get_number_values();
 
         if (series_rows != number_rows) {
@@ -369,6 +564,15 @@ TimeSeriesSet::TimeSeriesSet(string _filename, const vector<string>& _fields) {
     Log::info("read time series '%s' with number rows: %d\n", filename.c_str(), number_rows);
 }
 
+void TimeSeriesSet::print_statistics() {
+    for (auto series = time_series.begin(); series != time_series.end(); series++) {
+        if (series->second->get_min_change() == 0 && series->second->get_max_change() == 0) {
+            Log::warning("WARNING: unchanging series: '%s'\n", series->first.c_str());
+        }
+        series->second->print_statistics();
+    }
+}
+
 TimeSeriesSet::~TimeSeriesSet() {
     for (std::map<string, TimeSeries*>::iterator it = time_series.begin(); it != time_series.end();
          it = time_series.begin()) {
@@ -505,6 +709,31 @@ void TimeSeriesSet::export_time_series(
     }
 }
 
+/**
+ * The same as above, but copying the values straight into a sequence of a tensor which was
+ * allocated with number_rows - abs(time_offset) values.
+ */
+void TimeSeriesSet::export_time_series(
+    TimeSeriesTensor& data, int32_t sequence, const vector<string>& requested_fields,
+    const vector<string>& shift_fields, int32_t time_offset
+) {
+    int32_t length = data[sequence].get_length();
+
+    for (int32_t i = 0; i < (int32_t) requested_fields.size(); i++) {
+        // output data ignores the first N values, as do the shifted input fields
+        int32_t start = 0;
+        if (time_offset > 0) {
+            start = time_offset;
+        } else if (time_offset < 0
+                   && find(shift_fields.begin(), shift_fields.end(), requested_fields[i]) != shift_fields.end()) {
+            start = -time_offset;
+        }
+
+        const double* values = time_series[requested_fields[i]]->get_data();
+        memcpy(data.get_parameter_data(sequence, i), values + start, length * sizeof(double));
+    }
+}
+
 void TimeSeriesSet::export_time_series(vector<vector<double> >& data, const vector<string>& requested_fields) {
     vector<string> shift_fields;  // no fields will be shifted as this is empty
     export_time_series(data, requested_fields, shift_fields, 0);
@@ -618,15 +847,26 @@ void TimeSeriesSets::help_message() {
         "average, divide by the standard deviation and then divide by the normalized max to ensure values are between "
         "-1 and 1.\n"
     );
+
+    Log::info("\tCaching:\n");
+    Log::info(
+        "\t\t--time_series_cache <directory>: (optional) cache the loaded and normalized time series in a binary "
+        "file in this directory, which later runs with the same files and normalization settings will load instead "
+        "of the CSV files.\n"
+    );
 }
 
-TimeSeriesSets::TimeSeriesSets() : normalize_type("none") {
+TimeSeriesSets::TimeSeriesSets() : normalize_type("none"), cache_data(NULL), cache_size(0) {
 }
 
 TimeSeriesSets::~TimeSeriesSets() {
     for (int32_t i = 0; i < (int32_t) time_series.size(); i++) {
         delete time_series[i];
     }
+
+    if (cache_data != NULL) {
+        munmap((void*) cache_data, cache_size);
+    }
 }
 
 void merge_parameter_names(
@@ -650,21 +890,32 @@ void merge_parameter_names(
     }
 }
 
-void TimeSeriesSets::parse_parameters_string(const vector<string>& p) {
+/**
+ * Parses the --parameters argument (name, settings string and optional bounds for each parameter), which
+ * is shared by TimeSeriesSets and TimeSeriesStream so both honor the same user specified bounds. Returns
+ * false if the arguments are invalid.
+ */
+bool parse_parameters_string(
+    const vector<string>& p, vector<string>& all_parameter_names, vector<string>& input_parameter_names,
+    vector<string>& output_parameter_names, map<string, double>& normalize_mins, map<string, double>& normalize_maxs
+) {
     for (auto i = p.begin(); i != p.end();) {
         string parameter = *i;
         i++;
+        if (i == p.end()) {
+            Log::fatal("Parameter '%s' did not have a settings string.\n", parameter.c_str());
+            return false;
+        }
         string settings = *i;
         i++;
 
-        if (settings.find_first_not_of("iob")) {
+        if (settings.find_first_not_of("iob") != string::npos) {
             Log::fatal(
                 "Settings string for parameter '%s' was invalid, should consist only of characters 'i', 'o', or 'b'; i "
                 ": input, o : output, b : bounded.\n",
                 parameter.c_str()
             );
-            help_message();
-            exit(1);
+            return false;
         }
 
         bool has_input = false;
@@ -675,22 +926,29 @@ void TimeSeriesSets::parse_parameters_string(const vector<string>& p) {
         all_parameter_names.push_back(parameter);
         if (settings.find('i') != string::npos) {
             input_parameter_names.push_back(parameter);
+            has_input = true;
         }
 
         if (settings.find('o') != string::npos) {
             output_parameter_names.push_back(parameter);
+            has_output = true;
         }
 
         if (settings.find('b') != string::npos) {
+            if (p.end() - i < 2) {
+                Log::fatal("Parameter '%s' is bounded but did not have a min and max bound.\n", parameter.c_str());
+                return false;
+            }
             string min_bound_s = *i;
             i++;
             string max_bound_s = *i;
             i++;
 
             min_bound = stod(min_bound_s);
-            max_bound = stod(min_bound_s);
+            max_bound = stod(max_bound_s);
             normalize_mins[parameter] = min_bound;
             normalize_maxs[parameter] = max_bound;
+            has_bounds = true;
         }
 
         if (!has_input && !has_output) {
@@ -698,11 +956,10 @@ void TimeSeriesSets::parse_parameters_string(const vector<string>& p) {
                 "Settings string for parameter '%s' was invalid, did not contain an 'i' for input or 'o' for output.\n",
                 parameter.c_str()
             );
-            help_message();
-            exit(1);
+            return false;
         }
 
-        Log::info("parsed parameter '%s' as ");
+        Log::info("parsed parameter '%s' as ", parameter.c_str());
         if (has_input) {
             Log::info_no_header("input");
         }
@@ -717,6 +974,17 @@ void TimeSeriesSets::parse_parameters_string(const vector<string>& p) {
         }
         Log::info_no_header("\n");
     }
+
+    return true;
+}
+
+void TimeSeriesSets::parse_parameters_string(const vector<string>& p) {
+    if (!::parse_parameters_string(
+            p, all_parameter_names, input_parameter_names, output_parameter_names, normalize_mins, normalize_maxs
+        )) {
+        help_message();
+        exit(1);
+    }
 }
 
 void TimeSeriesSets::load_time_series() {
@@ -731,17 +999,396 @@ void TimeSeriesSets::load_time_series() {
         Log::debug("got time series filenames:\n");
     }
 
-    for (int32_t i = 0; i < (int32_t) filenames.size(); i++) {
+    // the files are parsed in parallel
+    time_series.resize(filenames.size(), NULL);
+    run_in_parallel((int32_t) filenames.size(), [&](int32_t i) {
         Log::info("\t%s\n", filenames[i].c_str());
+        time_series[i] = new TimeSeriesSet(filenames[i], all_parameter_names);
+    });
 
-        TimeSeriesSet* ts = new TimeSeriesSet(filenames[i], all_parameter_names);
-        time_series.push_back(ts);
+    // the statistics are calculated for every column of every file in parallel, rather than
+    // one file at a time as each is loaded
+    vector<TimeSeries*> columns;
+    for (int32_t i = 0; i < (int32_t) time_series.size(); i++) {
+        for (auto series = time_series[i]->time_series.begin(); series != time_series[i]->time_series.end();
+             series++) {
+            columns.push_back(series->second);
+        }
+    }
+    run_in_parallel((int32_t) columns.size(), [&](int32_t i) { columns[i]->calculate_statistics(); });
+
+    for (int32_t i = 0; i < (int32_t) time_series.size(); i++) {
+        time_series[i]->print_statistics();
+    }
 
-        rows += ts->get_number_rows();
+    for (int32_t i = 0; i < (int32_t) time_series.size(); i++) {
+        rows += time_series[i]->get_number_rows();
     }
     Log::debug("number of time series files: %d, total rows: %d\n", filenames.size(), rows);
 }
 
+/**
+ * The normalized time series can be cached in a binary columnar file (--time_series_cache <directory>)
+ * so later runs over the same data skip parsing and normalizing the CSV files. The cache file is:
+ *
+ *  - the magic "EXTS", the format version, the cache key, the offset of the column data and the size
+ *    of each value (int32_t, int32_t, uint64_t, int64_t, int32_t)
+ *  - the number of series and fields (int32_t), the normalize type and the field names
+ *  - the normalization mins, maxs, avgs and std devs, each as a count followed by (field name, value)
+ *  - for each series the number of rows, followed by the min, average, max, std dev, variance, min change
+ *    and max change of each field; these are calculated when the CSV files are loaded and normalizing does
+ *    not recalculate them, so they are the statistics of the values before normalization
+ *  - padding to a 64 byte boundary, then for each series each field's normalized values as a column
+ *
+ * The columns are used in place from the memory mapped file (see TimeSeries::get_data) rather than copied.
+ *
+ * Strings are written as their length (int32_t) followed by their characters. The key is a hash of the
+ * contents of the files, the parameter names and the normalization settings, so a cache is never used
+ * for different data.
+ */
+#define TIME_SERIES_CACHE_VERSION   1
+#define TIME_SERIES_CACHE_ALIGNMENT 64
+
+static uint64_t hash_bytes(uint64_t hash, const char* bytes, size_t length) {
+    // FNV-1a over 8 byte words (then the remaining bytes) so large files hash quickly
+    const uint64_t fnv_prime = 1099511628211ULL;
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(uint64_t));
+        hash = (hash ^ word) * fnv_prime;
+    }
+    for (; i < length; i++) {
+        hash = (hash ^ (uint8_t) bytes[i]) * fnv_prime;
+    }
+
+    return (hash ^ length) * fnv_prime;
+}
+
+static uint64_t hash_string(uint64_t hash, const string& value) {
+    return hash_bytes(hash, value.c_str(), value.size());
+}
+
+static uint64_t hash_map(uint64_t hash, const map<string, double>& values) {
+    uint64_t count = values.size();
+    hash = hash_bytes(hash, (const char*) &count, sizeof(uint64_t));
+    for (auto it = values.begin(); it != values.end(); it++) {
+        hash = hash_string(hash, it->first);
+        hash = hash_bytes(hash, (const char*) &it->second, sizeof(double));
+    }
+    return hash;
+}
+
+static void write_cache_bytes(vector<char>& buffer, const void* bytes, size_t length) {
+    buffer.insert(buffer.end(), (const char*) bytes, (const char*) bytes + length);
+}
+
+static void write_cache_string(vector<char>& buffer, const string& value) {
+    int32_t length = (int32_t) value.size();
+    write_cache_bytes(buffer, &length, sizeof(int32_t));
+    write_cache_bytes(buffer, value.c_str(), length);
+}
+
+static void write_cache_map(vector<char>& buffer, const map<string, double>& values) {
+    int32_t count = (int32_t) values.size();
+    write_cache_bytes(buffer, &count, sizeof(int32_t));
+    for (auto it = values.begin(); it != values.end(); it++) {
+        write_cache_string(buffer, it->first);
+        write_cache_bytes(buffer, &it->second, sizeof(double));
+    }
+}
+
+static bool read_cache_bytes(const char* data, size_t size, size_t& position, void* bytes, size_t length) {
+    if (position + length > size) {
+        return false;
+    }
+    memcpy(bytes, data + position, length);
+    position += length;
+    return true;
+}
+
+static bool read_cache_string(const char* data, size_t size, size_t& position, string& value) {
+    int32_t length;
+    if (!read_cache_bytes(data, size, position, &length, sizeof(int32_t)) || length < 0
+        || position + length > size) {
+        return false;
+    }
+    value.assign(data + position, length);
+    position += length;
+    return true;
+}
+
+static bool read_cache_map(const char* data, size_t size, size_t& position, map<string, double>& values) {
+    int32_t count;
+    if (!read_cache_bytes(data, size, position, &count, sizeof(int32_t)) || count < 0) {
+        return false;
+    }
+
+    values.clear();
+    for (int32_t i = 0; i < count; i++) {
+        string name;
+        double value;
+        if (!read_cache_string(data, size, position, name)
+            || !read_cache_bytes(data, size, position, &value, sizeof(double))) {
+            return false;
+        }
+        values[name] = value;
+    }
+    return true;
+}
+
+uint64_t TimeSeriesSets::get_cache_key() const {
+    uint64_t key = 14695981039346656037ULL;
+
+    int32_t version = TIME_SERIES_CACHE_VERSION;
+    key = hash_bytes(key, (const char*) &version, sizeof(int32_t));
+
+    for (int32_t i = 0; i < (int32_t) filenames.size(); i++) {
+        int32_t fd = open(filenames[i].c_str(), O_RDONLY);
+        struct stat file_stat;
+        if (fd < 0 || fstat(fd, &file_stat) != 0) {
+            Log::fatal("ERROR: could not open time series file '%s': %s\n", filenames[i].c_str(), strerror(errno));
+            exit(1);
+        }
+
+        size_t file_size = file_stat.st_size;
+        if (file_size > 0) {
+            const char* file_data = (const char*) mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (file_data == MAP_FAILED) {
+                Log::fatal(
+                    "ERROR: could not memory map time series file '%s': %s\n", filenames[i].c_str(), strerror(errno)
+                );
+                exit(1);
+            }
+            madvise((void*) file_data, file_size, MADV_SEQUENTIAL);
+            key = hash_bytes(key, file_data, file_size);
+            munmap((void*) file_data, file_size);
+        } else {
+            key = hash_bytes(key, NULL, 0);
+        }
+        close(fd);
+    }
+
+    for (int32_t i = 0; i < (int32_t) all_parameter_names.size(); i++) {
+        key = hash_string(key, all_parameter_names[i]);
+    }
+
+    // user specified bounds (or the values from a genome) change the normalization
+    key = hash_string(key, normalize_type);
+    key = hash_map(key, normalize_mins);
+    key = hash_map(key, normalize_maxs);
+    key = hash_map(key, normalize_avgs);
+    key = hash_map(key, normalize_std_devs);
+
+    return key;
+}
+
+string TimeSeriesSets::get_cache_filename(string cache_directory, uint64_t key) {
+    mkpath(cache_directory.c_str(), 0777);
+
+    char key_string[17];
+    snprintf(key_string, sizeof(key_string), "%016llx", (unsigned long long) key);
+    return cache_directory + "/time_series_" + key_string + ".bin";
+}
+
+bool TimeSeriesSets::read_cache(string cache_filename, uint64_t cache_key) {
+    int32_t fd = open(cache_filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        Log::info("no time series cache at '%s'\n", cache_filename.c_str());
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        Log::warning("could not read time series cache '%s', reloading the time series\n", cache_filename.c_str());
+        return false;
+    }
+    size_t size = file_stat.st_size;
+
+    const char* data = (const char*) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        Log::warning("could not memory map time series cache '%s': %s\n", cache_filename.c_str(), strerror(errno));
+        return false;
+    }
+
+    size_t position = 0;
+    char magic[4];
+    int32_t version;
+    uint64_t key;
+    int64_t data_offset;
+    int32_t value_size;
+    int32_t number_series;
+    int32_t number_fields;
+    string cached_normalize_type;
+    map<string, double> cached_mins, cached_maxs, cached_avgs, cached_std_devs;
+
+    bool valid = read_cache_bytes(data, size, position, magic, 4) && memcmp(magic, "EXTS", 4) == 0
+                 && read_cache_bytes(data, size, position, &version, sizeof(int32_t))
+                 && version == TIME_SERIES_CACHE_VERSION
+                 && read_cache_bytes(data, size, position, &key, sizeof(uint64_t))
+                 && read_cache_bytes(data, size, position, &data_offset, sizeof(int64_t))
+                 && read_cache_bytes(data, size, position, &value_size, sizeof(int32_t))
+                 && value_size == sizeof(double)
+                 && read_cache_bytes(data, size, position, &number_series, sizeof(int32_t))
+                 && number_series == (int32_t) filenames.size()
+                 && read_cache_bytes(data, size, position, &number_fields, sizeof(int32_t))
+                 && number_fields == (int32_t) all_parameter_names.size()
+                 && read_cache_string(data, size, position, cached_normalize_type);
+
+    for (int32_t i = 0; valid && i < number_fields; i++) {
+        string field;
+        valid = read_cache_string(data, size, position, field) && field == all_parameter_names[i];
+    }
+
+    valid = valid && read_cache_map(data, size, position, cached_mins)
+            && read_cache_map(data, size, position, cached_maxs) && read_cache_map(data, size, position, cached_avgs)
+            && read_cache_map(data, size, position, cached_std_devs);
+
+    vector<int32_t> series_rows;
+    vector<double> statistics;
+    int64_t total_rows = 0;
+    for (int32_t i = 0; valid && i < number_series; i++) {
+        int32_t rows = 0;
+        valid = read_cache_bytes(data, size, position, &rows, sizeof(int32_t)) && rows > 0;
+        if (valid) {
+            series_rows.push_back(rows);
+            total_rows += rows;
+        }
+
+        for (int32_t j = 0; valid && j < number_fields * 7; j++) {
+            double statistic = 0.0;
+            valid = read_cache_bytes(data, size, position, &statistic, sizeof(double));
+            if (valid) {
+                statistics.push_back(statistic);
+            }
+        }
+    }
+
+    valid = valid && data_offset >= (int64_t) position && data_offset % TIME_SERIES_CACHE_ALIGNMENT == 0
+            && data_offset + total_rows * number_fields * (int64_t) sizeof(double) == (int64_t) size;
+
+    // the key is also in the filename, this catches a cache file which was copied or renamed
+    if (!valid || key != cache_key) {
+        munmap((void*) data, size);
+        Log::warning("time series cache '%s' is invalid, reloading the time series\n", cache_filename.c_str());
+        return false;
+    }
+
+    time_series.clear();
+    const double* column = (const double*) (data + data_offset);
+    for (int32_t i = 0; i < number_series; i++) {
+        TimeSeriesSet* set = new TimeSeriesSet();
+        set->filename = filenames[i];
+        set->fields = all_parameter_names;
+        set->number_rows = series_rows[i];
+
+        for (int32_t j = 0; j < number_fields; j++) {
+            TimeSeries* series = new TimeSeries(all_parameter_names[j]);
+            series->mapped_values = column;
+            series->number_mapped_values = series_rows[i];
+            column += series_rows[i];
+
+            const double* series_statistics = &statistics[(i * number_fields + j) * 7];
+            series->min = series_statistics[0];
+            series->average = series_statistics[1];
+            series->max = series_statistics[2];
+            series->std_dev = series_statistics[3];
+            series->variance = series_statistics[4];
+            series->min_change = series_statistics[5];
+            series->max_change = series_statistics[6];
+
+            set->time_series[all_parameter_names[j]] = series;
+        }
+
+        time_series.push_back(set);
+        Log::info("read time series '%s' from cache with number rows: %d\n", filenames[i].c_str(), series_rows[i]);
+    }
+
+    // the series use the columns in place, so the cache stays mapped until these time series are deleted
+    cache_data = data;
+    cache_size = size;
+
+    normalize_type = cached_normalize_type;
+    normalize_mins = cached_mins;
+    normalize_maxs = cached_maxs;
+    normalize_avgs = cached_avgs;
+    normalize_std_devs = cached_std_devs;
+
+    Log::info("read %d time series from cache '%s'\n", number_series, cache_filename.c_str());
+    return true;
+}
+
+void TimeSeriesSets::write_cache(string cache_filename, uint64_t cache_key) {
+    vector<char> header;
+
+    int32_t version = TIME_SERIES_CACHE_VERSION;
+    uint64_t key = cache_key;
+    int64_t data_offset = 0;
+    int32_t value_size = sizeof(double);
+    int32_t number_series = (int32_t) time_series.size();
+    int32_t number_fields = (int32_t) all_parameter_names.size();
+
+    write_cache_bytes(header, "EXTS", 4);
+    write_cache_bytes(header, &version, sizeof(int32_t));
+    write_cache_bytes(header, &key, sizeof(uint64_t));
+    size_t data_offset_position = header.size();
+    write_cache_bytes(header, &data_offset, sizeof(int64_t));
+    write_cache_bytes(header, &value_size, sizeof(int32_t));
+    write_cache_bytes(header, &number_series, sizeof(int32_t));
+    write_cache_bytes(header, &number_fields, sizeof(int32_t));
+    write_cache_string(header, normalize_type);
+    for (int32_t i = 0; i < number_fields; i++) {
+        write_cache_string(header, all_parameter_names[i]);
+    }
+
+    write_cache_map(header, normalize_mins);
+    write_cache_map(header, normalize_maxs);
+    write_cache_map(header, normalize_avgs);
+    write_cache_map(header, normalize_std_devs);
+
+    for (int32_t i = 0; i < number_series; i++) {
+        int32_t rows = time_series[i]->get_number_rows();
+        write_cache_bytes(header, &rows, sizeof(int32_t));
+
+        for (int32_t j = 0; j < number_fields; j++) {
+            const TimeSeries* series = time_series[i]->time_series[all_parameter_names[j]];
+            double statistics[7] = {series->min,      series->average,    series->max,       series->std_dev,
+                                    series->variance, series->min_change, series->max_change};
+            write_cache_bytes(header, statistics, sizeof(statistics));
+        }
+    }
+
+    // align the columns so they can be used in place when the cache is memory mapped
+    header.resize(
+        (header.size() + TIME_SERIES_CACHE_ALIGNMENT - 1) / TIME_SERIES_CACHE_ALIGNMENT * TIME_SERIES_CACHE_ALIGNMENT, 0
+    );
+    data_offset = header.size();
+    memcpy(&header[data_offset_position], &data_offset, sizeof(int64_t));
+
+    // write to a temporary file and rename it so other processes never see a partial cache
+    string temporary_filename = cache_filename + ".tmp." + to_string(getpid());
+    ofstream outfile(temporary_filename, std::ios::binary);
+    outfile.write(header.data(), header.size());
+    for (int32_t i = 0; i < number_series; i++) {
+        for (int32_t j = 0; j < number_fields; j++) {
+            const TimeSeries* series = time_series[i]->time_series[all_parameter_names[j]];
+            outfile.write((const char*) series->get_data(), series->get_number_values() * sizeof(double));
+        }
+    }
+    outfile.close();
+
+    if (!outfile || rename(temporary_filename.c_str(), cache_filename.c_str()) != 0) {
+        Log::warning("could not write time series cache '%s'\n", cache_filename.c_str());
+        unlink(temporary_filename.c_str());
+        return;
+    }
+
+    Log::info("wrote time series cache '%s'\n", cache_filename.c_str());
+}
+
 TimeSeriesSets* TimeSeriesSets::generate_from_arguments(const vector<string>& arguments) {
     Log::info("Generating time series data for EXAMM\n");
     TimeSeriesSets* tss = new TimeSeriesSets();
@@ -831,14 +1478,27 @@ TimeSeriesSets* TimeSeriesSets::generate_from_arguments(const vector<string>& ar
         exit(1);
     }
 
-    tss->load_time_series();
-
     tss->normalize_type = "";
     if (get_argument(arguments, "--normalize", false, tss->normalize_type)) {
     } else {
         tss->normalize_type = "none";
     }
 
+    // the cache key depends on the normalize type and any user specified bounds, so it is
+    // calculated before normalizing
+    string cache_directory;
+    uint64_t cache_key = 0;
+    string cache_filename = "";
+    if (get_argument(arguments, "--time_series_cache", false, cache_directory)) {
+        cache_key = tss->get_cache_key();
+        cache_filename = get_cache_filename(cache_directory, cache_key);
+        if (tss->read_cache(cache_filename, cache_key)) {
+            return tss;
+        }
+    }
+
+    tss->load_time_series();
+
     if (tss->normalize_type.compare("none") == 0) {
         Log::debug("not normalizing time series.\n");
     } else if (tss->normalize_type.compare("min_max") == 0) {
@@ -853,12 +1513,33 @@ TimeSeriesSets* TimeSeriesSets::generate_from_arguments(const vector<string>& ar
         exit(1);
     }
 
+    if (cache_filename != "") {
+        tss->write_cache(cache_filename, cache_key);
+    }
+
     return tss;
 }
 
 TimeSeriesSets* TimeSeriesSets::generate_test(
     const vector<string>& _test_filenames, const vector<string>& _input_parameter_names,
     const vector<string>& _output_parameter_names
+) {
+    return generate_test(
+        _test_filenames, _input_parameter_names, _output_parameter_names, "none", map<string, double>(),
+        map<string, double>(), map<string, double>(), map<string, double>(), ""
+    );
+}
+
+/**
+ * Loads test time series normalized with the given (typically a genome's) normalization
+ * values, using the time series cache in cache_directory if it is not empty.
+ */
+TimeSeriesSets* TimeSeriesSets::generate_test(
+    const vector<string>& _test_filenames, const vector<string>& _input_parameter_names,
+    const vector<string>& _output_parameter_names, string _normalize_type,
+    const map<string, double>& _normalize_mins, const map<string, double>& _normalize_maxs,
+    const map<string, double>& _normalize_avgs, const map<string, double>& _normalize_std_devs,
+    string cache_directory
 ) {
     TimeSeriesSets* tss = new TimeSeriesSets();
 
@@ -874,14 +1555,35 @@ TimeSeriesSets* TimeSeriesSets::generate_test(
     tss->output_parameter_names = _output_parameter_names;
     merge_parameter_names(tss->input_parameter_names, tss->output_parameter_names, tss->all_parameter_names);
 
-    tss->normalize_mins.clear();
-    tss->normalize_maxs.clear();
+    tss->normalize_type = _normalize_type;
+    tss->normalize_mins = _normalize_mins;
+    tss->normalize_maxs = _normalize_maxs;
 
-    tss->normalize_avgs.clear();
-    tss->normalize_std_devs.clear();
+    tss->normalize_avgs = _normalize_avgs;
+    tss->normalize_std_devs = _normalize_std_devs;
+
+    uint64_t cache_key = 0;
+    string cache_filename = "";
+    if (cache_directory != "") {
+        cache_key = tss->get_cache_key();
+        cache_filename = get_cache_filename(cache_directory, cache_key);
+        if (tss->read_cache(cache_filename, cache_key)) {
+            return tss;
+        }
+    }
 
     tss->load_time_series();
 
+    if (_normalize_type.compare("min_max") == 0) {
+        tss->normalize_min_max(_normalize_mins, _normalize_maxs);
+    } else if (_normalize_type.compare("avg_std_dev") == 0) {
+        tss->normalize_avg_std_dev(_normalize_avgs, _normalize_std_devs, _normalize_mins, _normalize_maxs);
+    }
+
+    if (cache_filename != "") {
+        tss->write_cache(cache_filename, cache_key);
+    }
+
     return tss;
 }
 
@@ -958,14 +1660,10 @@ void TimeSeriesSets::normalize_min_max() {
         }
 
         Log::info_no_header("%30s, min: %22.10lf, max: %22.10lf\n", parameter_name.c_str(), min, max);
-
-        // for each series, subtract min, divide by (max - min)
-        for (int32_t j = 0; j < (int32_t) time_series.size(); j++) {
-            time_series[j]->normalize_min_max(parameter_name, min, max);
-        }
     }
 
-    normalize_type = "min_max";
+    // for each series, subtract min, divide by (max - min)
+    apply_normalize_min_max();
 }
 
 void TimeSeriesSets::normalize_min_max(
@@ -996,14 +1694,10 @@ void TimeSeriesSets::normalize_min_max(
             }
             exit(1);
         }
-
-        // for each series, subtract min, divide by (max - min)
-        for (int32_t j = 0; j < (int32_t) time_series.size(); j++) {
-            time_series[j]->normalize_min_max(field, normalize_mins[field], normalize_maxs[field]);
-        }
     }
 
-    normalize_type = "min_max";
+    // for each series, subtract min, divide by (max - min)
+    apply_normalize_min_max();
 }
 
 void TimeSeriesSets::normalize_avg_std_dev() {
@@ -1079,14 +1773,10 @@ void TimeSeriesSets::normalize_avg_std_dev() {
             "%22.10lf\n",
             parameter_name.c_str(), min, max, avg, norm_max, std_dev
         );
-
-        // for each series, subtract min, divide by (max - min)
-        for (int32_t j = 0; j < (int32_t) time_series.size(); j++) {
-            time_series[j]->normalize_avg_std_dev(parameter_name, avg, std_dev, norm_max);
-        }
     }
 
-    normalize_type = "avg_std_dev";
+    // for each series, subtract avg, divide by std_dev; then divide by normalized_max to make between -1 and 1
+    apply_normalize_avg_std_dev();
 }
 
 void TimeSeriesSets::normalize_avg_std_dev(
@@ -1140,23 +1830,52 @@ void TimeSeriesSets::normalize_avg_std_dev(
             }
             exit(1);
         }
+    }
 
-        double min = normalize_mins[field];
-        double max = normalize_maxs[field];
-        double avg = normalize_avgs[field];
-        double std_dev = normalize_std_devs[field];
+    // for each series, subtract avg, divide by std_dev; then divide by normalized_max to make between -1 and 1
+    apply_normalize_avg_std_dev();
+}
 
-        double norm_min = (min - avg) / std_dev;
-        double norm_max = (max - avg) / std_dev;
+/**
+ * Normalizes every column of every series with the normalization mins and maxs, in parallel.
+ */
+void TimeSeriesSets::apply_normalize_min_max() {
+    int32_t number_fields = (int32_t) all_parameter_names.size();
 
-        norm_max = fmax(norm_min, norm_max);
+    run_in_parallel((int32_t) time_series.size() * number_fields, [&](int32_t task) {
+        const string& field = all_parameter_names[task % number_fields];
+        TimeSeries* series = time_series[task / number_fields]->time_series.at(field);
+        series->normalize_min_max(normalize_mins.at(field), normalize_maxs.at(field));
+    });
 
-        // for each series, subtract avg, divide by std_dev; then divide by normalized_max to make between -1 and 1
-        for (int32_t j = 0; j < (int32_t) time_series.size(); j++) {
-            time_series[j]->normalize_avg_std_dev(field, avg, std_dev, norm_max);
-        }
+    normalize_type = "min_max";
+}
+
+/**
+ * Normalizes every column of every series with the normalization averages and standard
+ * deviations, in parallel.
+ */
+void TimeSeriesSets::apply_normalize_avg_std_dev() {
+    int32_t number_fields = (int32_t) all_parameter_names.size();
+
+    vector<double> norm_maxs;
+    for (int32_t i = 0; i < number_fields; i++) {
+        const string& field = all_parameter_names[i];
+        double avg = normalize_avgs.at(field);
+        double std_dev = normalize_std_devs.at(field);
+
+        double norm_min = (normalize_mins.at(field) - avg) / std_dev;
+        double norm_max = (normalize_maxs.at(field) - avg) / std_dev;
+        norm_maxs.push_back(fmax(norm_min, norm_max));
     }
 
+    run_in_parallel((int32_t) time_series.size() * number_fields, [&](int32_t task) {
+        int32_t field = task % number_fields;
+        const string& name = all_parameter_names[field];
+        TimeSeries* series = time_series[task / number_fields]->time_series.at(name);
+        series->normalize_avg_std_dev(normalize_avgs.at(name), normalize_std_devs.at(name), norm_maxs[field]);
+    });
+
     normalize_type = "avg_std_dev";
 }
 
@@ -1213,6 +1932,55 @@ void TimeSeriesSets::export_test_series(
     export_time_series(test_indexes, time_offset, inputs, outputs);
 }
 
+/**
+ * Exports the series into one contiguous tensor for the inputs and one for the outputs, without
+ * the intermediate vectors.
+ */
+void TimeSeriesSets::export_time_series(
+    const vector<int>& series_indexes, int32_t time_offset, TimeSeriesTensor& inputs, TimeSeriesTensor& outputs
+) {
+    int32_t abs_time_offset = time_offset < 0 ? -time_offset : time_offset;
+
+    vector<int32_t> lengths;
+    for (int32_t i = 0; i < (int32_t) series_indexes.size(); i++) {
+        lengths.push_back(time_series[series_indexes[i]]->get_number_rows() - abs_time_offset);
+    }
+
+    inputs.allocate((int32_t) input_parameter_names.size(), lengths);
+    outputs.allocate((int32_t) output_parameter_names.size(), lengths);
+
+    for (int32_t i = 0; i < (int32_t) series_indexes.size(); i++) {
+        int32_t series_index = series_indexes[i];
+
+        time_series[series_index]->export_time_series(
+            inputs, i, input_parameter_names, shift_parameter_names, -time_offset
+        );
+        time_series[series_index]->export_time_series(
+            outputs, i, output_parameter_names, shift_parameter_names, time_offset
+        );
+    }
+}
+
+void TimeSeriesSets::export_training_series(int32_t time_offset, TimeSeriesTensor& inputs, TimeSeriesTensor& outputs) {
+    if (training_indexes.size() == 0) {
+        Log::fatal(
+            "ERROR: attempting to export training time series, however the training_indexes were not specified.\n"
+        );
+        exit(1);
+    }
+
+    export_time_series(training_indexes, time_offset, inputs, outputs);
+}
+
+void TimeSeriesSets::export_test_series(int32_t time_offset, TimeSeriesTensor& inputs, TimeSeriesTensor& outputs) {
+    if (test_indexes.size() == 0) {
+        Log::fatal("ERROR: attempting to export test time series, however the test_indexes were not specified.\n");
+        exit(1);
+    }
+
+    export_time_series(test_indexes, time_offset, inputs, outputs);
+}
+
 /**
  * This exports from all the loaded time series a particular column
  */
@@ -1227,6 +1995,93 @@ void TimeSeriesSets::export_series_by_name(string field_name, vector<vector<doub
     }
 }
 
+void TimeSeriesSets::get_lagged_correlations(
+    const vector<string>& first_fields, const vector<string>& second_fields, int32_t max_lag,
+    vector<vector<vector<vector<double> > > >& correlations
+) {
+    int32_t number_series = (int32_t) time_series.size();
+    int32_t number_first = (int32_t) first_fields.size();
+    int32_t number_second = (int32_t) second_fields.size();
+
+    correlations.assign(
+        number_series,
+        vector<vector<vector<double> > >(number_first, vector<vector<double> >(number_second, vector<double>()))
+    );
+    if (max_lag <= 0) {
+        return;
+    }
+
+    // zero padding the series to twice their length means the (circular) correlation of the
+    // FFTs does not wrap around; series of the same length share an FFT
+    map<int32_t, FFT*> ffts;
+    for (int32_t i = 0; i < number_series; i++) {
+        int32_t rows = time_series[i]->get_number_rows();
+        if (ffts.count(rows) == 0) {
+            ffts[rows] = new FFT(2 * rows);
+        }
+    }
+
+    // the spectrum of a series with its average subtracted
+    auto get_spectrum = [&](const TimeSeries* series, const FFT* fft, vector<complex<double> >& spectrum) {
+        spectrum.assign(fft->get_size(), complex<double>(0.0, 0.0));
+        const double* values = series->get_data();
+        for (int32_t i = 0; i < series->get_number_values(); i++) {
+            spectrum[i] = values[i] - series->average;
+        }
+        fft->transform(spectrum, false);
+    };
+
+    vector<vector<vector<complex<double> > > > first_spectra(
+        number_series, vector<vector<complex<double> > >(number_first)
+    );
+    run_in_parallel(number_series * number_first, [&](int32_t task) {
+        int32_t series = task / number_first;
+        int32_t first = task % number_first;
+        get_spectrum(
+            time_series[series]->time_series.at(first_fields[first]),
+            ffts.at(time_series[series]->get_number_rows()), first_spectra[series][first]
+        );
+    });
+
+    run_in_parallel(number_series * number_second, [&](int32_t task) {
+        int32_t series = task / number_second;
+        int32_t second = task % number_second;
+        const FFT* fft = ffts.at(time_series[series]->get_number_rows());
+
+        const TimeSeries* second_series = time_series[series]->time_series.at(second_fields[second]);
+        vector<complex<double> > second_spectrum;
+        get_spectrum(second_series, fft, second_spectrum);
+
+        vector<complex<double> > product(fft->get_size());
+        for (int32_t first = 0; first < number_first; first++) {
+            const TimeSeries* first_series = time_series[series]->time_series.at(first_fields[first]);
+            const vector<complex<double> >& first_spectrum = first_spectra[series][first];
+
+            // the inverse FFT of A * conj(B) is the sum over i of a[i + lag] * b[i] for every lag
+            for (int32_t k = 0; k < fft->get_size(); k++) {
+                product[k] = first_spectrum[k] * conj(second_spectrum[k]);
+            }
+            fft->transform(product, true);
+
+            // the same normalization as TimeSeries::get_correlation
+            vector<double>& pair_correlations = correlations[series][first][second];
+            pair_correlations.assign(max_lag, 0.0);
+            int32_t rows = (int32_t) fmin(first_series->get_number_values(), second_series->get_number_values());
+            for (int32_t lag = 0; lag < max_lag && lag < rows; lag++) {
+                if (first_series->variance >= 1e-12 && second_series->variance >= 1e-12) {
+                    pair_correlations[lag] = (product[lag].real()
+                                              / sqrt(first_series->variance * second_series->variance))
+                                             / (rows - lag);
+                }
+            }
+        }
+    });
+
+    for (auto fft = ffts.begin(); fft != ffts.end(); fft++) {
+        delete fft->second;
+    }
+}
+
 void TimeSeriesSets::write_time_series_sets(string base_filename) {
     for (int32_t i = 0; i < (int32_t) time_series.size(); i++) {
         string filepath = time_series[i]->get_filename();
@@ -1322,6 +2177,14 @@ void TimeSeriesSets::set_test_indexes(const vector<int>& _test_indexes) {
     test_indexes = _test_indexes;
 }
 
+vector<int> TimeSeriesSets::get_training_indexes() const {
+    return training_indexes;
+}
+
+vector<int> TimeSeriesSets::get_test_indexes() const {
+    return test_indexes;
+}
+
 TimeSeriesSet* TimeSeriesSets::get_set(int32_t i) {
     return time_series.at(i);
 }
@@ -13,6 +13,19 @@ using std::map;
 #include <vector>
 using std::vector;
 
+#include "time_series_tensor.hxx"
+
+void string_split(const string& s, char delim, vector<string>& result);
+bool parse_time_series_value(const char* start, const char* end, double& value);
+void merge_parameter_names(
+    const vector<string>& input_parameter_names, const vector<string>& output_parameter_names,
+    vector<string>& all_parameter_names
+);
+bool parse_parameters_string(
+    const vector<string>& p, vector<string>& all_parameter_names, vector<string>& input_parameter_names,
+    vector<string>& output_parameter_names, map<string, double>& normalize_mins, map<string, double>& normalize_maxs
+);
+
 class TimeSeries {
    private:
     string name;
@@ -27,12 +40,25 @@ class TimeSeries {
 
     vector<double> values;
 
+    // a series read from a memory mapped cache uses its column of the cache in place (see
+    // TimeSeriesSets::read_cache), the values are only copied into the vector if they are modified
+    const double* mapped_values;
+    int64_t number_mapped_values;
+
     TimeSeries();
 
+    const double* get_data() const;
+    void copy_mapped_values();
+
+    // the values are copied directly when exporting to a tensor and when reading a cache
+    friend class TimeSeriesSet;
+    friend class TimeSeriesSets;
+
    public:
     TimeSeries(string _name);
 
     void add_value(double value);
+    void reserve(int64_t number_values);
     double get_value(int32_t i);
 
     void calculate_statistics();
@@ -71,7 +97,13 @@ class TimeSeriesSet {
 
     TimeSeriesSet();
 
+    friend class TimeSeriesSets;
+
    public:
+    /**
+     * Reads the fields of a CSV file. The statistics of the series are not calculated here, so
+     * that TimeSeriesSets can calculate them for every column of every file in parallel.
+     */
     TimeSeriesSet(string _filename, const vector<string>& _fields);
     ~TimeSeriesSet();
     void add_time_series(string name);
@@ -92,6 +124,8 @@ class TimeSeriesSet {
     double get_min_change(string field);
     double get_max_change(string field);
 
+    void print_statistics();
+
     double get_correlation(string field1, string field2, int32_t lag) const;
 
     void normalize_min_max(string field, double min, double max);
@@ -103,6 +137,10 @@ class TimeSeriesSet {
         vector<vector<double> >& data, const vector<string>& requested_fields, const vector<string>& shift_fields,
         int32_t time_offset
     );
+    void export_time_series(
+        TimeSeriesTensor& data, int32_t sequence, const vector<string>& requested_fields,
+        const vector<string>& shift_fields, int32_t time_offset
+    );
 
     TimeSeriesSet* copy();
 
@@ -135,8 +173,19 @@ class TimeSeriesSets {
     map<string, double> normalize_avgs;
     map<string, double> normalize_std_devs;
 
+    // the memory mapped cache the time series were read from, which stays mapped while they use it
+    const char* cache_data;
+    size_t cache_size;
+
     void parse_parameters_string(const vector<string>& p);
     void load_time_series();
+    void apply_normalize_min_max();
+    void apply_normalize_avg_std_dev();
+
+    uint64_t get_cache_key() const;
+    static string get_cache_filename(string cache_directory, uint64_t key);
+    bool read_cache(string cache_filename, uint64_t cache_key);
+    void write_cache(string cache_filename, uint64_t cache_key);
 
    public:
     static void help_message();
@@ -148,6 +197,13 @@ class TimeSeriesSets {
         const vector<string>& _test_filenames, const vector<string>& _input_parameter_names,
         const vector<string>& _output_parameter_names
     );
+    static TimeSeriesSets* generate_test(
+        const vector<string>& _test_filenames, const vector<string>& _input_parameter_names,
+        const vector<string>& _output_parameter_names, string _normalize_type,
+        const map<string, double>& _normalize_mins, const map<string, double>& _normalize_maxs,
+        const map<string, double>& _normalize_avgs, const map<string, double>& _normalize_std_devs,
+        string cache_directory
+    );
 
     void normalize_min_max();
     void normalize_min_max(const map<string, double>& _normalize_mins, const map<string, double>& _normalize_maxs);
@@ -176,8 +232,25 @@ class TimeSeriesSets {
         int32_t time_offset, vector<vector<vector<double> > >& inputs, vector<vector<vector<double> > >& outputs
     );
 
+    void export_time_series(
+        const vector<int>& series_indexes, int32_t time_offset, TimeSeriesTensor& inputs, TimeSeriesTensor& outputs
+    );
+    void export_training_series(int32_t time_offset, TimeSeriesTensor& inputs, TimeSeriesTensor& outputs);
+    void export_test_series(int32_t time_offset, TimeSeriesTensor& inputs, TimeSeriesTensor& outputs);
+
     void export_series_by_name(string field_name, vector<vector<double> >& exported_series);
 
+    /**
+     * Calculates the correlation of each of the first fields, lagged by 0 to max_lag - 1 time steps,
+     * with each of the second fields in every series: correlations[series][i][j][lag] is the same as
+     * get_set(series)->get_correlation(first_fields[i], second_fields[j], lag). All the lags of a
+     * pair are calculated at once with FFTs, and the pairs are calculated in parallel.
+     */
+    void get_lagged_correlations(
+        const vector<string>& first_fields, const vector<string>& second_fields, int32_t max_lag,
+        vector<vector<vector<vector<double> > > >& correlations
+    );
+
     double denormalize(string field_name, double value);
 
     string get_normalize_type() const;
@@ -196,6 +269,8 @@ class TimeSeriesSets {
 
     void set_training_indexes(const vector<int>& _training_indexes);
     void set_test_indexes(const vector<int>& _test_indexes);
+    vector<int> get_training_indexes() const;
+    vector<int> get_test_indexes() const;
 
     TimeSeriesSet* get_set(int32_t i);
 };
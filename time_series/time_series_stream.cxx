@@ -0,0 +1,511 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+using std::find;
+
+#include <fstream>
+using std::getline;
+using std::ifstream;
+
+#include <functional>
+using std::function;
+
+#include <limits>
+using std::numeric_limits;
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "time_series_stream.hxx"
+#include "window_sampler.hxx"
+
+void TimeSeriesStream::help_message() {
+    Log::info("TimeSeriesStream options from arguments:\n");
+    Log::info(
+        "\t\t--stream_training_data : read the training files in chunks each epoch instead of loading them into "
+        "memory, requires --training_filenames, --test_filenames and either --input_parameter_names and "
+        "--output_parameter_names or --parameters (with the same user specified bounds as when loading them)\n"
+    );
+    Log::info("\t\t--stream_chunk_rows <rows> : (optional) rows of a file in each chunk, 10000 if not specified\n");
+    Log::info(
+        "\t\t--stream_prefetch_chunks <chunks> : (optional) chunks read ahead of training, 2 if not specified\n"
+    );
+}
+
+TimeSeriesStream* TimeSeriesStream::generate_from_arguments(const vector<string>& arguments) {
+    TimeSeriesStream* stream = new TimeSeriesStream();
+
+    if (!argument_exists(arguments, "--training_filenames") || !argument_exists(arguments, "--test_filenames")
+        || (!argument_exists(arguments, "--parameters")
+            && (!argument_exists(arguments, "--input_parameter_names")
+                || !argument_exists(arguments, "--output_parameter_names")))) {
+        Log::fatal("Could not find the arguments needed to stream the training data. Usage instructions:\n");
+        help_message();
+        exit(1);
+    }
+
+    if (argument_exists(arguments, "--shift_parameter_names")) {
+        Log::fatal("ERROR: --shift_parameter_names is not supported when streaming the training data\n");
+        exit(1);
+    }
+
+    get_argument_vector(arguments, "--training_filenames", true, stream->training_filenames);
+    get_argument_vector(arguments, "--test_filenames", true, stream->test_filenames);
+    if (argument_exists(arguments, "--parameters")) {
+        vector<string> p;
+        get_argument_vector(arguments, "--parameters", true, p);
+        if (!parse_parameters_string(
+                p, stream->all_parameter_names, stream->input_parameter_names, stream->output_parameter_names,
+                stream->normalize_mins, stream->normalize_maxs
+            )) {
+            help_message();
+            exit(1);
+        }
+    } else {
+        get_argument_vector(arguments, "--input_parameter_names", true, stream->input_parameter_names);
+        get_argument_vector(arguments, "--output_parameter_names", true, stream->output_parameter_names);
+        merge_parameter_names(
+            stream->input_parameter_names, stream->output_parameter_names, stream->all_parameter_names
+        );
+    }
+
+    stream->normalize_type = "none";
+    get_argument(arguments, "--normalize", false, stream->normalize_type);
+    if (stream->normalize_type != "none" && stream->normalize_type != "min_max"
+        && stream->normalize_type != "avg_std_dev") {
+        Log::fatal("Unknown normalize type: '%s'\n", stream->normalize_type.c_str());
+        exit(1);
+    }
+
+    stream->time_offset = 1;
+    get_argument(arguments, "--time_offset", true, stream->time_offset);
+    if (stream->time_offset < 0) {
+        Log::fatal("ERROR: the time offset (%d) cannot be negative when streaming\n", stream->time_offset);
+        exit(1);
+    }
+
+    stream->chunk_rows = 10000;
+    get_argument(arguments, "--stream_chunk_rows", false, stream->chunk_rows);
+    stream->prefetch_chunks = 2;
+    get_argument(arguments, "--stream_prefetch_chunks", false, stream->prefetch_chunks);
+    if (stream->chunk_rows <= 0 || stream->prefetch_chunks <= 0) {
+        Log::fatal(
+            "ERROR: invalid stream chunk rows (%d) or prefetch chunks (%d)\n", stream->chunk_rows,
+            stream->prefetch_chunks
+        );
+        exit(1);
+    }
+
+    // chunks are sliced by the training sequence length, unless windows are sampled from them, so
+    // that they hold whole sequences the chunk rows are rounded up to a multiple of it
+    stream->sequence_length = 0;
+    if (!WindowSampler::is_requested(arguments)) {
+        get_argument(arguments, "--train_sequence_length", false, stream->sequence_length);
+    }
+    if (stream->sequence_length > 0) {
+        stream->chunk_rows =
+            (stream->chunk_rows + stream->sequence_length - 1) / stream->sequence_length * stream->sequence_length;
+    }
+
+    stream->cache_directory = "";
+    get_argument(arguments, "--time_series_cache", false, stream->cache_directory);
+
+    stream->calculate_normalization();
+
+    Log::info(
+        "streaming %d training files in chunks of %d rows, prefetching %d chunks (about %ld bytes)\n",
+        (int32_t) stream->training_filenames.size(), stream->chunk_rows, stream->prefetch_chunks,
+        (int64_t) (stream->prefetch_chunks + 2) * (stream->chunk_rows + stream->time_offset)
+            * (stream->input_parameter_names.size() + stream->output_parameter_names.size()) * sizeof(double)
+    );
+
+    return stream;
+}
+
+void TimeSeriesStream::read_rows(
+    string filename, const vector<string>& fields, const function<bool(const vector<double>&)>& row_function
+) {
+    ifstream file(filename);
+    if (!file.is_open()) {
+        Log::fatal("ERROR: could not open time series file '%s'\n", filename.c_str());
+        exit(1);
+    }
+
+    string line;
+    if (!getline(file, line)) {
+        Log::fatal("ERROR! Could not get headers from the CSV file '%s'. File potentially empty!\n", filename.c_str());
+        exit(1);
+    }
+
+    vector<string> file_fields;
+    string_split(line, ',', file_fields);
+    for (int32_t i = 0; i < (int32_t) file_fields.size(); i++) {
+        file_fields[i].erase(std::remove(file_fields[i].begin(), file_fields[i].end(), '\r'), file_fields[i].end());
+    }
+
+    // the index in fields of each column of the file, or -1 if it is not used
+    vector<int32_t> column_fields(file_fields.size(), -1);
+    for (int32_t i = 0; i < (int32_t) fields.size(); i++) {
+        auto column = find(file_fields.begin(), file_fields.end(), fields[i]);
+        if (column == file_fields.end()) {
+            Log::fatal(
+                "ERROR: could not find specified field '%s' in time series file: '%s'\n", fields[i].c_str(),
+                filename.c_str()
+            );
+            exit(1);
+        }
+        column_fields[column - file_fields.begin()] = i;
+    }
+
+    vector<double> values(fields.size(), 0.0);
+    int32_t row = 1;
+    while (getline(file, line)) {
+        const char* position = line.c_str();
+        const char* line_end = position + line.size();
+
+        if (line.size() == 0 || position[0] == '#') {
+            row++;
+            continue;
+        }
+
+        int32_t number_values = (int32_t) std::count(position, line_end, ',') + 1;
+        if (line_end[-1] == ',') {
+            number_values--;
+        }
+
+        if (number_values != (int32_t) file_fields.size()) {
+            Log::fatal(
+                "ERROR! number of values in row %d was %d, but there were %d fields in the header.\n", row,
+                number_values, file_fields.size()
+            );
+            exit(1);
+        }
+
+        bool valid = true;
+        const char* value_start = position;
+        for (int32_t i = 0; i < number_values; i++) {
+            const char* value_end = (const char*) memchr(value_start, ',', line_end - value_start);
+            if (value_end == NULL) {
+                value_end = line_end;
+            }
+
+            if (column_fields[i] >= 0 && !parse_time_series_value(value_start, value_end, values[column_fields[i]])) {
+                Log::error(
+                    "file: '%s' -- invalid value on row %d and column %d: '%s', value: '%s', skipping the row\n",
+                    filename.c_str(), row, i, file_fields[i].c_str(), string(value_start, value_end).c_str()
+                );
+                valid = false;
+            }
+
+            value_start = value_end + 1;
+        }
+        row++;
+
+        if (valid && !row_function(values)) {
+            return;
+        }
+    }
+}
+
+/**
+ * Calculates the normalization values over all of the training and test files the same way
+ * TimeSeriesSets does (combining each file's statistics), so the values are the same as if
+ * the files had been loaded into memory.
+ */
+void TimeSeriesStream::calculate_normalization() {
+    if (normalize_type == "none") {
+        return;
+    }
+
+    vector<string> filenames = training_filenames;
+    filenames.insert(filenames.end(), test_filenames.begin(), test_filenames.end());
+
+    int32_t number_fields = (int32_t) all_parameter_names.size();
+
+    // the number of rows, min, max, average and variance of each field of each file
+    vector<int64_t> file_rows(filenames.size(), 0);
+    vector<vector<double> > file_mins(filenames.size(), vector<double>(number_fields, numeric_limits<double>::max()));
+    vector<vector<double> > file_maxs(filenames.size(), vector<double>(number_fields, -numeric_limits<double>::max()));
+    vector<vector<double> > file_avgs(filenames.size(), vector<double>(number_fields, 0.0));
+    vector<vector<double> > file_variances(filenames.size(), vector<double>(number_fields, 0.0));
+
+    std::atomic<int32_t> next_file(0);
+    string log_id = Log::get_id();
+
+    auto read_files = [&]() {
+        for (int32_t i = next_file++; i < (int32_t) filenames.size(); i = next_file++) {
+            Log::info("\tcalculating statistics for %s\n", filenames[i].c_str());
+
+            // Welford's online algorithm, so only a row is kept in memory at a time
+            vector<double> m2(number_fields, 0.0);
+            read_rows(filenames[i], all_parameter_names, [&](const vector<double>& values) {
+                file_rows[i]++;
+                for (int32_t j = 0; j < number_fields; j++) {
+                    double delta = values[j] - file_avgs[i][j];
+                    file_avgs[i][j] += delta / file_rows[i];
+                    m2[j] += delta * (values[j] - file_avgs[i][j]);
+
+                    file_mins[i][j] = fmin(file_mins[i][j], values[j]);
+                    file_maxs[i][j] = fmax(file_maxs[i][j], values[j]);
+                }
+                return true;
+            });
+
+            if (file_rows[i] <= 0) {
+                Log::fatal("ERROR, number rows: %ld <= 0 in '%s'\n", file_rows[i], filenames[i].c_str());
+                exit(1);
+            }
+            for (int32_t j = 0; j < number_fields; j++) {
+                file_variances[i][j] = m2[j] / (file_rows[i] - 1);
+            }
+        }
+    };
+
+    int32_t number_threads = std::min((int32_t) filenames.size(), (int32_t) thread::hardware_concurrency());
+    vector<thread> threads;
+    for (int32_t i = 1; i < number_threads; i++) {
+        // each thread logs under its own id, so it does not write into (or close) this thread's log
+        threads.push_back(thread([&, i]() {
+            string thread_log_id = log_id + "_statistics_" + to_string(i);
+            Log::set_id(thread_log_id);
+            read_files();
+            Log::release_id(thread_log_id);
+        }));
+    }
+    read_files();
+    for (int32_t i = 0; i < (int32_t) threads.size(); i++) {
+        threads[i].join();
+    }
+
+    for (int32_t j = 0; j < number_fields; j++) {
+        string parameter_name = all_parameter_names[j];
+
+        double min = numeric_limits<double>::max();
+        double max = -numeric_limits<double>::max();
+        double numerator_average = 0.0;
+        int64_t total_values = 0;
+        for (int32_t i = 0; i < (int32_t) filenames.size(); i++) {
+            min = fmin(min, file_mins[i][j]);
+            max = fmax(max, file_maxs[i][j]);
+            numerator_average += file_avgs[i][j] * file_rows[i];
+            total_values += file_rows[i];
+        }
+        // user specified bounds are used for min max normalization, avg std dev normalization always
+        // calculates them (the same as TimeSeriesSets::normalize_min_max and normalize_avg_std_dev)
+        if (normalize_type == "min_max" && normalize_mins.count(parameter_name) > 0) {
+            Log::info(
+                "user specified bounds for %30s, min: %22.10lf, max: %22.10lf\n", parameter_name.c_str(),
+                normalize_mins[parameter_name], normalize_maxs[parameter_name]
+            );
+            continue;
+        }
+        normalize_mins[parameter_name] = min;
+        normalize_maxs[parameter_name] = max;
+
+        if (normalize_type == "avg_std_dev") {
+            double avg = numerator_average / total_values;
+
+            double numerator_std_dev = 0.0;
+            for (int32_t i = 0; i < (int32_t) filenames.size(); i++) {
+                double avg_diff = file_avgs[i][j] - avg;
+                numerator_std_dev += ((file_rows[i] - 1) * file_variances[i][j]) + (file_rows[i] * avg_diff * avg_diff);
+            }
+
+            normalize_avgs[parameter_name] = avg;
+            normalize_std_devs[parameter_name] = numerator_std_dev / (total_values - 1);
+        }
+
+        Log::info("calculated bounds for %30s, min: %22.10lf, max: %22.10lf\n", parameter_name.c_str(), min, max);
+    }
+}
+
+void TimeSeriesStream::read_chunks(int32_t file, const function<bool(TimeSeriesChunk*)>& chunk_function) const {
+    int32_t number_fields = (int32_t) all_parameter_names.size();
+
+    // the normalization of each field, the same as TimeSeries::normalize_min_max and normalize_avg_std_dev
+    vector<double> mins(number_fields), maxs(number_fields), avgs(number_fields), std_devs(number_fields),
+        norm_maxs(number_fields);
+    for (int32_t j = 0; j < number_fields; j++) {
+        if (normalize_type == "none") {
+            continue;
+        }
+        mins[j] = normalize_mins.at(all_parameter_names[j]);
+        maxs[j] = normalize_maxs.at(all_parameter_names[j]);
+        if (normalize_type == "avg_std_dev") {
+            avgs[j] = normalize_avgs.at(all_parameter_names[j]);
+            std_devs[j] = normalize_std_devs.at(all_parameter_names[j]);
+            norm_maxs[j] = fmax((mins[j] - avgs[j]) / std_devs[j], (maxs[j] - avgs[j]) / std_devs[j]);
+        }
+    }
+
+    vector<int32_t> input_fields, output_fields;
+    for (int32_t i = 0; i < (int32_t) input_parameter_names.size(); i++) {
+        input_fields.push_back(
+            find(all_parameter_names.begin(), all_parameter_names.end(), input_parameter_names[i])
+            - all_parameter_names.begin()
+        );
+    }
+    for (int32_t i = 0; i < (int32_t) output_parameter_names.size(); i++) {
+        output_fields.push_back(
+            find(all_parameter_names.begin(), all_parameter_names.end(), output_parameter_names[i])
+            - all_parameter_names.begin()
+        );
+    }
+
+    // the buffered rows of each field; the last time_offset rows of a chunk are kept for the
+    // outputs of the next one
+    vector<vector<double> > columns(number_fields);
+    for (int32_t j = 0; j < number_fields; j++) {
+        columns[j].reserve(chunk_rows + time_offset);
+    }
+
+    auto export_chunk = [&](int32_t length) {
+        vector<int32_t> lengths;
+        if (sequence_length > 0) {
+            lengths.assign(length / sequence_length, sequence_length);
+        } else {
+            lengths.push_back(length);
+        }
+
+        TimeSeriesChunk* chunk = new TimeSeriesChunk();
+        chunk->file = file;
+        chunk->inputs.allocate((int32_t) input_fields.size(), lengths);
+        chunk->outputs.allocate((int32_t) output_fields.size(), lengths);
+
+        for (int32_t k = 0, start = 0; k < (int32_t) lengths.size(); start += lengths[k], k++) {
+            for (int32_t i = 0; i < (int32_t) input_fields.size(); i++) {
+                memcpy(
+                    chunk->inputs.get_parameter_data(k, i), columns[input_fields[i]].data() + start,
+                    lengths[k] * sizeof(double)
+                );
+            }
+            for (int32_t i = 0; i < (int32_t) output_fields.size(); i++) {
+                memcpy(
+                    chunk->outputs.get_parameter_data(k, i), columns[output_fields[i]].data() + start + time_offset,
+                    lengths[k] * sizeof(double)
+                );
+            }
+        }
+
+        return chunk_function(chunk);
+    };
+
+    bool reading = true;
+    read_rows(training_filenames[file], all_parameter_names, [&](const vector<double>& values) {
+        for (int32_t j = 0; j < number_fields; j++) {
+            double value = values[j];
+            if (normalize_type == "min_max") {
+                value = (value - mins[j]) / (maxs[j] - mins[j]);
+            } else if (normalize_type == "avg_std_dev") {
+                value = ((value - avgs[j]) / std_devs[j]) / norm_maxs[j];
+            }
+            columns[j].push_back(value);
+        }
+
+        if ((int32_t) columns[0].size() == chunk_rows + time_offset) {
+            reading = export_chunk(chunk_rows);
+            for (int32_t j = 0; j < number_fields; j++) {
+                columns[j].erase(columns[j].begin(), columns[j].begin() + chunk_rows);
+            }
+        }
+        return reading;
+    });
+
+    int32_t remaining = (int32_t) columns[0].size() - time_offset;
+    if (reading && remaining > 0 && (sequence_length == 0 || remaining >= sequence_length)) {
+        export_chunk(remaining);
+    }
+}
+
+TimeSeriesSets* TimeSeriesStream::generate_test_sets() const {
+    return TimeSeriesSets::generate_test(
+        test_filenames, input_parameter_names, output_parameter_names, normalize_type, normalize_mins, normalize_maxs,
+        normalize_avgs, normalize_std_devs, cache_directory
+    );
+}
+
+int32_t TimeSeriesStream::get_number_files() const {
+    return (int32_t) training_filenames.size();
+}
+
+int32_t TimeSeriesStream::get_prefetch_chunks() const {
+    return prefetch_chunks;
+}
+
+TimeSeriesStreamReader::TimeSeriesStreamReader(const TimeSeriesStream* _stream, const vector<int32_t>& _file_order)
+    : stream(_stream), file_order(_file_order), finished(false), stopped(false) {
+    reader_thread = thread(&TimeSeriesStreamReader::read_files, this, Log::get_id() + "_reader");
+}
+
+TimeSeriesStreamReader::~TimeSeriesStreamReader() {
+    queue_mutex.lock();
+    stopped = true;
+    queue_mutex.unlock();
+    queue_condition.notify_all();
+
+    reader_thread.join();
+
+    while (queue.size() > 0) {
+        delete queue.front();
+        queue.pop_front();
+    }
+}
+
+void TimeSeriesStreamReader::read_files(string log_id) {
+    Log::set_id(log_id);
+
+    for (int32_t i = 0; i < (int32_t) file_order.size(); i++) {
+        bool reading = true;
+        stream->read_chunks(file_order[i], [&](TimeSeriesChunk* chunk) {
+            std::unique_lock<mutex> lock(queue_mutex);
+            queue_condition.wait(lock, [&]() {
+                return stopped || (int32_t) queue.size() < stream->get_prefetch_chunks();
+            });
+
+            if (stopped) {
+                delete chunk;
+                reading = false;
+                return false;
+            }
+
+            queue.push_back(chunk);
+            queue_condition.notify_all();
+            return true;
+        });
+
+        if (!reading) {
+            break;
+        }
+    }
+
+    queue_mutex.lock();
+    finished = true;
+    queue_mutex.unlock();
+    queue_condition.notify_all();
+
+    Log::release_id(log_id);
+}
+
+TimeSeriesChunk* TimeSeriesStreamReader::next_chunk() {
+    std::unique_lock<mutex> lock(queue_mutex);
+    queue_condition.wait(lock, [&]() { return finished || queue.size() > 0; });
+
+    if (queue.size() == 0) {
+        return NULL;
+    }
+
+    TimeSeriesChunk* chunk = queue.front();
+    queue.pop_front();
+    queue_condition.notify_all();
+    return chunk;
+}
@@ -0,0 +1,136 @@
+#ifndef EXAMM_TIME_SERIES_STREAM_HXX
+#define EXAMM_TIME_SERIES_STREAM_HXX
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <deque>
+using std::deque;
+
+#include <functional>
+using std::function;
+
+#include <map>
+using std::map;
+
+#include <mutex>
+using std::mutex;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "time_series.hxx"
+#include "time_series_tensor.hxx"
+
+/**
+ * A chunk of consecutive rows of one training file, normalized and exported the same way as
+ * TimeSeriesSets::export_training_series, and sliced by --train_sequence_length if given.
+ */
+struct TimeSeriesChunk {
+    int32_t file;
+    TimeSeriesTensor inputs;
+    TimeSeriesTensor outputs;
+};
+
+/**
+ * Streams the training time series from their CSV files instead of loading them into memory
+ * (--stream_training_data), for data sets which do not fit in memory. The normalization
+ * values are calculated once, in a pass over the training and test files which only keeps a
+ * row at a time, so they are the same as if the files had been loaded. Each epoch a
+ * TimeSeriesStreamReader then reads the training files in --stream_chunk_rows row chunks,
+ * keeping at most --stream_prefetch_chunks chunks ahead of training.
+ *
+ * The (much smaller) test files are still loaded into memory for validation.
+ */
+class TimeSeriesStream {
+   private:
+    vector<string> training_filenames;
+    vector<string> test_filenames;
+
+    vector<string> input_parameter_names;
+    vector<string> output_parameter_names;
+    vector<string> all_parameter_names;
+
+    string normalize_type;
+    map<string, double> normalize_mins;
+    map<string, double> normalize_maxs;
+    map<string, double> normalize_avgs;
+    map<string, double> normalize_std_devs;
+
+    int32_t time_offset;
+    int32_t chunk_rows;
+    int32_t prefetch_chunks;
+    int32_t sequence_length;
+
+    string cache_directory;
+
+    void calculate_normalization();
+
+   public:
+    static void help_message();
+
+    static TimeSeriesStream* generate_from_arguments(const vector<string>& arguments);
+
+    /**
+     * Calls row_function with the values of the given fields for each row of the file, until
+     * it returns false.
+     */
+    static void read_rows(
+        string filename, const vector<string>& fields, const function<bool(const vector<double>&)>& row_function
+    );
+
+    /**
+     * Reads the given training file one chunk at a time, calling chunk_function with each chunk
+     * (which it then owns) until it returns false.
+     */
+    void read_chunks(int32_t file, const function<bool(TimeSeriesChunk*)>& chunk_function) const;
+
+    /**
+     * Loads the test files, normalized with the streamed data's normalization values.
+     */
+    TimeSeriesSets* generate_test_sets() const;
+
+    int32_t get_number_files() const;
+    int32_t get_prefetch_chunks() const;
+};
+
+/**
+ * Reads the chunks of one epoch on a background thread, in the given order of files, through
+ * a queue bounded to the stream's prefetch chunks. Destroying the reader stops the thread, so
+ * training can stop part way through an epoch.
+ */
+class TimeSeriesStreamReader {
+   private:
+    const TimeSeriesStream* stream;
+    vector<int32_t> file_order;
+
+    mutex queue_mutex;
+    condition_variable queue_condition;
+    deque<TimeSeriesChunk*> queue;
+    bool finished;
+    bool stopped;
+
+    thread reader_thread;
+
+    void read_files(string log_id);
+
+    TimeSeriesStreamReader(const TimeSeriesStreamReader&) = delete;
+    TimeSeriesStreamReader& operator=(const TimeSeriesStreamReader&) = delete;
+
+   public:
+    TimeSeriesStreamReader(const TimeSeriesStream* _stream, const vector<int32_t>& _file_order);
+    ~TimeSeriesStreamReader();
+
+    /**
+     * Waits for and returns the next chunk, which the caller then owns, or NULL after the last.
+     */
+    TimeSeriesChunk* next_chunk();
+};
+
+#endif
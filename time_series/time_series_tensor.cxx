@@ -0,0 +1,158 @@
+#include <cstdlib>
+#include <cstring>
+using std::memset;
+
+#include <vector>
+using std::vector;
+
+#include "common/log.hxx"
+#include "time_series_tensor.hxx"
+
+// parameters start on cache line boundaries, which is also enough for any SIMD loads
+#define TIME_SERIES_TENSOR_ALIGNMENT 64
+#define TIME_SERIES_TENSOR_ALIGNED_VALUES (TIME_SERIES_TENSOR_ALIGNMENT / sizeof(double))
+
+SeriesView::SeriesView() : data(NULL), parameter_stride(0), number_parameters(0), length(0) {
+}
+
+SeriesView::SeriesView(const double* _data, int32_t _number_parameters, int32_t _length, int64_t _parameter_stride)
+    : data(_data), parameter_stride(_parameter_stride), number_parameters(_number_parameters), length(_length) {
+}
+
+SeriesView SeriesView::window(int32_t start, int32_t window_length) const {
+    if (start < 0 || window_length < 0 || start + window_length > length) {
+        Log::fatal(
+            "ERROR: window from %d with length %d is outside of series with length %d\n", start, window_length, length
+        );
+        exit(1);
+    }
+
+    return SeriesView(data + start, number_parameters, window_length, parameter_stride);
+}
+
+TimeSeriesTensor::TimeSeriesTensor() : number_parameters(0), storage(NULL), storage_size(0) {
+}
+
+TimeSeriesTensor::TimeSeriesTensor(const vector<vector<vector<double> > >& series)
+    : number_parameters(0), storage(NULL), storage_size(0) {
+    if (series.size() == 0) {
+        return;
+    }
+
+    vector<int32_t> lengths;
+    for (int32_t i = 0; i < (int32_t) series.size(); i++) {
+        lengths.push_back(series[i].size() == 0 ? 0 : (int32_t) series[i][0].size());
+    }
+    allocate((int32_t) series[0].size(), lengths);
+
+    for (int32_t i = 0; i < (int32_t) series.size(); i++) {
+        if ((int32_t) series[i].size() != number_parameters) {
+            Log::fatal(
+                "ERROR: series %d has %d parameters, but series 0 has %d\n", i, (int32_t) series[i].size(),
+                number_parameters
+            );
+            exit(1);
+        }
+
+        for (int32_t j = 0; j < number_parameters; j++) {
+            if ((int32_t) series[i][j].size() != lengths[i]) {
+                Log::fatal(
+                    "ERROR: parameter %d of series %d has %d values, but parameter 0 has %d\n", j, i,
+                    (int32_t) series[i][j].size(), lengths[i]
+                );
+                exit(1);
+            }
+            if (lengths[i] > 0) {
+                memcpy(get_parameter_data(i, j), series[i][j].data(), lengths[i] * sizeof(double));
+            }
+        }
+    }
+}
+
+TimeSeriesTensor::~TimeSeriesTensor() {
+    clear();
+}
+
+void TimeSeriesTensor::clear() {
+    free(storage);
+    storage = NULL;
+    storage_size = 0;
+    sequences.clear();
+}
+
+void TimeSeriesTensor::allocate(int32_t _number_parameters, const vector<int32_t>& lengths) {
+    clear();
+    number_parameters = _number_parameters;
+
+    vector<int64_t> offsets;
+    vector<int64_t> strides;
+    for (int32_t i = 0; i < (int32_t) lengths.size(); i++) {
+        int64_t stride = (lengths[i] + TIME_SERIES_TENSOR_ALIGNED_VALUES - 1) / TIME_SERIES_TENSOR_ALIGNED_VALUES
+                         * TIME_SERIES_TENSOR_ALIGNED_VALUES;
+        offsets.push_back(storage_size);
+        strides.push_back(stride);
+        storage_size += stride * number_parameters;
+    }
+
+    if (storage_size > 0) {
+        storage = (double*) aligned_alloc(TIME_SERIES_TENSOR_ALIGNMENT, storage_size * sizeof(double));
+        if (storage == NULL) {
+            Log::fatal("ERROR: could not allocate %ld values for time series tensor\n", storage_size);
+            exit(1);
+        }
+        memset(storage, 0, storage_size * sizeof(double));
+    }
+
+    for (int32_t i = 0; i < (int32_t) lengths.size(); i++) {
+        sequences.push_back(SeriesView(storage + offsets[i], number_parameters, lengths[i], strides[i]));
+    }
+}
+
+void TimeSeriesTensor::set_views(int32_t _number_parameters, const vector<SeriesView>& views) {
+    clear();
+    number_parameters = _number_parameters;
+    sequences = views;
+}
+
+double* TimeSeriesTensor::get_parameter_data(int32_t sequence, int32_t parameter) {
+    if (storage == NULL) {
+        Log::fatal("ERROR: cannot write to a time series tensor which does not own its values\n");
+        exit(1);
+    }
+    return (double*) sequences[sequence].get_parameter(parameter);
+}
+
+void TimeSeriesTensor::slice(int32_t sequence_length) {
+    vector<SeriesView> windows;
+
+    for (int32_t i = 0; i < (int32_t) sequences.size(); i++) {
+        int32_t length = sequences[i].get_length();
+        for (int32_t start = 0; start + sequence_length <= length; start += sequence_length) {
+            windows.push_back(sequences[i].window(start, sequence_length));
+        }
+        Log::info(
+            "Before slicing, original time series %d has %d parameters, and %d length\n", i, number_parameters, length
+        );
+    }
+
+    sequences = windows;
+    Log::info(
+        "After slicing, sliced data has %d sets, and %d parameters and length %d \n", (int32_t) sequences.size(),
+        number_parameters, sequence_length
+    );
+}
+
+int32_t TimeSeriesTensor::get_number_parameters() const {
+    return number_parameters;
+}
+
+void TimeSeriesTensor::export_series(vector<vector<vector<double> > >& series) const {
+    series.resize(sequences.size());
+    for (int32_t i = 0; i < (int32_t) sequences.size(); i++) {
+        series[i].resize(number_parameters);
+        for (int32_t j = 0; j < number_parameters; j++) {
+            const double* values = sequences[i].get_parameter(j);
+            series[i][j].assign(values, values + sequences[i].get_length());
+        }
+    }
+}
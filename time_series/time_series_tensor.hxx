@@ -0,0 +1,109 @@
+#ifndef EXAMM_TIME_SERIES_TENSOR_HXX
+#define EXAMM_TIME_SERIES_TENSOR_HXX
+
+#include <cstdint>
+
+#include <vector>
+using std::vector;
+
+/**
+ * A read only view of one series (or a window of one): number_parameters rows of length values,
+ * where the values of parameter p start at data + p * parameter_stride. Views never own their
+ * data, so they are cheap to copy and windows of a view share its values.
+ */
+class SeriesView {
+   private:
+    const double* data;
+    int64_t parameter_stride;
+    int32_t number_parameters;
+    int32_t length;
+
+   public:
+    SeriesView();
+    SeriesView(const double* _data, int32_t _number_parameters, int32_t _length, int64_t _parameter_stride);
+
+    inline int32_t get_number_parameters() const {
+        return number_parameters;
+    }
+
+    inline int32_t get_length() const {
+        return length;
+    }
+
+    inline const double* get_parameter(int32_t parameter) const {
+        return data + parameter * parameter_stride;
+    }
+
+    inline double get(int32_t parameter, int32_t time) const {
+        return data[parameter * parameter_stride + time];
+    }
+
+    /**
+     * A view of length values starting at time start, sharing this view's values.
+     */
+    SeriesView window(int32_t start, int32_t window_length) const;
+};
+
+/**
+ * The training data for a set of series (series x parameter x time) in one contiguous, 64 byte
+ * aligned block, with a SeriesView for each sequence. Slicing the series into shorter sequences
+ * only replaces the views, the values are never copied.
+ *
+ * A tensor can also hold views of memory it does not own (e.g., an MPI shared memory window),
+ * which must outlive the tensor.
+ */
+class TimeSeriesTensor {
+   private:
+    int32_t number_parameters;
+
+    double* storage;
+    int64_t storage_size;
+
+    vector<SeriesView> sequences;
+
+    TimeSeriesTensor(const TimeSeriesTensor&) = delete;
+    TimeSeriesTensor& operator=(const TimeSeriesTensor&) = delete;
+
+   public:
+    TimeSeriesTensor();
+    explicit TimeSeriesTensor(const vector<vector<vector<double> > >& series);
+    ~TimeSeriesTensor();
+
+    /**
+     * Clears the tensor and allocates one sequence of each of the given lengths, with every
+     * parameter's values starting on a 64 byte boundary. The values are zeroed.
+     */
+    void allocate(int32_t _number_parameters, const vector<int32_t>& lengths);
+
+    /**
+     * Clears the tensor and sets it to hold views of memory it does not own.
+     */
+    void set_views(int32_t _number_parameters, const vector<SeriesView>& views);
+
+    /**
+     * Writable values of a parameter of a sequence allocated by this tensor, for filling it in.
+     */
+    double* get_parameter_data(int32_t sequence, int32_t parameter);
+
+    /**
+     * Replaces the sequences with consecutive, non-overlapping windows of sequence_length values;
+     * the remainder of each sequence shorter than sequence_length is dropped.
+     */
+    void slice(int32_t sequence_length);
+
+    void clear();
+
+    inline int32_t size() const {
+        return (int32_t) sequences.size();
+    }
+
+    inline const SeriesView& operator[](int32_t sequence) const {
+        return sequences[sequence];
+    }
+
+    int32_t get_number_parameters() const;
+
+    void export_series(vector<vector<vector<double> > >& series) const;
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include <random>
+using std::minstd_rand0;
+using std::uniform_int_distribution;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "window_sampler.hxx"
+
+WindowSampler::WindowSampler()
+    : enabled(false),
+      sequence_length(0),
+      sequence_stride(0),
+      random_sequence_length(false),
+      sequence_length_lower_bound(30),
+      sequence_length_upper_bound(100),
+      windows_per_epoch(0) {
+}
+
+/**
+ * Returns true if the arguments ask for windows to be sampled during training, in which case
+ * the training data should not be sliced ahead of time.
+ */
+bool WindowSampler::is_requested(const vector<string>& arguments) {
+    return argument_exists(arguments, "--train_sequence_stride")
+           || argument_exists(arguments, "--random_sequence_length");
+}
+
+void WindowSampler::generate_from_arguments(const vector<string>& arguments) {
+    enabled = is_requested(arguments);
+    if (!enabled) {
+        return;
+    }
+
+    random_sequence_length = argument_exists(arguments, "--random_sequence_length");
+
+    if (random_sequence_length) {
+        get_argument(arguments, "--sequence_length_lower_bound", false, sequence_length_lower_bound);
+        get_argument(arguments, "--sequence_length_upper_bound", false, sequence_length_upper_bound);
+        get_argument(arguments, "--windows_per_epoch", false, windows_per_epoch);
+
+        if (sequence_length_lower_bound <= 0 || sequence_length_upper_bound < sequence_length_lower_bound) {
+            Log::fatal(
+                "ERROR: invalid random sequence length bounds: %d to %d\n", sequence_length_lower_bound,
+                sequence_length_upper_bound
+            );
+            exit(1);
+        }
+
+        Log::info(
+            "sampling random training windows with lengths from %d to %d\n", sequence_length_lower_bound,
+            sequence_length_upper_bound
+        );
+
+    } else {
+        get_argument(arguments, "--train_sequence_length", true, sequence_length);
+        get_argument(arguments, "--train_sequence_stride", true, sequence_stride);
+
+        if (sequence_length <= 0 || sequence_stride <= 0) {
+            Log::fatal(
+                "ERROR: invalid training sequence length (%d) or stride (%d)\n", sequence_length, sequence_stride
+            );
+            exit(1);
+        }
+
+        Log::info("sampling training windows of length %d every %d values\n", sequence_length, sequence_stride);
+    }
+}
+
+bool WindowSampler::is_enabled() const {
+    return enabled;
+}
+
+void WindowSampler::get_epoch_windows(
+    const TimeSeriesTensor& inputs, minstd_rand0& generator, vector<SeriesWindow>& windows
+) const {
+    windows.clear();
+
+    if (!random_sequence_length) {
+        for (int32_t i = 0; i < inputs.size(); i++) {
+            int32_t length = inputs[i].get_length();
+            if (length <= sequence_length) {
+                windows.push_back({i, 0, length});
+                continue;
+            }
+
+            for (int32_t start = 0; start + sequence_length <= length; start += sequence_stride) {
+                windows.push_back({i, start, sequence_length});
+            }
+        }
+        return;
+    }
+
+    int64_t total_length = 0;
+    for (int32_t i = 0; i < inputs.size(); i++) {
+        total_length += inputs[i].get_length();
+    }
+
+    if (total_length == 0) {
+        // there are no values to pick windows from
+        Log::warning("no training windows were sampled, as the training series have no values\n");
+        return;
+    }
+
+    int32_t number_windows = windows_per_epoch;
+    if (number_windows <= 0) {
+        // enough windows of the average length to cover the training data once
+        number_windows = (int32_t) (total_length * 2 / (sequence_length_lower_bound + sequence_length_upper_bound));
+        if (number_windows < 1) {
+            number_windows = 1;
+        }
+    }
+
+    // pick the sequence for each window proportionally to its length, so every value is
+    // equally likely to be trained on
+    uniform_int_distribution<int64_t> position_distribution(0, total_length - 1);
+    uniform_int_distribution<int32_t> length_distribution(sequence_length_lower_bound, sequence_length_upper_bound);
+
+    for (int32_t i = 0; i < number_windows; i++) {
+        int64_t position = position_distribution(generator);
+        int32_t sequence = 0;
+        while (position >= inputs[sequence].get_length()) {
+            position -= inputs[sequence].get_length();
+            sequence++;
+        }
+
+        int32_t available = inputs[sequence].get_length();
+        int32_t length = length_distribution(generator);
+        if (length >= available) {
+            windows.push_back({sequence, 0, available});
+            continue;
+        }
+
+        uniform_int_distribution<int32_t> start_distribution(0, available - length);
+        windows.push_back({sequence, start_distribution(generator), length});
+    }
+}
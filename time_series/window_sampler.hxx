@@ -0,0 +1,70 @@
+#ifndef EXAMM_WINDOW_SAMPLER_HXX
+#define EXAMM_WINDOW_SAMPLER_HXX
+
+#include <random>
+using std::minstd_rand0;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "time_series_tensor.hxx"
+
+/**
+ * A window of one of the training sequences, given as an offset into the sequence so the
+ * window's values are never copied.
+ */
+struct SeriesWindow {
+    int32_t sequence;
+    int32_t start;
+    int32_t length;
+};
+
+/**
+ * Generates the windows of the training series which backpropagate_stochastic trains on
+ * each epoch, instead of slicing the training data ahead of time:
+ *
+ *  - with --train_sequence_length and --train_sequence_stride, every window of the given
+ *    length starting every stride values, so windows overlap if the stride is shorter
+ *  - with --random_sequence_length, new windows each epoch with uniformly random lengths
+ *    between --sequence_length_lower_bound and --sequence_length_upper_bound, at uniformly
+ *    random positions, --windows_per_epoch of them (by default enough to cover the training
+ *    data once)
+ *
+ * Without either argument the sampler is disabled and training uses the sequences as they
+ * are (which --train_sequence_length alone slices into non-overlapping windows).
+ */
+class WindowSampler {
+   private:
+    bool enabled;
+
+    int32_t sequence_length;
+    int32_t sequence_stride;
+
+    bool random_sequence_length;
+    int32_t sequence_length_lower_bound;
+    int32_t sequence_length_upper_bound;
+    int32_t windows_per_epoch;
+
+   public:
+    WindowSampler();
+
+    static bool is_requested(const vector<string>& arguments);
+
+    void generate_from_arguments(const vector<string>& arguments);
+
+    bool is_enabled() const;
+
+    /**
+     * Fills in the windows for an epoch over the given training sequences. Each sequence
+     * which is shorter than the windows is used as a whole, and there are no windows if the
+     * sequences have no values.
+     */
+    void get_epoch_windows(
+        const TimeSeriesTensor& inputs, minstd_rand0& generator, vector<SeriesWindow>& windows
+    ) const;
+};
+
+#endif
@@ -139,7 +139,7 @@ void WordSeries::normalize_min_max(double min, double max) {
         min, max, this->min, this->max
     );
 
-    for (int i = 0; i < values.size(); i++) {
+    for (int i = 0; i < (int32_t) values.size(); i++) {
         if (values[i] < min) {
             Log::warning(
                 "normalizing series %s, value[%d] %lf was less than min for normalization: %lf\n", name.c_str(), i,
@@ -166,7 +166,7 @@ void WordSeries::normalize_avg_std_dev(double avg, double std_dev, double norm_m
         name.c_str(), avg, std_dev, norm_max, this->average, this->std_dev
     );
 
-    for (int i = 0; i < values.size(); i++) {
+    for (int i = 0; i < (int32_t) values.size(); i++) {
         values[i] = ((values[i] - avg) / std_dev) / norm_max;
     }
 }
@@ -247,11 +247,12 @@ void SentenceSeries::add_word_series(string name) {
 }
 
 SentenceSeries::SentenceSeries(
-    const string _filename, const vector<string>& _word_index, const map<string, int>& _vocab
+    const string _filename, const vector<string>& _word_index, const map<string, int>& _vocab, bool _sparse
 ) {
     filename = _filename;
     word_index = _word_index;
     vocab = _vocab;
+    sparse = _sparse;
 
     ifstream cs_file(filename.c_str());
 
@@ -263,13 +264,26 @@ SentenceSeries::SentenceSeries(
         file_words.push_back("<eos>");
     }
 
-    for (int i = 0; i < word_index.size(); i++) {
+    tokens.resize(file_words.size());
+    for (int i = 0; i < (int) file_words.size(); ++i) {
+        tokens[i] = vocab[file_words[i]];
+    }
+
+    number_rows = file_words.size();
+
+    if (sparse) {
+        // the one-hot word series would be vocabulary size times larger than the tokens
+        Log::info("read sparse sentence series '%s' with number rows: %d\n", filename.c_str(), number_rows);
+        return;
+    }
+
+    for (int i = 0; i < (int32_t) word_index.size(); i++) {
         add_word_series(word_index[i]);
     }
 
-    for (int i = 0; i < file_words.size(); ++i) {
-        int current_word = vocab[file_words[i]];
-        for (int i = 0; i < word_index.size(); ++i) {
+    for (int i = 0; i < number_rows; ++i) {
+        int current_word = tokens[i];
+        for (int i = 0; i < (int32_t) word_index.size(); ++i) {
             if (i != current_word) {
                 word_series[word_index[i]]->add_value(0);
             } else {
@@ -278,8 +292,6 @@ SentenceSeries::SentenceSeries(
         }
     }
 
-    number_rows = file_words.size();
-
     for (auto series = word_series.begin(); series != word_series.end(); series++) {
         series->second->calculate_statistics();
         if (series->second->get_min_change() == 0 && series->second->get_max_change() == 0) {
@@ -378,26 +390,31 @@ double SentenceSeries::get_correlation(string word1, string word2, int32_t lag)
 }
 
 void SentenceSeries::export_word_series(vector<vector<double> >& data, int word_offset) {
+    if (sparse) {
+        Log::fatal("ERROR: cannot export the one-hot word series of sparse sentence series '%s'\n", filename.c_str());
+        exit(1);
+    }
+
     cout << "word_offset:: " << word_offset << endl;
     data.clear();
     data.resize(word_index.size(), vector<double>(number_rows - fabs(word_offset), 0.0));
 
     if (word_offset > 0) {
         cout << "testing" << endl;
-        for (int i = 0; i < word_index.size(); ++i) {
+        for (int i = 0; i < (int32_t) word_index.size(); ++i) {
             for (int j = word_offset; j < number_rows; ++j) {
                 data[i][j - word_offset] = word_series[word_index[i]]->get_value(j);
             }
         }
     } else if (word_offset < 0) {
         cout << "training" << endl;
-        for (int i = 0; i < word_index.size(); ++i) {
+        for (int i = 0; i < (int32_t) word_index.size(); ++i) {
             for (int j = 0; j < number_rows + word_offset; ++j) {
                 data[i][j] = word_series[word_index[i]]->get_value(j);
             }
         }
     } else {
-        for (int i = 0; i < word_index.size(); ++i) {
+        for (int i = 0; i < (int32_t) word_index.size(); ++i) {
             for (int j = 0; j < number_rows; ++j) {
                 data[i][j] = word_series[word_index[i]]->get_value(j);
             }
@@ -409,6 +426,23 @@ void SentenceSeries::export_word_series(vector<vector<double> >& data) {
     export_word_series(data, 0);
 }
 
+/**
+ * Exports the tokens the same way export_word_series exports the one-hot word series, a positive
+ * word_offset drops the first words (for the expected outputs) and a negative word_offset drops the last
+ * words (for the inputs).
+ */
+void SentenceSeries::export_tokens(vector<int32_t>& exported_tokens, int word_offset) {
+    if (word_offset > 0) {
+        exported_tokens.assign(tokens.begin() + word_offset, tokens.end());
+    } else {
+        exported_tokens.assign(tokens.begin(), tokens.end() + word_offset);
+    }
+}
+
+const vector<int32_t>& SentenceSeries::get_tokens() const {
+    return tokens;
+}
+
 SentenceSeries::SentenceSeries() {
 }
 
@@ -418,6 +452,8 @@ SentenceSeries* SentenceSeries::copy() {
     ss->filename = filename;
     ss->word_index = word_index;
     ss->vocab = vocab;
+    ss->tokens = tokens;
+    ss->sparse = sparse;
 
     for (auto series = word_series.begin(); series != word_series.end(); series++) {
         ss->word_series[series->first] = series->second->copy();
@@ -444,7 +480,7 @@ void SentenceSeries::select_parameters(
     select_parameters(combined_parameters);
 }
 
-Corpus::Corpus() : normalize_type("none") {
+Corpus::Corpus() : normalize_type("none"), sparse(false) {
 }
 
 Corpus::~Corpus() {
@@ -475,7 +511,7 @@ void merge_parameter_names_word(
 }
 
 void Corpus::load_word_library() {
-    for (int i = 0; i < training_indexes.size(); ++i) {
+    for (int i = 0; i < (int32_t) training_indexes.size(); ++i) {
         vector<string> words;
         string filename = filenames[training_indexes[i]];
         ifstream cs_file(filename.c_str());
@@ -502,7 +538,7 @@ void Corpus::load_word_library() {
     for (uint32_t i = 0; i < filenames.size(); i++) {
         Log::debug("\t%s\n", filenames[i].c_str());
 
-        SentenceSeries* ss = new SentenceSeries(filenames[i], word_index, vocab);
+        SentenceSeries* ss = new SentenceSeries(filenames[i], word_index, vocab, sparse);
         sent_series.push_back(ss);
     }
 }
@@ -522,13 +558,13 @@ Corpus* Corpus::generate_from_arguments(const vector<string>& arguments) {
         get_argument_vector(arguments, "--test_filenames", true, test_filenames);
 
         int current = 0;
-        for (int i = 0; i < training_filenames.size(); i++) {
+        for (int i = 0; i < (int32_t) training_filenames.size(); i++) {
             cs->filenames.push_back(training_filenames[i]);
             cs->training_indexes.push_back(current);
             current++;
         }
 
-        for (int i = 0; i < test_filenames.size(); i++) {
+        for (int i = 0; i < (int32_t) test_filenames.size(); i++) {
             cs->filenames.push_back(test_filenames[i]);
             cs->test_indexes.push_back(current);
             current++;
@@ -547,6 +583,10 @@ Corpus* Corpus::generate_from_arguments(const vector<string>& arguments) {
     cs->input_parameter_names.clear();
     cs->output_parameter_names.clear();
 
+    // keep only the token index of each word instead of a one-hot series per vocabulary word, for
+    // training with RNN::sparse_forward_pass
+    cs->sparse = argument_exists(arguments, "--sparse_word_series");
+
     cs->load_word_library();
 
     return cs;
@@ -617,9 +657,14 @@ double Corpus::denormalize(string field_name, double value) {
 }
 
 void Corpus::normalize_min_max() {
+    if (sparse) {
+        Log::fatal("ERROR: sparse word series (--sparse_word_series) are one-hot encoded and cannot be normalized\n");
+        exit(1);
+    }
+
     Log::info("doing min/max normalization:\n");
 
-    for (int i = 0; i < all_parameter_names.size(); i++) {
+    for (int i = 0; i < (int32_t) all_parameter_names.size(); i++) {
         string parameter_name = all_parameter_names[i];
 
         double min = numeric_limits<double>::max();
@@ -635,7 +680,7 @@ void Corpus::normalize_min_max() {
             Log::info("user specified bounds for ");
 
         } else {
-            for (int j = 0; j < sent_series.size(); j++) {
+            for (int j = 0; j < (int32_t) sent_series.size(); j++) {
                 double current_min = sent_series[j]->get_min(parameter_name);
                 double current_max = sent_series[j]->get_max(parameter_name);
 
@@ -656,7 +701,7 @@ void Corpus::normalize_min_max() {
         Log::info_no_header("%30s, min: %22.10lf, max: %22.10lf\n", parameter_name.c_str(), min, max);
 
         // for each series, subtract min, divide by (max - min)
-        for (int j = 0; j < sent_series.size(); j++) {
+        for (int j = 0; j < (int32_t) sent_series.size(); j++) {
             sent_series[j]->normalize_min_max(parameter_name, min, max);
         }
     }
@@ -692,7 +737,7 @@ void Corpus::normalize_min_max(const map<string, double>& _normalize_mins, const
         }
 
         // for each series, subtract min, divide by (max - min)
-        for (int j = 0; j < sent_series.size(); j++) {
+        for (int j = 0; j < (int32_t) sent_series.size(); j++) {
             sent_series[j]->normalize_min_max(field, normalize_mins[field], normalize_maxs[field]);
         }
     }
@@ -701,9 +746,14 @@ void Corpus::normalize_min_max(const map<string, double>& _normalize_mins, const
 }
 
 void Corpus::normalize_avg_std_dev() {
+    if (sparse) {
+        Log::fatal("ERROR: sparse word series (--sparse_word_series) are one-hot encoded and cannot be normalized\n");
+        exit(1);
+    }
+
     Log::info("doing min/max normalization:\n");
 
-    for (int i = 0; i < all_parameter_names.size(); i++) {
+    for (int i = 0; i < (int32_t) all_parameter_names.size(); i++) {
         string parameter_name = all_parameter_names[i];
 
         double min = numeric_limits<double>::max();
@@ -724,7 +774,7 @@ void Corpus::normalize_avg_std_dev() {
             double numerator_average = 0.0;
             long total_values = 0;
 
-            for (int j = 0; j < sent_series.size(); j++) {
+            for (int j = 0; j < (int32_t) sent_series.size(); j++) {
                 int n_values = sent_series[j]->get_number_rows();
                 numerator_average += sent_series[j]->get_average(parameter_name) * n_values;
                 total_values += n_values;
@@ -747,7 +797,7 @@ void Corpus::normalize_avg_std_dev() {
 
             double numerator_std_dev = 0.0;
             // get the Bessel-corrected (n-1 denominator) combined standard deviation
-            for (int j = 0; j < sent_series.size(); j++) {
+            for (int j = 0; j < (int32_t) sent_series.size(); j++) {
                 int n_values = sent_series[j]->get_number_rows();
 
                 double avg_diff = sent_series[j]->get_average(parameter_name) - avg;
@@ -775,7 +825,7 @@ void Corpus::normalize_avg_std_dev() {
         );
 
         // for each series, subtract min, divide by (max - min)
-        for (int j = 0; j < sent_series.size(); j++) {
+        for (int j = 0; j < (int32_t) sent_series.size(); j++) {
             sent_series[j]->normalize_avg_std_dev(parameter_name, avg, std_dev, norm_max);
         }
     }
@@ -846,7 +896,7 @@ void Corpus::normalize_avg_std_dev(
         norm_max = fmax(norm_min, norm_max);
 
         // for each series, subtract avg, divide by std_dev; then divide by normalized_max to make between -1 and 1
-        for (int j = 0; j < sent_series.size(); j++) {
+        for (int j = 0; j < (int32_t) sent_series.size(); j++) {
             sent_series[j]->normalize_avg_std_dev(field, avg, std_dev, norm_max);
         }
     }
@@ -861,13 +911,12 @@ vector<vector<vector<double> > > batchify(int batch_size, vector<vector<vector<d
     int no_batches = 0;
     int batchNo = -1;
 
-    for (int i = 0; i < data.size(); ++i) {
+    for (int i = 0; i < (int32_t) data.size(); ++i) {
         no_batches += (data[i][0].size() - 1) / batch_size + 1;
-    std:
         cout << no_batches << " " << std::endl;
     }
 
-    if (data[0][0].size() < batch_size) {
+    if ((int32_t) data[0][0].size() < batch_size) {
         batchData.resize(no_batches, vector<vector<double> >(no_features, vector<double>(data[0][0].size())));
     } else {
         batchData.resize(no_batches, vector<vector<double> >(no_features, vector<double>(batch_size)));
@@ -875,9 +924,9 @@ vector<vector<vector<double> > > batchify(int batch_size, vector<vector<vector<d
 
     std::cout << batchData.size() << " " << data[0].size() << " " << batchData[0][0].size() << std::endl;
 
-    for (int k = 0; k < data.size(); ++k) {
-        for (int j = 0; j < data[k][0].size(); ++j) {
-            for (int i = 0; i < data[k].size(); ++i) {
+    for (int k = 0; k < (int32_t) data.size(); ++k) {
+        for (int j = 0; j < (int32_t) data[k][0].size(); ++j) {
+            for (int i = 0; i < (int32_t) data[k].size(); ++i) {
                 if (i == 0 && (j % batch_size) == 0) {
                     batchNo++;
                 }
@@ -914,6 +963,58 @@ void Corpus::export_sent_series(
     outputs = batchify(64, temp_outputs);
 }
 
+/**
+ * Exports the token sequences of the given series, split into sequences of up to 64 words the same
+ * way export_sent_series batches the one-hot word series.
+ */
+void Corpus::export_token_series(
+    const vector<int>& series_indexes, int word_offset, vector<vector<int32_t> >& inputs,
+    vector<vector<int32_t> >& outputs
+) {
+    const int batch_size = 64;
+
+    inputs.clear();
+    outputs.clear();
+
+    vector<int32_t> series_inputs;
+    vector<int32_t> series_outputs;
+
+    for (uint32_t i = 0; i < series_indexes.size(); i++) {
+        int series_index = series_indexes[i];
+
+        sent_series[series_index]->export_tokens(series_inputs, -word_offset);
+        sent_series[series_index]->export_tokens(series_outputs, word_offset);
+
+        for (int start = 0; start < (int) series_inputs.size(); start += batch_size) {
+            int stop = std::min(start + batch_size, (int) series_inputs.size());
+            inputs.push_back(vector<int32_t>(series_inputs.begin() + start, series_inputs.begin() + stop));
+            outputs.push_back(vector<int32_t>(series_outputs.begin() + start, series_outputs.begin() + stop));
+        }
+    }
+}
+
+void Corpus::export_training_tokens(
+    int word_offset, vector<vector<int32_t> >& inputs, vector<vector<int32_t> >& outputs
+) {
+    if (training_indexes.size() == 0) {
+        Log::fatal(
+            "ERROR: attempting to export training time series, however the training_indexes were not specified.\n"
+        );
+        exit(1);
+    }
+
+    export_token_series(training_indexes, word_offset, inputs, outputs);
+}
+
+void Corpus::export_test_tokens(int word_offset, vector<vector<int32_t> >& inputs, vector<vector<int32_t> >& outputs) {
+    if (test_indexes.size() == 0) {
+        Log::fatal("ERROR: attempting to export test time series, however the test_indexes were not specified.\n");
+        exit(1);
+    }
+
+    export_token_series(test_indexes, word_offset, inputs, outputs);
+}
+
 /**
  * This exports the time series marked as training series by the training_indexes vector.
  */
@@ -947,7 +1048,7 @@ void Corpus::export_test_series(
 void Corpus::export_series_by_name(string field_name, vector<vector<double> >& exported_series) {
     exported_series.clear();
 
-    for (int32_t i = 0; i < sent_series.size(); i++) {
+    for (int32_t i = 0; i < (int32_t) sent_series.size(); i++) {
         vector<double> current_series;
 
         sent_series[i]->get_series(field_name, current_series);
@@ -962,7 +1063,7 @@ void Corpus::write_sentence_series_sets(string base_filename) {
         vector<vector<double> > data;
         sent_series[i]->export_word_series(data);
 
-        for (int j = 0; j < all_parameter_names.size(); j++) {
+        for (int j = 0; j < (int32_t) all_parameter_names.size(); j++) {
             if (j > 0) {
                 outfile << ",";
             }
@@ -970,8 +1071,8 @@ void Corpus::write_sentence_series_sets(string base_filename) {
         }
         outfile << endl;
 
-        for (int j = 0; j < data[0].size(); j++) {
-            for (int k = 0; k < data.size(); k++) {
+        for (int j = 0; j < (int32_t) data[0].size(); j++) {
+            for (int k = 0; k < (int32_t) data.size(); k++) {
                 if (k > 0) {
                     outfile << ",";
                 }
@@ -1023,6 +1124,10 @@ int Corpus::get_number_outputs() const {
     return output_parameter_names.size();
 }
 
+bool Corpus::is_sparse() const {
+    return sparse;
+}
+
 void Corpus::set_training_indexes(const vector<int>& _training_indexes) {
     training_indexes = _training_indexes;
 }
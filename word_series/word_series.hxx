@@ -68,10 +68,18 @@ class SentenceSeries {
     vector<string> word_index;
     map<string, WordSeries*> word_series;
 
+    // the index of each word in the word index, one per row
+    vector<int32_t> tokens;
+
+    // sparse sentence series only keep the tokens, not a one-hot word series per word
+    bool sparse;
+
     SentenceSeries();
 
    public:
-    SentenceSeries(const string _filename, const vector<string>& _word_index, const map<string, int>& _vocab);
+    SentenceSeries(
+        const string _filename, const vector<string>& _word_index, const map<string, int>& _vocab, bool _sparse
+    );
     ~SentenceSeries();
     void add_word_series(string name);
 
@@ -100,6 +108,9 @@ class SentenceSeries {
     void export_word_series(vector<vector<double> >& data, int word_offset);
     void export_word_series(vector<vector<double> >& data);
 
+    void export_tokens(vector<int32_t>& exported_tokens, int word_offset);
+    const vector<int32_t>& get_tokens() const;
+
     SentenceSeries* copy();
 
     void select_parameters(const vector<string>& input_parameter_names, const vector<string>& output_parameter_names);
@@ -130,6 +141,8 @@ class Corpus {
     vector<string> word_index;
     map<string, int> vocab;
 
+    bool sparse;
+
     void load_word_library();
 
    public:
@@ -166,6 +179,15 @@ class Corpus {
         int word_offset, vector<vector<vector<double> > >& inputs, vector<vector<vector<double> > >& outputs
     );
 
+    void export_token_series(
+        const vector<int>& series_indexes, int word_offset, vector<vector<int32_t> >& inputs,
+        vector<vector<int32_t> >& outputs
+    );
+
+    void export_training_tokens(int word_offset, vector<vector<int32_t> >& inputs, vector<vector<int32_t> >& outputs);
+
+    void export_test_tokens(int word_offset, vector<vector<int32_t> >& inputs, vector<vector<int32_t> >& outputs);
+
     void export_series_by_name(string field_name, vector<vector<double> >& exported_series);
 
     double denormalize(string field_name, double value);
@@ -184,6 +206,8 @@ class Corpus {
     int get_number_inputs() const;
     int get_number_outputs() const;
 
+    bool is_sparse() const;
+
     void set_training_indexes(const vector<int>& _training_indexes);
     void set_test_indexes(const vector<int>& _test_indexes);
 